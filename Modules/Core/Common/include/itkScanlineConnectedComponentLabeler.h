@@ -0,0 +1,182 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScanlineConnectedComponentLabeler_h
+#define itkScanlineConnectedComponentLabeler_h
+
+#include "itkImageRegion.h"
+#include "itkBarrier.h"
+
+#include <utility>
+#include <vector>
+
+namespace itk
+{
+/** \class ScanlineConnectedComponentLabeler
+ * \brief Label the connected components of the run-length encoded lines of
+ * an image region with several threads.
+ *
+ * This class holds the algorithm shared by the filters labeling connected
+ * components from run-length encoded lines, such as
+ * ConnectedComponentImageFilter and BinaryImageToLabelMapFilter.  The
+ * requested region is split in blocks of consecutive lines, one per thread,
+ * and each thread encodes the runs of the lines of its block with GetLine().
+ * Every thread then calls ThreadedResolve(), which
+ *
+ *  - numbers the runs in raster order, each thread numbering the runs of its
+ *    block after those of the preceding blocks;
+ *  - links the overlapping runs of the block in a union-find table, each
+ *    thread writing only the entries of its own block;
+ *  - collects the links between the first lines of the block and the
+ *    preceding block, and merges them in the union-find table of the roots
+ *    of the blocks.  This is the only sequential step, and its cost is
+ *    proportional to the size of the block boundaries;
+ *  - numbers the components consecutively in the raster order of their first
+ *    run, each thread numbering the components starting in its block.
+ *
+ * No step requires a lock, and the component numbers do not depend on the
+ * number of threads.
+ *
+ * \ingroup ITKCommon
+ */
+template< unsigned int VImageDimension >
+class ITK_TEMPLATE_EXPORT ScanlineConnectedComponentLabeler
+{
+public:
+  /** Standard class typedefs. */
+  typedef ScanlineConnectedComponentLabeler Self;
+
+  itkStaticConstMacro(ImageDimension, unsigned int, VImageDimension);
+
+  typedef Index< VImageDimension >        IndexType;
+  typedef ImageRegion< VImageDimension >  RegionType;
+  typedef SizeValueType                   LabelType;
+
+  /** A run of connected pixels along the first dimension. */
+  struct RunLength
+    {
+    SizeValueType length;
+    IndexType     where;   // Index of the start of the run
+    LabelType     label;   // Label of the run, set by ThreadedResolve()
+    };
+
+  typedef std::vector< RunLength >        LineEncodingType;
+  typedef std::vector< LineEncodingType > LineMapType;
+
+  /** Connectivity linking all the overlapping runs, used for binary
+   * images. */
+  struct OverlappingRunsAreConnected
+    {
+    bool operator()( const RunLength &, const RunLength & ) const
+    {
+      return true;
+    }
+    };
+
+  ScanlineConnectedComponentLabeler();
+
+  /** Prepare the labeling of the lines of the region by the given number of
+   * threads.  Every thread must call ThreadedResolve(). */
+  void Initialize( const RegionType & region, ThreadIdType numberOfThreads, bool fullyConnected );
+
+  /** Release the memory of the lines and of the tables. */
+  void Clear();
+
+  /** Get the id of the line starting at an index of the region. */
+  SizeValueType GetLineId( const IndexType & index ) const;
+
+  /** Get the runs of a line. The runs must be stored in increasing order. */
+  LineEncodingType & GetLine( SizeValueType lineId )
+  {
+    return m_LineMap[lineId];
+  }
+  const LineEncodingType & GetLine( SizeValueType lineId ) const
+  {
+    return m_LineMap[lineId];
+  }
+
+  /** Label the runs of the lines, once each thread has encoded the lines of
+   * its region.  Neighbor runs are connected when they overlap, according
+   * to the connectivity given to Initialize(), and when the functor
+   * connectivity( currentRun, previousRun ) returns true.  Every thread must
+   * call this method, as it synchronizes them. */
+  template< typename TRunConnectivity >
+  void ThreadedResolve( ThreadIdType threadId, const RegionType & regionForThread,
+                        const TRunConnectivity & connectivity );
+
+  void ThreadedResolve( ThreadIdType threadId, const RegionType & regionForThread )
+  {
+    this->ThreadedResolve( threadId, regionForThread, OverlappingRunsAreConnected() );
+  }
+
+  /** Get the number of components.  Valid after ThreadedResolve(). */
+  SizeValueType GetNumberOfComponents() const
+  {
+    return m_NumberOfComponents;
+  }
+
+  /** Get the number of the component of a run, starting at 0 in the raster
+   * order of the first run of the components.  Valid after
+   * ThreadedResolve(). */
+  SizeValueType GetComponent( const RunLength & run ) const
+  {
+    return m_Consecutive[m_UnionFind[run.label]];
+  }
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ScanlineConnectedComponentLabeler);
+
+  typedef std::vector< OffsetValueType >                 OffsetVectorType;
+  typedef std::vector< LabelType >                       UnionFindType;
+  typedef std::vector< std::pair< LabelType, LabelType > > LinksType;
+
+  void SetupLineOffsets();
+
+  bool CheckNeighbors( const IndexType & A, const IndexType & B ) const;
+
+  /** Link the overlapping runs of two neighbor lines in the union-find table,
+   * or store the pairs of roots of their labels when links is not null. */
+  template< typename TRunConnectivity >
+  void CompareLines( const LineEncodingType & current, const LineEncodingType & neighbor,
+                     const TRunConnectivity & connectivity, LinksType * links );
+
+  LabelType LookupSet( LabelType label );
+
+  void LinkLabels( LabelType lab1, LabelType lab2 );
+
+  void Wait();
+
+  RegionType       m_Region;
+  bool             m_FullyConnected;
+  OffsetVectorType m_LineOffsets;
+  LineMapType      m_LineMap;
+  UnionFindType    m_UnionFind;
+  UnionFindType    m_Consecutive;
+  SizeValueType    m_NumberOfComponents;
+
+  std::vector< SizeValueType > m_NumberOfRuns;
+  std::vector< SizeValueType > m_NumberOfRoots;
+  std::vector< LinksType >     m_BoundaryLinks;
+  Barrier::Pointer             m_Barrier;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkScanlineConnectedComponentLabeler.hxx"
+#endif
+
+#endif
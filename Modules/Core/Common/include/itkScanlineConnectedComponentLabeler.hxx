@@ -0,0 +1,445 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkScanlineConnectedComponentLabeler_hxx
+#define itkScanlineConnectedComponentLabeler_hxx
+
+#include "itkScanlineConnectedComponentLabeler.h"
+#include "itkImage.h"
+#include "itkConstShapedNeighborhoodIterator.h"
+#include "itkConnectedComponentAlgorithm.h"
+
+namespace itk
+{
+template< unsigned int VImageDimension >
+ScanlineConnectedComponentLabeler< VImageDimension >
+::ScanlineConnectedComponentLabeler() :
+  m_FullyConnected( false ),
+  m_NumberOfComponents( 0 )
+{
+}
+
+template< unsigned int VImageDimension >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::Initialize( const RegionType & region, ThreadIdType numberOfThreads, bool fullyConnected )
+{
+  m_Region = region;
+  m_FullyConnected = fullyConnected;
+  m_NumberOfComponents = 0;
+
+  m_LineMap.clear();
+  m_LineMap.resize( region.GetNumberOfPixels() / region.GetSize(0) );
+  this->SetupLineOffsets();
+
+  m_NumberOfRuns.assign( numberOfThreads, 0 );
+  m_NumberOfRoots.assign( numberOfThreads, 0 );
+  m_BoundaryLinks.clear();
+  m_BoundaryLinks.resize( numberOfThreads );
+  m_Barrier = Barrier::New();
+  m_Barrier->Initialize( numberOfThreads );
+}
+
+template< unsigned int VImageDimension >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::Clear()
+{
+  LineMapType().swap( m_LineMap );
+  UnionFindType().swap( m_UnionFind );
+  UnionFindType().swap( m_Consecutive );
+  m_BoundaryLinks.clear();
+  m_Barrier = ITK_NULLPTR;
+}
+
+template< unsigned int VImageDimension >
+SizeValueType
+ScanlineConnectedComponentLabeler< VImageDimension >
+::GetLineId( const IndexType & index ) const
+{
+  SizeValueType offset = 0;
+  SizeValueType stride = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    offset += static_cast< SizeValueType >( index[d] - m_Region.GetIndex(d) ) * stride;
+    stride *= m_Region.GetSize(d);
+    }
+  return offset / m_Region.GetSize(0);
+}
+
+template< unsigned int VImageDimension >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::Wait()
+{
+  // use m_NumberOfRuns.size() to get the number of thread used
+  if ( m_NumberOfRuns.size() > 1 )
+    {
+    m_Barrier->Wait();
+    }
+}
+
+template< unsigned int VImageDimension >
+template< typename TRunConnectivity >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::ThreadedResolve( ThreadIdType threadId, const RegionType & regionForThread,
+                   const TRunConnectivity & connectivity )
+{
+  const ThreadIdType  numberOfThreads = static_cast< ThreadIdType >( m_NumberOfRuns.size() );
+  const SizeValueType firstLineId = this->GetLineId( regionForThread.GetIndex() );
+  const SizeValueType endLineId = firstLineId + regionForThread.GetNumberOfPixels() / regionForThread.GetSize(0);
+
+  SizeValueType numberOfRuns = 0;
+  for ( SizeValueType lineId = firstLineId; lineId < endLineId; ++lineId )
+    {
+    numberOfRuns += m_LineMap[lineId].size();
+    }
+  m_NumberOfRuns[threadId] = numberOfRuns;
+
+  // wait for the other threads to complete that part
+  this->Wait();
+
+  LabelType firstLabel = 1;
+  SizeValueType totalNumberOfRuns = 0;
+  for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
+    {
+    if ( i < threadId )
+      {
+      firstLabel += m_NumberOfRuns[i];
+      }
+    totalNumberOfRuns += m_NumberOfRuns[i];
+    }
+
+  if ( threadId == 0 )
+    {
+    m_UnionFind.resize( totalNumberOfRuns + 1 );
+    m_Consecutive.resize( totalNumberOfRuns + 1 );
+    m_UnionFind[0] = 0;
+    }
+
+  this->Wait();
+
+  // number the runs of the block in raster order, and link the runs of the
+  // lines of the block. The neighbor lines are "previous" lines, so the
+  // lines of the preceding blocks are skipped here.
+  LabelType label = firstLabel;
+  for ( SizeValueType lineId = firstLineId; lineId < endLineId; ++lineId )
+    {
+    for ( typename LineEncodingType::iterator cIt = m_LineMap[lineId].begin(); cIt != m_LineMap[lineId].end(); ++cIt )
+      {
+      cIt->label = label;
+      m_UnionFind[label] = label;
+      ++label;
+      }
+    }
+  const LabelType endLabel = label;
+
+  OffsetValueType maximumLineOffset = 0;
+  for ( typename OffsetVectorType::const_iterator I = m_LineOffsets.begin(); I != m_LineOffsets.end(); ++I )
+    {
+    maximumLineOffset = std::max( maximumLineOffset, -( *I ) );
+    }
+
+  for ( SizeValueType lineId = firstLineId; lineId < endLineId; ++lineId )
+    {
+    if ( m_LineMap[lineId].empty() )
+      {
+      continue;
+      }
+    for ( typename OffsetVectorType::const_iterator I = m_LineOffsets.begin(); I != m_LineOffsets.end(); ++I )
+      {
+      const OffsetValueType neighborId = static_cast< OffsetValueType >( lineId ) + ( *I );
+      if ( neighborId >= static_cast< OffsetValueType >( firstLineId ) && !m_LineMap[neighborId].empty()
+           && this->CheckNeighbors( m_LineMap[lineId][0].where, m_LineMap[neighborId][0].where ) )
+        {
+        this->CompareLines( m_LineMap[lineId], m_LineMap[neighborId], connectivity, ITK_NULLPTR );
+        }
+      }
+    }
+
+  // The parent of a label is a lower label of the block, so a single pass
+  // points every label of the block to its root.
+  for ( LabelType lab = firstLabel; lab < endLabel; ++lab )
+    {
+    m_UnionFind[lab] = m_UnionFind[m_UnionFind[lab]];
+    }
+
+  this->Wait();
+
+  // collect the links between the first lines of the block and the
+  // preceding blocks, without modifying the table
+  LinksType & links = m_BoundaryLinks[threadId];
+  links.clear();
+  const SizeValueType endBoundaryLineId =
+    std::min( endLineId, firstLineId + static_cast< SizeValueType >( maximumLineOffset ) );
+  for ( SizeValueType lineId = firstLineId; lineId < endBoundaryLineId; ++lineId )
+    {
+    if ( m_LineMap[lineId].empty() )
+      {
+      continue;
+      }
+    for ( typename OffsetVectorType::const_iterator I = m_LineOffsets.begin(); I != m_LineOffsets.end(); ++I )
+      {
+      const OffsetValueType neighborId = static_cast< OffsetValueType >( lineId ) + ( *I );
+      if ( neighborId >= 0 && neighborId < static_cast< OffsetValueType >( firstLineId )
+           && !m_LineMap[neighborId].empty()
+           && this->CheckNeighbors( m_LineMap[lineId][0].where, m_LineMap[neighborId][0].where ) )
+        {
+        this->CompareLines( m_LineMap[lineId], m_LineMap[neighborId], connectivity, &links );
+        }
+      }
+    }
+
+  this->Wait();
+
+  // merge the links across the blocks. Only the entries of the roots of the
+  // blocks are modified, and each of them ends up pointing to its final root.
+  if ( threadId == 0 )
+    {
+    for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
+      {
+      for ( typename LinksType::const_iterator lIt = m_BoundaryLinks[i].begin(); lIt != m_BoundaryLinks[i].end(); ++lIt )
+        {
+        this->LinkLabels( lIt->first, lIt->second );
+        }
+      }
+    for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
+      {
+      for ( typename LinksType::const_iterator lIt = m_BoundaryLinks[i].begin(); lIt != m_BoundaryLinks[i].end(); ++lIt )
+        {
+        this->LookupSet( lIt->first );
+        this->LookupSet( lIt->second );
+        }
+      }
+    }
+
+  this->Wait();
+
+  // point the labels of the block to their final root, and count the roots.
+  // A parent outside of the block is already a final root, and a parent in
+  // the block is a lower label, already processed.
+  SizeValueType numberOfRoots = 0;
+  for ( LabelType lab = firstLabel; lab < endLabel; ++lab )
+    {
+    const LabelType parent = m_UnionFind[lab];
+    if ( parent == lab )
+      {
+      ++numberOfRoots;
+      }
+    else if ( parent >= firstLabel )
+      {
+      m_UnionFind[lab] = m_UnionFind[parent];
+      }
+    }
+  m_NumberOfRoots[threadId] = numberOfRoots;
+
+  this->Wait();
+
+  SizeValueType component = 0;
+  SizeValueType numberOfComponents = 0;
+  for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
+    {
+    if ( i < threadId )
+      {
+      component += m_NumberOfRoots[i];
+      }
+    numberOfComponents += m_NumberOfRoots[i];
+    }
+  for ( LabelType lab = firstLabel; lab < endLabel; ++lab )
+    {
+    if ( m_UnionFind[lab] == lab )
+      {
+      m_Consecutive[lab] = component;
+      ++component;
+      }
+    }
+  if ( threadId == 0 )
+    {
+    m_NumberOfComponents = numberOfComponents;
+    }
+
+  this->Wait();
+}
+
+template< unsigned int VImageDimension >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::SetupLineOffsets()
+{
+  // Create a neighborhood so that we can generate a table of offsets
+  // to "previous" line indexes
+  // We are going to mis-use the neighborhood iterators to compute the
+  // offset for us. All this messing around produces an array of
+  // offsets that will be used to index the map
+  typedef Image< OffsetValueType, VImageDimension - 1 >          PretendImageType;
+  typedef typename PretendImageType::RegionType::SizeType        PretendSizeType;
+  typedef typename PretendImageType::RegionType::IndexType       PretendIndexType;
+  typedef ConstShapedNeighborhoodIterator< PretendImageType >    LineNeighborhoodType;
+
+  typename PretendImageType::Pointer fakeImage = PretendImageType::New();
+
+  typename PretendImageType::RegionType LineRegion;
+
+  PretendSizeType PretendSize;
+  // The first dimension has been collapsed
+  for ( unsigned int i = 0; i < PretendSize.GetSizeDimension(); i++ )
+    {
+    PretendSize[i] = m_Region.GetSize(i + 1);
+    }
+
+  LineRegion.SetSize(PretendSize);
+  fakeImage->SetRegions(LineRegion);
+  PretendSizeType kernelRadius;
+  kernelRadius.Fill(1);
+  LineNeighborhoodType lnit(kernelRadius, fakeImage, LineRegion);
+
+  // only activate the indices that are "previous" to the current
+  // pixel and face connected (exclude the center pixel from the
+  // neighborhood)
+  //
+  setConnectivityPrevious(&lnit, m_FullyConnected);
+
+  typename LineNeighborhoodType::IndexListType ActiveIndexes;
+  ActiveIndexes = lnit.GetActiveIndexList();
+
+  typename LineNeighborhoodType::IndexListType::const_iterator LI;
+
+  PretendIndexType idx = LineRegion.GetIndex();
+  OffsetValueType  offset = fakeImage->ComputeOffset(idx);
+
+  m_LineOffsets.clear();
+  for ( LI = ActiveIndexes.begin(); LI != ActiveIndexes.end(); LI++ )
+    {
+    m_LineOffsets.push_back(fakeImage->ComputeOffset( idx + lnit.GetOffset(*LI) ) - offset);
+    }
+}
+
+template< unsigned int VImageDimension >
+bool
+ScanlineConnectedComponentLabeler< VImageDimension >
+::CheckNeighbors(const IndexType & A, const IndexType & B) const
+{
+  // this checks whether the line encodings are really neighbors. The
+  // first dimension gets ignored because the encodings are along that
+  // axis
+  for ( unsigned i = 1; i < ImageDimension; i++ )
+    {
+    if ( itk::Math::abs(A[i] - B[i]) > 1 )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+template< unsigned int VImageDimension >
+template< typename TRunConnectivity >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::CompareLines( const LineEncodingType & current, const LineEncodingType & neighbor,
+                const TRunConnectivity & connectivity, LinksType * links )
+{
+  OffsetValueType offset = 0;
+
+  if ( m_FullyConnected )
+    {
+    offset = 1;
+    }
+
+  // The runs of a line are sorted and disjoint, but may be adjacent when
+  // the pixels are not connected by the connectivity functor, so a
+  // neighbor run may overlap several successive current runs.
+  typename LineEncodingType::const_iterator mIt = neighbor.begin(); // out marker iterator
+
+  for ( typename LineEncodingType::const_iterator cIt = current.begin(); cIt != current.end(); ++cIt )
+    {
+    const OffsetValueType cStart = cIt->where[0];  // the start x position
+    const OffsetValueType cLast = cStart + cIt->length - 1;
+
+    // skip the neighbor runs ending before the current run: they can't
+    // overlap the next current runs either
+    while ( mIt != neighbor.end()
+            && static_cast< OffsetValueType >( mIt->where[0] + mIt->length - 1 ) + offset < cStart )
+      {
+      ++mIt;
+      }
+
+    for ( typename LineEncodingType::const_iterator nIt = mIt;
+          nIt != neighbor.end() && nIt->where[0] - offset <= cLast; ++nIt )
+      {
+      // the runs overlap
+      if ( connectivity( *cIt, *nIt ) )
+        {
+        if ( links == ITK_NULLPTR )
+          {
+          this->LinkLabels( nIt->label, cIt->label );
+          }
+        else
+          {
+          const std::pair< LabelType, LabelType > link( m_UnionFind[nIt->label], m_UnionFind[cIt->label] );
+          if ( links->empty() || links->back() != link )
+            {
+            links->push_back( link );
+            }
+          }
+        }
+      }
+    }
+}
+
+// union find related functions
+template< unsigned int VImageDimension >
+typename ScanlineConnectedComponentLabeler< VImageDimension >::LabelType
+ScanlineConnectedComponentLabeler< VImageDimension >
+::LookupSet( LabelType label )
+{
+  LabelType root = label;
+  while ( m_UnionFind[root] != root )
+    {
+    root = m_UnionFind[root];
+    }
+  // compress the path
+  while ( m_UnionFind[label] != root )
+    {
+    const LabelType next = m_UnionFind[label];
+    m_UnionFind[label] = root;
+    label = next;
+    }
+  return root;
+}
+
+template< unsigned int VImageDimension >
+void
+ScanlineConnectedComponentLabeler< VImageDimension >
+::LinkLabels( LabelType lab1, LabelType lab2 )
+{
+  const LabelType E1 = this->LookupSet(lab1);
+  const LabelType E2 = this->LookupSet(lab2);
+
+  if ( E1 < E2 )
+    {
+    m_UnionFind[E2] = E1;
+    }
+  else
+    {
+    m_UnionFind[E1] = E2;
+    }
+}
+} // end namespace itk
+
+#endif
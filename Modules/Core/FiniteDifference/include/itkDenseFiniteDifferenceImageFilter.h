@@ -61,6 +61,37 @@ namespace itk
  * subclass it to a specific instance that supplies a function and Halt()
  * method.
  *
+ * \par Active tiles
+ * When UseActiveTiles is on, the requested region is divided into tiles of
+ * ActiveTileSize pixels along each dimension, and the change of each tile is
+ * tracked as the largest magnitude of \f$ \Delta u \Delta t \f$ over its
+ * pixels.  A tile is only recomputed in the next iteration when its own
+ * change, or the change of a tile whose pixels are in the neighborhood of its
+ * pixels, is larger than ActiveTileTolerance; the update of the other tiles is
+ * zero.  The iteration halts when no tile is active anymore.  With a zero
+ * tolerance, the output is unchanged for difference functions that only
+ * depend on the neighborhood of the pixel.  Global data accumulated by the
+ * function (e.g. the RMS change) is only computed over the active tiles.
+ *
+ * \par Temporal blocking
+ * When NumberOfStepsPerBlock is larger than one, each iteration of the
+ * superclass advances the solution by several time steps: every tile of
+ * BlockTileSize pixels along each dimension is copied with a halo of the
+ * function radius times the number of steps into buffers small enough to
+ * stay in cache, advanced there, and written back.  This trades the
+ * recomputation of the halos for the memory traffic of the update buffer and
+ * of the output at each time step.  It is intended for explicit stencil
+ * filters whose time step is fixed, whose function does not accumulate
+ * global data, and whose InitializeIteration() does not change the function
+ * between the time steps of a block.  InitializeIteration() is called, and
+ * IterationEvent invoked, once per block, and a block does not go past the
+ * number of iterations; the output is then unchanged.  In this mode the
+ * update buffer holds the new values of the output rather than updates, so
+ * the methods that control temporal blocking are protected and only made
+ * public by the subclasses that meet these requirements, such as the
+ * anisotropic diffusion filters with a fixed average gradient magnitude and
+ * the curvature flow filters.
+ *
  * \ingroup ImageFilters
  * \sa FiniteDifferenceImageFilter
  * \ingroup ITKFiniteDifference
@@ -101,6 +132,27 @@ public:
   /** The container type for the update buffer. */
   typedef OutputImageType UpdateBufferType;
 
+  /** Set/Get whether only the tiles of the output that changed in the
+   * previous iteration, and their neighbors, are recomputed.  Default is
+   * off. */
+  itkSetMacro(UseActiveTiles, bool);
+  itkGetConstMacro(UseActiveTiles, bool);
+  itkBooleanMacro(UseActiveTiles);
+
+  /** Set/Get the number of pixels of the active tiles along each
+   * dimension.  Default is 16. */
+  itkSetMacro(ActiveTileSize, SizeValueType);
+  itkGetConstMacro(ActiveTileSize, SizeValueType);
+
+  /** Set/Get the largest change of a tile for which it is considered
+   * converged.  Default is 0. */
+  itkSetMacro(ActiveTileTolerance, double);
+  itkGetConstMacro(ActiveTileTolerance, double);
+
+  /** Get the number of tiles recomputed in the next iteration, when active
+   * tiles are used. */
+  itkGetConstMacro(NumberOfActiveTiles, SizeValueType);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro( OutputTimesDoubleCheck,
@@ -115,8 +167,7 @@ public:
 #endif
 
 protected:
-  DenseFiniteDifferenceImageFilter()
-  { m_UpdateBuffer = UpdateBufferType::New(); }
+  DenseFiniteDifferenceImageFilter();
   ~DenseFiniteDifferenceImageFilter() {}
   void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
@@ -144,6 +195,26 @@ protected:
    * Superclass::GenerateData(). */
   virtual void AllocateUpdateBuffer() ITK_OVERRIDE;
 
+  /** Set/Get the number of time steps advanced in each tile before it is
+   * written back to the output.  Default is 1, which disables temporal
+   * blocking.  Subclasses that support temporal blocking make these methods
+   * public. */
+  itkSetClampMacro(NumberOfStepsPerBlock, IdentifierType, 1, NumericTraits< IdentifierType >::max());
+  itkGetConstMacro(NumberOfStepsPerBlock, IdentifierType);
+
+  /** Set/Get the number of pixels of the temporal blocking tiles along each
+   * dimension, without their halo.  Default is 32. */
+  itkSetMacro(BlockTileSize, SizeValueType);
+  itkGetConstMacro(BlockTileSize, SizeValueType);
+
+  /** Halts when active tiles are used and no tile is active anymore, or
+   * when the superclass halts. */
+  virtual bool Halt() ITK_OVERRIDE;
+
+  /** Returns true when active tiles are used and none of them is active:
+   * further iterations would not change the output. */
+  bool AllActiveTilesConverged() const;
+
   /** The type of region used for multithreading */
   typedef typename UpdateBufferType::RegionType ThreadRegionType;
 
@@ -184,8 +255,72 @@ private:
    * which it then passes to ThreadedCalculateChange for processing. */
   static ITK_THREAD_RETURN_TYPE CalculateChangeThreaderCallback(void *arg);
 
+  /** These callback methods distribute the tiles between the threads when
+   * active tiles are used. */
+  static ITK_THREAD_RETURN_TYPE ApplyUpdateActiveTilesThreaderCallback(void *arg);
+  static ITK_THREAD_RETURN_TYPE CalculateChangeActiveTilesThreaderCallback(void *arg);
+
+  /** These callback methods advance the tiles by several time steps into the
+   * update buffer, and copy the update buffer to the output, when temporal
+   * blocking is used. */
+  static ITK_THREAD_RETURN_TYPE ApplyUpdateTemporalBlockThreaderCallback(void *arg);
+  static ITK_THREAD_RETURN_TYPE CalculateChangeTemporalBlockThreaderCallback(void *arg);
+
+  /** Advance a tile of the output by the number of steps of the current
+   * block in the scratch buffers of the thread, and write its new values to
+   * the update buffer.  Returns the smallest time step. */
+  TimeStepType ThreadedAdvanceTile(const ThreadRegionType & tileRegion,
+                                   ThreadIdType threadId);
+
+  /** Divide the requested region of the output into tiles of the given
+   * size, and return their number. */
+  SizeValueType InitializeTiles(SizeValueType tileSize);
+
+  /** Returns the region of the tile with the given linear index. */
+  ThreadRegionType GetTileRegion(SizeValueType tile) const;
+
+  /** Divide the requested region of the output into tiles, all active. */
+  void InitializeActiveTiles();
+
+  /** Activate the tiles whose neighborhood changed in the last update. */
+  void UpdateActiveTiles();
+
+  /** Returns the largest absolute value of the components of a pixel. */
+  static double GetMaximumAbsoluteComponent(const PixelType & pixel);
+
   /** The buffer that holds the updates for an iteration of the algorithm. */
   typename UpdateBufferType::Pointer m_UpdateBuffer;
+
+  bool          m_UseActiveTiles;
+  SizeValueType m_ActiveTileSize;
+  double        m_ActiveTileTolerance;
+  SizeValueType m_NumberOfActiveTiles;
+
+  /** The region divided into tiles, the size of the tiles, the number of
+   * tiles along each dimension, and the number of tiles whose pixels are in
+   * the neighborhood of the pixels of an active tile along each dimension. */
+  ThreadRegionType                    m_TilesRegion;
+  SizeValueType                       m_TileSize;
+  typename ThreadRegionType::SizeType m_NumberOfTiles;
+  typename ThreadRegionType::SizeType m_ActiveTileReach;
+
+  /** Whether each tile is recomputed in the next iteration, and the largest
+   * change of each tile in the last update. */
+  std::vector< bool >   m_ActiveTiles;
+  std::vector< double > m_TileChanges;
+
+  IdentifierType m_NumberOfStepsPerBlock;
+  SizeValueType  m_BlockTileSize;
+
+  /** The number of time steps of the current block, or zero when temporal
+   * blocking is not used. */
+  IdentifierType m_NumberOfStepsInBlock;
+
+  /** The scratch buffers of each thread in which the tiles are advanced.
+   * They are allocated for the largest padded tile and reused by all the
+   * tiles of the thread. */
+  std::vector< typename OutputImageType::Pointer >  m_TileValues;
+  std::vector< typename UpdateBufferType::Pointer > m_TileUpdates;
 };
 } // end namespace itk
 
@@ -20,12 +20,31 @@
 #include "itkDenseFiniteDifferenceImageFilter.h"
 
 #include <list>
+#include <algorithm>
 #include "itkImageRegionIterator.h"
 #include "itkNumericTraits.h"
 #include "itkNeighborhoodAlgorithm.h"
+#include "itkDefaultConvertPixelTraits.h"
 
 namespace itk
 {
+template< typename TInputImage, typename TOutputImage >
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::DenseFiniteDifferenceImageFilter() :
+  m_UseActiveTiles(false),
+  m_ActiveTileSize(16),
+  m_ActiveTileTolerance(0.0),
+  m_NumberOfActiveTiles(0),
+  m_TileSize(0),
+  m_NumberOfStepsPerBlock(1),
+  m_BlockTileSize(32),
+  m_NumberOfStepsInBlock(0)
+{
+  m_UpdateBuffer = UpdateBufferType::New();
+  m_NumberOfTiles.Fill(0);
+  m_ActiveTileReach.Fill(0);
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
@@ -91,11 +110,35 @@ DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
   str.Filter = this;
   str.TimeStep = dt;
   this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
-  this->GetMultiThreader()->SetSingleMethod(this->ApplyUpdateThreaderCallback,
-                                            &str);
+  const bool useActiveTiles = m_UseActiveTiles && !m_ActiveTiles.empty();
+  if ( m_NumberOfStepsInBlock > 0 )
+    {
+    this->GetMultiThreader()->SetSingleMethod(this->ApplyUpdateTemporalBlockThreaderCallback,
+                                              &str);
+    }
+  else if ( useActiveTiles )
+    {
+    this->GetMultiThreader()->SetSingleMethod(this->ApplyUpdateActiveTilesThreaderCallback,
+                                              &str);
+    }
+  else
+    {
+    this->GetMultiThreader()->SetSingleMethod(this->ApplyUpdateThreaderCallback,
+                                              &str);
+    }
   // Multithread the execution
   this->GetMultiThreader()->SingleMethodExecute();
 
+  if ( m_NumberOfStepsInBlock > 0 )
+    {
+    // The superclass counts one iteration for the whole block.
+    this->SetElapsedIterations( this->GetElapsedIterations() + m_NumberOfStepsInBlock - 1 );
+    }
+  else if ( useActiveTiles )
+    {
+    this->UpdateActiveTiles();
+    }
+
   // Explicitely call Modified on GetOutput here
   // since ThreadedApplyUpdate changes this buffer
   // through iterators which do not increment the
@@ -129,6 +172,40 @@ DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
   return ITK_THREAD_RETURN_VALUE;
 }
 
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::ApplyUpdateActiveTilesThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  DenseFDThreadStruct* str = (DenseFDThreadStruct *)
+      ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+  DenseFiniteDifferenceImageFilter *filter = str->Filter;
+
+  // All the tiles are updated, since the update buffer of the inactive tiles
+  // may have been modified by a subclass.  Each tile is processed by a
+  // single thread, which records its change.
+  const double timeStepMagnitude = std::abs( static_cast< double >( str->TimeStep ) );
+  const SizeValueType numberOfTiles = static_cast< SizeValueType >( filter->m_ActiveTiles.size() );
+  for ( SizeValueType tile = threadId; tile < numberOfTiles; tile += threadCount )
+    {
+    const ThreadRegionType tileRegion = filter->GetTileRegion(tile);
+    filter->ThreadedApplyUpdate(str->TimeStep, tileRegion, threadId);
+
+    double change = 0.0;
+    ImageRegionConstIterator< UpdateBufferType > u(filter->m_UpdateBuffer, tileRegion);
+    for ( u.GoToBegin(); !u.IsAtEnd(); ++u )
+      {
+      change = std::max( change, GetMaximumAbsoluteComponent( u.Get() ) );
+      }
+    filter->m_TileChanges[tile] = change * timeStepMagnitude;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template< typename TInputImage, typename TOutputImage >
 typename
 DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >::TimeStepType
@@ -142,8 +219,53 @@ DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
   str.TimeStep = NumericTraits< TimeStepType >::ZeroValue();  // Not used during the
   // calculate change step.
   this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
-  this->GetMultiThreader()->SetSingleMethod(this->CalculateChangeThreaderCallback,
-                                            &str);
+  m_NumberOfStepsInBlock = 0;
+  if ( m_NumberOfStepsPerBlock > 1 )
+    {
+    if ( m_UseActiveTiles )
+      {
+      itkExceptionMacro(<< "Active tiles cannot be used with temporal blocking.");
+      }
+    this->InitializeTiles(m_BlockTileSize);
+
+    // The block does not go past the number of iterations, so that the
+    // halting criteria of the subclasses are met.
+    m_NumberOfStepsInBlock = m_NumberOfStepsPerBlock;
+    if ( this->GetNumberOfIterations() > this->GetElapsedIterations() )
+      {
+      m_NumberOfStepsInBlock = std::min( m_NumberOfStepsInBlock,
+                                         this->GetNumberOfIterations() - this->GetElapsedIterations() );
+      }
+
+    // The scratch buffers are kept from one block to the next.
+    const ThreadIdType numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+    if ( m_TileValues.size() != numberOfThreads )
+      {
+      m_TileValues.resize(numberOfThreads);
+      m_TileUpdates.resize(numberOfThreads);
+      for ( ThreadIdType i = 0; i < numberOfThreads; i++ )
+        {
+        m_TileValues[i] = OutputImageType::New();
+        m_TileUpdates[i] = UpdateBufferType::New();
+        }
+      }
+    this->GetMultiThreader()->SetSingleMethod(this->CalculateChangeTemporalBlockThreaderCallback,
+                                              &str);
+    }
+  else if ( m_UseActiveTiles )
+    {
+    if ( this->GetElapsedIterations() == 0 || m_ActiveTiles.empty() )
+      {
+      this->InitializeActiveTiles();
+      }
+    this->GetMultiThreader()->SetSingleMethod(this->CalculateChangeActiveTilesThreaderCallback,
+                                              &str);
+    }
+  else
+    {
+    this->GetMultiThreader()->SetSingleMethod(this->CalculateChangeThreaderCallback,
+                                              &str);
+    }
 
   // Initialize the list of time step values that will be generated by the
   // various threads.  There is one distinct slot for each possible thread,
@@ -159,9 +281,13 @@ DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
   // Multithread the execution
   this->GetMultiThreader()->SingleMethodExecute();
 
-  // Resolve the single value time step to return
-  TimeStepType dt = this->ResolveTimeStep( str.TimeStepList,
-                                           str.ValidTimeStepList );
+  // Resolve the single value time step to return.  When no tile is active,
+  // the update is zero and the time step does not matter.
+  TimeStepType dt = NumericTraits< TimeStepType >::ZeroValue();
+  if ( m_NumberOfStepsInBlock > 0 || !m_UseActiveTiles || m_NumberOfActiveTiles > 0 )
+    {
+    dt = this->ResolveTimeStep( str.TimeStepList, str.ValidTimeStepList );
+    }
 
   // Explicitely call Modified on m_UpdateBuffer here
   // since ThreadedCalculateChange changes this buffer
@@ -202,6 +328,387 @@ DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
   return ITK_THREAD_RETURN_VALUE;
 }
 
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::CalculateChangeActiveTilesThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  DenseFDThreadStruct * str = (DenseFDThreadStruct *)
+      ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+  DenseFiniteDifferenceImageFilter *filter = str->Filter;
+
+  // The change of the active tiles is calculated, and the update of the
+  // inactive tiles is zero.  The time step of the thread is the smallest
+  // time step of its tiles.
+  const SizeValueType numberOfTiles = static_cast< SizeValueType >( filter->m_ActiveTiles.size() );
+  for ( SizeValueType tile = threadId; tile < numberOfTiles; tile += threadCount )
+    {
+    const ThreadRegionType tileRegion = filter->GetTileRegion(tile);
+    if ( filter->m_ActiveTiles[tile] )
+      {
+      const TimeStepType timeStep = filter->ThreadedCalculateChange(tileRegion, threadId);
+      if ( !str->ValidTimeStepList[threadId] || timeStep < str->TimeStepList[threadId] )
+        {
+        str->TimeStepList[threadId] = timeStep;
+        }
+      str->ValidTimeStepList[threadId] = true;
+      }
+    else
+      {
+      ImageRegionIterator< UpdateBufferType > u(filter->m_UpdateBuffer, tileRegion);
+      for ( u.GoToBegin(); !u.IsAtEnd(); ++u )
+        {
+        u.Set( NumericTraits< PixelType >::ZeroValue() );
+        }
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::CalculateChangeTemporalBlockThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  DenseFDThreadStruct * str = (DenseFDThreadStruct *)
+      ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+  DenseFiniteDifferenceImageFilter *filter = str->Filter;
+
+  SizeValueType numberOfTiles = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    numberOfTiles *= filter->m_NumberOfTiles[d];
+    }
+
+  if ( static_cast< SizeValueType >( threadId ) >= numberOfTiles )
+    {
+    return ITK_THREAD_RETURN_VALUE;
+    }
+
+  // The scratch buffers of the thread are allocated once for the largest
+  // padded tile, so that the tiles reuse their memory.
+  const OutputImageType *output = filter->GetOutput();
+  const typename OutputImageType::SizeType radius = filter->GetDifferenceFunction()->GetRadius();
+  ThreadRegionType largestRegion = output->GetBufferedRegion();
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    const SizeValueType paddedSize = filter->m_TileSize + 2 * radius[d] * filter->m_NumberOfStepsInBlock;
+    largestRegion.SetSize( d, std::min( paddedSize, largestRegion.GetSize(d) ) );
+    }
+  OutputImageType * values = filter->m_TileValues[threadId];
+  values->SetOrigin( output->GetOrigin() );
+  values->SetSpacing( output->GetSpacing() );
+  values->SetDirection( output->GetDirection() );
+  values->SetRegions(largestRegion);
+  values->Allocate();
+
+  UpdateBufferType * updates = filter->m_TileUpdates[threadId];
+  updates->CopyInformation(values);
+  updates->SetRegions(largestRegion);
+  updates->Allocate();
+
+  // The time step of the thread is the smallest time step of its tiles.
+  for ( SizeValueType tile = threadId; tile < numberOfTiles; tile += threadCount )
+    {
+    const TimeStepType timeStep = filter->ThreadedAdvanceTile( filter->GetTileRegion(tile), threadId );
+    if ( !str->ValidTimeStepList[threadId] || timeStep < str->TimeStepList[threadId] )
+      {
+      str->TimeStepList[threadId] = timeStep;
+      }
+    str->ValidTimeStepList[threadId] = true;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage >
+ITK_THREAD_RETURN_TYPE
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::ApplyUpdateTemporalBlockThreaderCallback(void *arg)
+{
+  ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  DenseFDThreadStruct* str = (DenseFDThreadStruct *)
+      ( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  // The update buffer holds the new values of the output.
+  ThreadRegionType splitRegion;
+  ThreadIdType total = str->Filter->SplitRequestedRegion(threadId, threadCount,
+                                            splitRegion);
+
+  if ( threadId < total )
+    {
+    ImageRegionConstIterator< UpdateBufferType > u(str->Filter->m_UpdateBuffer, splitRegion);
+    ImageRegionIterator< OutputImageType >       o(str->Filter->GetOutput(), splitRegion);
+    for ( ; !u.IsAtEnd(); ++u, ++o )
+      {
+      o.Set( u.Get() );
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >::TimeStepType
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::ThreadedAdvanceTile(const ThreadRegionType & tileRegion, ThreadIdType threadId)
+{
+  typedef typename OutputImageType::SizeType                      SizeType;
+  typedef typename FiniteDifferenceFunctionType::NeighborhoodType NeighborhoodIteratorType;
+
+  typedef NeighborhoodAlgorithm::ImageBoundaryFacesCalculator< OutputImageType >
+  FaceCalculatorType;
+
+  typedef typename FaceCalculatorType::FaceListType FaceListType;
+
+  const OutputImageType *output = this->GetOutput();
+
+  const typename FiniteDifferenceFunctionType::Pointer
+      df = this->GetDifferenceFunction();
+
+  const SizeType radius = df->GetRadius();
+
+  // Information travels by the radius of the function at each time step, so
+  // the tile is copied with a halo of the radius times the number of steps.
+  // The halo is cropped at the boundary of the output, where the boundary
+  // conditions of the local buffer are those of the output.
+  SizeType halo;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    halo[d] = radius[d] * m_NumberOfStepsInBlock;
+    }
+  ThreadRegionType blockRegion = tileRegion;
+  blockRegion.PadByRadius(halo);
+  blockRegion.Crop( output->GetBufferedRegion() );
+
+  // The scratch buffers are large enough for any tile: allocating them only
+  // changes their regions.
+  OutputImageType * values = m_TileValues[threadId];
+  values->SetRegions(blockRegion);
+  values->Allocate();
+
+  UpdateBufferType * updates = m_TileUpdates[threadId];
+  updates->SetRegions(blockRegion);
+  updates->Allocate();
+
+  ImageRegionConstIterator< OutputImageType > in(output, blockRegion);
+  ImageRegionIterator< OutputImageType >      local(values, blockRegion);
+  for ( ; !in.IsAtEnd(); ++in, ++local )
+    {
+    local.Set( in.Get() );
+    }
+
+  // Each step computes the pixels that are still exact at the end of the
+  // block, which shrink by the radius towards the tile.  As in the dense
+  // iteration, the pixels outside of the requested region are not updated.
+  TimeStepType minimumTimeStep = NumericTraits< TimeStepType >::ZeroValue();
+  FaceCalculatorType faceCalculator;
+  for ( IdentifierType step = 0; step < m_NumberOfStepsInBlock; step++ )
+    {
+    SizeType margin;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      margin[d] = radius[d] * ( m_NumberOfStepsInBlock - 1 - step );
+      }
+    ThreadRegionType stepRegion = tileRegion;
+    stepRegion.PadByRadius(margin);
+    stepRegion.Crop(m_TilesRegion);
+
+    void * globalData = df->GetGlobalDataPointer();
+
+    FaceListType faceList = faceCalculator(values, stepRegion, radius);
+    for ( typename FaceListType::iterator fIt = faceList.begin(); fIt != faceList.end(); ++fIt )
+      {
+      NeighborhoodIteratorType              nD(radius, values, *fIt);
+      ImageRegionIterator< UpdateBufferType > nU(updates, *fIt);
+      for ( nD.GoToBegin(); !nD.IsAtEnd(); ++nD, ++nU )
+        {
+        nU.Value() = df->ComputeUpdate(nD, globalData);
+        }
+      }
+
+    const TimeStepType timeStep = df->ComputeGlobalTimeStep(globalData);
+    df->ReleaseGlobalDataPointer(globalData);
+    if ( step == 0 || timeStep < minimumTimeStep )
+      {
+      minimumTimeStep = timeStep;
+      }
+
+    ImageRegionIterator< UpdateBufferType > u(updates, stepRegion);
+    ImageRegionIterator< OutputImageType >  o(values, stepRegion);
+    for ( ; !u.IsAtEnd(); ++u, ++o )
+      {
+      o.Value() += static_cast< PixelType >( u.Value() * timeStep );
+      }
+    }
+
+  ImageRegionConstIterator< OutputImageType > result(values, tileRegion);
+  ImageRegionIterator< UpdateBufferType >     out(m_UpdateBuffer, tileRegion);
+  for ( ; !result.IsAtEnd(); ++result, ++out )
+    {
+    out.Set( result.Get() );
+    }
+
+  return minimumTimeStep;
+}
+
+template< typename TInputImage, typename TOutputImage >
+SizeValueType
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::InitializeTiles(SizeValueType tileSize)
+{
+  if ( tileSize == 0 )
+    {
+    itkExceptionMacro(<< "The size of the tiles must be positive.");
+    }
+
+  m_TilesRegion = this->GetOutput()->GetRequestedRegion();
+  m_TileSize = tileSize;
+
+  SizeValueType numberOfTiles = 1;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    m_NumberOfTiles[d] = ( m_TilesRegion.GetSize(d) + m_TileSize - 1 ) / m_TileSize;
+    numberOfTiles *= m_NumberOfTiles[d];
+    }
+  return numberOfTiles;
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >::ThreadRegionType
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::GetTileRegion(SizeValueType tile) const
+{
+  ThreadRegionType tileRegion;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    const SizeValueType position = tile % m_NumberOfTiles[d];
+    tile /= m_NumberOfTiles[d];
+    const SizeValueType start = position * m_TileSize;
+    tileRegion.SetIndex( d, m_TilesRegion.GetIndex(d) + static_cast< OffsetValueType >( start ) );
+    tileRegion.SetSize( d, std::min( m_TileSize, m_TilesRegion.GetSize(d) - start ) );
+    }
+  return tileRegion;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::InitializeActiveTiles()
+{
+  const SizeValueType numberOfTiles = this->InitializeTiles(m_ActiveTileSize);
+
+  const typename FiniteDifferenceFunctionType::RadiusType radius =
+    this->GetDifferenceFunction()->GetRadius();
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    m_ActiveTileReach[d] = ( radius[d] + m_TileSize - 1 ) / m_TileSize;
+    }
+
+  m_ActiveTiles.assign(numberOfTiles, true);
+  m_TileChanges.assign(numberOfTiles, 0.0);
+  m_NumberOfActiveTiles = numberOfTiles;
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::UpdateActiveTiles()
+{
+  const SizeValueType numberOfTiles = static_cast< SizeValueType >( m_ActiveTiles.size() );
+  std::fill(m_ActiveTiles.begin(), m_ActiveTiles.end(), false);
+
+  // Each tile that changed activates the tiles within reach of its pixels'
+  // neighborhoods, itself included.
+  for ( SizeValueType tile = 0; tile < numberOfTiles; tile++ )
+    {
+    if ( m_TileChanges[tile] <= m_ActiveTileTolerance )
+      {
+      continue;
+      }
+
+    IndexValueType first[ImageDimension];
+    SizeValueType  count[ImageDimension];
+    SizeValueType  numberOfNeighbors = 1;
+    SizeValueType  remainder = tile;
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      const IndexValueType position = static_cast< IndexValueType >( remainder % m_NumberOfTiles[d] );
+      remainder /= m_NumberOfTiles[d];
+      const IndexValueType reach = static_cast< IndexValueType >( m_ActiveTileReach[d] );
+      first[d] = std::max< IndexValueType >( 0, position - reach );
+      const IndexValueType last =
+        std::min< IndexValueType >( static_cast< IndexValueType >( m_NumberOfTiles[d] ) - 1, position + reach );
+      count[d] = static_cast< SizeValueType >( last - first[d] + 1 );
+      numberOfNeighbors *= count[d];
+      }
+
+    for ( SizeValueType neighbor = 0; neighbor < numberOfNeighbors; neighbor++ )
+      {
+      SizeValueType offset = neighbor;
+      SizeValueType linearIndex = 0;
+      SizeValueType stride = 1;
+      for ( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        linearIndex += ( static_cast< SizeValueType >( first[d] ) + offset % count[d] ) * stride;
+        offset /= count[d];
+        stride *= m_NumberOfTiles[d];
+        }
+      m_ActiveTiles[linearIndex] = true;
+      }
+    }
+
+  m_NumberOfActiveTiles = static_cast< SizeValueType >(
+    std::count(m_ActiveTiles.begin(), m_ActiveTiles.end(), true) );
+}
+
+template< typename TInputImage, typename TOutputImage >
+double
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::GetMaximumAbsoluteComponent(const PixelType & pixel)
+{
+  double maximum = 0.0;
+  const unsigned int numberOfComponents = NumericTraits< PixelType >::GetLength(pixel);
+  for ( unsigned int k = 0; k < numberOfComponents; k++ )
+    {
+    const double component =
+      static_cast< double >( DefaultConvertPixelTraits< PixelType >::GetNthComponent(k, pixel) );
+    maximum = std::max( maximum, std::abs(component) );
+    }
+  return maximum;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::AllActiveTilesConverged() const
+{
+  return m_UseActiveTiles && !m_ActiveTiles.empty()
+         && this->GetElapsedIterations() > 0 && m_NumberOfActiveTiles == 0;
+}
+
+template< typename TInputImage, typename TOutputImage >
+bool
+DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
+::Halt()
+{
+  if ( this->AllActiveTilesConverged() )
+    {
+    return true;
+    }
+  return Superclass::Halt();
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
@@ -306,6 +813,13 @@ DenseFiniteDifferenceImageFilter< TInputImage, TOutputImage >
 ::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+
+  os << indent << "UseActiveTiles: " << m_UseActiveTiles << std::endl;
+  os << indent << "ActiveTileSize: " << m_ActiveTileSize << std::endl;
+  os << indent << "ActiveTileTolerance: " << m_ActiveTileTolerance << std::endl;
+  os << indent << "NumberOfActiveTiles: " << m_NumberOfActiveTiles << std::endl;
+  os << indent << "NumberOfStepsPerBlock: " << m_NumberOfStepsPerBlock << std::endl;
+  os << indent << "BlockTileSize: " << m_BlockTileSize << std::endl;
 }
 } // end namespace itk
 
@@ -61,6 +61,13 @@ namespace itk
  * The B spline coefficients are calculated through the
  * BSplineDecompositionImageFilter
  *
+ * The methods that are not given a thread id evaluate the spline with
+ * working space of fixed size on the stack, and sum the coefficients
+ * directly from the buffer of the coefficient image, separably along the
+ * first dimension. EvaluateAtContinuousIndices() additionally reuses the
+ * weights of the dimensions other than the first between consecutive
+ * positions that share them, as along the scanlines of a resampled image.
+ *
  * Limitations:  Spline order must be between 0 and 5.
  *               Spline order must be set before setting the image.
  *               Uses mirror boundary conditions.
@@ -133,6 +140,12 @@ public:
                            itkGetStaticConstMacro(ImageDimension) >
   CovariantVectorType;
 
+  /** Offset in the buffer of the coefficient image. */
+  typedef typename CoefficientImageType::OffsetValueType OffsetValueType;
+
+  /** Highest supported spline order. */
+  itkStaticConstMacro(MaximumSplineOrder, unsigned int, 5);
+
   /** Evaluate the function at a ContinuousIndex position.
    *
    * Returns the B-Spline interpolated image intensity at a
@@ -165,21 +178,23 @@ public:
                                                index) const ITK_OVERRIDE
   {
     // Don't know thread information, make evaluateIndex, weights on the stack.
-    // Slower, but safer.
-    vnl_matrix< long >   evaluateIndex( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weights( ImageDimension, ( m_SplineOrder + 1 ) );
-
-    // Pass evaluateIndex, weights by reference. They're only good as long
-    // as this method is in scope.
-    return this->EvaluateAtContinuousIndexInternal(index,
-                                                   evaluateIndex,
-                                                   weights);
+    long   evaluateIndex[ImageDimension][MaximumSplineOrder + 1];
+    double weights[ImageDimension][MaximumSplineOrder + 1];
+
+    return this->InterpolateAtContinuousIndex(index, evaluateIndex, weights);
   }
 
   virtual OutputType EvaluateAtContinuousIndex(const ContinuousIndexType &
                                                index,
                                                ThreadIdType threadId) const;
 
+  /** Evaluate the spline at an array of continuous index positions. The
+   * weights along the dimensions other than the first are computed again
+   * only when these coordinates change from a position to the next. */
+  virtual void EvaluateAtContinuousIndices(const ContinuousIndexType *indices,
+                                           OutputType *values,
+                                           SizeValueType numberOfIndices) const ITK_OVERRIDE;
+
   CovariantVectorType EvaluateDerivative(const PointType & point) const
   {
     ContinuousIndexType index;
@@ -204,20 +219,16 @@ public:
     const ContinuousIndexType & x) const
   {
     // Don't know thread information, make evaluateIndex, weights,
-    // weightsDerivative
-    // on the stack.
-    // Slower, but safer.
-    vnl_matrix< long >   evaluateIndex( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weights( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weightsDerivative( ImageDimension, ( m_SplineOrder + 1 ) );
-
-    // Pass evaluateIndex, weights, weightsDerivative by reference. They're only
-    // good
-    // as long as this method is in scope.
-    return this->EvaluateDerivativeAtContinuousIndexInternal(x,
-                                                             evaluateIndex,
-                                                             weights,
-                                                             weightsDerivative);
+    // weightsDerivative on the stack.
+    long   evaluateIndex[ImageDimension][MaximumSplineOrder + 1];
+    double weights[ImageDimension][MaximumSplineOrder + 1];
+    double weightsDerivative[ImageDimension][MaximumSplineOrder + 1];
+
+    OutputType          value;
+    CovariantVectorType derivativeValue;
+    this->InterpolateValueAndDerivativeAtContinuousIndex(x, value, derivativeValue,
+                                                         evaluateIndex, weights, weightsDerivative);
+    return derivativeValue;
   }
 
   CovariantVectorType EvaluateDerivativeAtContinuousIndex(
@@ -261,22 +272,13 @@ public:
     ) const
   {
     // Don't know thread information, make evaluateIndex, weights,
-    // weightsDerivative
-    // on the stack.
-    // Slower, but safer.
-    vnl_matrix< long >   evaluateIndex( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weights( ImageDimension, ( m_SplineOrder + 1 ) );
-    vnl_matrix< double > weightsDerivative( ImageDimension, ( m_SplineOrder + 1 ) );
-
-    // Pass evaluateIndex, weights, weightsDerivative by reference. They're only
-    // good
-    // as long as this method is in scope.
-    this->EvaluateValueAndDerivativeAtContinuousIndexInternal(x,
-                                                              value,
-                                                              deriv,
-                                                              evaluateIndex,
-                                                              weights,
-                                                              weightsDerivative);
+    // weightsDerivative on the stack.
+    long   evaluateIndex[ImageDimension][MaximumSplineOrder + 1];
+    double weights[ImageDimension][MaximumSplineOrder + 1];
+    double weightsDerivative[ImageDimension][MaximumSplineOrder + 1];
+
+    this->InterpolateValueAndDerivativeAtContinuousIndex(x, value, deriv,
+                                                         evaluateIndex, weights, weightsDerivative);
   }
 
   void EvaluateValueAndDerivativeAtContinuousIndex(
@@ -368,16 +370,39 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(BSplineInterpolateImageFunction);
 
+  /** Evaluate the spline with the working space given, which is either
+   * made of vnl_matrix or of fixed size arrays. */
+  template< typename TIndexMatrix, typename TWeightMatrix >
+  OutputType InterpolateAtContinuousIndex(const ContinuousIndexType & x,
+                                          TIndexMatrix & evaluateIndex,
+                                          TWeightMatrix & weights) const;
+
+  template< typename TIndexMatrix, typename TWeightMatrix >
+  void InterpolateValueAndDerivativeAtContinuousIndex(const ContinuousIndexType & x,
+                                                      OutputType & value,
+                                                      CovariantVectorType & derivativeValue,
+                                                      TIndexMatrix & evaluateIndex,
+                                                      TWeightMatrix & weights,
+                                                      TWeightMatrix & weightsDerivative) const;
+
+  /** Offsets in the buffer of the coefficient image of the indices of the
+   * region of support, per dimension. */
+  template< typename TIndexMatrix >
+  void ComputeCoefficientOffsets(const TIndexMatrix & evaluateIndex,
+                                 OffsetValueType offsets[][MaximumSplineOrder + 1]) const;
+
   /** Determines the weights for interpolation of the value x */
+  template< typename TIndexMatrix, typename TWeightMatrix >
   void SetInterpolationWeights(const ContinuousIndexType & x,
-                               const vnl_matrix< long > & EvaluateIndex,
-                               vnl_matrix< double > & weights,
+                               const TIndexMatrix & EvaluateIndex,
+                               TWeightMatrix & weights,
                                unsigned int splineOrder) const;
 
   /** Determines the weights for the derivative portion of the value x */
+  template< typename TIndexMatrix, typename TWeightMatrix >
   void SetDerivativeWeights(const ContinuousIndexType & x,
-                            const vnl_matrix< long > & EvaluateIndex,
-                            vnl_matrix< double > & weights,
+                            const TIndexMatrix & EvaluateIndex,
+                            TWeightMatrix & weights,
                             unsigned int splineOrder) const;
 
   /** Precomputation for converting the 1D index of the interpolation
@@ -385,13 +410,15 @@ private:
   void GeneratePointsToIndex();
 
   /** Determines the indices to use give the splines region of support */
-  void DetermineRegionOfSupport(vnl_matrix< long > & evaluateIndex,
+  template< typename TIndexMatrix >
+  void DetermineRegionOfSupport(TIndexMatrix & evaluateIndex,
                                 const ContinuousIndexType & x,
                                 unsigned int splineOrder) const;
 
   /** Set the indices in evaluateIndex at the boundaries based on mirror
     * boundary conditions. */
-  void ApplyMirrorBoundaryConditions(vnl_matrix< long > & evaluateIndex,
+  template< typename TIndexMatrix >
+  void ApplyMirrorBoundaryConditions(TIndexMatrix & evaluateIndex,
                                      unsigned int splineOrder) const;
 
   Iterator m_CIterator;                                    // Iterator for
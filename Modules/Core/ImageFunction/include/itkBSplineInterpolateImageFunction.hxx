@@ -124,8 +124,10 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
     {
     return;
     }
-  m_SplineOrder = SplineOrder;
+  // The coefficient filter rejects the orders that are not supported, so
+  // set it first.
   m_CoefficientFilter->SetSplineOrder(SplineOrder);
+  m_SplineOrder = SplineOrder;
 
   //this->SetPoles();
   m_MaxNumberInterpolationPoints = 1;
@@ -379,11 +381,12 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix, typename TWeightMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::SetInterpolationWeights(const ContinuousIndexType & x,
-                          const vnl_matrix< long > & EvaluateIndex,
-                          vnl_matrix< double > & weights,
+                          const TIndexMatrix & EvaluateIndex,
+                          TWeightMatrix & weights,
                           unsigned int splineOrder) const
 {
   // For speed improvements we could make each case a separate function and use
@@ -492,11 +495,12 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix, typename TWeightMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::SetDerivativeWeights(const ContinuousIndexType & x,
-                       const vnl_matrix< long > & EvaluateIndex,
-                       vnl_matrix< double > & weights,
+                       const TIndexMatrix & EvaluateIndex,
+                       TWeightMatrix & weights,
                        unsigned int splineOrder) const
 {
   // For speed improvements we could make each case a separate function and use
@@ -658,9 +662,10 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::DetermineRegionOfSupport(vnl_matrix< long > & evaluateIndex,
+::DetermineRegionOfSupport(TIndexMatrix & evaluateIndex,
                            const ContinuousIndexType & x,
                            unsigned int splineOrder) const
 {
@@ -676,9 +681,10 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 }
 
 template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::ApplyMirrorBoundaryConditions(vnl_matrix< long > & evaluateIndex,
+::ApplyMirrorBoundaryConditions(TIndexMatrix & evaluateIndex,
                                 unsigned int splineOrder) const
 {
   const IndexType startIndex = this->GetStartIndex();
@@ -722,6 +728,72 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::EvaluateAtContinuousIndexInternal(const ContinuousIndexType & x,
                                     vnl_matrix< long > & evaluateIndex,
                                     vnl_matrix< double > & weights) const
+{
+  return this->InterpolateAtContinuousIndex(x, evaluateIndex, weights);
+}
+
+template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateValueAndDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
+                                                      OutputType & value,
+                                                      CovariantVectorType & derivativeValue,
+                                                      vnl_matrix< long > & evaluateIndex,
+                                                      vnl_matrix< double > & weights,
+                                                      vnl_matrix< double > & weightsDerivative
+                                                      ) const
+{
+  this->InterpolateValueAndDerivativeAtContinuousIndex(x, value, derivativeValue,
+                                                       evaluateIndex, weights, weightsDerivative);
+}
+
+template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::CovariantVectorType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::EvaluateDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
+                                              vnl_matrix< long > & evaluateIndex,
+                                              vnl_matrix< double > & weights,
+                                              vnl_matrix< double > & weightsDerivative
+                                              ) const
+{
+  OutputType          value;
+  CovariantVectorType derivativeValue;
+  this->InterpolateValueAndDerivativeAtContinuousIndex(x, value, derivativeValue,
+                                                       evaluateIndex, weights, weightsDerivative);
+  return derivativeValue;
+}
+
+template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ComputeCoefficientOffsets(const TIndexMatrix & evaluateIndex,
+                            OffsetValueType offsets[][MaximumSplineOrder + 1]) const
+{
+  // Same pixels as m_Coefficients->GetPixel(), without the function call.
+  const IndexType &       bufferStart = m_Coefficients->GetBufferedRegion().GetIndex();
+  const OffsetValueType * offsetTable = m_Coefficients->GetOffsetTable();
+
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
+    {
+    for ( unsigned int k = 0; k <= m_SplineOrder; k++ )
+      {
+      offsets[n][k] = ( evaluateIndex[n][k] - bufferStart[n] ) * offsetTable[n];
+      }
+    }
+}
+
+template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix, typename TWeightMatrix >
+typename
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::OutputType
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::InterpolateAtContinuousIndex(const ContinuousIndexType & x,
+                               TIndexMatrix & evaluateIndex,
+                               TWeightMatrix & weights) const
 {
   // compute the interpolation indexes
   this->DetermineRegionOfSupport( ( evaluateIndex ), x, m_SplineOrder );
@@ -732,35 +804,46 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
   // Modify evaluateIndex at the boundaries using mirror boundary conditions
   this->ApplyMirrorBoundaryConditions( ( evaluateIndex ), m_SplineOrder );
 
-  // perform interpolation
-  double    interpolated = 0.0;
-  IndexType coefficientIndex;
-  // Step through eachpoint in the N-dimensional interpolation cube.
-  for ( unsigned int p = 0; p < m_MaxNumberInterpolationPoints; p++ )
+  OffsetValueType offsets[ImageDimension][MaximumSplineOrder + 1];
+  this->ComputeCoefficientOffsets(evaluateIndex, offsets);
+
+  // perform interpolation, summing along the first dimension for each
+  // point of the interpolation cube in the other dimensions.
+  const CoefficientDataType *coefficients = m_Coefficients->GetBufferPointer();
+  const unsigned int         support = m_SplineOrder + 1;
+  double                     interpolated = 0.0;
+  for ( unsigned int p = 0; p < m_MaxNumberInterpolationPoints; p += support )
     {
-    double w = 1.0;
-    for ( unsigned int n = 0; n < ImageDimension; n++ )
+    double          w = 1.0;
+    OffsetValueType offset = 0;
+    for ( unsigned int n = 1; n < ImageDimension; n++ )
       {
-      unsigned int indx = m_PointsToIndex[p][n];
-      w *= ( weights )[n][indx];
-      coefficientIndex[n] = ( evaluateIndex )[n][indx];
+      const unsigned int indx = m_PointsToIndex[p][n];
+      w *= weights[n][indx];
+      offset += offsets[n][indx];
       }
-    interpolated += w * m_Coefficients->GetPixel(coefficientIndex);
+    const CoefficientDataType *line = coefficients + offset;
+    double                     lineValue = 0.0;
+    for ( unsigned int k = 0; k < support; k++ )
+      {
+      lineValue += weights[0][k] * line[offsets[0][k]];
+      }
+    interpolated += w * lineValue;
     }
 
   return ( interpolated );
 }
 
 template< typename TImageType, typename TCoordRep, typename TCoefficientType >
+template< typename TIndexMatrix, typename TWeightMatrix >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::EvaluateValueAndDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
-                                                      OutputType & value,
-                                                      CovariantVectorType & derivativeValue,
-                                                      vnl_matrix< long > & evaluateIndex,
-                                                      vnl_matrix< double > & weights,
-                                                      vnl_matrix< double > & weightsDerivative
-                                                      ) const
+::InterpolateValueAndDerivativeAtContinuousIndex(const ContinuousIndexType & x,
+                                                 OutputType & value,
+                                                 CovariantVectorType & derivativeValue,
+                                                 TIndexMatrix & evaluateIndex,
+                                                 TWeightMatrix & weights,
+                                                 TWeightMatrix & weightsDerivative) const
 {
   this->DetermineRegionOfSupport( ( evaluateIndex ), x, m_SplineOrder );
 
@@ -774,57 +857,62 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
   // Modify EvaluateIndex at the boundaries using mirror boundary conditions
   this->ApplyMirrorBoundaryConditions( ( evaluateIndex ), m_SplineOrder );
 
-  unsigned int indx;
-  double       tmpV;
-  double       w, w1, tmpW;
-  IndexType    coefficientIndex;
-  value = 0.0;
-  unsigned int p, n, n1;
-  derivativeValue[0] = 0.0;
-  for ( p = 0; p < m_MaxNumberInterpolationPoints; p++ )
+  OffsetValueType offsets[ImageDimension][MaximumSplineOrder + 1];
+  this->ComputeCoefficientOffsets(evaluateIndex, offsets);
+
+  // The value and the derivatives along each dimension share the sums
+  // along the first dimension.
+  const CoefficientDataType *coefficients = m_Coefficients->GetBufferPointer();
+  const unsigned int         support = m_SplineOrder + 1;
+  double                     interpolated = 0.0;
+  double                     derivative[ImageDimension];
+  double                     derivativeWeight[ImageDimension];
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
     {
-    indx = m_PointsToIndex[p][0];
-    coefficientIndex[0] = ( evaluateIndex )[0][indx];
-    w = ( weights )[0][indx];
-    w1 = ( weightsDerivative )[0][indx];
-    for ( n = 1; n < ImageDimension; n++ )
-      {
-      indx = m_PointsToIndex[p][n];
-      coefficientIndex[n] = ( evaluateIndex )[n][indx];
-      tmpW = ( weights )[n][indx];
-      w *= tmpW;
-      w1 *= tmpW;
-      }
-    tmpV = m_Coefficients->GetPixel(coefficientIndex);
-    value += w * tmpV;
-    derivativeValue[0] += w1 * tmpV;
+    derivative[n] = 0.0;
     }
-  derivativeValue[0] /= this->GetInputImage()->GetSpacing()[0];
-  for ( n = 1; n < ImageDimension; n++ )
+  for ( unsigned int p = 0; p < m_MaxNumberInterpolationPoints; p += support )
     {
-    derivativeValue[n] = 0.0;
-    for ( p = 0; p < m_MaxNumberInterpolationPoints; p++ )
+    double          w = 1.0;
+    OffsetValueType offset = 0;
+    for ( unsigned int n = 1; n < ImageDimension; n++ )
       {
-      w1 = 1.0;
-      for ( n1 = 0; n1 < ImageDimension; n1++ )
+      derivativeWeight[n] = 1.0;
+      }
+    for ( unsigned int n = 1; n < ImageDimension; n++ )
+      {
+      const unsigned int indx = m_PointsToIndex[p][n];
+      const double       tmpW = weights[n][indx];
+      for ( unsigned int n1 = 1; n1 < ImageDimension; n1++ )
         {
-        indx = m_PointsToIndex[p][n1];
-        coefficientIndex[n1] = ( evaluateIndex )[n1][indx];
-
-        if ( n1 == n )
-          {
-          w1 *= ( weightsDerivative )[n1][indx];
-          }
-        else
-          {
-          w1 *= ( weights )[n1][indx];
-          }
+        derivativeWeight[n1] *= ( n1 == n ) ? weightsDerivative[n][indx] : tmpW;
         }
-      derivativeValue[n] += m_Coefficients->GetPixel(coefficientIndex)
-                            * w1;
+      w *= tmpW;
+      offset += offsets[n][indx];
+      }
+    const CoefficientDataType *line = coefficients + offset;
+    double                     lineValue = 0.0;
+    double                     lineDerivative = 0.0;
+    for ( unsigned int k = 0; k < support; k++ )
+      {
+      const double tmpV = line[offsets[0][k]];
+      lineValue += weights[0][k] * tmpV;
+      lineDerivative += weightsDerivative[0][k] * tmpV;
+      }
+    interpolated += w * lineValue;
+    derivative[0] += w * lineDerivative;
+    for ( unsigned int n = 1; n < ImageDimension; n++ )
+      {
+      derivative[n] += derivativeWeight[n] * lineValue;
       }
-    // take spacing into account
-    derivativeValue[n] /= this->GetInputImage()->GetSpacing()[n];
+    }
+
+  value = interpolated;
+  // take spacing into account
+  const typename InputImageType::SpacingType & spacing = this->GetInputImage()->GetSpacing();
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
+    {
+    derivativeValue[n] = derivative[n] / spacing[n];
     }
 
   if ( this->m_UseImageDirection )
@@ -833,73 +921,74 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
     this->GetInputImage()->TransformLocalVectorToPhysicalVector(derivativeValue, orientedDerivative);
     derivativeValue = orientedDerivative;
     }
-
 }
 
 template< typename TImageType, typename TCoordRep, typename TCoefficientType >
-typename
-BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::CovariantVectorType
+void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
-::EvaluateDerivativeAtContinuousIndexInternal(const ContinuousIndexType & x,
-                                              vnl_matrix< long > & evaluateIndex,
-                                              vnl_matrix< double > & weights,
-                                              vnl_matrix< double > & weightsDerivative
-                                              ) const
+::EvaluateAtContinuousIndices(const ContinuousIndexType *indices,
+                              OutputType *values,
+                              SizeValueType numberOfIndices) const
 {
-  this->DetermineRegionOfSupport( ( evaluateIndex ), x, m_SplineOrder );
+  long            evaluateIndex[ImageDimension][MaximumSplineOrder + 1];
+  double          weights[ImageDimension][MaximumSplineOrder + 1];
+  OffsetValueType offsets[ImageDimension][MaximumSplineOrder + 1];
 
-  SetInterpolationWeights(x, ( evaluateIndex ), ( weights ), m_SplineOrder);
+  const CoefficientDataType *coefficients = m_Coefficients->GetBufferPointer();
+  const unsigned int         support = m_SplineOrder + 1;
+  const unsigned int         numberOfLines = m_MaxNumberInterpolationPoints / support;
 
-  SetDerivativeWeights(x,
-                       ( evaluateIndex ),
-                       ( weightsDerivative ),
-                       m_SplineOrder);
+  // Weight and offset of each line of the interpolation cube along the
+  // first dimension, which depend only on the other coordinates.
+  std::vector< double >          lineWeights(numberOfLines);
+  std::vector< OffsetValueType > lineOffsets(numberOfLines);
 
-  // Modify EvaluateIndex at the boundaries using mirror boundary conditions
-  this->ApplyMirrorBoundaryConditions( ( evaluateIndex ), m_SplineOrder );
+  for ( SizeValueType i = 0; i < numberOfIndices; ++i )
+    {
+    const ContinuousIndexType & x = indices[i];
 
-  const InputImageType *inputImage = this->GetInputImage();
-  const typename InputImageType::SpacingType & spacing = inputImage->GetSpacing();
+    bool linesChanged = ( i == 0 );
+    for ( unsigned int n = 1; n < ImageDimension && !linesChanged; n++ )
+      {
+      linesChanged = ( x[n] != indices[i - 1][n] );
+      }
 
-  // Calculate derivative
-  CovariantVectorType derivativeValue;
-  double              tempValue;
-  IndexType           coefficientIndex;
-  for ( unsigned int n = 0; n < ImageDimension; n++ )
-    {
-    derivativeValue[n] = 0.0;
-    for ( unsigned int p = 0; p < m_MaxNumberInterpolationPoints; p++ )
+    this->DetermineRegionOfSupport(evaluateIndex, x, m_SplineOrder);
+    this->SetInterpolationWeights(x, evaluateIndex, weights, m_SplineOrder);
+    this->ApplyMirrorBoundaryConditions(evaluateIndex, m_SplineOrder);
+    this->ComputeCoefficientOffsets(evaluateIndex, offsets);
+
+    if ( linesChanged )
       {
-      tempValue = 1.0;
-      for ( unsigned int n1 = 0; n1 < ImageDimension; n1++ )
+      for ( unsigned int l = 0; l < numberOfLines; l++ )
         {
-        unsigned int indx;
-        indx = m_PointsToIndex[p][n1];
-        coefficientIndex[n1] = ( evaluateIndex )[n1][indx];
-
-        if ( n1 == n )
+        const unsigned int p = l * support;
+        double             w = 1.0;
+        OffsetValueType    offset = 0;
+        for ( unsigned int n = 1; n < ImageDimension; n++ )
           {
-          tempValue *= ( weightsDerivative )[n1][indx];
-          }
-        else
-          {
-          tempValue *= ( weights )[n1][indx];
+          const unsigned int indx = m_PointsToIndex[p][n];
+          w *= weights[n][indx];
+          offset += offsets[n][indx];
           }
+        lineWeights[l] = w;
+        lineOffsets[l] = offset;
         }
-      derivativeValue[n] += m_Coefficients->GetPixel(coefficientIndex) * tempValue;
       }
-    derivativeValue[n] /= spacing[n];
-    }
 
-  if ( this->m_UseImageDirection )
-    {
-    CovariantVectorType orientedDerivative;
-    inputImage->TransformLocalVectorToPhysicalVector(derivativeValue, orientedDerivative);
-    return orientedDerivative;
+    double interpolated = 0.0;
+    for ( unsigned int l = 0; l < numberOfLines; l++ )
+      {
+      const CoefficientDataType *line = coefficients + lineOffsets[l];
+      double                     lineValue = 0.0;
+      for ( unsigned int k = 0; k < support; k++ )
+        {
+        lineValue += weights[0][k] * line[offsets[0][k]];
+        }
+      interpolated += lineWeights[l] * lineValue;
+      }
+    values[i] = interpolated;
     }
-
-  return ( derivativeValue );
 }
 } // namespace itk
 
@@ -110,6 +110,23 @@ public:
   virtual OutputType EvaluateAtContinuousIndex(
     const ContinuousIndexType & index) const ITK_OVERRIDE = 0;
 
+  /** Interpolate the image at an array of continuous index positions,
+   * typically the positions of the pixels of an output scanline, so that
+   * subclasses can reuse the work shared by neighboring positions. No
+   * bounds checking is done.
+   *
+   * The default implementation calls EvaluateAtContinuousIndex() for each
+   * position. */
+  virtual void EvaluateAtContinuousIndices(const ContinuousIndexType *indices,
+                                           OutputType *values,
+                                           SizeValueType numberOfIndices) const
+  {
+    for ( SizeValueType i = 0; i < numberOfIndices; ++i )
+      {
+      values[i] = this->EvaluateAtContinuousIndex(indices[i]);
+      }
+  }
+
   /** Interpolate the image at an index position.
    *
    * Simply returns the image value at the
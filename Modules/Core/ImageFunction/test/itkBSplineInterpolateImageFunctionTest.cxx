@@ -597,6 +597,52 @@ int testEvaluateValueAndDerivative(void)
   return EXIT_SUCCESS;
 }
 
+//Test to verify that EvaluateAtContinuousIndices, which reuses the weights
+//between the positions, and the thread-specific EvaluateAtContinuousIndex
+//produce the same results as EvaluateAtContinuousIndex.
+int testEvaluateAtContinuousIndices(void)
+{
+  const unsigned int ImageDimension = 2;
+  typedef float                                  PixelType;
+  typedef   itk::Image<PixelType,ImageDimension> ImageType;
+  typedef itk::BSplineInterpolateImageFunction<ImageType,double, double> BSplineInterpolatorFunctionType;
+  typedef BSplineInterpolatorFunctionType::ContinuousIndexType ContinuousIndexType;
+
+  // A scanline along the first dimension, then a slanted one, both
+  // crossing the borders where the mirror boundary conditions apply.
+  const unsigned int numberOfIndices = 200;
+  std::vector< ContinuousIndexType > indices( 2 * numberOfIndices );
+  for( unsigned int i = 0; i < numberOfIndices; ++i )
+    {
+    indices[i][0] = -0.45 + 0.16 * i;
+    indices[i][1] = 7.3;
+    indices[numberOfIndices + i][0] = 31.45 - 0.16 * i;
+    indices[numberOfIndices + i][1] = -0.45 + 0.13 * i;
+    }
+
+  for( unsigned int splineOrder = 0; splineOrder <= 5; ++splineOrder )
+    {
+    BSplineInterpolatorFunctionType::Pointer interpolator =
+      makeRandomImageInterpolator<BSplineInterpolatorFunctionType>(splineOrder);
+
+    std::vector< BSplineInterpolatorFunctionType::OutputType > values( indices.size() );
+    interpolator->EvaluateAtContinuousIndices( &indices[0], &values[0], indices.size() );
+
+    for( unsigned int i = 0; i < indices.size(); ++i )
+      {
+      const double value = interpolator->EvaluateAtContinuousIndex( indices[i] );
+      const double threadValue = interpolator->EvaluateAtContinuousIndex( indices[i], 0 );
+      if( itk::Math::abs( value - values[i] ) > 1e-9 || itk::Math::abs( value - threadValue ) > 1e-9 )
+        {
+        std::cout << "[ERROR] Spline order " << splineOrder << " at " << indices[i] << ": "
+                  << value << " != " << values[i] << " or " << threadValue << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
 int
 itkBSplineInterpolateImageFunctionTest(
     int itkNotUsed(argc),
@@ -618,6 +664,8 @@ itkBSplineInterpolateImageFunctionTest(
 
   flag += testEvaluateValueAndDerivative();
 
+  flag += testEvaluateAtContinuousIndices();
+
   /* Return results of test */
   if (flag != 0) {
     std::cout << "*** " << flag << " tests failed" << std::endl;
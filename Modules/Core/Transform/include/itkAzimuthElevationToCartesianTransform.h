@@ -139,6 +139,12 @@ public:
   /** Transform from azimuth-elevation to cartesian. */
   OutputPointType     TransformPoint(const InputPointType  & point) const ITK_OVERRIDE;
 
+  /** Transform a batch of points with TransformPoint(): the matrix and
+   * offset of the superclass do not describe this transform. */
+  virtual void TransformPoints(const InputPointType *inputPoints,
+                               OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const ITK_OVERRIDE;
+
   /** Back transform from cartesian to azimuth-elevation.  */
   inline InputPointType  BackTransform(const OutputPointType  & point) const
   {
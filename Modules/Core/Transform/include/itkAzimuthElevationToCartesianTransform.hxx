@@ -92,6 +92,18 @@ AzimuthElevationToCartesianTransform<TParametersValueType, NDimensions>::Transfo
   return result;
 }
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+AzimuthElevationToCartesianTransform<TParametersValueType, NDimensions>
+::TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    outputPoints[i] = this->TransformPoint( inputPoints[i] );
+    }
+}
+
 /** Transform a point, from azimuth-elevation to cartesian */
 template<typename TParametersValueType, unsigned int NDimensions>
 typename AzimuthElevationToCartesianTransform<TParametersValueType, NDimensions>
@@ -217,6 +217,11 @@ public:
   /** Transform points by a BSpline deformable transformation. */
   OutputPointType  TransformPoint( const InputPointType & point ) const ITK_OVERRIDE;
 
+  /** Transform a batch of points, allocating the weights and indices
+   * arrays once for the whole batch. */
+  virtual void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const ITK_OVERRIDE;
+
   /** Interpolation weights function type. */
   typedef BSplineInterpolationWeightFunction<ScalarType,
     itkGetStaticConstMacro( SpaceDimension ),
@@ -346,5 +346,22 @@ BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
   return outputPoint;
 }
 
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineBaseTransform<TParametersValueType, NDimensions, VSplineOrder>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  WeightsType             weights( this->m_WeightsFunction->GetNumberOfWeights() );
+  ParameterIndexArrayType indices( this->m_WeightsFunction->GetNumberOfWeights() );
+  bool                    inside;
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    const InputPointType point = inputPoints[i];
+    this->TransformPoint( point, outputPoints[i], weights, indices, inside );
+    }
+}
+
 } // namespace
 #endif
@@ -236,6 +236,14 @@ public:
   virtual void TransformPoint( const InputPointType & inputPoint, OutputPointType & outputPoint,
     WeightsType & weights, ParameterIndexArrayType & indices, bool & inside ) const ITK_OVERRIDE;
 
+  /** Transform a batch of points. The one dimensional weights of each
+   * dimension are reused between consecutive points that share the same
+   * continuous index along that dimension, such as the pixels of an image
+   * scanline aligned with the grid, and the coefficients are read directly
+   * from the coefficient images. */
+  virtual void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const ITK_OVERRIDE;
+
   /** Compute the Jacobian in one position. */
   virtual void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const ITK_OVERRIDE;
 
@@ -23,6 +23,7 @@
 #include "itkContinuousIndex.h"
 #include "itkImageScanlineConstIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkBSplineKernelFunction.h"
 
 namespace itk
 {
@@ -650,6 +651,131 @@ BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
      << this->m_CoefficientImages[0]->GetDirection() << std::endl;
 }
 
+template<typename TParametersValueType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TParametersValueType, NDimensions, VSplineOrder>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( !this->m_CoefficientImages[0]->GetBufferPointer() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  typedef BSplineKernelFunction<SplineOrder> KernelType;
+
+  const unsigned int SupportSize = SplineOrder + 1;
+
+  typename KernelType::Pointer kernel = KernelType::New();
+
+  const ParametersValueType *coefficients[SpaceDimension];
+  for( unsigned int j = 0; j < SpaceDimension; j++ )
+    {
+    coefficients[j] = this->m_CoefficientImages[j]->GetBufferPointer();
+    }
+  const OffsetValueType * offsetTable = this->m_CoefficientImages[0]->GetOffsetTable();
+  const IndexType         bufferStart = this->m_CoefficientImages[0]->GetBufferedRegion().GetIndex();
+
+  // The support region is the product of a row along the first dimension
+  // and of the "outer" support along the other ones, whose weights and
+  // offsets are only recomputed when the index changes along one of these
+  // dimensions.
+  SizeValueType numberOfOuterWeights = 1;
+  for( unsigned int j = 1; j < SpaceDimension; j++ )
+    {
+    numberOfOuterWeights *= SupportSize;
+    }
+  std::vector<double>          outerWeights( numberOfOuterWeights );
+  std::vector<OffsetValueType> outerOffsets( numberOfOuterWeights );
+
+  double              weights1D[SpaceDimension][SplineOrder + 1];
+  IndexValueType      supportIndex[SpaceDimension];
+  ContinuousIndexType cachedIndex;
+  bool                cacheValid = false;
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    const InputPointType point = inputPoints[i];
+
+    ContinuousIndexType index;
+    this->m_CoefficientImages[0]->TransformPhysicalPointToContinuousIndex( point, index );
+
+    // NOTE: if the support region does not lie totally within the grid
+    // we assume zero displacement and return the input point
+    if( !this->InsideValidRegion( index ) )
+      {
+      outputPoints[i] = point;
+      continue;
+      }
+
+    bool outerChanged = !cacheValid;
+    for( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+      if( cacheValid && index[j] == cachedIndex[j] )
+        {
+        continue;
+        }
+      // Same weights as BSplineInterpolationWeightFunction.
+      supportIndex[j] = Math::Floor<IndexValueType>( index[j] - static_cast<double>( SplineOrder - 1 ) / 2.0 );
+      double x = index[j] - static_cast<double>( supportIndex[j] );
+      for( unsigned int k = 0; k < SupportSize; k++ )
+        {
+        weights1D[j][k] = kernel->Evaluate( x );
+        x -= 1.0;
+        }
+      cachedIndex[j] = index[j];
+      outerChanged = outerChanged || j > 0;
+      }
+    cacheValid = true;
+
+    if( outerChanged )
+      {
+      for( SizeValueType o = 0; o < numberOfOuterWeights; ++o )
+        {
+        double          weight = 1.0;
+        OffsetValueType offset = 0;
+        SizeValueType   remainder = o;
+        for( unsigned int j = 1; j < SpaceDimension; j++ )
+          {
+          const unsigned int k = remainder % SupportSize;
+          remainder /= SupportSize;
+          weight *= weights1D[j][k];
+          offset += ( supportIndex[j] + static_cast<IndexValueType>( k ) - bufferStart[j] ) * offsetTable[j];
+          }
+        outerWeights[o] = weight;
+        outerOffsets[o] = offset;
+        }
+      }
+
+    const OffsetValueType rowStart = supportIndex[0] - bufferStart[0];
+    double                displacement[SpaceDimension];
+    for( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+      displacement[j] = 0.0;
+      }
+    for( SizeValueType o = 0; o < numberOfOuterWeights; ++o )
+      {
+      const OffsetValueType rowOffset = outerOffsets[o] + rowStart;
+      for( unsigned int j = 0; j < SpaceDimension; j++ )
+        {
+        const ParametersValueType *row = coefficients[j] + rowOffset;
+        double                     rowSum = 0.0;
+        for( unsigned int k = 0; k < SupportSize; k++ )
+          {
+          rowSum += weights1D[0][k] * row[k];
+          }
+        displacement[j] += outerWeights[o] * rowSum;
+        }
+      }
+
+    for( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+      outputPoints[i][j] = point[j] + static_cast<ScalarType>( displacement[j] );
+      }
+    }
+}
+
 } // namespace
 
 
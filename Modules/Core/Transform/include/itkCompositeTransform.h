@@ -243,6 +243,11 @@ public:
   */
   virtual OutputPointType TransformPoint( const InputPointType & inputPoint ) const ITK_OVERRIDE;
 
+  /** Transform a batch of points, applying each transform of the queue to
+   * the whole batch in turn, in the same order as TransformPoint(). */
+  virtual void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const ITK_OVERRIDE;
+
   /**  Method to transform a vector. */
   using Superclass::TransformVector;
   virtual OutputVectorType TransformVector(const InputVectorType &) const ITK_OVERRIDE;
@@ -355,6 +360,17 @@ public:
    */
   virtual void FlattenTransformQueue();
 
+  /**
+   * Return a new composite transform, meant for evaluation only, that maps
+   * points as this transform does, with nested composite transforms
+   * expanded and each run of consecutive linear transforms of the queue
+   * multiplied into a single AffineTransform. A linear transform that does
+   * not derive from MatrixOffsetTransformBase is sampled at the origin and
+   * the unit vectors. The sub transforms that are not merged are shared with
+   * this transform, not copied.
+   */
+  Pointer GetFlattenedTransform() const;
+
   /**
    * Compute the Jacobian with respect to the parameters for the compositie
    * transform using Jacobian rule. See comments in the implementation.
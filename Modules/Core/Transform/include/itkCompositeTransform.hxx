@@ -19,6 +19,9 @@
 #define itkCompositeTransform_hxx
 
 #include "itkCompositeTransform.h"
+#include "itkAffineTransform.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -100,6 +103,28 @@ CompositeTransform<TParametersValueType, NDimensions>
 }
 
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+CompositeTransform<TParametersValueType, NDimensions>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( outputPoints != inputPoints )
+    {
+    std::copy( inputPoints, inputPoints + numberOfPoints, outputPoints );
+    }
+
+  /* Apply in reverse queue order, in place.  */
+  typename TransformQueueType::const_iterator it( this->m_TransformQueue.end() );
+  const typename TransformQueueType::const_iterator beginit( this->m_TransformQueue.begin() );
+  while( it != beginit )
+    {
+    it--;
+    (*it)->TransformPoints( outputPoints, outputPoints, numberOfPoints );
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename CompositeTransform<TParametersValueType, NDimensions>
 ::OutputVectorType
@@ -1090,6 +1115,104 @@ CompositeTransform<TParametersValueType, NDimensions>
 }
 
 
+template<typename TParametersValueType, unsigned int NDimensions>
+typename CompositeTransform<TParametersValueType, NDimensions>::Pointer
+CompositeTransform<TParametersValueType, NDimensions>
+::GetFlattenedTransform() const
+{
+  typedef AffineTransform<TParametersValueType, NDimensions>                          AffineTransformType;
+  typedef MatrixOffsetTransformBase<TParametersValueType, NDimensions, NDimensions>  MatrixOffsetTransformType;
+  typedef typename AffineTransformType::MatrixType                                    AffineMatrixType;
+  typedef typename AffineTransformType::OutputVectorType                              OffsetType;
+
+  /* Expand the nested composite transforms, which are flattened first. */
+  TransformQueueType transforms;
+  for( SizeValueType m = 0; m < this->GetNumberOfTransforms(); m++ )
+    {
+    const Self * nestedCompositeTransform = dynamic_cast<const Self *>( this->m_TransformQueue[m].GetPointer() );
+    if( nestedCompositeTransform )
+      {
+      if( nestedCompositeTransform->GetNumberOfTransforms() > 0 )
+        {
+        Pointer nestedFlattenedTransform = nestedCompositeTransform->GetFlattenedTransform();
+        for( SizeValueType n = 0; n < nestedFlattenedTransform->GetNumberOfTransforms(); n++ )
+          {
+          transforms.push_back( nestedFlattenedTransform->GetNthTransformModifiablePointer( n ) );
+          }
+        }
+      }
+    else
+      {
+      transforms.push_back( this->m_TransformQueue[m] );
+      }
+    }
+
+  /* Merge the runs of linear transforms. The composition of the run
+   * T_i, ..., T_j of the queue is T_i o ... o T_j, so the matrices are
+   * multiplied in queue order. */
+  Pointer flattened = Self::New();
+  SizeValueType m = 0;
+  while( m < transforms.size() )
+    {
+    SizeValueType runEnd = m;
+    while( runEnd < transforms.size() && transforms[runEnd]->IsLinear() )
+      {
+      ++runEnd;
+      }
+    if( runEnd - m < 2 )
+      {
+      flattened->AddTransform( transforms[m] );
+      m++;
+      continue;
+      }
+
+    AffineMatrixType matrix;
+    matrix.SetIdentity();
+    OffsetType offset;
+    offset.Fill( NumericTraits<TParametersValueType>::ZeroValue() );
+    for( ; m < runEnd; m++ )
+      {
+      const TransformType * transform = transforms[m].GetPointer();
+      AffineMatrixType transformMatrix;
+      OffsetType transformOffset;
+      const MatrixOffsetTransformType * matrixOffsetTransform =
+        dynamic_cast<const MatrixOffsetTransformType *>( transform );
+      if( matrixOffsetTransform )
+        {
+        transformMatrix = matrixOffsetTransform->GetMatrix();
+        transformOffset = matrixOffsetTransform->GetOffset();
+        }
+      else
+        {
+        InputPointType point;
+        point.Fill( NumericTraits<TParametersValueType>::ZeroValue() );
+        const OutputPointType origin = transform->TransformPoint( point );
+        for( unsigned int j = 0; j < NDimensions; j++ )
+          {
+          point[j] = NumericTraits<TParametersValueType>::OneValue();
+          const OutputPointType column = transform->TransformPoint( point );
+          point[j] = NumericTraits<TParametersValueType>::ZeroValue();
+          for( unsigned int i = 0; i < NDimensions; i++ )
+            {
+            transformMatrix[i][j] = column[i] - origin[i];
+            }
+          transformOffset[j] = origin[j];
+          }
+        }
+      offset += matrix * transformOffset;
+      matrix = matrix * transformMatrix;
+      }
+
+    typename AffineTransformType::Pointer affine = AffineTransformType::New();
+    affine->SetMatrix( matrix );
+    affine->SetOffset( offset );
+    flattened->AddTransform( affine );
+    }
+
+  return flattened;
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 void
 CompositeTransform<TParametersValueType, NDimensions>
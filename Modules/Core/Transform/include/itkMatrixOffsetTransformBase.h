@@ -379,6 +379,13 @@ public:
 
   OutputPointType       TransformPoint(const InputPointType & point) const ITK_OVERRIDE;
 
+  /** Transform a batch of points with the matrix and offset, without a
+   * virtual call per point.  Subclasses that override TransformPoint() must
+   * override this method as well. */
+  virtual void TransformPoints(const InputPointType *inputPoints,
+                               OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const ITK_OVERRIDE;
+
   using Superclass::TransformVector;
 
   OutputVectorType      TransformVector(const InputVectorType & vector) const ITK_OVERRIDE;
@@ -185,6 +185,30 @@ MatrixOffsetTransformBase<TParametersValueType, NInputDimensions, NOutputDimensi
 }
 
 
+template<typename TParametersValueType, unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+MatrixOffsetTransformBase<TParametersValueType, NInputDimensions, NOutputDimensions>
+::TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  // Same operations as TransformPoint(), unrolled over the batch.
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    const InputPointType point = inputPoints[i];
+    for( unsigned int r = 0; r < NOutputDimensions; ++r )
+      {
+      ScalarType sum = NumericTraits<ScalarType>::ZeroValue();
+      for( unsigned int c = 0; c < NInputDimensions; ++c )
+        {
+        sum += m_Matrix[r][c] * point[c];
+        }
+      outputPoints[i][r] = sum + m_Offset[r];
+      }
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NInputDimensions,
           unsigned int NOutputDimensions>
 typename MatrixOffsetTransformBase<TParametersValueType,
@@ -160,6 +160,12 @@ public:
    * vector. */
   OutputPointType     TransformPoint(const InputPointType  & point) const ITK_OVERRIDE;
 
+  /** Transform a batch of points with the same operations as
+   * TransformPoint(). */
+  virtual void TransformPoints(const InputPointType *inputPoints,
+                               OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const ITK_OVERRIDE;
+
   using Superclass::TransformVector;
   OutputVectorType    TransformVector(const InputVectorType & vector) const ITK_OVERRIDE;
 
@@ -132,6 +132,25 @@ ScaleTransform<TParametersValueType, NDimensions>
 }
 
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+ScaleTransform<TParametersValueType, NDimensions>
+::TransformPoints(const InputPointType *inputPoints, OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  const InputPointType &center = this->GetCenter();
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    const InputPointType point = inputPoints[i];
+    for( unsigned int j = 0; j < SpaceDimension; j++ )
+      {
+      outputPoints[i][j] = ( point[j] - center[j] ) * m_Scale[j] + center[j];
+      }
+    }
+}
+
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename ScaleTransform<TParametersValueType, NDimensions>::OutputVectorType
 ScaleTransform<TParametersValueType, NDimensions>
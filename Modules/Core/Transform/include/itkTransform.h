@@ -188,6 +188,18 @@ public:
    */
   virtual OutputPointType TransformPoint(const InputPointType  &) const = 0;
 
+  /** Method to transform a batch of points. \c inputPoints and
+   * \c outputPoints hold \c numberOfPoints points each, and may be the
+   * same array when the input and output point types are the same. The
+   * default implementation calls TransformPoint() for each point.
+   * Subclasses override it to share work between the points of a batch,
+   * typically the pixels of a scanline, and subclasses that override
+   * TransformPoint() must override it accordingly.
+   * \warning This method must be thread-safe. */
+  virtual void TransformPoints(const InputPointType *inputPoints,
+                               OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const;
+
   /**  Method to transform a vector. */
   virtual OutputVectorType  TransformVector(const InputVectorType &) const
   {
@@ -133,6 +133,16 @@ public:
 
   itkGetConstMacro(FixedAverageGradientMagnitude, double);
 
+  /** Set/Get the number of time steps advanced in each tile and the size of
+   * the tiles when temporal blocking is used (see
+   * DenseFiniteDifferenceImageFilter).  Temporal blocking requires a fixed
+   * average gradient magnitude, which is otherwise recomputed at different
+   * iterations. */
+  using Superclass::SetNumberOfStepsPerBlock;
+  using Superclass::GetNumberOfStepsPerBlock;
+  using Superclass::SetBlockTileSize;
+  using Superclass::GetBlockTileSize;
+
 protected:
   AnisotropicDiffusionImageFilter();
   ~AnisotropicDiffusionImageFilter() {}
@@ -82,6 +82,11 @@ AnisotropicDiffusionImageFilter< TInputImage, TOutputImage >
                      << minSpacing / std::pow( 2.0, static_cast< double >( ImageDimension + 1 ) ) );
     }
 
+  if ( m_GradientMagnitudeIsFixed == false && this->GetNumberOfStepsPerBlock() > 1 )
+    {
+    itkExceptionMacro( << "Temporal blocking requires a fixed average gradient magnitude." );
+    }
+
   if ( m_GradientMagnitudeIsFixed == false )
     {
     if ( ( this->GetElapsedIterations() % m_ConductanceScalingUpdateInterval ) == 0 )
@@ -0,0 +1,166 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkGradientAnisotropicDiffusionImageFilter.h"
+#include "itkCurvatureAnisotropicDiffusionImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the temporal blocking of DenseFiniteDifferenceImageFilter with the
+ * gradient and curvature anisotropic diffusion filters: advancing several
+ * time steps per tile gives the same output as the dense iteration, for
+ * several tile sizes, numbers of steps per block and numbers of threads.
+ * Temporal blocking requires a fixed average gradient magnitude.
+ */
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< float, Dimension > ImageType;
+
+ImageType::Pointer
+CreateImage()
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size[0] = 37;
+  size[1] = 29;
+  size[2] = 21;
+  image->SetRegions( size );
+  image->Allocate();
+
+  unsigned int seed = 11;
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    seed = seed * 1103515245u + 12345u;
+    it.Set( static_cast< float >( ( seed >> 16 ) % 256 ) );
+    }
+  return image;
+}
+
+template< typename TFilter >
+ImageType::Pointer
+RunFilter( ImageType * image, itk::IdentifierType numberOfStepsPerBlock, itk::SizeValueType blockTileSize,
+           itk::ThreadIdType numberOfThreads )
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput( image );
+  filter->SetNumberOfIterations( 7 );
+  filter->SetTimeStep( 0.05 );
+  filter->SetConductanceParameter( 2.0 );
+  filter->SetFixedAverageGradientMagnitude( 20.0 );
+  filter->SetNumberOfStepsPerBlock( numberOfStepsPerBlock );
+  filter->SetBlockTileSize( blockTileSize );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+  if( filter->GetElapsedIterations() != 7 )
+    {
+    std::cerr << "The filter ran " << filter->GetElapsedIterations() << " iterations instead of 7" << std::endl;
+    return ITK_NULLPTR;
+    }
+  return filter->GetOutput();
+}
+
+template< typename TFilter >
+bool
+CompareTemporalBlocking( ImageType * image, const char * name )
+{
+  ImageType::Pointer reference = RunFilter< TFilter >( image, 1, 32, 1 );
+
+  bool result = true;
+  const itk::IdentifierType stepsPerBlock[] = { 2, 3, 10 };
+  const itk::SizeValueType  tileSizes[] = { 4, 16 };
+  for( unsigned int s = 0; s < 3; ++s )
+    {
+    for( unsigned int t = 0; t < 2; ++t )
+      {
+      for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 3; numberOfThreads += 2 )
+        {
+        ImageType::Pointer output = RunFilter< TFilter >( image, stepsPerBlock[s], tileSizes[t], numberOfThreads );
+        if( output.IsNull() )
+          {
+          result = false;
+          continue;
+          }
+        itk::ImageRegionConstIterator< ImageType > itReference( reference, reference->GetBufferedRegion() );
+        itk::ImageRegionConstIterator< ImageType > itOutput( output, output->GetBufferedRegion() );
+        for( ; !itReference.IsAtEnd(); ++itReference, ++itOutput )
+          {
+          if( itk::Math::NotExactlyEquals( itReference.Get(), itOutput.Get() ) )
+            {
+            std::cerr << name << " with " << stepsPerBlock[s] << " steps per block, tiles of "
+                      << tileSizes[t] << " pixels and " << numberOfThreads << " threads: the value at "
+                      << itOutput.GetIndex() << " is " << itOutput.Get() << " instead of "
+                      << itReference.Get() << std::endl;
+            result = false;
+            break;
+            }
+          }
+        }
+      }
+    }
+  return result;
+}
+}
+
+int itkAnisotropicDiffusionTemporalBlockingTest( int, char *[] )
+{
+  typedef itk::GradientAnisotropicDiffusionImageFilter< ImageType, ImageType >  GradientFilterType;
+  typedef itk::CurvatureAnisotropicDiffusionImageFilter< ImageType, ImageType > CurvatureFilterType;
+
+  GradientFilterType::Pointer filter = GradientFilterType::New();
+  TEST_SET_GET_VALUE( 1, filter->GetNumberOfStepsPerBlock() );
+  filter->SetNumberOfStepsPerBlock( 0 );
+  TEST_SET_GET_VALUE( 1, filter->GetNumberOfStepsPerBlock() );
+  filter->SetNumberOfStepsPerBlock( 4 );
+  TEST_SET_GET_VALUE( 4, filter->GetNumberOfStepsPerBlock() );
+  filter->SetBlockTileSize( 8 );
+  TEST_SET_GET_VALUE( 8, filter->GetBlockTileSize() );
+
+  // Temporal blocking cannot be combined with active tiles.
+  ImageType::Pointer image = CreateImage();
+  filter->SetInput( image );
+  filter->SetNumberOfIterations( 2 );
+  filter->UseActiveTilesOn();
+  TRY_EXPECT_EXCEPTION( filter->Update() );
+
+  // Without a fixed average gradient magnitude, the conductance would be
+  // scaled at different iterations, so temporal blocking is rejected.
+  GradientFilterType::Pointer defaultFilter = GradientFilterType::New();
+  defaultFilter->SetInput( image );
+  defaultFilter->SetNumberOfIterations( 2 );
+  defaultFilter->SetNumberOfStepsPerBlock( 2 );
+  TRY_EXPECT_EXCEPTION( defaultFilter->Update() );
+  defaultFilter->SetNumberOfStepsPerBlock( 1 );
+  TRY_EXPECT_NO_EXCEPTION( defaultFilter->Update() );
+
+  bool result = true;
+  result = CompareTemporalBlocking< GradientFilterType >( image, "GradientAnisotropicDiffusion" ) && result;
+  result = CompareTemporalBlocking< CurvatureFilterType >( image, "CurvatureAnisotropicDiffusion" ) && result;
+
+  if( !result )
+    {
+    std::cerr << "Test failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -136,6 +136,14 @@ public:
   /** Get the timestep parameter. */
   itkGetConstMacro(TimeStep, TimeStepType);
 
+  /** Set/Get the number of time steps advanced in each tile and the size of
+   * the tiles when temporal blocking is used (see
+   * DenseFiniteDifferenceImageFilter). */
+  using Superclass::SetNumberOfStepsPerBlock;
+  using Superclass::GetNumberOfStepsPerBlock;
+  using Superclass::SetBlockTileSize;
+  using Superclass::GetBlockTileSize;
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro( DoubleConvertibleToOutputCheck,
@@ -161,10 +169,12 @@ protected:
   void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
 
   /** Supplies the halting criteria for this class of filters.  The
-   * algorithm will stop after a user-specified number of iterations. */
+   * algorithm will stop after a user-specified number of iterations, or
+   * when no active tile is left. */
   virtual bool Halt() ITK_OVERRIDE
   {
-    if ( this->GetElapsedIterations() == this->GetNumberOfIterations() )
+    if ( this->GetElapsedIterations() == this->GetNumberOfIterations()
+         || this->AllActiveTilesConverged() )
       {
       return true;
       }
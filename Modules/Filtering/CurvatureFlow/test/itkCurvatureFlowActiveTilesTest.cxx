@@ -0,0 +1,157 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCurvatureFlowImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the active tiles of DenseFiniteDifferenceImageFilter with
+ * CurvatureFlowImageFilter: with a zero tolerance the output is identical to
+ * the dense iteration while the flat tiles are skipped, a positive tolerance
+ * keeps the output close, and the iteration halts once no tile changes.
+ * Temporal blocking also gives the output of the dense iteration.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< float, Dimension >                        ImageType;
+typedef itk::CurvatureFlowImageFilter< ImageType, ImageType > FilterType;
+
+ImageType::Pointer
+CreateImage( bool constant )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size[0] = 100;
+  size[1] = 70;
+  image->SetRegions( size );
+  image->Allocate();
+  image->FillBuffer( 5.0f );
+  if( constant )
+    {
+    return image;
+    }
+
+  // A noisy square in a flat background.
+  unsigned int seed = 7;
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    if( index[0] >= 12 && index[0] < 30 && index[1] >= 15 && index[1] < 33 )
+      {
+      seed = seed * 1103515245u + 12345u;
+      it.Set( 100.0f + static_cast< float >( ( seed >> 16 ) % 100 ) );
+      }
+    }
+  return image;
+}
+
+FilterType::Pointer
+RunFilter( ImageType * image, bool useActiveTiles, double tolerance, itk::ThreadIdType numberOfThreads )
+{
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetNumberOfIterations( 12 );
+  filter->SetTimeStep( 0.1 );
+  filter->SetUseActiveTiles( useActiveTiles );
+  filter->SetActiveTileSize( 8 );
+  filter->SetActiveTileTolerance( tolerance );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+  return filter;
+}
+
+double
+MaximumDifference( const ImageType * image1, const ImageType * image2 )
+{
+  double maximum = 0.0;
+  itk::ImageRegionConstIterator< ImageType > it1( image1, image1->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< ImageType > it2( image2, image2->GetBufferedRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    maximum = std::max( maximum, std::abs( static_cast< double >( it1.Get() ) - it2.Get() ) );
+    }
+  return maximum;
+}
+}
+
+int itkCurvatureFlowActiveTilesTest( int, char *[] )
+{
+  FilterType::Pointer filter = FilterType::New();
+  TEST_SET_GET_BOOLEAN( filter, UseActiveTiles, true );
+  filter->SetUseActiveTiles( false );
+  filter->SetActiveTileSize( 4 );
+  TEST_SET_GET_VALUE( 4, filter->GetActiveTileSize() );
+  filter->SetActiveTileTolerance( 0.5 );
+  TEST_SET_GET_VALUE( 0.5, filter->GetActiveTileTolerance() );
+
+  ImageType::Pointer image = CreateImage( false );
+  FilterType::Pointer denseFilter = RunFilter( image, false, 0.0, 1 );
+
+  // The flat background does not change, so only the tiles close to the
+  // square are recomputed, and the output is unchanged.
+  const itk::SizeValueType numberOfTiles = 13 * 9;
+  itk::SizeValueType activeTilesWithoutTolerance = 0;
+  for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 3; numberOfThreads += 2 )
+    {
+    FilterType::Pointer activeFilter = RunFilter( image, true, 0.0, numberOfThreads );
+    std::cout << "Active tiles with " << numberOfThreads << " threads: "
+              << activeFilter->GetNumberOfActiveTiles() << " of " << numberOfTiles << std::endl;
+    TEST_EXPECT_TRUE( activeFilter->GetNumberOfActiveTiles() > 0 );
+    TEST_EXPECT_TRUE( activeFilter->GetNumberOfActiveTiles() < numberOfTiles / 2 );
+    TEST_SET_GET_VALUE( 12, activeFilter->GetElapsedIterations() );
+    TEST_SET_GET_VALUE( 0.0, MaximumDifference( denseFilter->GetOutput(), activeFilter->GetOutput() ) );
+    activeTilesWithoutTolerance = activeFilter->GetNumberOfActiveTiles();
+    }
+
+  // Tiles whose change fell below the tolerance are frozen: fewer tiles are
+  // active, and the output stays within the tolerance per iteration.
+  const double tolerance = 4.0;
+  FilterType::Pointer toleranceFilter = RunFilter( image, true, tolerance, 2 );
+  const double difference = MaximumDifference( denseFilter->GetOutput(), toleranceFilter->GetOutput() );
+  std::cout << "Maximum difference with a tolerance: " << difference << std::endl;
+  TEST_EXPECT_TRUE( toleranceFilter->GetNumberOfActiveTiles() < activeTilesWithoutTolerance );
+  TEST_EXPECT_TRUE( difference < tolerance * toleranceFilter->GetElapsedIterations() );
+
+  // Temporal blocking advances the tiles by several steps at a time, and
+  // also leaves the output unchanged.
+  FilterType::Pointer blockFilter = FilterType::New();
+  blockFilter->SetInput( image );
+  blockFilter->SetNumberOfIterations( 12 );
+  blockFilter->SetTimeStep( 0.1 );
+  blockFilter->SetNumberOfStepsPerBlock( 5 );
+  blockFilter->SetBlockTileSize( 16 );
+  blockFilter->SetNumberOfThreads( 3 );
+  blockFilter->Update();
+  TEST_SET_GET_VALUE( 12, blockFilter->GetElapsedIterations() );
+  TEST_SET_GET_VALUE( 0.0, MaximumDifference( denseFilter->GetOutput(), blockFilter->GetOutput() ) );
+
+  // A flat image converges after the first iteration.
+  ImageType::Pointer constantImage = CreateImage( true );
+  FilterType::Pointer constantFilter = RunFilter( constantImage, true, 0.0, 2 );
+  TEST_SET_GET_VALUE( 1, constantFilter->GetElapsedIterations() );
+  TEST_SET_GET_VALUE( 0, constantFilter->GetNumberOfActiveTiles() );
+  TEST_SET_GET_VALUE( 0.0, MaximumDifference( constantImage, constantFilter->GetOutput() ) );
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
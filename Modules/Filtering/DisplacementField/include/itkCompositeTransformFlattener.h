@@ -0,0 +1,122 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCompositeTransformFlattener_h
+#define itkCompositeTransformFlattener_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkCompositeTransform.h"
+#include "itkDisplacementFieldTransform.h"
+
+namespace itk
+{
+/** \class CompositeTransformFlattener
+ * \brief Reduce a CompositeTransform to a shorter chain that is cheaper to
+ * evaluate.
+ *
+ * The flattened transform is meant for evaluation only, e.g. to resample
+ * an image with the result of a registration. Consecutive linear transforms
+ * are multiplied into a single AffineTransform, as done by
+ * CompositeTransform::GetFlattenedTransform().
+ *
+ * When ResampleNonlinearTransforms is on, each run of consecutive nonlinear
+ * transforms, e.g. B-spline and displacement field transforms, is also
+ * sampled into a single DisplacementFieldTransform on the grid of the
+ * reference image. A run made of a single DisplacementFieldTransform is
+ * kept as is. This is an approximation: the resampled run is interpolated
+ * linearly between the grid points, and is the identity outside the
+ * reference image.
+ *
+ * \ingroup ITKDisplacementField
+ */
+template<typename TParametersValueType = double, unsigned int NDimensions = 3>
+class ITK_TEMPLATE_EXPORT CompositeTransformFlattener
+: public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef CompositeTransformFlattener Self;
+  typedef Object                      Superclass;
+  typedef SmartPointer<Self>          Pointer;
+  typedef SmartPointer<const Self>    ConstPointer;
+
+  /** New macro for creation of through a Smart Pointer. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( CompositeTransformFlattener, Object );
+
+  /** Dimension of the transforms. */
+  itkStaticConstMacro( Dimension, unsigned int, NDimensions );
+
+  /** Transform types. */
+  typedef CompositeTransform<TParametersValueType, NDimensions>          CompositeTransformType;
+  typedef typename CompositeTransformType::TransformType                  TransformType;
+  typedef DisplacementFieldTransform<TParametersValueType, NDimensions>  DisplacementFieldTransformType;
+  typedef typename DisplacementFieldTransformType::DisplacementFieldType DisplacementFieldType;
+
+  /** Image defining the grid of the resampled displacement fields. */
+  typedef ImageBase<NDimensions> ReferenceImageType;
+
+  /** Set/Get the transform to flatten. */
+  itkSetConstObjectMacro( Transform, CompositeTransformType );
+  itkGetConstObjectMacro( Transform, CompositeTransformType );
+
+  /** Set/Get the image whose grid the nonlinear runs are resampled on.
+   * Required when ResampleNonlinearTransforms is on. */
+  itkSetConstObjectMacro( ReferenceImage, ReferenceImageType );
+  itkGetConstObjectMacro( ReferenceImage, ReferenceImageType );
+
+  /** Set/Get whether the runs of nonlinear transforms are resampled into
+   * displacement fields. Default is off. */
+  itkSetMacro( ResampleNonlinearTransforms, bool );
+  itkGetConstMacro( ResampleNonlinearTransforms, bool );
+  itkBooleanMacro( ResampleNonlinearTransforms );
+
+  /** Compute the flattened transform. */
+  virtual void Flatten();
+
+  /** Get the flattened transform computed by Flatten(). */
+  itkGetModifiableObjectMacro( FlattenedTransform, CompositeTransformType );
+
+protected:
+  CompositeTransformFlattener();
+  ~CompositeTransformFlattener() {}
+
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
+
+  /** Sample the composition of the run [begin, end) of the queue of
+   * transform on the grid of the reference image. */
+  typename DisplacementFieldTransformType::Pointer ResampleTransforms(
+    const CompositeTransformType * transform, SizeValueType begin, SizeValueType end ) const;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(CompositeTransformFlattener);
+
+  typename CompositeTransformType::ConstPointer m_Transform;
+  typename ReferenceImageType::ConstPointer     m_ReferenceImage;
+  typename CompositeTransformType::Pointer      m_FlattenedTransform;
+  bool                                          m_ResampleNonlinearTransforms;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkCompositeTransformFlattener.hxx"
+#endif
+
+#endif
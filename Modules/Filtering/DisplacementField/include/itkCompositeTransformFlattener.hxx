@@ -0,0 +1,118 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkCompositeTransformFlattener_hxx
+#define itkCompositeTransformFlattener_hxx
+
+#include "itkCompositeTransformFlattener.h"
+#include "itkTransformToDisplacementFieldFilter.h"
+
+namespace itk
+{
+
+template<typename TParametersValueType, unsigned int NDimensions>
+CompositeTransformFlattener<TParametersValueType, NDimensions>
+::CompositeTransformFlattener() :
+  m_ResampleNonlinearTransforms( false )
+{
+}
+
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+CompositeTransformFlattener<TParametersValueType, NDimensions>
+::Flatten()
+{
+  if( !this->m_Transform )
+    {
+    itkExceptionMacro( "The transform to flatten is not set." );
+    }
+
+  typename CompositeTransformType::Pointer flattened = this->m_Transform->GetFlattenedTransform();
+
+  if( this->m_ResampleNonlinearTransforms )
+    {
+    if( !this->m_ReferenceImage )
+      {
+      itkExceptionMacro( "The reference image is required to resample the nonlinear transforms." );
+      }
+
+    typename CompositeTransformType::Pointer resampled = CompositeTransformType::New();
+    SizeValueType m = 0;
+    while( m < flattened->GetNumberOfTransforms() )
+      {
+      SizeValueType runEnd = m;
+      while( runEnd < flattened->GetNumberOfTransforms()
+             && !flattened->GetNthTransformConstPointer( runEnd )->IsLinear() )
+        {
+        ++runEnd;
+        }
+      if( runEnd == m
+          || ( runEnd == m + 1
+               && dynamic_cast<const DisplacementFieldTransformType *>( flattened->GetNthTransformConstPointer( m ) ) ) )
+        {
+        resampled->AddTransform( flattened->GetNthTransformModifiablePointer( m ) );
+        ++m;
+        continue;
+        }
+      resampled->AddTransform( this->ResampleTransforms( flattened, m, runEnd ).GetPointer() );
+      m = runEnd;
+      }
+    flattened = resampled;
+    }
+
+  this->m_FlattenedTransform = flattened;
+}
+
+template<typename TParametersValueType, unsigned int NDimensions>
+typename CompositeTransformFlattener<TParametersValueType, NDimensions>::DisplacementFieldTransformType::Pointer
+CompositeTransformFlattener<TParametersValueType, NDimensions>
+::ResampleTransforms( const CompositeTransformType * transform, SizeValueType begin, SizeValueType end ) const
+{
+  typename CompositeTransformType::Pointer run = CompositeTransformType::New();
+  for( SizeValueType n = begin; n < end; n++ )
+    {
+    run->AddTransform( transform->GetNthTransformModifiablePointer( n ) );
+    }
+
+  typedef TransformToDisplacementFieldFilter<DisplacementFieldType, TParametersValueType> FieldGeneratorType;
+  typename FieldGeneratorType::Pointer fieldGenerator = FieldGeneratorType::New();
+  fieldGenerator->SetTransform( run );
+  fieldGenerator->SetReferenceImage( this->m_ReferenceImage );
+  fieldGenerator->UseReferenceImageOn();
+  fieldGenerator->Update();
+
+  typename DisplacementFieldTransformType::Pointer displacementFieldTransform = DisplacementFieldTransformType::New();
+  displacementFieldTransform->SetDisplacementField( fieldGenerator->GetOutput() );
+  return displacementFieldTransform;
+}
+
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+CompositeTransformFlattener<TParametersValueType, NDimensions>
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Transform: " << this->m_Transform.GetPointer() << std::endl;
+  os << indent << "ReferenceImage: " << this->m_ReferenceImage.GetPointer() << std::endl;
+  os << indent << "ResampleNonlinearTransforms: " << this->m_ResampleNonlinearTransforms << std::endl;
+  os << indent << "FlattenedTransform: " << this->m_FlattenedTransform.GetPointer() << std::endl;
+}
+
+} // end namespace itk
+
+#endif
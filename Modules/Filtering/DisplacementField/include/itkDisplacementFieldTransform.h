@@ -212,6 +212,11 @@ public:
    * be returned with zero displacemnt. */
   virtual OutputPointType TransformPoint( const InputPointType& thisPoint ) const ITK_OVERRIDE;
 
+  /** Transform a batch of points, mapping each point to the displacement
+   * field once and checking the field and interpolator once per batch. */
+  virtual void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const ITK_OVERRIDE;
+
   /**  Method to transform a vector. */
   using Superclass::TransformVector;
   virtual OutputVectorType TransformVector(const InputVectorType &) const ITK_OVERRIDE
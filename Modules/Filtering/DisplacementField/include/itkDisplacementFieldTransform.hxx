@@ -105,6 +105,42 @@ DisplacementFieldTransform<TParametersValueType, NDimensions>
   return outputPoint;
 }
 
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+DisplacementFieldTransform<TParametersValueType, NDimensions>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( !this->m_DisplacementField )
+    {
+    itkExceptionMacro( "No displacement field is specified." );
+    }
+  if( !this->m_Interpolator )
+    {
+    itkExceptionMacro( "No interpolator is specified." );
+    }
+
+  typename InterpolatorType::ContinuousIndexType cidx;
+  typename InterpolatorType::PointType point;
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    point.CastFrom( inputPoints[i] );
+    outputPoints[i].CastFrom( point );
+
+    // Same test as IsInsideBuffer( point ), without mapping the point twice.
+    this->m_DisplacementField->TransformPhysicalPointToContinuousIndex( point, cidx );
+    if( this->m_Interpolator->IsInsideBuffer( cidx ) )
+      {
+      typename InterpolatorType::OutputType displacement = this->m_Interpolator->EvaluateAtContinuousIndex( cidx );
+      for( unsigned int ii = 0; ii < NDimensions; ++ii )
+        {
+        outputPoints[i][ii] += displacement[ii];
+        }
+      }
+    }
+}
+
 template<typename TParametersValueType, unsigned int NDimensions>
 bool DisplacementFieldTransform<TParametersValueType, NDimensions>
 ::GetInverse( Self *inverse ) const
@@ -36,6 +36,11 @@ namespace itk
  * the result of the addition of the update array and the displacement
  * field, using a \c GaussianOperator filter.
  *
+ * Optionally, the fields are smoothed with a recursive (IIR) Gaussian filter
+ * whose cost does not depend on the variance, see
+ * \c UseRecursiveGaussianSmoothing.  All the components of the vectors are
+ * then filtered together along each line of the field.
+ *
  * To free the memory allocated and cached in \c GaussianSmoothDisplacementField
  * on demand, see \c FreeGaussianSmoothingTempField.
  *
@@ -84,6 +89,21 @@ public:
   itkSetMacro( GaussianSmoothingVarianceForTheTotalField, ScalarType );
   itkGetConstReferenceMacro( GaussianSmoothingVarianceForTheTotalField, ScalarType );
 
+  /**
+   * Use a RecursiveGaussianImageFilter along each dimension instead of the
+   * discrete GaussianOperator to smooth the fields.  The recursive filter
+   * approximates the Gaussian kernel with a cost independent of the variance,
+   * which is faster for large variances.  The variances are still given in
+   * pixel units.  Default = false.
+   */
+  itkSetMacro( UseRecursiveGaussianSmoothing, bool );
+  itkGetConstMacro( UseRecursiveGaussianSmoothing, bool );
+  itkBooleanMacro( UseRecursiveGaussianSmoothing );
+
+  /** Free the temporary field kept between the calls of
+   * \c GaussianSmoothDisplacementField by the recursive smoothing. */
+  void FreeGaussianSmoothingTempField();
+
   /** Update the transform's parameters by the values in \c update.
    * We assume \c update is of the same length as Parameters. Throw
    * exception otherwise.
@@ -122,6 +142,14 @@ protected:
                                                   GaussianSmoothingSmootherType;
   GaussianSmoothingOperatorType                    m_GaussianSmoothingOperator;
 
+  bool                                             m_UseRecursiveGaussianSmoothing;
+
+  /** Smooth the field with recursive Gaussian filters.  The unsmoothed field
+   * is kept in \c m_GaussianSmoothingTempField when the variance requires it. */
+  DisplacementFieldPointer RecursiveGaussianSmoothDisplacementField( DisplacementFieldType *, ScalarType );
+
+  DisplacementFieldPointer                         m_GaussianSmoothingTempField;
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(GaussianSmoothingOnUpdateDisplacementFieldTransform);
 
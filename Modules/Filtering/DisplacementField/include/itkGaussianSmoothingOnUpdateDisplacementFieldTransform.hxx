@@ -27,6 +27,7 @@
 #include "itkImageLinearIteratorWithIndex.h"
 #include "itkImportImageFilter.h"
 #include "itkMultiplyImageFilter.h"
+#include "itkRecursiveGaussianImageFilter.h"
 #include "itkVectorNeighborhoodOperatorImageFilter.h"
 
 namespace itk
@@ -38,6 +39,7 @@ GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimen
 {
   this->m_GaussianSmoothingVarianceForTheUpdateField = 3.0;
   this->m_GaussianSmoothingVarianceForTheTotalField = 0.5;
+  this->m_UseRecursiveGaussianSmoothing = false;
 }
 
 template<typename TParametersValueType, unsigned int NDimensions>
@@ -136,41 +138,59 @@ GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimen
     return field;
     }
 
-  typedef ImageDuplicator< DisplacementFieldType > DuplicatorType;
-  typename DuplicatorType::Pointer duplicator = DuplicatorType::New();
-  duplicator->SetInputImage( field );
-  duplicator->Update();
-
-  DisplacementFieldPointer smoothField = duplicator->GetModifiableOutput();
-
-  typename GaussianSmoothingSmootherType::Pointer smoother = GaussianSmoothingSmootherType::New();
-
+  // The recursive filters need at least 4 pixels along each dimension.
+  bool useRecursiveGaussianSmoothing = this->m_UseRecursiveGaussianSmoothing;
   for( unsigned int dimension = 0; dimension < Superclass::Dimension; ++dimension )
     {
-    // smooth along this dimension
-    this->m_GaussianSmoothingOperator.SetDirection( dimension );
-    this->m_GaussianSmoothingOperator.SetVariance( variance );
-    this->m_GaussianSmoothingOperator.SetMaximumError( 0.001 );
-    this->m_GaussianSmoothingOperator.SetMaximumKernelWidth( smoothField->GetRequestedRegion().GetSize()[dimension] );
-    this->m_GaussianSmoothingOperator.CreateDirectional();
-
-    // todo: make sure we only smooth within the buffered region
-    smoother->SetOperator( this->m_GaussianSmoothingOperator );
-    smoother->SetInput( smoothField );
-    try
+    if( field->GetBufferedRegion().GetSize()[dimension] < 4 )
       {
-      smoother->Update();
+      useRecursiveGaussianSmoothing = false;
       }
-    catch( ExceptionObject & exc )
+    }
+
+  DisplacementFieldPointer smoothField;
+  if( useRecursiveGaussianSmoothing )
+    {
+    smoothField = this->RecursiveGaussianSmoothDisplacementField( field, variance );
+    }
+  else
+    {
+    typedef ImageDuplicator< DisplacementFieldType > DuplicatorType;
+    typename DuplicatorType::Pointer duplicator = DuplicatorType::New();
+    duplicator->SetInputImage( field );
+    duplicator->Update();
+
+    smoothField = duplicator->GetModifiableOutput();
+
+    typename GaussianSmoothingSmootherType::Pointer smoother = GaussianSmoothingSmootherType::New();
+
+    for( unsigned int dimension = 0; dimension < Superclass::Dimension; ++dimension )
       {
-      std::string msg("Caught exception: ");
-      msg += exc.what();
-      itkExceptionMacro( << msg );
-      }
+      // smooth along this dimension
+      this->m_GaussianSmoothingOperator.SetDirection( dimension );
+      this->m_GaussianSmoothingOperator.SetVariance( variance );
+      this->m_GaussianSmoothingOperator.SetMaximumError( 0.001 );
+      this->m_GaussianSmoothingOperator.SetMaximumKernelWidth( smoothField->GetRequestedRegion().GetSize()[dimension] );
+      this->m_GaussianSmoothingOperator.CreateDirectional();
+
+      // todo: make sure we only smooth within the buffered region
+      smoother->SetOperator( this->m_GaussianSmoothingOperator );
+      smoother->SetInput( smoothField );
+      try
+        {
+        smoother->Update();
+        }
+      catch( ExceptionObject & exc )
+        {
+        std::string msg("Caught exception: ");
+        msg += exc.what();
+        itkExceptionMacro( << msg );
+        }
 
-    smoothField = smoother->GetOutput();
-    smoothField->Update();
-    smoothField->DisconnectPipeline();
+      smoothField = smoother->GetOutput();
+      smoothField->Update();
+      smoothField->DisconnectPipeline();
+      }
     }
 
   const DisplacementVectorType zeroVector( 0.0 );
@@ -214,6 +234,73 @@ GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimen
   return field;
 }
 
+template<typename TParametersValueType, unsigned int NDimensions>
+typename GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimensions>::DisplacementFieldPointer
+GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimensions>
+::RecursiveGaussianSmoothDisplacementField( DisplacementFieldType *field, ScalarType variance )
+{
+  // The field is smoothed in place, unless it is averaged with the smoothed
+  // field afterwards.  In that case it is smoothed in the temporary field,
+  // which is kept for the next calls.
+  DisplacementFieldPointer smoothField = field;
+  if( variance < 0.5 )
+    {
+    if( this->m_GaussianSmoothingTempField.IsNull() ||
+        this->m_GaussianSmoothingTempField->GetBufferedRegion() != field->GetBufferedRegion() )
+      {
+      this->m_GaussianSmoothingTempField = DisplacementFieldType::New();
+      this->m_GaussianSmoothingTempField->CopyInformation( field );
+      this->m_GaussianSmoothingTempField->SetRegions( field->GetBufferedRegion() );
+      this->m_GaussianSmoothingTempField->Allocate();
+      }
+    this->m_GaussianSmoothingTempField->CopyInformation( field );
+    ImageAlgorithm::Copy< DisplacementFieldType, DisplacementFieldType >( field, this->m_GaussianSmoothingTempField,
+      field->GetBufferedRegion(), field->GetBufferedRegion() );
+    smoothField = this->m_GaussianSmoothingTempField;
+    }
+
+  typedef RecursiveGaussianImageFilter< DisplacementFieldType, DisplacementFieldType > RecursiveSmootherType;
+
+  // The filters run in place on an image sharing the buffer of the smoothed
+  // field, so that no other field is allocated.
+  DisplacementFieldPointer smootherInput = DisplacementFieldType::New();
+  smootherInput->Graft( smoothField );
+
+  for( unsigned int dimension = 0; dimension < Superclass::Dimension; ++dimension )
+    {
+    // The filter divides the sigma by the spacing.
+    typename RecursiveSmootherType::Pointer smoother = RecursiveSmootherType::New();
+    smoother->SetInput( smootherInput );
+    smoother->SetDirection( dimension );
+    smoother->SetSigma( std::sqrt( variance ) * smoothField->GetSpacing()[dimension] );
+    smoother->SetNormalizeAcrossScale( false );
+    smoother->InPlaceOn();
+    try
+      {
+      smoother->Update();
+      }
+    catch( ExceptionObject & exc )
+      {
+      std::string msg("Caught exception: ");
+      msg += exc.what();
+      itkExceptionMacro( << msg );
+      }
+
+    smootherInput = smoother->GetOutput();
+    smootherInput->DisconnectPipeline();
+    }
+
+  return smoothField;
+}
+
+template<typename TParametersValueType, unsigned int NDimensions>
+void
+GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimensions>
+::FreeGaussianSmoothingTempField()
+{
+  this->m_GaussianSmoothingTempField = ITK_NULLPTR;
+}
+
 template<typename TParametersValueType, unsigned int NDimensions>
 typename LightObject::Pointer
 GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimensions>
@@ -236,6 +323,8 @@ GaussianSmoothingOnUpdateDisplacementFieldTransform<TParametersValueType, NDimen
     (this->GetGaussianSmoothingVarianceForTheUpdateField());
   rval->SetGaussianSmoothingVarianceForTheTotalField
     (this->GetGaussianSmoothingVarianceForTheTotalField());
+  rval->SetUseRecursiveGaussianSmoothing
+    (this->GetUseRecursiveGaussianSmoothing());
 
   rval->SetFixedParameters(this->GetFixedParameters());
   rval->SetParameters(this->GetParameters());
@@ -254,6 +343,8 @@ PrintSelf( std::ostream& os, Indent indent ) const
      << indent << "m_GaussianSmoothingVarianceForTheUpdateField: " << this->m_GaussianSmoothingVarianceForTheUpdateField
      << std::endl
      << indent << "m_GaussianSmoothingVarianceForTheTotalField: " << this->m_GaussianSmoothingVarianceForTheTotalField
+     << std::endl
+     << indent << "m_UseRecursiveGaussianSmoothing: " << this->m_UseRecursiveGaussianSmoothing
      << std::endl;
 }
 } // namespace itk
@@ -168,7 +168,8 @@ protected:
   virtual void ThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId ) ITK_OVERRIDE;
 
   /** Default implementation for resampling that works for any
-   * transformation type.
+   * transformation type.  The physical points of each scanline are computed
+   * once and mapped with a single call to TransformPoints().
    */
   void NonlinearThreadedGenerateData( const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId );
 
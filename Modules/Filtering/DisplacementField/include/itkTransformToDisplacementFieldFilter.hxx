@@ -25,6 +25,8 @@
 #include "itkImageRegionIteratorWithIndex.h"
 #include "itkImageLinearIteratorWithIndex.h"
 
+#include <vector>
+
 namespace itk
 {
 
@@ -188,15 +190,27 @@ TransformToDisplacementFieldFilter< TOutputImage, TParametersValueType>
   const TransformType * transform = this->GetInput()->Get();
 
   // Create an iterator that will walk the output region for this thread.
-  typedef ImageRegionIteratorWithIndex< TOutputImage > OutputIteratorType;
+  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputIteratorType;
   OutputIteratorType outIt( output, outputRegionForThread );
 
+  outIt.SetDirection(0);
+
+  // The physical points of a scanline are computed once and transformed
+  // together with TransformPoints().
+  typedef typename TransformType::InputPointType  TransformInputPointType;
+  typedef typename TransformType::OutputPointType TransformOutputPointType;
+  const SizeValueType lineLength = outputRegionForThread.GetSize()[0];
+  std::vector< TransformInputPointType >  outputPoints( lineLength );
+  std::vector< TransformOutputPointType > transformedPoints( lineLength );
+
   // Define a few variables that will be used to translate from an input pixel
   // to an output pixel
   PointType outputPoint;         // Coordinates of output pixel
   PointType transformedPoint;    // Coordinates of transformed pixel
   PixelType displacement;         // the difference
 
+  IndexType index;
+
   // Support for progress methods/callbacks
   ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
 
@@ -204,20 +218,32 @@ TransformToDisplacementFieldFilter< TOutputImage, TParametersValueType>
   outIt.GoToBegin();
   while ( !outIt.IsAtEnd() )
     {
-    // Determine the index of the current output pixel
-    output->TransformIndexToPhysicalPoint( outIt.GetIndex(), outputPoint );
+    // Determine the physical points of the current scanline
+    index = outIt.GetIndex();
+    for ( SizeValueType x = 0; x < lineLength; ++x, ++index[0] )
+      {
+      output->TransformIndexToPhysicalPoint( index, outputPoint );
+      outputPoints[x] = outputPoint;
+      }
 
-    // Compute corresponding input pixel position
-    transformedPoint = transform->TransformPoint( outputPoint );
+    // Compute corresponding input pixel positions
+    transform->TransformPoints( &outputPoints[0], &transformedPoints[0], lineLength );
 
-    displacement = transformedPoint - outputPoint;
+    for ( SizeValueType x = 0; !outIt.IsAtEndOfLine(); ++x )
+      {
+      outputPoint = outputPoints[x];
+      transformedPoint = transformedPoints[x];
 
-    // Set it
-    outIt.Set( displacement );
+      displacement = transformedPoint - outputPoint;
+
+      // Set it
+      outIt.Set( displacement );
 
-    // Update progress and iterator
-    progress.CompletedPixel();
-    ++outIt;
+      // Update progress and iterator
+      progress.CompletedPixel();
+      ++outIt;
+      }
+    outIt.NextLine();
     }
 }
 
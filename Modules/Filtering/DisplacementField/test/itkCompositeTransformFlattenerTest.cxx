@@ -0,0 +1,169 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCompositeTransformFlattener.h"
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkEuler2DTransform.h"
+#include "itkTranslationTransform.h"
+#include "itkImageRegionIterator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::CompositeTransform< double, Dimension > CompositeTransformType;
+typedef CompositeTransformType::InputPointType       PointType;
+
+bool
+ComparePoints( const CompositeTransformType * expected, const CompositeTransformType * flattened,
+               double tolerance, double extent )
+{
+  for ( double x = 0.0; x <= extent; x += 1.7 )
+    {
+    for ( double y = 0.0; y <= extent; y += 2.3 )
+      {
+      PointType point;
+      point[0] = x;
+      point[1] = y;
+      const PointType expectedPoint = expected->TransformPoint( point );
+      const PointType flattenedPoint = flattened->TransformPoint( point );
+      if ( expectedPoint.EuclideanDistanceTo( flattenedPoint ) > tolerance )
+        {
+        std::cerr << "Point " << point << " is mapped to " << flattenedPoint
+                  << " instead of " << expectedPoint << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+}
+
+int itkCompositeTransformFlattenerTest( int, char *[] )
+{
+  typedef itk::AffineTransform< double, Dimension >      AffineTransformType;
+  typedef itk::Euler2DTransform< double >                EulerTransformType;
+  typedef itk::TranslationTransform< double, Dimension > TranslationTransformType;
+  typedef itk::BSplineTransform< double, Dimension, 3 >  BSplineTransformType;
+
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::OutputVectorType scale;
+  scale[0] = 1.2;
+  scale[1] = 0.8;
+  affine->Scale( scale );
+  affine->Shear( 0, 1, 0.1 );
+
+  EulerTransformType::Pointer euler = EulerTransformType::New();
+  euler->SetAngle( 0.3 );
+  EulerTransformType::InputPointType center;
+  center[0] = 10.0;
+  center[1] = 5.0;
+  euler->SetCenter( center );
+
+  TranslationTransformType::Pointer translation = TranslationTransformType::New();
+  TranslationTransformType::OutputVectorType offset;
+  offset[0] = 3.0;
+  offset[1] = -2.0;
+  translation->Translate( offset );
+
+  BSplineTransformType::Pointer bspline = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  physicalDimensions.Fill( 40.0 );
+  BSplineTransformType::MeshSizeType meshSize;
+  meshSize.Fill( 4 );
+  BSplineTransformType::OriginType origin;
+  origin.Fill( -5.0 );
+  bspline->SetTransformDomainOrigin( origin );
+  bspline->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bspline->SetTransformDomainMeshSize( meshSize );
+  BSplineTransformType::ParametersType parameters( bspline->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] = 0.5 * std::sin( 0.7 * i );
+    }
+  bspline->SetParametersByValue( parameters );
+
+  // Linear chain, with a nested composite transform.
+  CompositeTransformType::Pointer nested = CompositeTransformType::New();
+  nested->AddTransform( euler );
+  nested->AddTransform( translation );
+
+  CompositeTransformType::Pointer linear = CompositeTransformType::New();
+  linear->AddTransform( affine );
+  linear->AddTransform( nested );
+  linear->AddTransform( euler );
+
+  CompositeTransformType::Pointer flattenedLinear = linear->GetFlattenedTransform();
+  TEST_EXPECT_EQUAL( flattenedLinear->GetNumberOfTransforms(), 1 );
+  TEST_EXPECT_TRUE( flattenedLinear->IsLinear() );
+  TEST_EXPECT_TRUE( ComparePoints( linear, flattenedLinear, 1e-9, 30.0 ) );
+
+  // Mixed chain: the linear runs on both sides of the B-spline transform
+  // are merged separately.
+  CompositeTransformType::Pointer mixed = CompositeTransformType::New();
+  mixed->AddTransform( affine );
+  mixed->AddTransform( translation );
+  mixed->AddTransform( bspline );
+  mixed->AddTransform( bspline );
+  mixed->AddTransform( euler );
+  mixed->AddTransform( affine );
+
+  CompositeTransformType::Pointer flattenedMixed = mixed->GetFlattenedTransform();
+  TEST_EXPECT_EQUAL( flattenedMixed->GetNumberOfTransforms(), 4 );
+  TEST_EXPECT_TRUE( ComparePoints( mixed, flattenedMixed, 1e-9, 30.0 ) );
+
+  // Resampling the run of B-spline transforms into a displacement field.
+  typedef itk::CompositeTransformFlattener< double, Dimension > FlattenerType;
+  FlattenerType::Pointer flattener = FlattenerType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( flattener, CompositeTransformFlattener, Object );
+
+  flattener->SetTransform( mixed );
+  flattener->ResampleNonlinearTransformsOn();
+  TRY_EXPECT_EXCEPTION( flattener->Flatten() );
+
+  typedef FlattenerType::DisplacementFieldType FieldType;
+  FieldType::Pointer reference = FieldType::New();
+  FieldType::SizeType size;
+  size.Fill( 361 );
+  FieldType::SpacingType spacing;
+  spacing.Fill( 0.25 );
+  FieldType::PointType fieldOrigin;
+  fieldOrigin.Fill( -30.0 );
+  reference->SetRegions( size );
+  reference->SetSpacing( spacing );
+  reference->SetOrigin( fieldOrigin );
+  flattener->SetReferenceImage( reference );
+  TRY_EXPECT_NO_EXCEPTION( flattener->Flatten() );
+
+  CompositeTransformType::Pointer resampled = flattener->GetFlattenedTransform();
+  TEST_EXPECT_EQUAL( resampled->GetNumberOfTransforms(), 3 );
+  TEST_EXPECT_TRUE( dynamic_cast< const FlattenerType::DisplacementFieldTransformType * >(
+                      resampled->GetNthTransformConstPointer( 1 ) ) != ITK_NULLPTR );
+  // The B-spline transform is discontinuous at the border of its domain,
+  // where the linear interpolation of the field is not accurate.
+  TEST_EXPECT_TRUE( ComparePoints( mixed, resampled, 0.01, 20.0 ) );
+
+  flattener->ResampleNonlinearTransformsOff();
+  flattener->Flatten();
+  TEST_EXPECT_EQUAL( flattener->GetFlattenedTransform()->GetNumberOfTransforms(), 4 );
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -21,6 +21,24 @@
 #include "itkGaussianSmoothingOnUpdateDisplacementFieldTransform.h"
 #include "itkNumericTraits.h"
 #include "itkMath.h"
+#include "itkImageAlgorithm.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+template< typename TField >
+typename TField::Pointer
+CopyField( const TField * field )
+{
+  typename TField::Pointer copy = TField::New();
+  copy->CopyInformation( field );
+  copy->SetRegions( field->GetBufferedRegion() );
+  copy->Allocate();
+  itk::ImageAlgorithm::Copy( field, copy.GetPointer(), field->GetBufferedRegion(), copy->GetBufferedRegion() );
+  return copy;
+}
+}
 
 /**
  * Test the UpdateTransformParameters and related methods,
@@ -179,6 +197,78 @@ int itkGaussianSmoothingOnUpdateDisplacementFieldTransformTest(int ,char *[] )
     std::cout << std::endl;
     }
 
+  /* Test the recursive smoothing against the discrete smoothing on a smooth
+   * field with an anisotropic spacing. */
+  std::cout << "Testing the recursive Gaussian smoothing..." << std::endl;
+  DisplacementTransformType::Pointer recursiveTransform = DisplacementTransformType::New();
+  TEST_SET_GET_BOOLEAN( recursiveTransform, UseRecursiveGaussianSmoothing, false );
+  recursiveTransform->UseRecursiveGaussianSmoothingOn();
+  TEST_SET_GET_BOOLEAN( recursiveTransform, UseRecursiveGaussianSmoothing, true );
+
+  FieldType::SizeType smoothSize;
+  smoothSize[0] = 64;
+  smoothSize[1] = 48;
+  FieldType::SpacingType smoothSpacing;
+  smoothSpacing[0] = 1.0;
+  smoothSpacing[1] = 2.0;
+  const double variances[] = { 0.25, 4.0, 16.0 };
+  for( unsigned int v = 0; v < 3; ++v )
+    {
+    FieldType::Pointer discreteField = FieldType::New();
+    discreteField->SetRegions( smoothSize );
+    discreteField->SetSpacing( smoothSpacing );
+    discreteField->Allocate();
+    itk::ImageRegionIteratorWithIndex< FieldType > fieldIt( discreteField, discreteField->GetLargestPossibleRegion() );
+    for( fieldIt.GoToBegin(); !fieldIt.IsAtEnd(); ++fieldIt )
+      {
+      DisplacementTransformType::OutputVectorType vector;
+      vector[0] = std::sin( 0.2 * fieldIt.GetIndex()[0] ) * std::cos( 0.1 * fieldIt.GetIndex()[1] );
+      vector[1] = std::cos( 0.15 * fieldIt.GetIndex()[0] + 0.3 * fieldIt.GetIndex()[1] );
+      fieldIt.Set( vector );
+      }
+    FieldType::Pointer recursiveField = CopyField< FieldType >( discreteField );
+    FieldType::Pointer reusedField = CopyField< FieldType >( discreteField );
+    FieldType::Pointer freshField = CopyField< FieldType >( discreteField );
+
+    displacementTransform->GaussianSmoothDisplacementField( discreteField, variances[v] );
+    recursiveTransform->GaussianSmoothDisplacementField( recursiveField, variances[v] );
+
+    // The temporary field of the first call is reused by a second call on a
+    // field of the same size, which gives the result of a fresh transform.
+    const double secondVariance = variances[( v + 1 ) % 3];
+    recursiveTransform->GaussianSmoothDisplacementField( reusedField, secondVariance );
+    DisplacementTransformType::Pointer freshTransform = DisplacementTransformType::New();
+    freshTransform->UseRecursiveGaussianSmoothingOn();
+    freshTransform->GaussianSmoothDisplacementField( freshField, secondVariance );
+    for( itk::SizeValueType i = 0; i < reusedField->GetBufferedRegion().GetNumberOfPixels(); ++i )
+      {
+      if( reusedField->GetBufferPointer()[i] != freshField->GetBufferPointer()[i] )
+        {
+        std::cout << "The smoothing with a reused temporary field differs from the smoothing "
+                  << "with a fresh transform at pixel " << i << "." << std::endl;
+        return EXIT_FAILURE;
+        }
+      }
+
+    double maximumDifference = 0.0;
+    for( itk::SizeValueType i = 0; i < discreteField->GetBufferedRegion().GetNumberOfPixels(); ++i )
+      {
+      for( unsigned int d = 0; d < dimensions; ++d )
+        {
+        maximumDifference = std::max( maximumDifference, std::abs(
+          discreteField->GetBufferPointer()[i][d] - recursiveField->GetBufferPointer()[i][d] ) );
+        }
+      }
+    std::cout << "Variance " << variances[v] << ": maximum difference with the discrete smoothing "
+              << maximumDifference << std::endl;
+    if( maximumDifference > 0.02 )
+      {
+      std::cout << "The recursive smoothing differs from the discrete smoothing." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  recursiveTransform->FreeGaussianSmoothingTempField();
+
   /* Exercise Get/Set sigma */
   displacementTransform->SetGaussianSmoothingVarianceForTheUpdateField(2);
   std::cout << "sigma: "
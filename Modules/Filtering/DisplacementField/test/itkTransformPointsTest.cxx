@@ -0,0 +1,252 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAffineTransform.h"
+#include "itkAzimuthElevationToCartesianTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkCenteredAffineTransform.h"
+#include "itkCenteredEuler3DTransform.h"
+#include "itkCenteredRigid2DTransform.h"
+#include "itkCenteredSimilarity2DTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkEuler2DTransform.h"
+#include "itkEuler3DTransform.h"
+#include "itkFixedCenterOfRotationAffineTransform.h"
+#include "itkQuaternionRigidTransform.h"
+#include "itkRigid2DTransform.h"
+#include "itkScalableAffineTransform.h"
+#include "itkScaleLogarithmicTransform.h"
+#include "itkScaleSkewVersor3DTransform.h"
+#include "itkScaleTransform.h"
+#include "itkScaleVersor3DTransform.h"
+#include "itkSimilarity2DTransform.h"
+#include "itkSimilarity3DTransform.h"
+#include "itkVersorRigid3DTransform.h"
+#include "itkVersorTransform.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkImageRegionIterator.h"
+#include "itkMath.h"
+
+#include <vector>
+
+/**
+ * Check that Transform::TransformPoints() gives the same points as
+ * TransformPoint() called on each point, for the transforms that override
+ * it and for every subclass of MatrixOffsetTransformBase, both out of place
+ * and in place.
+ */
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+template< unsigned int VDimension >
+bool
+TestTransformPoints( const itk::Transform< double, VDimension, VDimension > * transform, const char * name )
+{
+  typedef typename itk::Transform< double, VDimension, VDimension >::InputPointType PointType;
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  // A scanline of points, as in the resampling filters, and points
+  // scattered inside and around the domain of the transforms.
+  const unsigned int numberOfPoints = 500;
+  std::vector< PointType > points( numberOfPoints );
+  for ( unsigned int i = 0; i < numberOfPoints; ++i )
+    {
+    for ( unsigned int j = 0; j < VDimension; ++j )
+      {
+      if ( i < numberOfPoints / 2 )
+        {
+        points[i][j] = ( j == 0 ) ? -5.0 + 0.25 * i : 3.3 * j;
+        }
+      else
+        {
+        points[i][j] = generator->GetUniformVariate( -15.0, 45.0 );
+        }
+      }
+    }
+
+  std::vector< PointType > transformedPoints( numberOfPoints );
+  transform->TransformPoints( &points[0], &transformedPoints[0], numberOfPoints );
+
+  std::vector< PointType > inPlacePoints( points );
+  transform->TransformPoints( &inPlacePoints[0], &inPlacePoints[0], numberOfPoints );
+
+  for ( unsigned int i = 0; i < numberOfPoints; ++i )
+    {
+    const PointType expected = transform->TransformPoint( points[i] );
+    for ( unsigned int j = 0; j < VDimension; ++j )
+      {
+      if ( !itk::Math::FloatAlmostEqual( expected[j], transformedPoints[i][j], 4, 1e-9 )
+           || !itk::Math::FloatAlmostEqual( expected[j], inPlacePoints[i][j], 4, 1e-9 ) )
+        {
+        std::cerr << "Test failed for " << name << " at point " << points[i] << std::endl;
+        std::cerr << "Expected " << expected << " but got " << transformedPoints[i]
+                  << " and in place " << inPlacePoints[i] << std::endl;
+        return false;
+        }
+      }
+    }
+  std::cout << name << " passed." << std::endl;
+  return true;
+}
+
+// Perturb the parameters and the center of a subclass of
+// MatrixOffsetTransformBase, whose TransformPoints() may only use the
+// matrix and offset when TransformPoint() does.
+template< typename TTransform >
+bool
+TestMatrixOffsetTransformPoints( const char * name )
+{
+  const unsigned int TransformDimension = TTransform::InputSpaceDimension;
+
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 4321 );
+
+  typename TTransform::Pointer transform = TTransform::New();
+  typename TTransform::InputPointType center;
+  for ( unsigned int j = 0; j < TransformDimension; ++j )
+    {
+    center[j] = generator->GetUniformVariate( -3.0, 3.0 );
+    }
+  transform->SetCenter( center );
+  typename TTransform::ParametersType parameters = transform->GetParameters();
+  for ( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] += generator->GetUniformVariate( -0.3, 0.3 );
+    }
+  transform->SetParameters( parameters );
+
+  return TestTransformPoints< TransformDimension >( transform, name );
+}
+}
+
+int itkTransformPointsTest( int, char *[] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 5678 );
+
+  typedef itk::AffineTransform< double, Dimension > AffineTransformType;
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  AffineTransformType::ParametersType affineParameters( affine->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < affineParameters.Size(); ++i )
+    {
+    affineParameters[i] = generator->GetUniformVariate( -1.0, 1.0 );
+    }
+  affine->SetParameters( affineParameters );
+
+  typedef itk::BSplineTransform< double, Dimension, 3 > BSplineTransformType;
+  BSplineTransformType::Pointer bspline = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  BSplineTransformType::MeshSizeType           meshSize;
+  BSplineTransformType::OriginType             origin;
+  physicalDimensions.Fill( 30.0 );
+  meshSize[0] = 4;
+  meshSize[1] = 3;
+  meshSize[2] = 5;
+  origin.Fill( -2.0 );
+  bspline->SetTransformDomainOrigin( origin );
+  bspline->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bspline->SetTransformDomainMeshSize( meshSize );
+  BSplineTransformType::ParametersType bsplineParameters( bspline->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < bsplineParameters.Size(); ++i )
+    {
+    bsplineParameters[i] = generator->GetUniformVariate( -2.0, 2.0 );
+    }
+  bspline->SetParametersByValue( bsplineParameters );
+
+  typedef itk::DisplacementFieldTransform< double, Dimension > DisplacementFieldTransformType;
+  typedef DisplacementFieldTransformType::DisplacementFieldType FieldType;
+  FieldType::Pointer field = FieldType::New();
+  FieldType::SizeType size;
+  size.Fill( 12 );
+  FieldType::SpacingType spacing;
+  spacing.Fill( 2.5 );
+  field->SetRegions( size );
+  field->SetSpacing( spacing );
+  field->Allocate();
+  itk::ImageRegionIterator< FieldType > it( field, field->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType displacement;
+    for ( unsigned int j = 0; j < Dimension; ++j )
+      {
+      displacement[j] = generator->GetUniformVariate( -1.0, 1.0 );
+      }
+    it.Set( displacement );
+    }
+  DisplacementFieldTransformType::Pointer displacementField = DisplacementFieldTransformType::New();
+  displacementField->SetDisplacementField( field );
+
+  typedef itk::CompositeTransform< double, Dimension > CompositeTransformType;
+  CompositeTransformType::Pointer composite = CompositeTransformType::New();
+  composite->AddTransform( affine );
+  composite->AddTransform( bspline );
+  composite->AddTransform( displacementField );
+
+  bool passed = true;
+  passed &= TestTransformPoints< Dimension >( affine, "AffineTransform" );
+  passed &= TestTransformPoints< Dimension >( bspline, "BSplineTransform" );
+  passed &= TestTransformPoints< Dimension >( displacementField, "DisplacementFieldTransform" );
+  passed &= TestTransformPoints< Dimension >( composite, "CompositeTransform" );
+
+  // The azimuth-elevation transform derives from AffineTransform but is not
+  // linear, and the scale transform computes its points around its center.
+  typedef itk::AzimuthElevationToCartesianTransform< double, Dimension > AzimuthElevationTransformType;
+  AzimuthElevationTransformType::Pointer azimuthElevation = AzimuthElevationTransformType::New();
+  azimuthElevation->SetAzimuthElevationToCartesianParameters( 0.5, 2.0, 40, 30, 1.5, 2.0 );
+  passed &= TestTransformPoints< Dimension >( azimuthElevation, "AzimuthElevationToCartesianTransform" );
+  azimuthElevation->SetForwardCartesianToAzimuthElevation();
+  passed &= TestTransformPoints< Dimension >( azimuthElevation, "AzimuthElevationToCartesianTransform inverse" );
+
+  passed &= TestMatrixOffsetTransformPoints< itk::MatrixOffsetTransformBase< double, 3, 3 > >( "MatrixOffsetTransformBase 3D" );
+  passed &= TestMatrixOffsetTransformPoints< itk::MatrixOffsetTransformBase< double, 2, 2 > >( "MatrixOffsetTransformBase 2D" );
+  passed &= TestMatrixOffsetTransformPoints< itk::AffineTransform< double, 3 > >( "AffineTransform 3D" );
+  passed &= TestMatrixOffsetTransformPoints< itk::AffineTransform< double, 2 > >( "AffineTransform 2D" );
+  passed &= TestMatrixOffsetTransformPoints< itk::CenteredAffineTransform< double, 3 > >( "CenteredAffineTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::FixedCenterOfRotationAffineTransform< double, 3 > >( "FixedCenterOfRotationAffineTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::ScalableAffineTransform< double, 3 > >( "ScalableAffineTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::ScaleTransform< double, 3 > >( "ScaleTransform 3D" );
+  passed &= TestMatrixOffsetTransformPoints< itk::ScaleTransform< double, 2 > >( "ScaleTransform 2D" );
+  passed &= TestMatrixOffsetTransformPoints< itk::ScaleLogarithmicTransform< double, 3 > >( "ScaleLogarithmicTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::Rigid2DTransform< double > >( "Rigid2DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::Euler2DTransform< double > >( "Euler2DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::CenteredRigid2DTransform< double > >( "CenteredRigid2DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::Similarity2DTransform< double > >( "Similarity2DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::CenteredSimilarity2DTransform< double > >( "CenteredSimilarity2DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::Euler3DTransform< double > >( "Euler3DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::CenteredEuler3DTransform< double > >( "CenteredEuler3DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::QuaternionRigidTransform< double > >( "QuaternionRigidTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::VersorTransform< double > >( "VersorTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::VersorRigid3DTransform< double > >( "VersorRigid3DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::Similarity3DTransform< double > >( "Similarity3DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::ScaleVersor3DTransform< double > >( "ScaleVersor3DTransform" );
+  passed &= TestMatrixOffsetTransformPoints< itk::ScaleSkewVersor3DTransform< double > >( "ScaleSkewVersor3DTransform" );
+
+  if ( !passed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -19,6 +19,7 @@
 #define itkSignedMaurerDistanceMapImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include <vector>
 
 namespace itk
 {
@@ -171,7 +172,23 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(SignedMaurerDistanceMapImageFilter);
 
-  void Voronoi(unsigned int, OutputIndexType idx, OutputImageType *output );
+  /** Compute the distance along the dimension d of a group of lines
+   * consecutive along the first dimension, starting at idx. */
+  void Voronoi(unsigned int d, OutputIndexType idx, OutputSizeValueType numberOfLines, OutputImageType *output,
+               std::vector< OutputPixelType > & lines, std::vector< OutputPixelType > & g,
+               std::vector< OutputPixelType > & h, std::vector< bool > & hasBackground);
+
+  /** Mark the boundary pixels of the binary object along a line of the
+   * first dimension. hasBackground is a scratch buffer of the length of
+   * the line. */
+  void ComputeBoundary(OutputIndexType idx, OutputPixelType *line, std::vector< bool > & hasBackground);
+
+  /** Sign a distance according to the input pixel value. */
+  OutputPixelType GetSignedDistance(OutputPixelType distance, const InputPixelType & inputValue) const;
+
+  /** Compute the signed distance from a squared distance. */
+  OutputPixelType GetSignedSquareRoot(OutputPixelType squaredDistance, const InputPixelType & inputValue) const;
+
   bool Remove(OutputPixelType, OutputPixelType, OutputPixelType,
               OutputPixelType, OutputPixelType, OutputPixelType);
 
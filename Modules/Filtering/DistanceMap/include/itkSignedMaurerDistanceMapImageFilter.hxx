@@ -26,7 +26,8 @@
 #include "itkProgressAccumulator.h"
 #include "itkMath.h"
 #include "vnl/vnl_vector.h"
-#include "itkMath.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -116,53 +117,15 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   ThreadIdType nbthreads = this->GetNumberOfThreads();
 
   OutputImageType *outputPtr = this->GetOutput();
-  const InputImageType *inputPtr = this->GetInput();
   m_InputCache = this->GetInput();
 
   // prepare the data
   this->AllocateOutputs();
   this->m_Spacing = outputPtr->GetSpacing();
 
-  // store the binary image in an image with a pixel type as small as possible
-  // instead of keeping the native input pixel type to avoid using too much
-  // memory.
-  typedef BinaryThresholdImageFilter< InputImageType,
-                                      OutputImageType > BinaryFilterType;
-
-  ProgressAccumulator::Pointer progressAcc = ProgressAccumulator::New();
-  progressAcc->SetMiniPipelineFilter(this);
-
-  // compute the boundary of the binary object.
-  // To do that, we erode the binary object. The eroded pixels are the ones
-  // on the boundary. We mark them with the value 2
-  typename BinaryFilterType::Pointer binaryFilter = BinaryFilterType::New();
-
-  binaryFilter->SetLowerThreshold(this->m_BackgroundValue);
-  binaryFilter->SetUpperThreshold(this->m_BackgroundValue);
-  binaryFilter->SetInsideValue( NumericTraits< OutputPixelType >::max() );
-  binaryFilter->SetOutsideValue( NumericTraits< OutputPixelType >::ZeroValue() );
-  binaryFilter->SetInput( inputPtr );
-  binaryFilter->SetNumberOfThreads( nbthreads );
-  progressAcc->RegisterInternalFilter( binaryFilter, 0.1f );
-  binaryFilter->GraftOutput( outputPtr );
-  binaryFilter->Update();
-
-  // Dilate the inverted image by 1 pixel to give it the same boundary
-  // as the univerted inputPtr.
-  typedef BinaryContourImageFilter< OutputImageType,
-                                    OutputImageType > BorderFilterType;
-  typename BorderFilterType::Pointer borderFilter = BorderFilterType::New();
-  borderFilter->SetInput( binaryFilter->GetOutput() );
-  borderFilter->SetForegroundValue( NumericTraits< OutputPixelType >::ZeroValue() );
-  borderFilter->SetBackgroundValue( NumericTraits< OutputPixelType >::max() );
-  borderFilter->SetFullyConnected( true );
-  borderFilter->SetNumberOfThreads( nbthreads );
-  progressAcc->RegisterInternalFilter( borderFilter, 0.23f );
-  borderFilter->Update();
-
-  this->GraftOutput( borderFilter->GetOutput() );
-
-  // Set up the multithreaded processing
+  // Set up the multithreaded processing. The boundary of the binary object
+  // is computed while processing the first dimension, and the square root
+  // is computed while processing the last one.
   typename ImageSource< OutputImageType >::ThreadStruct str;
   str.Filter = this;
 
@@ -184,139 +147,117 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
 {
-  OutputImageType      *outputImage = this->GetOutput();
-
-  InputRegionType region = outputRegionForThread;
-  InputSizeType   size   = region.GetSize();
-  InputIndexType  startIndex = outputRegionForThread.GetIndex();
-
-  OutputImageType      *outputPtr = this->GetOutput();
-
-  // compute the number of rows first, so we can setup a progress reporter
-  std::vector< InputSizeValueType > NumberOfRows;
-  for ( unsigned int i = 0; i < InputImageDimension; i++ )
+  OutputImageType *outputImage = this->GetOutput();
+  const unsigned int d = m_CurrentDimension;
+  const OutputSizeValueType nd = outputImage->GetRequestedRegion().GetSize()[d];
+
+  // the first pixel of each line processed by this thread
+  OutputImageRegionType lineStartRegion = outputRegionForThread;
+  lineStartRegion.SetIndex( d, outputImage->GetRequestedRegion().GetIndex()[d] );
+  lineStartRegion.SetSize( d, 1 );
+
+  const float progressPerDimension = 1.0f / static_cast< float >( ImageDimension );
+  ProgressReporter progress(this,
+                            threadId,
+                            lineStartRegion.GetNumberOfPixels(),
+                            30,
+                            static_cast< float >( d ) * progressPerDimension,
+                            progressPerDimension);
+
+  // The lines of the other dimensions are strided in memory: several lines
+  // consecutive along the first dimension are copied together in a
+  // contiguous buffer, so that the memory is read and written in blocks.
+  const OutputSizeValueType maximumNumberOfLines = ( d == 0 ) ? 1 : 16;
+
+  // scratch buffers, reused for all the lines of the thread
+  std::vector< OutputPixelType > lines( maximumNumberOfLines * nd );
+  std::vector< OutputPixelType > g( nd );
+  std::vector< OutputPixelType > h( nd );
+  std::vector< bool >            hasBackground( ( d == 0 ) ? nd : 0 );
+
+  ImageRegionConstIteratorWithIndex< OutputImageType > it( outputImage, lineStartRegion );
+  while ( !it.IsAtEnd() )
     {
-    NumberOfRows.push_back(1);
-    for ( unsigned int d = 0; d < InputImageDimension; d++ )
+    const OutputIndexType idx = it.GetIndex();
+    OutputSizeValueType   numberOfLines = 0;
+    do
       {
-      if ( d != i )
-        {
-        NumberOfRows[i] *= size[d];
-        }
+      ++numberOfLines;
+      ++it;
       }
-    }
+    while ( numberOfLines < maximumNumberOfLines && !it.IsAtEnd()
+            && it.GetIndex()[0] == idx[0] + static_cast< OutputIndexValueType >( numberOfLines ) );
 
-  // set the progress reporter. Use a pointer to be able to destroy it before
-  // the creation of progress2
-  // so it won't set wrong progress at the end of ThreadedGenerateData()
-  float progressPerDimension = 0.67f / static_cast< float >( ImageDimension );
-  if ( !this->m_SquaredDistance )
-    {
-    progressPerDimension = 0.67f / ( static_cast< float >( ImageDimension ) + 1 );
+    this->Voronoi(d, idx, numberOfLines, outputImage, lines, g, h, hasBackground);
+    progress.CompletedPixel();
+    for ( OutputSizeValueType n = 1; n < numberOfLines; n++ )
+      {
+      progress.CompletedPixel();
+      }
     }
-  ProgressReporter *progress =
-      new ProgressReporter(this,
-                           threadId,
-                           NumberOfRows[m_CurrentDimension],
-                           30,
-                           0.33f + static_cast< float >( m_CurrentDimension * progressPerDimension ),
-                           progressPerDimension);
-
-  // This variable provides the amount by which to divide the dimensionless index in order to get the index for each dimension.
-  vnl_vector< unsigned int > k(InputImageDimension - 1);
-  unsigned int count = 0;
-  k[count] = 1;
-  for ( unsigned int d = m_CurrentDimension + InputImageDimension - 1;
-         d > m_CurrentDimension + 1;
-         d-- )
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
+::ComputeBoundary(OutputIndexType idx, OutputPixelType *line, std::vector< bool > & hasBackground)
+{
+  // The boundary pixels are the object pixels with a background pixel
+  // in their fully connected neighborhood. They are marked with 0, and
+  // all the other pixels with the maximum value.
+  const OutputRegionType region = this->GetOutput()->GetRequestedRegion();
+  const OutputSizeValueType nd = region.GetSize()[0];
+  const InputPixelType *inputBuffer = m_InputCache->GetBufferPointer();
+
+  // hasBackground[i] is true if one of the neighbor lines has a
+  // background pixel at the position i
+  std::fill( hasBackground.begin(), hasBackground.end(), false );
+  unsigned int numberOfNeighborLines = 1;
+  for ( unsigned int i = 1; i < ImageDimension; i++ )
     {
-    k[count+1] = k[count] * size[d % InputImageDimension];
-    count++;
+    numberOfNeighborLines *= 3;
     }
-  k.flip();
-
-  // The index is defined as the dimensionless index into the pixel.
-  // It must be divided by each dimension size in order to get the index for that dimension.
-  // The result of this division is the offsetIndex, which is the index offset relative to the region of this thread.
-  // The true pixel location (idx) is provided by the sum of the offsetIndex and the startIndex.
-  InputSizeValueType index;
-  OutputIndexType offsetIndex;
-  offsetIndex.Fill(0);
-  InputSizeValueType tempRow = NumberOfRows[m_CurrentDimension];
-  OutputIndexType idx;
-  idx.Fill(0);
-
-  for ( InputSizeValueType n = 0; n < tempRow; n++ )
+  for ( unsigned int n = 0; n < numberOfNeighborLines; n++ )
     {
-    index = n;
-    count = 0;
-    for ( unsigned int d = m_CurrentDimension + 1;
-         d < m_CurrentDimension + InputImageDimension; d++ )
+    InputIndexType neighborIdx = idx;
+    bool           isInside = true;
+    unsigned int   code = n;
+    for ( unsigned int i = 1; i < ImageDimension; i++ )
       {
-      offsetIndex[d % InputImageDimension] = static_cast< OutputIndexValueType >( static_cast< double >( index ) / static_cast< double >( k[count] ) );
-      idx[d % InputImageDimension] = offsetIndex[d % InputImageDimension] + static_cast< OutputIndexValueType >( startIndex[d % InputImageDimension] );
-
-      index %= k[count];
-      count++;
+      neighborIdx[i] += static_cast< InputIndexValueType >( code % 3 ) - 1;
+      code /= 3;
+      if ( neighborIdx[i] < region.GetIndex()[i]
+           || neighborIdx[i] >= region.GetIndex()[i] + static_cast< InputIndexValueType >( region.GetSize()[i] ) )
+        {
+        isInside = false;
+        }
+      }
+    if ( !isInside )
+      {
+      continue;
+      }
+    const InputPixelType *neighborLine = inputBuffer + m_InputCache->ComputeOffset(neighborIdx);
+    for ( OutputSizeValueType i = 0; i < nd; i++ )
+      {
+      if ( Math::ExactlyEquals( neighborLine[i], this->m_BackgroundValue ) )
+        {
+        hasBackground[i] = true;
+        }
       }
-    this->Voronoi(m_CurrentDimension, idx,outputImage);
-    progress->CompletedPixel();
     }
-  delete progress;
 
-  if ( m_CurrentDimension == ImageDimension - 1 && !this->m_SquaredDistance )
+  const InputPixelType *inputLine = inputBuffer + m_InputCache->ComputeOffset(idx);
+  for ( OutputSizeValueType i = 0; i < nd; i++ )
     {
-    typedef ImageRegionIterator< OutputImageType >      OutputIterator;
-    typedef ImageRegionConstIterator< InputImageType  > InputIterator;
-
-    typename OutputImageType::RegionType outputRegion = outputRegionForThread;
-
-    OutputIterator Ot(outputPtr, outputRegion);
-    InputIterator  It(m_InputCache,  outputRegion);
-
-    Ot.GoToBegin();
-    It.GoToBegin();
-
-    ProgressReporter progress2(this, threadId,
-                               outputRegionForThread.GetNumberOfPixels(), 30,
-                               0.33f + static_cast< float >( ImageDimension * progressPerDimension ),
-                               progressPerDimension);
-
-    typedef typename NumericTraits< OutputPixelType >::RealType OutputRealType;
-
-    while ( !Ot.IsAtEnd() )
+    line[i] = NumericTraits< OutputPixelType >::max();
+    if ( Math::NotExactlyEquals( inputLine[i], this->m_BackgroundValue ) )
       {
-      // cast to a real type is required on some platforms
-      const OutputPixelType outputValue =
-        static_cast< OutputPixelType >(
-          std::sqrt( static_cast< OutputRealType >( itk::Math::abs( Ot.Get() ) ) ) );
-
-      if ( Math::NotExactlyEquals( It.Get(), this->m_BackgroundValue ) )
+      if ( hasBackground[i]
+           || ( i > 0 && hasBackground[i - 1] )
+           || ( i + 1 < nd && hasBackground[i + 1] ) )
         {
-        if ( this->GetInsideIsPositive() )
-          {
-          Ot.Set(outputValue);
-          }
-        else
-          {
-          Ot.Set(-outputValue);
-          }
+        line[i] = NumericTraits< OutputPixelType >::ZeroValue();
         }
-      else
-        {
-        if ( this->GetInsideIsPositive() )
-          {
-          Ot.Set(-outputValue);
-          }
-        else
-          {
-          Ot.Set(outputValue);
-          }
-        }
-
-      ++Ot;
-      ++It;
-      progress2.CompletedPixel();
       }
     }
 }
@@ -324,125 +265,179 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 template< typename TInputImage, typename TOutputImage >
 void
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
-::Voronoi(unsigned int d, OutputIndexType idx, OutputImageType *output)
+::Voronoi(unsigned int d, OutputIndexType idx, OutputSizeValueType numberOfLines, OutputImageType *output,
+          std::vector< OutputPixelType > & lines, std::vector< OutputPixelType > & g,
+          std::vector< OutputPixelType > & h, std::vector< bool > & hasBackground)
 {
   OutputRegionType      oRegion = output->GetRequestedRegion();
   OutputSizeValueType   nd = oRegion.GetSize()[d];
 
-  vnl_vector< OutputPixelType > g(nd, 0 );
-  vnl_vector< OutputPixelType > h(nd, 0 );
-
+  OutputPixelType *outputLine = output->GetBufferPointer() + output->ComputeOffset(idx);
+  const OffsetValueType outputStride = output->GetOffsetTable()[d];
+  const InputPixelType *inputLine = m_InputCache->GetBufferPointer() + m_InputCache->ComputeOffset(idx);
+  const OffsetValueType inputStride = m_InputCache->GetOffsetTable()[d];
 
-  InputRegionType iRegion = m_InputCache->GetRequestedRegion();
-  InputIndexType startIndex = iRegion.GetIndex();
-
-  OutputPixelType di;
+  // copy the lines in the contiguous buffer
+  if ( d == 0 )
+    {
+    this->ComputeBoundary(idx, &lines[0], hasBackground);
+    }
+  else
+    {
+    for ( OutputSizeValueType i = 0; i < nd; i++ )
+      {
+      const OutputPixelType *pixel = outputLine + i * outputStride;
+      for ( OutputSizeValueType n = 0; n < numberOfLines; n++ )
+        {
+        lines[n * nd + i] = pixel[n];
+        }
+      }
+    }
 
-  int l = -1;
+  const bool computeSquareRoot = ( d == ImageDimension - 1 && !this->m_SquaredDistance );
 
-  for ( unsigned int i = 0; i < nd; i++ )
+  for ( OutputSizeValueType n = 0; n < numberOfLines; n++ )
     {
-    idx[d] = i + startIndex[d];
+    OutputPixelType *line = &lines[n * nd];
 
-    di = output->GetPixel(idx);
+    OutputPixelType di;
 
-    OutputPixelType iw;
+    int l = -1;
 
-    if ( this->GetUseImageSpacing() )
+    for ( unsigned int i = 0; i < nd; i++ )
       {
-      iw = static_cast< OutputPixelType >( i ) *
-           static_cast< OutputPixelType >( this->m_Spacing[d] );
-      }
-    else
-      {
-      iw  = static_cast< OutputPixelType >( i );
-      }
+      di = line[i];
 
-    if ( Math::NotExactlyEquals( di, NumericTraits< OutputPixelType >::max() ) )
-      {
-      if ( l < 1 )
+      OutputPixelType iw;
+
+      if ( this->GetUseImageSpacing() )
         {
-        l++;
-        g(l) = di;
-        h(l) = iw;
+        iw = static_cast< OutputPixelType >( i ) *
+             static_cast< OutputPixelType >( this->m_Spacing[d] );
         }
       else
         {
-        while ( ( l >= 1 )
-                && this->Remove(g(l - 1), g(l), di, h(l - 1), h(l), iw) )
+        iw  = static_cast< OutputPixelType >( i );
+        }
+
+      if ( Math::NotExactlyEquals( di, NumericTraits< OutputPixelType >::max() ) )
+        {
+        if ( l < 1 )
           {
-          l--;
+          l++;
+          g[l] = di;
+          h[l] = iw;
+          }
+        else
+          {
+          while ( ( l >= 1 )
+                  && this->Remove(g[l - 1], g[l], di, h[l - 1], h[l], iw) )
+            {
+            l--;
+            }
+          l++;
+          g[l] = di;
+          h[l] = iw;
           }
-        l++;
-        g(l) = di;
-        h(l) = iw;
         }
       }
-    }
 
-  if ( l == -1 )
-    {
-    return;
-    }
+    OutputPixelType *       outputPixel = outputLine + n * output->GetOffsetTable()[0];
+    const InputPixelType *  inputPixel = inputLine + n * m_InputCache->GetOffsetTable()[0];
 
-  int ns = l;
-
-  l = 0;
-
-  for ( unsigned int i = 0; i < nd; i++ )
-    {
-    OutputPixelType iw;
-
-    if ( this->GetUseImageSpacing() )
-      {
-      iw = static_cast< OutputPixelType >( i * this->m_Spacing[d] );
-      }
-    else
-      {
-      iw = static_cast< OutputPixelType >( i );
-      }
-
-    OutputPixelType d1 = itk::Math::abs( g(l) ) + ( h(l) - iw ) * ( h(l) - iw );
-
-    while ( l < ns )
+    if ( l == -1 )
       {
-      // be sure to compute d2 *only* if l < ns
-      OutputPixelType d2 = itk::Math::abs( g(l + 1) ) + ( h(l + 1) - iw ) * ( h(l + 1) - iw );
-      // then compare d1 and d2
-      if ( d1 <= d2 )
+      // no object along this line: the pixels are left unchanged, but the
+      // distance must be computed from them on the last dimension
+      if ( computeSquareRoot )
         {
-        break;
+        for ( unsigned int i = 0; i < nd; i++ )
+          {
+          outputPixel[i * outputStride] = this->GetSignedSquareRoot(line[i], inputPixel[i * inputStride]);
+          }
         }
-      l++;
-      d1 = d2;
+      else if ( d == 0 )
+        {
+        for ( unsigned int i = 0; i < nd; i++ )
+          {
+          outputPixel[i * outputStride] = line[i];
+          }
+        }
+      continue;
       }
-    idx[d] = i + startIndex[d];
 
-    if ( Math::NotExactlyEquals( m_InputCache->GetPixel(idx), this->m_BackgroundValue ) )
+    int ns = l;
+
+    l = 0;
+
+    for ( unsigned int i = 0; i < nd; i++ )
       {
-      if ( this->m_InsideIsPositive )
+      OutputPixelType iw;
+
+      if ( this->GetUseImageSpacing() )
         {
-        output->SetPixel(idx,  d1);
+        iw = static_cast< OutputPixelType >( i * this->m_Spacing[d] );
         }
       else
         {
-        output->SetPixel(idx, -d1);
+        iw = static_cast< OutputPixelType >( i );
         }
-      }
-    else
-      {
-      if ( this->m_InsideIsPositive )
+
+      OutputPixelType d1 = itk::Math::abs( g[l] ) + ( h[l] - iw ) * ( h[l] - iw );
+
+      while ( l < ns )
+        {
+        // be sure to compute d2 *only* if l < ns
+        OutputPixelType d2 = itk::Math::abs( g[l + 1] ) + ( h[l + 1] - iw ) * ( h[l + 1] - iw );
+        // then compare d1 and d2
+        if ( d1 <= d2 )
+          {
+          break;
+          }
+        l++;
+        d1 = d2;
+        }
+
+      // the square root is taken on the signed squared distance, as a
+      // separate pass over the output would do
+      const OutputPixelType signedDistance = this->GetSignedDistance(d1, inputPixel[i * inputStride]);
+      if ( computeSquareRoot )
         {
-        output->SetPixel(idx, -d1);
+        outputPixel[i * outputStride] = this->GetSignedSquareRoot(signedDistance, inputPixel[i * inputStride]);
         }
       else
         {
-        output->SetPixel(idx,  d1);
+        outputPixel[i * outputStride] = signedDistance;
         }
       }
     }
 }
 
+template< typename TInputImage, typename TOutputImage >
+typename SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >::OutputPixelType
+SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
+::GetSignedDistance(OutputPixelType distance, const InputPixelType & inputValue) const
+{
+  if ( Math::NotExactlyEquals( inputValue, this->m_BackgroundValue ) )
+    {
+    return this->m_InsideIsPositive ? distance : -distance;
+    }
+  return this->m_InsideIsPositive ? -distance : distance;
+}
+
+template< typename TInputImage, typename TOutputImage >
+typename SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >::OutputPixelType
+SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
+::GetSignedSquareRoot(OutputPixelType squaredDistance, const InputPixelType & inputValue) const
+{
+  typedef typename NumericTraits< OutputPixelType >::RealType OutputRealType;
+
+  // cast to a real type is required on some platforms
+  const OutputPixelType distance = static_cast< OutputPixelType >(
+      std::sqrt( static_cast< OutputRealType >( itk::Math::abs( squaredDistance ) ) ) );
+  return this->GetSignedDistance(distance, inputValue);
+}
+
 template< typename TInputImage, typename TOutputImage >
 bool
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
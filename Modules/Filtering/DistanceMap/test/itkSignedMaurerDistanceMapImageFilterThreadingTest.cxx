@@ -0,0 +1,172 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Compare the output of SignedMaurerDistanceMapImageFilter with a brute force
+ * computation of the signed distance to the boundary pixels of the object,
+ * for several dimensions, spacings and numbers of threads.
+ */
+
+namespace
+{
+
+template< unsigned int VDimension >
+bool
+SignedMaurerDistanceMapCompare(unsigned int seed, itk::ThreadIdType numberOfThreads,
+                               bool squaredDistance, bool insideIsPositive, bool useImageSpacing)
+{
+  typedef itk::Image< unsigned char, VDimension > InputImageType;
+  typedef itk::Image< double, VDimension >        OutputImageType;
+  typedef typename InputImageType::IndexType      IndexType;
+  typedef typename InputImageType::RegionType     RegionType;
+
+  typename InputImageType::SizeType    size;
+  typename InputImageType::SpacingType spacing;
+  for ( unsigned int d = 0; d < VDimension; d++ )
+    {
+    size[d] = 9 + 2 * d;
+    spacing[d] = 1.0 + 0.5 * d;
+    }
+
+  typename InputImageType::Pointer image = InputImageType::New();
+  image->SetRegions(size);
+  image->SetSpacing(spacing);
+  image->Allocate();
+
+  const RegionType region = image->GetLargestPossibleRegion();
+  itk::ImageRegionIteratorWithIndex< InputImageType > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    seed = seed * 1103515245u + 12345u;
+    it.Set( ( ( seed >> 16 ) % 3 == 0 ) ? 2 : 0 );
+    }
+
+  // The boundary pixels are the foreground pixels with a background pixel in
+  // their fully connected neighborhood.
+  std::vector< IndexType > boundary;
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() == 0 )
+      {
+      continue;
+      }
+    RegionType neighborhood;
+    for ( unsigned int d = 0; d < VDimension; d++ )
+      {
+      neighborhood.SetIndex( d, it.GetIndex()[d] - 1 );
+      neighborhood.SetSize( d, 3 );
+      }
+    neighborhood.Crop(region);
+    bool isBoundary = false;
+    itk::ImageRegionIteratorWithIndex< InputImageType > nit(image, neighborhood);
+    for ( nit.GoToBegin(); !nit.IsAtEnd(); ++nit )
+      {
+      isBoundary = isBoundary || nit.Get() == 0;
+      }
+    if ( isBoundary )
+      {
+      boundary.push_back( it.GetIndex() );
+      }
+    }
+
+  typedef itk::SignedMaurerDistanceMapImageFilter< InputImageType, OutputImageType > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->SetSquaredDistance(squaredDistance);
+  filter->SetInsideIsPositive(insideIsPositive);
+  filter->SetUseImageSpacing(useImageSpacing);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->Update();
+  const OutputImageType *output = filter->GetOutput();
+
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    double expected = itk::NumericTraits< double >::max();
+    for ( size_t b = 0; b < boundary.size(); b++ )
+      {
+      double distance = 0.0;
+      for ( unsigned int d = 0; d < VDimension; d++ )
+        {
+        const double delta = ( boundary[b][d] - it.GetIndex()[d] ) * ( useImageSpacing ? spacing[d] : 1.0 );
+        distance += delta * delta;
+        }
+      expected = std::min( expected, distance );
+      }
+    if ( boundary.empty() )
+      {
+      continue;
+      }
+    if ( !squaredDistance )
+      {
+      expected = std::sqrt(expected);
+      }
+    if ( ( it.Get() != 0 ) != insideIsPositive )
+      {
+      expected = -expected;
+      }
+
+    const double value = output->GetPixel( it.GetIndex() );
+    if ( std::abs( value - expected ) > 1e-9 * std::max( 1.0, std::abs(expected) ) )
+      {
+      std::cerr << "Error in " << VDimension << "D with " << numberOfThreads << " threads, squared distance "
+                << squaredDistance << ", inside is positive " << insideIsPositive << ", use image spacing "
+                << useImageSpacing << ": the distance at " << it.GetIndex() << " is " << value
+                << " instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< unsigned int VDimension >
+bool
+SignedMaurerDistanceMapCompareAll(unsigned int seed)
+{
+  bool result = true;
+  for ( unsigned int flags = 0; flags < 8; flags++ )
+    {
+    for ( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3 )
+      {
+      result = SignedMaurerDistanceMapCompare< VDimension >( seed + flags, numberOfThreads,
+                                                             ( flags & 1 ) != 0, ( flags & 2 ) != 0,
+                                                             ( flags & 4 ) != 0 ) && result;
+      }
+    }
+  return result;
+}
+}
+
+int itkSignedMaurerDistanceMapImageFilterThreadingTest(int, char *[])
+{
+  bool result = true;
+  result = SignedMaurerDistanceMapCompareAll< 1 >( 1 ) && result;
+  result = SignedMaurerDistanceMapCompareAll< 2 >( 2 ) && result;
+  result = SignedMaurerDistanceMapCompareAll< 3 >( 3 ) && result;
+
+  if ( !result )
+    {
+    std::cerr << "Test failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -22,9 +22,7 @@
 #include "itkIntTypes.h"
 #include "itkFastMarchingStoppingCriterionBase.h"
 #include "itkFastMarchingTraits.h"
-
-#include <queue>
-#include <functional>
+#include "itkFastMarchingPriorityQueue.h"
 
 namespace itk
 {
@@ -40,8 +38,13 @@ namespace itk
  *
  * Updates are preformed using an entropy satisfy scheme where only
  * "upwind" neighborhoods are used. This implementation of Fast Marching
- * uses a std::priority_queue to locate the next proper node to
- * update.
+ * uses an indexed priority queue (FastMarchingPriorityQueue) to locate the
+ * next proper node to update: a trial node identified by GetNodeIdentifier()
+ * appears only once in the queue, and its value is decreased in place when
+ * one of its neighbors is updated.  The queue also provides the push(), top(),
+ * pop() and empty() methods of the std::priority_queue previously used, so
+ * that subclasses which push their nodes with push() keep working: these nodes
+ * are not identified.
  *
  * Fast Marching sweeps through N points in (N log N) steps to obtain
  * the arrival time value as the front propagates through the domain.
@@ -68,10 +71,6 @@ namespace itk
  *    \li Superclass (itk::ImageToImageFilter or
  * itk::QuadEdgeMeshToQuadEdgeMeshFilter )
  *
- * \todo In the current implemenation, std::priority_queue only allows
- * taking nodes out from the front and putting nodes in from the back.
- * Use itk::PriorityQueueContainer instead.
- *
  * \par Topology constraints:
  * Additional flexibiility in this class includes the implementation of
  * topology constraints for image-based fast marching.  Further details
@@ -136,20 +135,6 @@ public:
   typedef FastMarchingStoppingCriterionBase< TInput, TOutput > StoppingCriterionType;
   typedef typename StoppingCriterionType::Pointer              StoppingCriterionPointer;
 
-  /*
-  typedef long ElementIdentifier;
-
-  typedef MinPriorityQueueElementWrapper< NodeType,
-    OutputPixelType,
-    ElementIdentifier > PriorityQueueElementType;
-
-  typedef PriorityQueueContainer< PriorityQueueElementType,
-    PriorityQueueElementType,
-    OutputPixelType,
-    ElementIdentifier > PriorityQueueType;
-  typedef typename PriorityQueueType::Pointer PriorityQueuePointer;
-  */
-
   /** \enum TopologyCheckType */
   enum TopologyCheckType {
     /** \c Nothing */
@@ -230,15 +215,7 @@ protected:
 
   bool m_CollectPoints;
 
-  //PriorityQueuePointer m_Heap;
-  typedef std::vector< NodePairType >   HeapContainerType;
-  typedef std::greater< NodePairType >  NodeComparerType;
-
-  typedef std::priority_queue<
-    NodePairType,
-    HeapContainerType,
-    NodeComparerType >
-    PriorityQueueType;
+  typedef FastMarchingPriorityQueue< NodePairType > PriorityQueueType;
 
   PriorityQueueType m_Heap;
 
@@ -247,6 +224,13 @@ protected:
   /** \brief Get the total number of nodes in the domain */
   virtual IdentifierType GetTotalNumberOfNodes() const = 0;
 
+  /** \brief Get the identifier of a node in the trial priority queue.
+    \param[in] iNode
+    \return a non-negative integer, unique to the node in the domain, or
+    PriorityQueueType::UnknownIdentifier (the default) if the subclass does not
+    identify its nodes: the node is then pushed again at each update. */
+  virtual IdentifierType GetNodeIdentifier( const NodeType& iNode ) const;
+
   /** \brief Get the ouput value (front value) for a given node */
   virtual const OutputPixelType GetOutputValue( OutputDomainType* oDomain,
                                          const NodeType& iNode ) const = 0;
@@ -23,7 +23,6 @@
 
 #include "itkProgressReporter.h"
 #include "itkMath.h"
-#include "itkMath.h"
 
 namespace itk
 {
@@ -39,7 +38,6 @@ FastMarchingBase()
   m_ProcessedPoints = ITK_NULLPTR;
   m_ForbiddenPoints = ITK_NULLPTR;
 
-  //m_Heap = PriorityQueueType::New();
   m_SpeedConstant = 1.;
   m_InverseSpeed = -1.;
   m_NormalizationFactor = 1.;
@@ -104,16 +102,7 @@ Initialize( OutputDomainType* oDomain )
     }
 
   // make sure the heap is empty
-  while ( !m_Heap.empty() )
-    {
-    m_Heap.pop();
-    }
-  /*
-  while ( !m_Heap->Empty() )
-    {
-    m_Heap->Pop();
-    }
-  */
+  m_Heap.Clear();
 
   this->InitializeOutput( oDomain );
 
@@ -123,6 +112,16 @@ Initialize( OutputDomainType* oDomain )
   }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+IdentifierType
+FastMarchingBase< TInput, TOutput >::
+GetNodeIdentifier( const NodeType& ) const
+  {
+  return PriorityQueueType::UnknownIdentifier;
+  }
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template< typename TInput, typename TOutput >
 void
@@ -141,22 +140,16 @@ GenerateData()
 
   try
     {
-    //while( !m_Heap->Empty() )
-    while( !m_Heap.empty() )
+    while( !m_Heap.Empty() )
       {
-      //PriorityQueueElementType element = m_Heap->Peek();
-      //m_Heap->Pop();
-      //
-      //NodeType current_node = element.m_Element;
-      //OutputPixelType current_value = element.m_Priority;
-
-
-      NodePairType current_node_pair = m_Heap.top();
-      m_Heap.pop();
+      NodePairType current_node_pair = m_Heap.Peek();
+      m_Heap.Pop();
 
       NodeType current_node = current_node_pair.GetNode();
       current_value = this->GetOutputValue( output, current_node );
 
+      // the nodes without identifier are pushed again at each update, the
+      // elements with a previous value are discarded
       if( Math::ExactlyEquals(current_value, current_node_pair.GetValue()) )
         {
         // is this node already alive ?
@@ -195,14 +188,7 @@ GenerateData()
     // it.
     //
     // RELEASE MEMORY!!!
-    while( !m_Heap.empty() )
-      {
-      m_Heap.pop();
-      }
-    /*while( !m_Heap->Empty() )
-      {
-      m_Heap->Pop();
-      }*/
+    m_Heap.Clear();
 
     throw ProcessAborted(__FILE__, __LINE__);
     }
@@ -210,14 +196,7 @@ GenerateData()
   m_TargetReachedValue = current_value;
 
   // let's release some useless memory...
-  while( !m_Heap.empty() )
-    {
-    m_Heap.pop();
-    }
-  /*while( !m_Heap->Empty() )
-    {
-    m_Heap->Pop();
-    }*/
+  m_Heap.Clear();
   }
 // -----------------------------------------------------------------------------
 
@@ -127,6 +127,11 @@ void
 FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension >
 ::InitializeOutput(OutputImageType* oImage)
 {
+  if ( this->GetUseFastIterativeMethod() )
+    {
+    itkExceptionMacro(<< "The auxiliary values are not extended by the fast iterative method");
+    }
+
   this->Superclass::InitializeOutput( oImage );
 
   if ( !m_AuxiliaryAliveValues )
@@ -249,7 +254,7 @@ FastMarchingExtensionImageFilterBase< TInput, TOutput, TAuxValue, VAuxDimension
     //node.SetValue( outputPixel );
     //node.SetIndex( index );
     //m_TrialHeap.push(node);
-    this->m_Heap.push( NodePairType( iNode, outputPixel ) );
+    this->m_Heap.Push( NodePairType( iNode, outputPixel ), this->GetNodeIdentifier( iNode ) );
 
     // update auxiliary values
     for ( unsigned int k = 0; k < AuxDimension; k++ )
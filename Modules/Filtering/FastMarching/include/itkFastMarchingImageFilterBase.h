@@ -23,7 +23,9 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkNeighborhoodIterator.h"
 #include "itkArray.h"
+#include "itkMultiThreader.h"
 #include <bitset>
+#include <vector>
 
 namespace itk
 {
@@ -61,6 +63,28 @@ namespace itk
  * "Level Set Methods and Fast Marching Methods", J.A. Sethian,
  * Cambridge Press, Second edition, 1999.
  *
+ * The arrival times can also be computed in parallel with the Fast Iterative
+ * Method (see SetUseFastIterativeMethod()), described in
+ * "A Fast Iterative Method for Eikonal Equations", W.-K. Jeong and
+ * R.T. Whitaker, SIAM Journal on Scientific Computing, 30(5):2512-2534, 2008.
+ * Instead of freezing one node at a time in increasing order, all the nodes
+ * of an active list are updated concurrently from the current values of their
+ * neighbors, and the neighbors of the updated nodes form the next active list,
+ * until no value decreases anymore.  The converged values are the solution of
+ * the same upwind scheme.  With a FastMarchingThresholdStoppingCriterion, the
+ * nodes whose value reaches the threshold are not updated, so that the
+ * propagation stops there.  The stopping criterion is then applied to the
+ * nodes sorted by increasing arrival time, as if they had been frozen by the
+ * fast marching: the nodes which would not have been reached are set back to
+ * the large value.  Topology checks are not supported by this method.
+ *
+ * The fast marching method does not update the neighbors of a node on the
+ * border of the image along the dimensions where the node is on the border,
+ * while the fast iterative method updates all the neighbors of the nodes.
+ * Near the border of the image, the arrival times of the fast iterative
+ * method can therefore be lower than the ones of the fast marching method,
+ * and they are never higher.
+ *
  * \tparam TTraits traits
  *
  * \sa ImageFastMarchingTraits
@@ -151,6 +175,13 @@ public:
   itkGetConstReferenceMacro(OverrideOutputInformation, bool);
   itkBooleanMacro(OverrideOutputInformation);
 
+  /** Set/Get whether the arrival times are computed in parallel with the Fast
+   * Iterative Method instead of the sequential Fast Marching Method.  The
+   * default is false. */
+  itkSetMacro(UseFastIterativeMethod, bool);
+  itkGetConstReferenceMacro(UseFastIterativeMethod, bool);
+  itkBooleanMacro(UseFastIterativeMethod);
+
 protected:
 
   /** Constructor */
@@ -168,17 +199,27 @@ protected:
   OutputSpacingType   m_OutputSpacing;
   OutputDirectionType m_OutputDirection;
   bool                m_OverrideOutputInformation;
+  bool                m_UseFastIterativeMethod;
 
   /** Generate the output image meta information. */
   virtual void GenerateOutputInformation() ITK_OVERRIDE;
 
   virtual void EnlargeOutputRequestedRegion(DataObject *output) ITK_OVERRIDE;
 
+  /** Compute the arrival times with the fast marching or the fast iterative
+   * method. */
+  virtual void GenerateData() ITK_OVERRIDE;
+
+  void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
   LabelImagePointer               m_LabelImage;
   ConnectedComponentImagePointer  m_ConnectedComponentImage;
 
   IdentifierType GetTotalNumberOfNodes() const ITK_OVERRIDE;
 
+  /** Returns the offset of a node in the buffered region */
+  IdentifierType GetNodeIdentifier( const NodeType& iNode ) const ITK_OVERRIDE;
+
   void SetOutputValue( OutputImageType* oDomain,
                        const NodeType& iNode,
                        const OutputPixelType& iValue ) ITK_OVERRIDE;
@@ -218,6 +259,14 @@ protected:
                const NodeType& iNode,
                InternalNodeStructureArray& ioNeighbors ) const;
 
+  /** Compute the arrival time of a node from all its neighbors which have
+   * already been reached, for the fast iterative method. */
+  double SolveFromReachedNeighbors( OutputImageType* oImage,
+                                    const NodeType& iNode ) const;
+
+  /** Compute the arrival times with the fast iterative method. */
+  void GenerateDataWithFastIterativeMethod();
+
   // --------------------------------------------------------------------------
   // --------------------------------------------------------------------------
 
@@ -252,6 +301,20 @@ protected:
   const InputImageType* m_InputCache;
 
 private:
+  typedef std::vector< NodeType >        NodeContainerType;
+  typedef std::vector< OutputPixelType > OutputPixelContainerType;
+
+  /** Data shared by the threads updating the active list. */
+  struct FastIterativeThreadStruct
+    {
+    Self *                     Filter;
+    OutputImageType *          Output;
+    const NodeContainerType *  ActiveNodes;
+    OutputPixelContainerType * Values;
+    bool                       ExceptionCaught;
+    };
+
+  static ITK_THREAD_RETURN_TYPE FastIterativeThreaderCallback( void *arg );
 
   FastMarchingImageFilterBase( const Self& );
   void operator = ( const Self& );
@@ -24,6 +24,10 @@
 #include "itkImageRegionIterator.h"
 #include "itkConnectedComponentImageFilter.h"
 #include "itkRelabelComponentImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+
+#include <algorithm>
 
 namespace itk
 {
@@ -66,6 +70,7 @@ FastMarchingImageFilterBase()
   m_OutputSpacing.Fill(1.0);
   m_OutputDirection.SetIdentity();
   m_OverrideOutputInformation = false;
+  m_UseFastIterativeMethod = false;
 
   m_InputCache = ITK_NULLPTR;
   m_LabelImage = LabelImageType::New();
@@ -126,6 +131,307 @@ EnlargeOutputRequestedRegion(
 }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+  os << indent << "Use fast iterative method: " << m_UseFastIterativeMethod << std::endl;
+}
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateData()
+{
+  if( m_UseFastIterativeMethod )
+    {
+    this->GenerateDataWithFastIterativeMethod();
+    }
+  else
+    {
+    Superclass::GenerateData();
+    }
+}
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+void
+FastMarchingImageFilterBase< TInput, TOutput >::
+GenerateDataWithFastIterativeMethod()
+{
+  if( this->m_TopologyCheck != Superclass::Nothing )
+    {
+    itkExceptionMacro( << "Topology checks are not supported by the fast iterative method" );
+    }
+
+  OutputImageType* output = this->GetOutput();
+
+  this->Initialize( output );
+
+  // the initial trial nodes are frozen, as the alive ones
+  this->m_Heap.Clear();
+  this->m_StoppingCriterion->Reinitialize();
+
+  // nodes already in the next active list
+  std::vector< bool > isActive( this->GetTotalNumberOfNodes(), false );
+
+  NodeContainerType activeNodes;
+  NodeContainerType nextActiveNodes;
+
+  if( this->m_TrialPoints )
+    {
+    NodePairContainerConstIterator pointsIter = this->m_TrialPoints->Begin();
+    NodePairContainerConstIterator pointsEnd = this->m_TrialPoints->End();
+
+    for( ; pointsIter != pointsEnd; ++pointsIter )
+      {
+      const NodeType & node = pointsIter->Value().GetNode();
+      if( m_BufferedRegion.IsInside( node ) &&
+          m_LabelImage->GetPixel( node ) == Traits::InitialTrial )
+        {
+        activeNodes.push_back( node );
+        }
+      }
+    }
+
+  // With a threshold, the nodes whose value is not below it would never be
+  // frozen by the fast marching: they are not reached, which stops the
+  // propagation as early.  Their smallest value is kept in the output, to
+  // find the value at which the fast marching stops, and they are updated
+  // again if one of their neighbors decreases later.
+  typedef FastMarchingThresholdStoppingCriterion< TInput, TOutput > ThresholdCriterionType;
+  ThresholdCriterionType * thresholdCriterion =
+    dynamic_cast< ThresholdCriterionType * >( this->m_StoppingCriterion.GetPointer() );
+  const bool pruneNodes = ( thresholdCriterion != ITK_NULLPTR );
+  const OutputPixelType pruningValue = pruneNodes ?
+    static_cast< OutputPixelType >( thresholdCriterion->GetThreshold() ) : this->m_LargeValue;
+
+  // The progress of the iterations is the fraction of the nodes reached, and
+  // the freezing of the reached nodes takes the second half.
+  const float numberOfNodes = static_cast< float >( this->GetTotalNumberOfNodes() );
+  SizeValueType numberOfReachedNodes = 0;
+
+  OutputPixelContainerType values;
+
+  FastIterativeThreadStruct str;
+  str.Filter = this;
+  str.Output = output;
+  str.ActiveNodes = &activeNodes;
+  str.Values = &values;
+  str.ExceptionCaught = false;
+
+  // the neighbors of the initial trial nodes are updated first, without
+  // updating the initial trial nodes themselves
+  bool updateActiveNodes = false;
+
+  while( !activeNodes.empty() )
+    {
+    if( this->GetAbortGenerateData() )
+      {
+      ProcessAborted e( __FILE__, __LINE__ );
+      e.SetDescription( "Process aborted." );
+      e.SetLocation( ITK_LOCATION );
+      throw e;
+      }
+
+    nextActiveNodes.clear();
+
+    for( typename NodeContainerType::const_iterator nodeIt = activeNodes.begin();
+         nodeIt != activeNodes.end();
+         ++nodeIt )
+      {
+      isActive[m_LabelImage->ComputeOffset( *nodeIt )] = false;
+      }
+
+    if( updateActiveNodes )
+      {
+      // compute the new values of the active nodes from the current values of
+      // their neighbors, and only then store them, so that the result does not
+      // depend on the number of threads
+      values.resize( activeNodes.size() );
+
+      const ThreadIdType numberOfThreads = static_cast< ThreadIdType >(
+        std::max< SizeValueType >( 1, std::min< SizeValueType >( this->GetNumberOfThreads(),
+                                                                 activeNodes.size() / 256 ) ) );
+      if( numberOfThreads > 1 )
+        {
+        MultiThreader* multiThreader = this->GetMultiThreader();
+        multiThreader->SetNumberOfThreads( numberOfThreads );
+        multiThreader->SetSingleMethod( Self::FastIterativeThreaderCallback, &str );
+        multiThreader->SingleMethodExecute();
+        }
+      else
+        {
+        MultiThreader::ThreadInfoStruct info;
+        info.ThreadID = 0;
+        info.NumberOfThreads = 1;
+        info.UserData = &str;
+        Self::FastIterativeThreaderCallback( &info );
+        }
+
+      if( str.ExceptionCaught )
+        {
+        itkExceptionMacro( <<"Discriminant of quadratic equation is negative" );
+        }
+      }
+
+    for( size_t i = 0; i < activeNodes.size(); i++ )
+      {
+      const NodeType & node = activeNodes[i];
+
+      if( updateActiveNodes )
+        {
+        if( !( values[i] < output->GetPixel( node ) ) )
+          {
+          continue;
+          }
+        output->SetPixel( node, values[i] );
+        if( pruneNodes && !( values[i] < pruningValue ) )
+          {
+          continue;
+          }
+        if( m_LabelImage->GetPixel( node ) != Traits::Trial )
+          {
+          m_LabelImage->SetPixel( node, Traits::Trial );
+          ++numberOfReachedNodes;
+          }
+        }
+
+      // the neighbors of an updated node must be updated again
+      NodeType neighbor = node;
+      for( unsigned int j = 0; j < ImageDimension; j++ )
+        {
+        for( int s = -1; s < 2; s += 2 )
+          {
+          neighbor[j] = node[j] + s;
+          if( ( neighbor[j] >= m_StartIndex[j] ) && ( neighbor[j] <= m_LastIndex[j] ) )
+            {
+            const unsigned char label = m_LabelImage->GetPixel( neighbor );
+            const OffsetValueType offset = m_LabelImage->ComputeOffset( neighbor );
+            if( ( label != Traits::Alive ) &&
+                ( label != Traits::InitialTrial ) &&
+                ( label != Traits::Forbidden ) &&
+                !isActive[offset] )
+              {
+              isActive[offset] = true;
+              nextActiveNodes.push_back( neighbor );
+              }
+            }
+          }
+        neighbor[j] = node[j];
+        }
+      }
+
+    activeNodes.swap( nextActiveNodes );
+    updateActiveNodes = true;
+
+    this->UpdateProgress( 0.5f * static_cast< float >( numberOfReachedNodes ) / numberOfNodes );
+    }
+
+  // Freeze the reached nodes by increasing arrival time until the stopping
+  // criterion is satisfied, as the fast marching method would.
+  std::vector< NodePairType > reachedNodes;
+  OutputPixelType minimumPrunedValue = this->m_LargeValue;
+  ImageRegionConstIteratorWithIndex< LabelImageType > labelIt( m_LabelImage, m_BufferedRegion );
+  for( labelIt.GoToBegin(); !labelIt.IsAtEnd(); ++labelIt )
+    {
+    if( ( labelIt.Get() == Traits::Trial ) || ( labelIt.Get() == Traits::InitialTrial ) )
+      {
+      reachedNodes.push_back( NodePairType( labelIt.GetIndex(), output->GetPixel( labelIt.GetIndex() ) ) );
+      }
+    else if( pruneNodes && ( labelIt.Get() == Traits::Far ) &&
+             ( output->GetPixel( labelIt.GetIndex() ) < this->m_LargeValue ) )
+      {
+      minimumPrunedValue = std::min( minimumPrunedValue, output->GetPixel( labelIt.GetIndex() ) );
+      output->SetPixel( labelIt.GetIndex(), this->m_LargeValue );
+      }
+    }
+  std::stable_sort( reachedNodes.begin(), reachedNodes.end() );
+
+  ProgressReporter progress( this, 0, static_cast< SizeValueType >( reachedNodes.size() ), 100, 0.5f, 0.5f );
+
+  OutputPixelType currentValue = NumericTraits< OutputPixelType >::ZeroValue();
+  size_t i = 0;
+  for( ; i < reachedNodes.size(); i++ )
+    {
+    currentValue = reachedNodes[i].GetValue();
+
+    this->m_StoppingCriterion->SetCurrentNodePair( reachedNodes[i] );
+    if( this->m_StoppingCriterion->IsSatisfied() )
+      {
+      break;
+      }
+    if( this->m_CollectPoints )
+      {
+      this->m_ProcessedPoints->push_back( reachedNodes[i] );
+      }
+    m_LabelImage->SetPixel( reachedNodes[i].GetNode(), Traits::Alive );
+    progress.CompletedPixel();
+    }
+
+  const bool isSatisfied = ( i < reachedNodes.size() );
+
+  // the initial trial nodes keep their value, as in the fast marching method
+  for( ; i < reachedNodes.size(); i++ )
+    {
+    const NodeType & node = reachedNodes[i].GetNode();
+    if( m_LabelImage->GetPixel( node ) == Traits::Trial )
+      {
+      output->SetPixel( node, this->m_LargeValue );
+      m_LabelImage->SetPixel( node, Traits::Far );
+      }
+    }
+
+  // the fast marching stops at the smallest pruned node if it is reached
+  // before the node which satisfied the stopping criterion
+  if( minimumPrunedValue < this->m_LargeValue &&
+      ( !isSatisfied || minimumPrunedValue < currentValue ) )
+    {
+    currentValue = minimumPrunedValue;
+    }
+
+  this->m_TargetReachedValue = currentValue;
+}
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+ITK_THREAD_RETURN_TYPE
+FastMarchingImageFilterBase< TInput, TOutput >::
+FastIterativeThreaderCallback( void *arg )
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  FastIterativeThreadStruct *str = static_cast< FastIterativeThreadStruct * >( info->UserData );
+
+  const NodeContainerType & activeNodes = *str->ActiveNodes;
+  OutputPixelContainerType & values = *str->Values;
+
+  const size_t begin = activeNodes.size() * info->ThreadID / info->NumberOfThreads;
+  const size_t end = activeNodes.size() * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+
+  try
+    {
+    for( size_t i = begin; i < end; i++ )
+      {
+      values[i] = static_cast< OutputPixelType >(
+        str->Filter->SolveFromReachedNeighbors( str->Output, activeNodes[i] ) );
+      }
+    }
+  catch( ExceptionObject & )
+    {
+    str->ExceptionCaught = true;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template< typename TInput, typename TOutput >
 IdentifierType
@@ -136,6 +442,16 @@ GetTotalNumberOfNodes() const
   }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+IdentifierType
+FastMarchingImageFilterBase< TInput, TOutput >::
+GetNodeIdentifier( const NodeType& iNode ) const
+  {
+  return static_cast< IdentifierType >( m_LabelImage->ComputeOffset( iNode ) );
+  }
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template< typename TInput, typename TOutput >
 void
@@ -244,7 +560,7 @@ UpdateValue( OutputImageType* oImage, const NodeType& iNode )
     this->SetLabelValueForGivenNode( iNode, Traits::Trial );
 
     // insert point into trial heap
-    this->m_Heap.push( NodePairType( iNode, outputPixel ) );
+    this->m_Heap.Push( NodePairType( iNode, outputPixel ), this->GetNodeIdentifier( iNode ) );
     }
   }
 // -----------------------------------------------------------------------------
@@ -390,6 +706,52 @@ Solve( OutputImageType* oImage,
   }
 // -----------------------------------------------------------------------------
 
+// -----------------------------------------------------------------------------
+template< typename TInput, typename TOutput >
+double
+FastMarchingImageFilterBase< TInput, TOutput >::
+SolveFromReachedNeighbors( OutputImageType* oImage, const NodeType& iNode ) const
+{
+  InternalNodeStructureArray nodesUsed;
+
+  NodeType neighbor_node = iNode;
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    InternalNodeStructure temp_node;
+    temp_node.m_Node = iNode;
+    temp_node.m_Value = this->m_LargeValue;
+    temp_node.m_Axis = j;
+
+    // find the smallest valued neighbor in this dimension, whether it is
+    // frozen or not
+    for ( int s = -1; s < 2; s += 2 )
+      {
+      neighbor_node[j] = iNode[j] + s;
+
+      if ( ( neighbor_node[j] <= m_LastIndex[j] ) && ( neighbor_node[j] >= m_StartIndex[j] ) )
+        {
+        const unsigned char label = m_LabelImage->GetPixel( neighbor_node );
+        if ( ( label == Traits::Alive ) || ( label == Traits::Trial ) || ( label == Traits::InitialTrial ) )
+          {
+          const OutputPixelType neighValue = oImage->GetPixel( neighbor_node );
+          if ( temp_node.m_Value > neighValue )
+            {
+            temp_node.m_Value = neighValue;
+            temp_node.m_Node = neighbor_node;
+            }
+          }
+        }
+      }
+    nodesUsed[j] = temp_node;
+
+    neighbor_node[j] = iNode[j];
+    }
+
+  return this->Solve( oImage, iNode, nodesUsed );
+}
+// -----------------------------------------------------------------------------
+
 // -----------------------------------------------------------------------------
 template< typename TInput, typename TOutput >
 bool
@@ -536,6 +898,10 @@ InitializeOutput( OutputImageType* oImage )
   m_LabelImage->Allocate();
   m_LabelImage->FillBuffer( Traits::Far );
 
+  // the positions in the trial heap grow with the front, up to the number
+  // of nodes of the image
+  this->m_Heap.SetMaximumNumberOfNodes( this->GetTotalNumberOfNodes() );
+
   NodeType idx;
   OutputPixelType outputPixel = this->m_LargeValue;
 
@@ -638,8 +1004,7 @@ InitializeOutput( OutputImageType* oImage )
         outputPixel = pointsIter->Value().GetValue();
         this->SetOutputValue( oImage, idx, outputPixel );
 
-        //this->m_Heap->Push( PriorityQueueElementType( idx, pointsIter->second ) );
-        this->m_Heap.push( pointsIter->Value() );
+        this->m_Heap.Push( pointsIter->Value(), this->GetNodeIdentifier( idx ) );
         }
       ++pointsIter;
       }
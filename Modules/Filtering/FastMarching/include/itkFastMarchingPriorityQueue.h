@@ -0,0 +1,271 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#ifndef itkFastMarchingPriorityQueue_h
+#define itkFastMarchingPriorityQueue_h
+
+#include "itkIntTypes.h"
+#include "itkMacro.h"
+#include "itkNumericTraits.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace itk
+{
+/**
+\class FastMarchingPriorityQueue
+\brief Indexed binary min-heap of the trial nodes of a fast marching filter.
+
+Each node is identified by a non-negative integer, and appears at most once
+in the queue: pushing a node which is already in the queue updates its value
+and moves it to its new position, instead of inserting a duplicate to be
+discarded when it is popped.  The position of the nodes in the heap is
+stored in a vector indexed by the node identifiers, which grows with the
+largest identifier pushed, up to the number of nodes set with
+SetMaximumNumberOfNodes().
+
+Nodes pushed with the identifier UnknownIdentifier are not indexed: each push
+inserts a new element, and the elements whose value is no longer the one of
+their node are to be discarded when they are popped.
+
+\ingroup ITKFastMarching
+*/
+template< typename TNodePair >
+class FastMarchingPriorityQueue
+  {
+public:
+  typedef FastMarchingPriorityQueue Self;
+  typedef TNodePair                 NodePairType;
+
+  /** Identifier of the nodes which are not indexed. */
+  static const IdentifierType UnknownIdentifier = static_cast< IdentifierType >( -1 );
+
+  FastMarchingPriorityQueue() :
+    m_MaximumNumberOfNodes( NumericTraits< IdentifierType >::max() ) {}
+
+  /** Set an upper bound of the identifiers plus one, which limits the
+   * growth of the positions of the nodes. */
+  void SetMaximumNumberOfNodes( IdentifierType numberOfNodes )
+    {
+    m_MaximumNumberOfNodes = numberOfNodes;
+    }
+
+  bool Empty() const
+    {
+    return m_Heap.empty();
+    }
+
+  SizeValueType Size() const
+    {
+    return static_cast< SizeValueType >( m_Heap.size() );
+    }
+
+  /** Return true if the node is in the queue. */
+  bool Contains( IdentifierType iIdentifier ) const
+    {
+    // UnknownIdentifier is never below the size of the positions
+    return iIdentifier < m_Positions.size() &&
+      m_Positions[iIdentifier] != InvalidPosition;
+    }
+
+  /** Return the node with the smallest value. */
+  const NodePairType & Peek() const
+    {
+    return m_Heap.front().m_NodePair;
+    }
+
+  /** Insert a node, or update its value if it is already in the queue. */
+  void Push( const NodePairType & iNodePair, IdentifierType iIdentifier )
+    {
+    PositionType position = InvalidPosition;
+    if( iIdentifier != UnknownIdentifier )
+      {
+      if( iIdentifier >= m_Positions.size() )
+        {
+        this->GrowPositions( iIdentifier );
+        }
+      position = m_Positions[iIdentifier];
+      }
+    if( position == InvalidPosition )
+      {
+      if( m_Heap.size() >= static_cast< size_t >( InvalidPosition ) )
+        {
+        itkGenericExceptionMacro( << "Too many nodes in the fast marching priority queue" );
+        }
+      position = static_cast< PositionType >( m_Heap.size() );
+      m_Heap.push_back( ElementType( iNodePair, iIdentifier ) );
+      this->SetPosition( iIdentifier, position );
+      this->MoveUp( position );
+      }
+    else
+      {
+      const bool decrease = iNodePair.GetValue() < m_Heap[position].m_NodePair.GetValue();
+      m_Heap[position].m_NodePair = iNodePair;
+      if( decrease )
+        {
+        this->MoveUp( position );
+        }
+      else
+        {
+        this->MoveDown( position );
+        }
+      }
+    }
+
+  /** Remove the node with the smallest value. */
+  void Pop()
+    {
+    this->SetPosition( m_Heap.front().m_Identifier, InvalidPosition );
+    if( m_Heap.size() > 1 )
+      {
+      m_Heap.front() = m_Heap.back();
+      this->SetPosition( m_Heap.front().m_Identifier, 0 );
+      m_Heap.pop_back();
+      this->MoveDown( 0 );
+      }
+    else
+      {
+      m_Heap.pop_back();
+      }
+    }
+
+  /** Remove all the nodes and release the memory. */
+  void Clear()
+    {
+    std::vector< ElementType >().swap( m_Heap );
+    std::vector< PositionType >().swap( m_Positions );
+    }
+
+  /** \name Interface of std::priority_queue
+   * For the subclasses of FastMarchingBase written when the trial nodes were
+   * stored in a std::priority_queue.  push() inserts a node which is not
+   * indexed. */
+  //@{
+  void push( const NodePairType & iNodePair )
+    {
+    this->Push( iNodePair, UnknownIdentifier );
+    }
+
+  const NodePairType & top() const
+    {
+    return this->Peek();
+    }
+
+  void pop()
+    {
+    this->Pop();
+    }
+
+  bool empty() const
+    {
+    return this->Empty();
+    }
+
+  size_t size() const
+    {
+    return m_Heap.size();
+    }
+  //@}
+
+private:
+  typedef uint32_t PositionType;
+
+  static const PositionType InvalidPosition = static_cast< PositionType >( -1 );
+
+  struct ElementType
+    {
+    ElementType( const NodePairType & iNodePair, IdentifierType iIdentifier ) :
+      m_NodePair( iNodePair ), m_Identifier( iIdentifier ) {}
+
+    NodePairType   m_NodePair;
+    IdentifierType m_Identifier;
+    };
+
+  void SetPosition( IdentifierType iIdentifier, PositionType position )
+    {
+    if( iIdentifier != UnknownIdentifier )
+      {
+      m_Positions[iIdentifier] = position;
+      }
+    }
+
+  /** Grow the positions geometrically to include iIdentifier, without
+   * exceeding the maximum number of nodes. */
+  void GrowPositions( IdentifierType iIdentifier )
+    {
+    IdentifierType size = std::max< IdentifierType >( iIdentifier + 1,
+                                                      2 * static_cast< IdentifierType >( m_Positions.size() ) );
+    size = std::max< IdentifierType >( iIdentifier + 1, std::min( size, m_MaximumNumberOfNodes ) );
+    m_Positions.reserve( size );
+    m_Positions.resize( iIdentifier + 1, static_cast< PositionType >( InvalidPosition ) );
+    }
+
+  void MoveUp( PositionType position )
+    {
+    const ElementType element = m_Heap[position];
+    while( position > 0 )
+      {
+      const PositionType parent = ( position - 1 ) / 2;
+      if( !( element.m_NodePair.GetValue() < m_Heap[parent].m_NodePair.GetValue() ) )
+        {
+        break;
+        }
+      m_Heap[position] = m_Heap[parent];
+      this->SetPosition( m_Heap[position].m_Identifier, position );
+      position = parent;
+      }
+    m_Heap[position] = element;
+    this->SetPosition( element.m_Identifier, position );
+    }
+
+  void MoveDown( PositionType position )
+    {
+    const ElementType element = m_Heap[position];
+    const size_t size = m_Heap.size();
+    for(;;)
+      {
+      size_t child = 2 * static_cast< size_t >( position ) + 1;
+      if( child >= size )
+        {
+        break;
+        }
+      if( child + 1 < size &&
+          m_Heap[child + 1].m_NodePair.GetValue() < m_Heap[child].m_NodePair.GetValue() )
+        {
+        ++child;
+        }
+      if( !( m_Heap[child].m_NodePair.GetValue() < element.m_NodePair.GetValue() ) )
+        {
+        break;
+        }
+      m_Heap[position] = m_Heap[child];
+      this->SetPosition( m_Heap[position].m_Identifier, position );
+      position = static_cast< PositionType >( child );
+      }
+    m_Heap[position] = element;
+    this->SetPosition( element.m_Identifier, position );
+    }
+
+  std::vector< ElementType >  m_Heap;
+  std::vector< PositionType > m_Positions;
+  IdentifierType              m_MaximumNumberOfNodes;
+  };
+}
+
+#endif // itkFastMarchingPriorityQueue_h
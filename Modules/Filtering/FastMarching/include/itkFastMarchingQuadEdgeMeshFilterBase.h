@@ -113,6 +113,8 @@ protected:
 
   IdentifierType GetTotalNumberOfNodes() const ITK_OVERRIDE;
 
+  IdentifierType GetNodeIdentifier( const NodeType& iNode ) const ITK_OVERRIDE;
+
   void SetOutputValue( OutputMeshType* oMesh,
                       const NodeType& iNode,
                       const OutputPixelType& iValue ) ITK_OVERRIDE;
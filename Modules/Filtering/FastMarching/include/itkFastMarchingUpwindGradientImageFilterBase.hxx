@@ -64,6 +64,11 @@ void
 FastMarchingUpwindGradientImageFilterBase< TInput, TOutput >::
 InitializeOutput(OutputImageType *output)
 {
+  if ( this->GetUseFastIterativeMethod() )
+    {
+    itkExceptionMacro(<< "The upwind gradient is not computed by the fast iterative method");
+    }
+
   Superclass::InitializeOutput(output);
 
   // allocate memory for the GradientImage if requested
@@ -0,0 +1,330 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingImageFilterBase.h"
+#include "itkFastMarchingThresholdStoppingCriterion.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Compare the arrival times computed with the fast iterative method, with one
+ * and several threads, to the ones of the fast marching method, with and
+ * without stopping the propagation.  The border of the image is forbidden so
+ * that both methods use the same neighbors.  The fast marching method gives
+ * the same result when its nodes are not identified in the trial heap.  When
+ * the border is not forbidden, the fast marching method does not update the
+ * neighbors of the border nodes along the border normal, so the arrival times
+ * of the fast iterative method are lower near the border, and never higher.
+ */
+
+namespace
+{
+
+/** Fast marching filter which does not identify its nodes in the trial heap,
+ * as a subclass which does not override GetNodeIdentifier(). */
+template< typename TImage >
+class UnidentifiedNodesFastMarching : public itk::FastMarchingImageFilterBase< TImage, TImage >
+{
+public:
+  typedef UnidentifiedNodesFastMarching                         Self;
+  typedef itk::FastMarchingImageFilterBase< TImage, TImage >    Superclass;
+  typedef itk::SmartPointer< Self >                             Pointer;
+  typedef typename Superclass::NodeType                         NodeType;
+
+  itkNewMacro( Self );
+
+protected:
+  UnidentifiedNodesFastMarching() {}
+
+  itk::IdentifierType GetNodeIdentifier( const NodeType& ) const ITK_OVERRIDE
+    {
+    return Superclass::PriorityQueueType::UnknownIdentifier;
+    }
+};
+
+template< unsigned int VDimension >
+class FastIterativeMethodTester
+{
+public:
+  typedef itk::Image< float, VDimension >                                       ImageType;
+  typedef itk::FastMarchingImageFilterBase< ImageType, ImageType >              FastMarchingType;
+  typedef typename FastMarchingType::NodePairType                               NodePairType;
+  typedef typename FastMarchingType::NodePairContainerType                      NodePairContainerType;
+  typedef itk::FastMarchingThresholdStoppingCriterion< ImageType, ImageType >   CriterionType;
+
+  FastIterativeMethodTester( unsigned int size, unsigned int seed, bool forbidBorder = true )
+    {
+    typename ImageType::SizeType imageSize;
+    imageSize.Fill( size );
+
+    m_Speed = ImageType::New();
+    m_Speed->SetRegions( imageSize );
+    m_Speed->Allocate();
+
+    itk::ImageRegionIteratorWithIndex< ImageType > it( m_Speed, m_Speed->GetBufferedRegion() );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      it.Set( 0.5f + static_cast< float >( this->Random( seed ) % 1000 ) / 500.0f );
+      }
+
+    m_TrialPoints = NodePairContainerType::New();
+    m_AlivePoints = NodePairContainerType::New();
+    m_ForbiddenPoints = NodePairContainerType::New();
+    for( unsigned int k = 0; k < 4; k++ )
+      {
+      // an alive node surrounded by trial nodes
+      typename ImageType::IndexType center = this->RandomIndex( seed, size - 4 );
+      for( unsigned int d = 0; d < VDimension; d++ )
+        {
+        center[d] += 2;
+        }
+      m_AlivePoints->push_back( NodePairType( center, 0.5 * k ) );
+      for( unsigned int d = 0; d < VDimension; d++ )
+        {
+        for( int s = -1; s < 2; s += 2 )
+          {
+          typename ImageType::IndexType index = center;
+          index[d] += s;
+          m_TrialPoints->push_back( NodePairType( index, 0.5 * k + 1.0 / m_Speed->GetPixel( index ) ) );
+          }
+        }
+      for( unsigned int l = 1; l < size - 1; l++ )
+        {
+        // a wall the front has to go around
+        typename ImageType::IndexType index;
+        index.Fill( size / 2 );
+        index[0] = l;
+        index[VDimension - 1] = size / 4 + k;
+        if( l < size - 4 )
+          {
+          m_ForbiddenPoints->push_back( NodePairType( index, 0.0 ) );
+          }
+        }
+      }
+
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      bool isOnBorder = false;
+      for( unsigned int d = 0; d < VDimension; d++ )
+        {
+        const typename ImageType::IndexValueType value = it.GetIndex()[d];
+        isOnBorder = isOnBorder || value == 0 || value == static_cast< typename ImageType::IndexValueType >( size - 1 );
+        }
+      if( isOnBorder && forbidBorder )
+        {
+        m_ForbiddenPoints->push_back( NodePairType( it.GetIndex(), 0.0 ) );
+        }
+      }
+    }
+
+  typename FastMarchingType::Pointer Run( bool useFastIterativeMethod, itk::ThreadIdType numberOfThreads,
+                                          double threshold, bool identifyNodes = true )
+    {
+    typename CriterionType::Pointer criterion = CriterionType::New();
+    criterion->SetThreshold( threshold );
+
+    typename FastMarchingType::Pointer marcher;
+    if( identifyNodes )
+      {
+      marcher = FastMarchingType::New();
+      }
+    else
+      {
+      marcher = UnidentifiedNodesFastMarching< ImageType >::New().GetPointer();
+      }
+    marcher->SetInput( m_Speed );
+    marcher->SetStoppingCriterion( criterion );
+    marcher->SetTrialPoints( m_TrialPoints );
+    marcher->SetAlivePoints( m_AlivePoints );
+    marcher->SetForbiddenPoints( m_ForbiddenPoints );
+    marcher->SetCollectPoints( true );
+    marcher->SetUseFastIterativeMethod( useFastIterativeMethod );
+    marcher->SetNumberOfThreads( numberOfThreads );
+    marcher->Update();
+    return marcher;
+    }
+
+  bool Test( double threshold )
+    {
+    typename FastMarchingType::Pointer fastMarching = this->Run( false, 1, threshold );
+    typename FastMarchingType::Pointer fastIterative = this->Run( true, 1, threshold );
+    typename FastMarchingType::Pointer threadedFastIterative = this->Run( true, 4, threshold );
+    typename FastMarchingType::Pointer unidentifiedFastMarching = this->Run( false, 1, threshold, false );
+
+    const ImageType * expected = fastMarching->GetOutput();
+    const ImageType * output = fastIterative->GetOutput();
+    const ImageType * threadedOutput = threadedFastIterative->GetOutput();
+
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it( expected, expected->GetBufferedRegion() );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const typename ImageType::IndexType & index = it.GetIndex();
+      if( itk::Math::NotExactlyEquals( unidentifiedFastMarching->GetOutput()->GetPixel( index ), it.Get() ) )
+        {
+        std::cerr << "The arrival time at " << index << " is " << unidentifiedFastMarching->GetOutput()->GetPixel( index )
+                  << " without node identifiers instead of " << it.Get() << std::endl;
+        return false;
+        }
+      if( itk::Math::NotExactlyEquals( output->GetPixel( index ), threadedOutput->GetPixel( index ) ) )
+        {
+        std::cerr << "The arrival time at " << index << " is " << threadedOutput->GetPixel( index )
+                  << " with 4 threads instead of " << output->GetPixel( index ) << std::endl;
+        return false;
+        }
+
+      // the trial nodes left by the fast marching method are not reached by
+      // the fast iterative method
+      const unsigned char label = fastMarching->GetLabelImage()->GetPixel( index );
+      if( label != fastIterative->GetLabelImage()->GetPixel( index ) &&
+          ( label != FastMarchingType::Traits::Trial ||
+            fastIterative->GetLabelImage()->GetPixel( index ) != FastMarchingType::Traits::Far ) )
+        {
+        std::cerr << "The label at " << index << " is "
+                  << static_cast< int >( fastIterative->GetLabelImage()->GetPixel( index ) )
+                  << " instead of " << static_cast< int >( label ) << std::endl;
+        return false;
+        }
+      if( label != FastMarchingType::Traits::Trial &&
+          itk::Math::NotExactlyEquals( output->GetPixel( index ), it.Get() ) )
+        {
+        std::cerr << "The arrival time at " << index << " is " << output->GetPixel( index )
+                  << " instead of " << it.Get() << std::endl;
+        return false;
+        }
+      }
+
+    if( fastIterative->GetProcessedPoints()->Size() != fastMarching->GetProcessedPoints()->Size() ||
+        itk::Math::NotExactlyEquals( fastIterative->GetTargetReachedValue(), fastMarching->GetTargetReachedValue() ) )
+      {
+      std::cerr << fastIterative->GetProcessedPoints()->Size() << " nodes were reached at "
+                << fastIterative->GetTargetReachedValue() << " instead of "
+                << fastMarching->GetProcessedPoints()->Size() << " at "
+                << fastMarching->GetTargetReachedValue() << std::endl;
+      return false;
+      }
+    return true;
+    }
+
+  bool TestBorder()
+    {
+    typename FastMarchingType::Pointer fastMarching = this->Run( false, 1, 1e6 );
+    typename FastMarchingType::Pointer fastIterative = this->Run( true, 1, 1e6 );
+    typename FastMarchingType::Pointer threadedFastIterative = this->Run( true, 4, 1e6 );
+
+    const ImageType * expected = fastMarching->GetOutput();
+    const ImageType * output = fastIterative->GetOutput();
+
+    itk::SizeValueType numberOfLowerNodes = 0;
+    itk::SizeValueType numberOfLowerBorderNodes = 0;
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it( expected, expected->GetBufferedRegion() );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const typename ImageType::IndexType & index = it.GetIndex();
+      if( itk::Math::NotExactlyEquals( output->GetPixel( index ), threadedFastIterative->GetOutput()->GetPixel( index ) ) )
+        {
+        std::cerr << "The arrival time at " << index << " is " << threadedFastIterative->GetOutput()->GetPixel( index )
+                  << " with 4 threads instead of " << output->GetPixel( index ) << std::endl;
+        return false;
+        }
+      if( output->GetPixel( index ) > it.Get() )
+        {
+        std::cerr << "The arrival time at " << index << " is " << output->GetPixel( index )
+                  << " which is higher than " << it.Get() << std::endl;
+        return false;
+        }
+      if( output->GetPixel( index ) < it.Get() )
+        {
+        ++numberOfLowerNodes;
+        bool isOnBorder = false;
+        for( unsigned int d = 0; d < VDimension; d++ )
+          {
+          isOnBorder = isOnBorder || index[d] == 0 ||
+            index[d] == static_cast< typename ImageType::IndexValueType >( expected->GetBufferedRegion().GetSize()[d] - 1 );
+          }
+        if( isOnBorder )
+          {
+          ++numberOfLowerBorderNodes;
+          }
+        }
+      }
+    std::cout << numberOfLowerNodes << " arrival times are lower with the fast iterative method, "
+              << numberOfLowerBorderNodes << " of them on the border" << std::endl;
+    return numberOfLowerBorderNodes > 0;
+    }
+
+private:
+  static unsigned int Random( unsigned int & seed )
+    {
+    seed = seed * 1103515245u + 12345u;
+    return seed >> 16;
+    }
+
+  static typename ImageType::IndexType RandomIndex( unsigned int & seed, unsigned int size )
+    {
+    typename ImageType::IndexType index;
+    for( unsigned int d = 0; d < VDimension; d++ )
+      {
+      index[d] = Random( seed ) % size;
+      }
+    return index;
+    }
+
+  typename ImageType::Pointer            m_Speed;
+  typename NodePairContainerType::Pointer m_TrialPoints;
+  typename NodePairContainerType::Pointer m_AlivePoints;
+  typename NodePairContainerType::Pointer m_ForbiddenPoints;
+};
+}
+
+int itkFastMarchingImageFilterBaseFastIterativeTest( int, char *[] )
+{
+  bool passed = true;
+
+  FastIterativeMethodTester< 2 > tester2D( 64, 2 );
+  passed = tester2D.Test( 1e6 ) && passed;
+  passed = tester2D.Test( 10.0 ) && passed;
+
+  FastIterativeMethodTester< 3 > tester3D( 24, 3 );
+  passed = tester3D.Test( 1e6 ) && passed;
+  passed = tester3D.Test( 5.0 ) && passed;
+
+  // the border nodes do not update their neighbors along the border normal
+  // in the fast marching method
+  FastIterativeMethodTester< 2 > borderTester2D( 64, 2, false );
+  passed = borderTester2D.TestBorder() && passed;
+  FastIterativeMethodTester< 3 > borderTester3D( 24, 3, false );
+  passed = borderTester3D.TestBorder() && passed;
+
+  // topology checks are not supported
+  typedef FastIterativeMethodTester< 2 >::FastMarchingType FastMarchingType;
+  FastMarchingType::Pointer marcher = FastMarchingType::New();
+  marcher->SetStoppingCriterion( FastIterativeMethodTester< 2 >::CriterionType::New() );
+  marcher->SetTrialPoints( FastMarchingType::NodePairContainerType::New() );
+  marcher->SetTopologyCheck( FastMarchingType::Strict );
+  TEST_SET_GET_BOOLEAN( marcher, UseFastIterativeMethod, true );
+  marcher->UseFastIterativeMethodOn();
+  TRY_EXPECT_EXCEPTION( marcher->Update() );
+
+  if( !passed )
+    {
+    std::cerr << "Test failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
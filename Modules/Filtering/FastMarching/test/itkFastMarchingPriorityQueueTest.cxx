@@ -0,0 +1,112 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkFastMarchingPriorityQueue.h"
+#include "itkNodePair.h"
+#include "itkMath.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Push, update and pop nodes in a FastMarchingPriorityQueue, and check that
+ * every node is popped once, with its last value, in increasing order.
+ * Nodes without identifier are pushed as duplicates, also through the
+ * interface of std::priority_queue.
+ */
+
+int itkFastMarchingPriorityQueueTest( int, char *[] )
+{
+  typedef itk::NodePair< itk::IdentifierType, float >      NodePairType;
+  typedef itk::FastMarchingPriorityQueue< NodePairType >   PriorityQueueType;
+
+  const itk::IdentifierType numberOfNodes = 1000;
+
+  PriorityQueueType queue;
+  TEST_EXPECT_TRUE( queue.Empty() );
+  queue.SetMaximumNumberOfNodes( numberOfNodes );
+
+  std::vector< float > values( numberOfNodes, 0.0f );
+  unsigned int seed = 1;
+  for( unsigned int k = 0; k < 4 * numberOfNodes; k++ )
+    {
+    seed = seed * 1103515245u + 12345u;
+    const itk::IdentifierType id = ( seed >> 16 ) % numberOfNodes;
+    seed = seed * 1103515245u + 12345u;
+    values[id] = static_cast< float >( ( seed >> 16 ) % 10000 );
+    queue.Push( NodePairType( id, values[id] ), id );
+    TEST_EXPECT_TRUE( queue.Contains( id ) );
+    }
+
+  itk::SizeValueType numberOfPushedNodes = 0;
+  for( itk::IdentifierType id = 0; id < numberOfNodes; id++ )
+    {
+    if( queue.Contains( id ) )
+      {
+      ++numberOfPushedNodes;
+      }
+    }
+  TEST_EXPECT_EQUAL( queue.Size(), numberOfPushedNodes );
+  TEST_EXPECT_TRUE( !queue.Contains( 2 * numberOfNodes ) );
+
+  float previousValue = -1.0f;
+  while( !queue.Empty() )
+    {
+    const NodePairType nodePair = queue.Peek();
+    queue.Pop();
+    TEST_EXPECT_TRUE( !queue.Contains( nodePair.GetNode() ) );
+    TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( nodePair.GetValue(), values[nodePair.GetNode()] ) );
+    TEST_EXPECT_TRUE( previousValue <= nodePair.GetValue() );
+    previousValue = nodePair.GetValue();
+    --numberOfPushedNodes;
+    }
+  TEST_EXPECT_EQUAL( numberOfPushedNodes, 0 );
+
+  queue.Push( NodePairType( 3, 1.0f ), 3 );
+  queue.Clear();
+  TEST_EXPECT_TRUE( queue.Empty() );
+  TEST_EXPECT_TRUE( !queue.Contains( 3 ) );
+
+  // the nodes without identifier are popped once per push
+  queue.Push( NodePairType( 5, 2.0f ), PriorityQueueType::UnknownIdentifier );
+  queue.Push( NodePairType( 5, 1.0f ), PriorityQueueType::UnknownIdentifier );
+  queue.Push( NodePairType( 7, 1.5f ), 7 );
+  TEST_EXPECT_EQUAL( queue.Size(), 3 );
+  TEST_EXPECT_TRUE( !queue.Contains( PriorityQueueType::UnknownIdentifier ) );
+  const float expectedValues[] = { 1.0f, 1.5f, 2.0f };
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( queue.Peek().GetValue(), expectedValues[k] ) );
+    queue.Pop();
+    }
+  TEST_EXPECT_TRUE( queue.Empty() );
+
+  // interface of std::priority_queue
+  queue.push( NodePairType( 5, 2.0f ) );
+  queue.push( NodePairType( 5, 1.0f ) );
+  queue.Push( NodePairType( 7, 1.5f ), 7 );
+  TEST_EXPECT_TRUE( !queue.empty() );
+  TEST_EXPECT_EQUAL( queue.size(), 3 );
+  for( unsigned int k = 0; k < 3; k++ )
+    {
+    TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( queue.top().GetValue(), expectedValues[k] ) );
+    queue.pop();
+    }
+  TEST_EXPECT_TRUE( queue.empty() );
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
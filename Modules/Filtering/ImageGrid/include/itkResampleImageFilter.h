@@ -27,6 +27,7 @@
 #include "itkSize.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkDataObjectDecorator.h"
+#include "itkIsSame.h"
 
 
 namespace itk
@@ -68,6 +69,18 @@ namespace itk
  * ProcessObject::GenerateInputRequestedRegion() and
  * ProcessObject::GenerateOutputInformation().
  *
+ * When the transform is linear, the input and output pixels are scalars,
+ * the input is an itk::Image and the interpolator is a
+ * LinearInterpolateImageFunction or a
+ * NearestNeighborInterpolateImageFunction, the filter clips each output
+ * scanline to the span that maps inside the input buffer and evaluates the
+ * interpolation inline over that span, without calling the interpolator.
+ *
+ * A CompositeTransform is evaluated through the copy returned by its
+ * GetFlattenedTransform() method, in which consecutive linear transforms are
+ * merged, so that a chain of linear transforms is resampled as a single
+ * linear transform.
+ *
  * This filter is implemented as a multithreaded filter.  It provides a
  * ThreadedGenerateData() method for its implementation.
  * \warning For multithreading, the TransformPoint method of the
@@ -332,6 +345,80 @@ protected:
                                           outputRegionForThread,
                                           ThreadIdType threadId);
 
+  /** Implementation for resampling with linear transformation types
+   * that clips each output scanline to the span inside the input buffer
+   * and interpolates linearly or with the nearest neighbor directly from
+   * the input buffer. Only valid when UseScanlineInterpolation() is
+   * true. */
+  void ScanlineThreadedGenerateData(const OutputImageRegionType &
+                                    outputRegionForThread,
+                                    ThreadIdType threadId, mpl::TrueType);
+  void ScanlineThreadedGenerateData(const OutputImageRegionType &
+                                    outputRegionForThread,
+                                    ThreadIdType threadId, mpl::FalseType);
+
+  /** True when the input and output pixels are scalars, and the input is
+   * an itk::Image, as required by ScanlineThreadedGenerateData(). */
+  typedef typename mpl::If<
+    std::numeric_limits< InputPixelType >::is_specialized
+    && std::numeric_limits< PixelType >::is_specialized
+    && IsSame< InputImageType, Image< InputPixelType, InputImageDimension > >::Value,
+    mpl::TrueType, mpl::FalseType >::Type ScanlineInterpolationSupportedType;
+
+  /** Whether the interpolator is evaluated inline by
+   * ScanlineThreadedGenerateData(). The interpolator must be exactly a
+   * LinearInterpolateImageFunction or a
+   * NearestNeighborInterpolateImageFunction, not a subclass which may
+   * override the interpolation. */
+  bool UseScanlineInterpolation() const;
+
+  /** Whether the x-th pixel of a scanline starting at lineStart and
+   * advancing by delta maps inside the input buffer. */
+  bool IsInsideScanlineBuffer(const ContinuousInputIndexType & lineStart,
+                              const TTransformPrecisionType *delta,
+                              IndexValueType x) const
+  {
+    ContinuousInputIndexType inputIndex;
+    for ( unsigned int j = 0; j < ImageDimension; ++j )
+      {
+      inputIndex[j] = lineStart[j] + static_cast< TTransformPrecisionType >( x ) * delta[j];
+      }
+    return m_Interpolator->IsInsideBuffer(inputIndex);
+  }
+
+  /** Set the output pixel for the x-th pixel of a scanline that maps
+   * outside the input buffer, from the extrapolator if any. */
+  template< typename TOutputIterator >
+  void EvaluateOutsideScanlineBuffer(TOutputIterator & outIt,
+                                     const ContinuousInputIndexType & lineStart,
+                                     const TTransformPrecisionType *delta,
+                                     IndexValueType x,
+                                     const PixelType & defaultValue,
+                                     const ComponentType minOutputValue,
+                                     const ComponentType maxOutputValue) const
+  {
+    if ( m_Extrapolator.IsNull() )
+      {
+      outIt.Set(defaultValue);
+      return;
+      }
+    ContinuousInputIndexType inputIndex;
+    for ( unsigned int j = 0; j < ImageDimension; ++j )
+      {
+      inputIndex[j] = lineStart[j] + static_cast< TTransformPrecisionType >( x ) * delta[j];
+      }
+    outIt.Set( this->CastPixelWithBoundsChecking( m_Extrapolator->EvaluateAtContinuousIndex(inputIndex),
+                                                  minOutputValue, maxOutputValue ) );
+  }
+
+  /** Transform evaluated by the threads: the flattened copy of a
+   * CompositeTransform made by BeforeThreadedGenerateData(), otherwise the
+   * transform itself. */
+  const TransformType * GetEvaluatedTransform() const
+  {
+    return m_FlattenedTransform.IsNull() ? this->GetTransform() : m_FlattenedTransform.GetPointer();
+  }
+
   /** Cast pixel from interpolator output to PixelType. */
   virtual PixelType CastPixelWithBoundsChecking( const InterpolatorOutputType value,
                                                  const ComponentType minComponent,
@@ -354,6 +441,8 @@ private:
   IndexType       m_OutputStartIndex;     // output image start index
   bool            m_UseReferenceImage;
 
+  TransformPointerType m_FlattenedTransform; // flattened composite transform
+
 };
 } // end namespace itk
 
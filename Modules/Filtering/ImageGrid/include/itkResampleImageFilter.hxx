@@ -26,6 +26,12 @@
 #include "itkImageScanlineIterator.h"
 #include "itkSpecialCoordinatesImage.h"
 #include "itkDefaultConvertPixelTraits.h"
+#include "itkCompositeTransform.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkMath.h"
+
+#include <typeinfo>
+#include <vector>
 
 namespace itk
 {
@@ -134,6 +140,20 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     m_Extrapolator->SetInputImage( this->GetInput() );
     }
 
+  // Evaluate a composite transform through a flattened copy, in which the
+  // runs of linear transforms are merged into a single affine transform.
+  // When all of them are linear, the fast path of ThreadedGenerateData()
+  // is used.
+  typedef CompositeTransform< TTransformPrecisionType, ImageDimension > CompositeTransformType;
+  const CompositeTransformType *compositeTransform =
+    dynamic_cast< const CompositeTransformType * >( this->GetTransform() );
+  m_FlattenedTransform = ITK_NULLPTR;
+  if ( compositeTransform && compositeTransform->GetNumberOfTransforms() > 1 )
+    {
+    typename CompositeTransformType::Pointer flattenedTransform = compositeTransform->GetFlattenedTransform();
+    m_FlattenedTransform = dynamic_cast< const TransformType * >( flattenedTransform.GetPointer() );
+    }
+
   unsigned int nComponents
     = DefaultConvertPixelTraits<PixelType>::GetNumberOfComponents(
         m_DefaultPixelValue );
@@ -162,6 +182,7 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
 {
   // Disconnect input image from the interpolator
   m_Interpolator->SetInputImage(ITK_NULLPTR);
+  m_FlattenedTransform = ITK_NULLPTR;
   if( !m_Extrapolator.IsNull() )
     {
     // Disconnect input image from the extrapolator
@@ -190,9 +211,16 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   // Check whether we can use a fast path for resampling. Fast path
   // can be used if the transformation is linear. Transform respond
   // to the IsLinear() call.
-  if ( !isSpecialCoordinatesImage && this->GetTransform()->GetTransformCategory() == TransformType::Linear )
+  if ( !isSpecialCoordinatesImage && this->GetEvaluatedTransform()->GetTransformCategory() == TransformType::Linear )
     {
-    this->LinearThreadedGenerateData(outputRegionForThread, threadId);
+    if ( this->UseScanlineInterpolation() )
+      {
+      this->ScanlineThreadedGenerateData(outputRegionForThread, threadId, ScanlineInterpolationSupportedType());
+      }
+    else
+      {
+      this->LinearThreadedGenerateData(outputRegionForThread, threadId);
+      }
     return;
     }
 
@@ -261,15 +289,30 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   const bool isSpecialCoordinatesImage = dynamic_cast< const InputSpecialCoordinatesImageType * >( inputPtr );
 
   // Get the input transform
-  const TransformType *transformPtr = this->GetTransform();
+  const TransformType *transformPtr = this->GetEvaluatedTransform();
 
 
   // Create an iterator that will walk the output region for this thread.
-  typedef ImageRegionIteratorWithIndex< TOutputImage > OutputIterator;
+  typedef ImageScanlineIterator< TOutputImage > OutputIterator;
   OutputIterator outIt(outputPtr, outputRegionForThread);
 
-  // Define a few indices that will be used to translate from an input pixel
-  // to an output pixel
+  // The points of a scanline are transformed together with
+  // TransformPoints(), which lets the transform hoist its per-call work out
+  // of the loop over the points.
+  typedef typename TransformType::InputPointType  TransformInputPointType;
+  typedef typename TransformType::OutputPointType TransformOutputPointType;
+  const SizeValueType lineLength = outputRegionForThread.GetSize()[0];
+  std::vector< TransformInputPointType >  outputPoints(lineLength);
+  std::vector< TransformOutputPointType > inputPoints(lineLength);
+
+  // Likewise, the positions inside the input buffer are interpolated
+  // together with EvaluateAtContinuousIndices().
+  typedef typename InterpolatorType::OutputType OutputType;
+  std::vector< ContinuousInputIndexType > lineIndices(lineLength);
+  std::vector< ContinuousInputIndexType > insideIndices(lineLength);
+  std::vector< OutputType >               insideValues(lineLength);
+  std::vector< bool >                     isInside(lineLength);
+
   PointType outputPoint;         // Coordinates of current output pixel
   PointType inputPoint;          // Coordinates of current input pixel
 
@@ -278,14 +321,13 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   // Support for progress methods/callbacks
   ProgressReporter progress( this,
                              threadId,
-                             outputRegionForThread.GetNumberOfPixels() );
+                             outputRegionForThread.GetNumberOfPixels() / lineLength );
 
   // Min/max values of the output pixel type AND these values
   // represented as the output type of the interpolator
   const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
   const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
 
-  typedef typename InterpolatorType::OutputType OutputType;
   const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
   const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
 
@@ -294,38 +336,63 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
 
   while ( !outIt.IsAtEnd() )
     {
-    // Determine the index of the current output pixel
-    outputPtr->TransformIndexToPhysicalPoint(outIt.GetIndex(), outputPoint);
+    // Determine the physical points of the current output scanline
+    IndexType index = outIt.GetIndex();
+    for ( SizeValueType x = 0; x < lineLength; ++x, ++index[0] )
+      {
+      outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+      outputPoints[x] = outputPoint;
+      }
 
-    // Compute corresponding input pixel position
-    inputPoint = transformPtr->TransformPoint(outputPoint);
-    const bool isInsideInput = inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
+    // Compute corresponding input pixel positions
+    transformPtr->TransformPoints(&outputPoints[0], &inputPoints[0], lineLength);
 
-    PixelType  pixval;
-    OutputType value;
-    // Evaluate input at right position and copy to the output
-    if( m_Interpolator->IsInsideBuffer(inputIndex) && ( !isSpecialCoordinatesImage || isInsideInput ) )
+    SizeValueType numberOfInsideIndices = 0;
+    for ( SizeValueType x = 0; x < lineLength; ++x )
       {
-      value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
-      pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-      outIt.Set(pixval);
+      inputPoint = inputPoints[x];
+      const bool isInsideInput = inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
+      lineIndices[x] = inputIndex;
+      isInside[x] = m_Interpolator->IsInsideBuffer(inputIndex) && ( !isSpecialCoordinatesImage || isInsideInput );
+      if ( isInside[x] )
+        {
+        insideIndices[numberOfInsideIndices++] = inputIndex;
+        }
       }
-    else
+    if ( numberOfInsideIndices > 0 )
       {
-      if( m_Extrapolator.IsNull() )
+      m_Interpolator->EvaluateAtContinuousIndices(&insideIndices[0], &insideValues[0], numberOfInsideIndices);
+      }
+
+    SizeValueType insideIndex = 0;
+    for ( SizeValueType x = 0; x < lineLength; ++x )
+      {
+      PixelType  pixval;
+      OutputType value;
+      // Copy the interpolated value to the output
+      if( isInside[x] )
         {
-        outIt.Set( m_DefaultPixelValue ); // default background value
+        pixval = this->CastPixelWithBoundsChecking( insideValues[insideIndex++], minOutputValue, maxOutputValue );
+        outIt.Set(pixval);
         }
       else
         {
-        value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
-        pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-        outIt.Set(pixval);
+        if( m_Extrapolator.IsNull() )
+          {
+          outIt.Set( m_DefaultPixelValue ); // default background value
+          }
+        else
+          {
+          value = m_Extrapolator->EvaluateAtContinuousIndex( lineIndices[x] );
+          pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
+          outIt.Set(pixval);
+          }
         }
+      ++outIt;
       }
 
     progress.CompletedPixel();
-    ++outIt;
+    outIt.NextLine();
     }
 }
 
@@ -346,7 +413,7 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
   const InputImageType *inputPtr = this->GetInput();
 
   // Get the input transform
-  const TransformType *transformPtr = this->GetTransform();
+  const TransformType *transformPtr = this->GetEvaluatedTransform();
 
   // Create an iterator that will walk the output region for this thread.
   typedef ImageScanlineIterator< TOutputImage > OutputIterator;
@@ -421,6 +488,14 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
                                                     tmpInputIndex);
   delta = tmpInputIndex - inputIndex;
 
+  // The positions of a scanline that are inside the input buffer are
+  // interpolated together with EvaluateAtContinuousIndices().
+  const SizeValueType lineLength = regionSize[0];
+  std::vector< ContinuousInputIndexType > lineIndices(lineLength);
+  std::vector< ContinuousInputIndexType > insideIndices(lineLength);
+  std::vector< OutputType >               insideValues(lineLength);
+  std::vector< bool >                     isInside(lineLength);
+
   while ( !outIt.IsAtEnd() )
     {
     // Determine the continuous index of the first pixel of output
@@ -436,15 +511,31 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
     inputPoint = transformPtr->TransformPoint(outputPoint);
     inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
 
-    while ( !outIt.IsAtEndOfLine() )
+    SizeValueType numberOfInsideIndices = 0;
+    for ( SizeValueType x = 0; x < lineLength; ++x )
+      {
+      lineIndices[x] = inputIndex;
+      isInside[x] = m_Interpolator->IsInsideBuffer(inputIndex);
+      if ( isInside[x] )
+        {
+        insideIndices[numberOfInsideIndices++] = inputIndex;
+        }
+      inputIndex += delta;
+      }
+    if ( numberOfInsideIndices > 0 )
+      {
+      m_Interpolator->EvaluateAtContinuousIndices(&insideIndices[0], &insideValues[0], numberOfInsideIndices);
+      }
+
+    SizeValueType insideIndex = 0;
+    for ( SizeValueType x = 0; x < lineLength; ++x )
       {
       PixelType  pixval;
       OutputType value;
-      // Evaluate input at right position and copy to the output
-      if ( m_Interpolator->IsInsideBuffer(inputIndex) )
+      // Copy the interpolated value to the output
+      if ( isInside[x] )
         {
-        value = m_Interpolator->EvaluateAtContinuousIndex(inputIndex);
-        pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
+        pixval = this->CastPixelWithBoundsChecking( insideValues[insideIndex++], minOutputValue, maxOutputValue );
         outIt.Set(pixval);
         }
       else
@@ -455,20 +546,266 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTra
           }
         else
           {
-          value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
+          value = m_Extrapolator->EvaluateAtContinuousIndex( lineIndices[x] );
           pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
           outIt.Set(pixval);
           }
         }
 
       ++outIt;
-      inputIndex += delta;
       }
     progress.CompletedPixel();
     outIt.NextLine();
     }
 }
 
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+bool
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::UseScanlineInterpolation() const
+{
+  if ( !ScanlineInterpolationSupportedType::Value || m_Interpolator.IsNull() )
+    {
+    return false;
+    }
+  typedef NearestNeighborInterpolateImageFunction< InputImageType, TInterpolatorPrecisionType >
+    NearestNeighborInterpolatorType;
+  // Subclasses of the interpolators may override the interpolation, so the
+  // dynamic type must match exactly.
+  const std::type_info & interpolatorType = typeid( *m_Interpolator );
+  return interpolatorType == typeid( LinearInterpolatorType )
+    || interpolatorType == typeid( NearestNeighborInterpolatorType );
+}
+
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::ScanlineThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                               ThreadIdType threadId,
+                               mpl::FalseType)
+{
+  this->LinearThreadedGenerateData(outputRegionForThread, threadId);
+}
+
+template< typename TInputImage,
+          typename TOutputImage,
+          typename TInterpolatorPrecisionType,
+          typename TTransformPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType, TTransformPrecisionType >
+::ScanlineThreadedGenerateData(const OutputImageRegionType &
+                               outputRegionForThread,
+                               ThreadIdType threadId,
+                               mpl::TrueType)
+{
+  typedef typename InterpolatorType::OutputType OutputType;
+  typedef typename InterpolatorType::IndexType  InputIndexType;
+  typedef TTransformPrecisionType               CoordinateType;
+  typedef NearestNeighborInterpolateImageFunction< InputImageType, TInterpolatorPrecisionType >
+    NearestNeighborInterpolatorType;
+
+  const unsigned int NumberOfCorners = 1u << ImageDimension;
+
+  OutputImageType *      outputPtr = this->GetOutput();
+  const InputImageType * inputPtr = this->GetInput();
+  const TransformType *  transformPtr = this->GetEvaluatedTransform();
+
+  const bool nearestNeighbor =
+    typeid( *m_Interpolator ) == typeid( NearestNeighborInterpolatorType );
+
+  // The interpolator bounds are those of the buffered region of the input.
+  const InputIndexType &           startIndex = m_Interpolator->GetStartIndex();
+  const InputIndexType &           endIndex = m_Interpolator->GetEndIndex();
+  const typename InterpolatorType::ContinuousIndexType & startContinuousIndex =
+    m_Interpolator->GetStartContinuousIndex();
+  const typename InterpolatorType::ContinuousIndexType & endContinuousIndex =
+    m_Interpolator->GetEndContinuousIndex();
+  const InputPixelType *  buffer = inputPtr->GetBufferPointer();
+  const OffsetValueType * offsetTable = inputPtr->GetOffsetTable();
+
+  typedef ImageScanlineIterator< TOutputImage > OutputIterator;
+  OutputIterator outIt(outputPtr, outputRegionForThread);
+
+  const typename OutputImageRegionType::SizeType &regionSize = outputRegionForThread.GetSize();
+  const SizeValueType numberOfLinesToProcess = outputRegionForThread.GetNumberOfPixels() / regionSize[0];
+  const IndexValueType lineLength = static_cast< IndexValueType >( regionSize[0] );
+
+  ProgressReporter progress( this,
+                             threadId,
+                             numberOfLinesToProcess );
+
+  const PixelType defaultValue = this->GetDefaultPixelValue();
+
+  const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
+  const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
+  const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
+  const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
+
+  // Delta along a scanline in the continuous index space of the input, as
+  // in LinearThreadedGenerateData().
+  PointType                outputPoint;
+  ContinuousInputIndexType inputIndex;
+  ContinuousInputIndexType nextInputIndex;
+  IndexType                index = outIt.GetIndex();
+  outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+  inputPtr->TransformPhysicalPointToContinuousIndex(transformPtr->TransformPoint(outputPoint), inputIndex);
+  ++index[0];
+  outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+  inputPtr->TransformPhysicalPointToContinuousIndex(transformPtr->TransformPoint(outputPoint), nextInputIndex);
+  CoordinateType delta[ImageDimension];
+  for ( unsigned int j = 0; j < ImageDimension; ++j )
+    {
+    delta[j] = nextInputIndex[j] - inputIndex[j];
+    }
+
+  ContinuousInputIndexType position;
+  OutputType               corners[NumberOfCorners];
+  OffsetValueType          lowerOffset[ImageDimension];
+  OffsetValueType          upperOffset[ImageDimension];
+  CoordinateType           distance[ImageDimension];
+
+  while ( !outIt.IsAtEnd() )
+    {
+    index = outIt.GetIndex();
+    outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+    inputPtr->TransformPhysicalPointToContinuousIndex(transformPtr->TransformPoint(outputPoint), inputIndex);
+
+    // Clip the scanline analytically to the span [begin, end) of the
+    // pixels whose continuous index lies inside the buffer, as tested by
+    // the interpolator's IsInsideBuffer(). The position along the scanline
+    // is monotonic in each dimension, so the pixels inside form a single
+    // span, whose ends are then adjusted with the exact test to absorb
+    // rounding errors.
+    IndexValueType begin = 0;
+    IndexValueType end = lineLength;
+    for ( unsigned int j = 0; j < ImageDimension; ++j )
+      {
+      const double p = inputIndex[j];
+      const double d = delta[j];
+      const double lower = startContinuousIndex[j];
+      const double upper = endContinuousIndex[j];
+      double first = 0.0;
+      double last = lineLength;
+      if ( d > 0.0 )
+        {
+        first = std::ceil( ( lower - p ) / d );
+        last = std::ceil( ( upper - p ) / d );
+        }
+      else if ( d < 0.0 )
+        {
+        first = std::floor( ( upper - p ) / d ) + 1.0;
+        last = std::floor( ( lower - p ) / d ) + 1.0;
+        }
+      else if ( !( p >= lower && p < upper ) )
+        {
+        last = 0.0;
+        }
+      if ( !( first <= last ) ) // Also catches NaN's.
+        {
+        first = last = 0.0;
+        }
+      first = std::max( 0.0, std::min( static_cast< double >( lineLength ), first ) );
+      last = std::max( 0.0, std::min( static_cast< double >( lineLength ), last ) );
+      begin = std::max( begin, static_cast< IndexValueType >( first ) );
+      end = std::min( end, static_cast< IndexValueType >( last ) );
+      }
+    if ( end < begin )
+      {
+      end = begin;
+      }
+    while ( begin < end && !this->IsInsideScanlineBuffer( inputIndex, delta, begin ) )
+      {
+      ++begin;
+      }
+    while ( end > begin && !this->IsInsideScanlineBuffer( inputIndex, delta, end - 1 ) )
+      {
+      --end;
+      }
+    while ( begin > 0 && this->IsInsideScanlineBuffer( inputIndex, delta, begin - 1 ) )
+      {
+      --begin;
+      }
+    while ( end < lineLength && this->IsInsideScanlineBuffer( inputIndex, delta, end ) )
+      {
+      ++end;
+      }
+
+    IndexValueType x = 0;
+    for (; x < begin; ++x, ++outIt )
+      {
+      this->EvaluateOutsideScanlineBuffer( outIt, inputIndex, delta, x,
+                                           defaultValue, minOutputValue, maxOutputValue );
+      }
+
+    if ( nearestNeighbor )
+      {
+      for (; x < end; ++x, ++outIt )
+        {
+        OffsetValueType offset = 0;
+        for ( unsigned int j = 0; j < ImageDimension; ++j )
+          {
+          const CoordinateType p = inputIndex[j] + static_cast< CoordinateType >( x ) * delta[j];
+          offset += ( Math::RoundHalfIntegerUp< IndexValueType >( p ) - startIndex[j] ) * offsetTable[j];
+          }
+        const OutputType value = static_cast< OutputType >( buffer[offset] );
+        outIt.Set( this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue ) );
+        }
+      }
+    else
+      {
+      for (; x < end; ++x, ++outIt )
+        {
+        // Same neighbors and weights as LinearInterpolateImageFunction: the
+        // lower neighbor is clamped to the start of the buffer, the upper
+        // one to its end.
+        for ( unsigned int j = 0; j < ImageDimension; ++j )
+          {
+          const CoordinateType p = inputIndex[j] + static_cast< CoordinateType >( x ) * delta[j];
+          const IndexValueType lower = std::max( Math::Floor< IndexValueType >( p ), startIndex[j] );
+          const IndexValueType upper = std::min( lower + 1, endIndex[j] );
+          distance[j] = std::max( p - static_cast< CoordinateType >( lower ), NumericTraits< CoordinateType >::ZeroValue() );
+          lowerOffset[j] = ( lower - startIndex[j] ) * offsetTable[j];
+          upperOffset[j] = ( upper - startIndex[j] ) * offsetTable[j];
+          }
+        for ( unsigned int c = 0; c < NumberOfCorners; ++c )
+          {
+          OffsetValueType offset = 0;
+          for ( unsigned int j = 0; j < ImageDimension; ++j )
+            {
+            offset += ( c & ( 1u << j ) ) ? upperOffset[j] : lowerOffset[j];
+            }
+          corners[c] = static_cast< OutputType >( buffer[offset] );
+          }
+        // Interpolate along each dimension in turn, halving the number of
+        // values each time.
+        for ( unsigned int j = 0, n = NumberOfCorners / 2; j < ImageDimension; ++j, n /= 2 )
+          {
+          for ( unsigned int c = 0; c < n; ++c )
+            {
+            corners[c] = corners[2 * c] + ( corners[2 * c + 1] - corners[2 * c] ) * distance[j];
+            }
+          }
+        outIt.Set( this->CastPixelWithBoundsChecking( corners[0], minOutputValue, maxOutputValue ) );
+        }
+      }
+
+    for (; x < lineLength; ++x, ++outIt )
+      {
+      this->EvaluateOutsideScanlineBuffer( outIt, inputIndex, delta, x,
+                                           defaultValue, minOutputValue, maxOutputValue );
+      }
+
+    progress.CompletedPixel();
+    outIt.NextLine();
+    }
+}
+
 template< typename TInputImage,
           typename TOutputImage,
           typename TInterpolatorPrecisionType,
@@ -0,0 +1,216 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAffineTransform.h"
+#include "itkResampleImageFilter.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkNearestNeighborInterpolateImageFunction.h"
+#include "itkNearestNeighborExtrapolateImageFunction.h"
+#include "itkRandomImageSource.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/* Resample a 3D image with an affine transform, whose output extends
+ * beyond the input on every side, so that each scanline is clipped to the
+ * input buffer. The output of the filter, which interpolates directly
+ * from the input buffer, is compared to the interpolator evaluated at each
+ * output pixel. A subclass of the linear interpolator, which overrides
+ * the interpolation, must not be evaluated inline. */
+namespace
+{
+typedef itk::Image< short, 3 >                       ImageType;
+typedef itk::AffineTransform< double, 3 >            TransformType;
+typedef itk::ResampleImageFilter< ImageType, ImageType > ResampleFilterType;
+
+/** Linear interpolator which offsets the interpolated values. */
+class OffsetLinearInterpolator:
+  public itk::LinearInterpolateImageFunction< ImageType, double >
+{
+public:
+  typedef OffsetLinearInterpolator                                 Self;
+  typedef itk::LinearInterpolateImageFunction< ImageType, double > Superclass;
+  typedef itk::SmartPointer< Self >                                Pointer;
+  typedef itk::SmartPointer< const Self >                          ConstPointer;
+
+  itkNewMacro( Self );
+  itkTypeMacro( OffsetLinearInterpolator, LinearInterpolateImageFunction );
+
+  virtual OutputType EvaluateAtContinuousIndex( const ContinuousIndexType & index ) const ITK_OVERRIDE
+  {
+    return Superclass::EvaluateAtContinuousIndex( index ) + 100.0;
+  }
+
+protected:
+  OffsetLinearInterpolator() {}
+  ~OffsetLinearInterpolator() ITK_OVERRIDE {}
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN( OffsetLinearInterpolator );
+};
+
+int CompareWithInterpolator( ResampleFilterType * resample,
+                             const ImageType * input,
+                             const TransformType * transform )
+{
+  ResampleFilterType::InterpolatorType * interpolator = resample->GetInterpolator();
+  ResampleFilterType::ExtrapolatorType * extrapolator = resample->GetExtrapolator();
+  interpolator->SetInputImage( input );
+  if ( extrapolator )
+    {
+    extrapolator->SetInputImage( input );
+    }
+
+  const ImageType * output = resample->GetOutput();
+  unsigned int      numberOfInside = 0;
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( output, output->GetBufferedRegion() );
+  for (; !it.IsAtEnd(); ++it )
+    {
+    ImageType::PointType point;
+    output->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    ResampleFilterType::ContinuousInputIndexType inputIndex;
+    input->TransformPhysicalPointToContinuousIndex( transform->TransformPoint( point ), inputIndex );
+
+    double expected = resample->GetDefaultPixelValue();
+    if ( interpolator->IsInsideBuffer( inputIndex ) )
+      {
+      expected = interpolator->EvaluateAtContinuousIndex( inputIndex );
+      ++numberOfInside;
+      }
+    else if ( extrapolator )
+      {
+      expected = extrapolator->EvaluateAtContinuousIndex( inputIndex );
+      }
+
+    // The values are truncated to short, allow for a different rounding of
+    // the interpolated values.
+    if ( std::fabs( expected - it.Get() ) > 1.0 )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "At index " << it.GetIndex() << " expected " << expected
+                << " but got " << it.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  if ( numberOfInside == 0 || numberOfInside == output->GetBufferedRegion().GetNumberOfPixels() )
+    {
+    std::cerr << "Test failed!" << std::endl;
+    std::cerr << "The output should be partially inside the input, but "
+              << numberOfInside << " pixels are inside." << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
+}
+
+int itkResampleImageTest7( int, char * [] )
+{
+  typedef itk::RandomImageSource< ImageType > SourceType;
+  SourceType::Pointer source = SourceType::New();
+  ImageType::SizeType size;
+  size[0] = 23;
+  size[1] = 17;
+  size[2] = 11;
+  source->SetSize( size );
+  source->SetMin( -1000 );
+  source->SetMax( 1000 );
+  source->Update();
+
+  ImageType::Pointer input = source->GetOutput();
+  ImageType::DirectionType direction;
+  direction.SetIdentity();
+  direction[0][0] = 0.0;
+  direction[0][1] = -1.0;
+  direction[1][0] = 1.0;
+  direction[1][1] = 0.0;
+  input->SetDirection( direction );
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.1;
+  spacing[1] = 0.9;
+  spacing[2] = 2.0;
+  input->SetSpacing( spacing );
+
+  TransformType::Pointer transform = TransformType::New();
+  TransformType::OutputVectorType axis;
+  axis[0] = 1.0;
+  axis[1] = 2.0;
+  axis[2] = 3.0;
+  transform->Rotate3D( axis, 0.3 );
+  TransformType::OutputVectorType scale;
+  scale[0] = 1.1;
+  scale[1] = 0.8;
+  scale[2] = 1.3;
+  transform->Scale( scale );
+  TransformType::OutputVectorType translation;
+  translation[0] = -4.5;
+  translation[1] = 3.25;
+  translation[2] = 1.0;
+  transform->Translate( translation );
+
+  ImageType::SizeType outputSize;
+  outputSize[0] = 41;
+  outputSize[1] = 37;
+  outputSize[2] = 29;
+  ImageType::PointType outputOrigin;
+  outputOrigin[0] = -30.0;
+  outputOrigin[1] = -10.0;
+  outputOrigin[2] = -15.0;
+  ImageType::SpacingType outputSpacing;
+  outputSpacing.Fill( 0.77 );
+
+  ResampleFilterType::Pointer resample = ResampleFilterType::New();
+  resample->SetInput( input );
+  resample->SetTransform( transform );
+  resample->SetSize( outputSize );
+  resample->SetOutputOrigin( outputOrigin );
+  resample->SetOutputSpacing( outputSpacing );
+  resample->SetDefaultPixelValue( 7 );
+
+  int testStatus = EXIT_SUCCESS;
+
+  // Linear interpolation, with the default pixel value outside.
+  TRY_EXPECT_NO_EXCEPTION( resample->Update() );
+  if ( CompareWithInterpolator( resample, input, transform ) == EXIT_FAILURE )
+    {
+    testStatus = EXIT_FAILURE;
+    }
+
+  // Nearest neighbor interpolation, with the nearest neighbor extrapolator.
+  typedef itk::NearestNeighborInterpolateImageFunction< ImageType, double > NearestInterpolatorType;
+  typedef itk::NearestNeighborExtrapolateImageFunction< ImageType, double > NearestExtrapolatorType;
+  resample->SetInterpolator( NearestInterpolatorType::New() );
+  resample->SetExtrapolator( NearestExtrapolatorType::New() );
+  TRY_EXPECT_NO_EXCEPTION( resample->Update() );
+  if ( CompareWithInterpolator( resample, input, transform ) == EXIT_FAILURE )
+    {
+    testStatus = EXIT_FAILURE;
+    }
+
+  // A subclass of the linear interpolator, with the default pixel value
+  // outside.
+  resample->SetInterpolator( OffsetLinearInterpolator::New() );
+  resample->SetExtrapolator( ITK_NULLPTR );
+  TRY_EXPECT_NO_EXCEPTION( resample->Update() );
+  if ( CompareWithInterpolator( resample, input, transform ) == EXIT_FAILURE )
+    {
+    testStatus = EXIT_FAILURE;
+    }
+
+  return testStatus;
+}
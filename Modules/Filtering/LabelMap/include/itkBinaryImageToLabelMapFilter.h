@@ -20,13 +20,11 @@
 
 #include "itkImageToImageFilter.h"
 #include <list>
-#include <map>
-#include <vector>
 #include "itkProgressReporter.h"
-#include "itkBarrier.h"
 #include "itkLabelMap.h"
 #include "itkLabelObject.h"
 #include "itkImageRegionSplitterDirection.h"
+#include "itkScanlineConnectedComponentLabeler.h"
 
 namespace itk
 {
@@ -41,6 +39,10 @@ namespace itk
  * that are reached earlier by a raster order scan have a lower
  * label.
  *
+ * The runs of foreground pixels are labeled with a union-find table by
+ * ScanlineConnectedComponentLabeler, shared with
+ * ConnectedComponentImageFilter.
+ *
  * The GetOutput() function of this class returns an itk::LabelMap.
  *
  * This implementation was taken from the Insight Journal paper:
@@ -49,7 +51,8 @@ namespace itk
  *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
- * \sa ConnectedComponentImageFilter, LabelImageToLabelMapFilter, LabelMap, LabelObject
+ * \sa ConnectedComponentImageFilter, LabelImageToLabelMapFilter, LabelMap, LabelObject,
+ * ScanlineConnectedComponentLabeler
  * \ingroup ITKLabelMap
  *
  * \wiki
@@ -185,56 +188,9 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(BinaryImageToLabelMapFilter);
 
-  // some additional types
-  typedef typename TOutputImage::RegionType::SizeType OutSizeType;
-
-  // types to support the run length encoding of lines
-  class runLength
-  {
-  public:
-    // run length information - may be a more type safe way of doing this
-    SizeValueType length;
-    typename InputImageType::IndexType where; // Index of the start of the run
-    InternalLabelType label;                  // the initial label of the run
-  };
-
-  typedef std::vector< runLength > lineEncoding;
-
-  // the map storing lines
-  typedef std::vector< lineEncoding > LineMapType;
-
-  typedef std::vector< OffsetValueType > OffsetVectorType;
-
-  // the types to support union-find operations
-  typedef std::vector< InternalLabelType > UnionFindType;
-  UnionFindType m_UnionFind;
-
-  typedef std::vector< OutputPixelType > ConsecutiveVectorType;
-  ConsecutiveVectorType m_Consecutive;
-
-  // functions to support union-find operations
-  void InitUnion(const InternalLabelType size);
-
-  void InsertSet(const InternalLabelType label);
-
-  InternalLabelType LookupSet(const InternalLabelType label);
-
-  void LinkLabels(const InternalLabelType lab1, const InternalLabelType lab2);
-
-  SizeValueType CreateConsecutive();
-
-  //////////////////
-  bool CheckNeighbors(const OutputIndexType & A,
-                      const OutputIndexType & B);
-
-  void CompareLines(lineEncoding & current, const lineEncoding & Neighbour);
-
-  void FillOutput(const LineMapType & LineMap,
-                  ProgressReporter & progress);
-
-  void SetupLineOffsets(OffsetVectorType & LineOffsets);
-
-  void Wait();
+  typedef ScanlineConnectedComponentLabeler< itkGetStaticConstMacro(ImageDimension) > LabelerType;
+  typedef typename LabelerType::RunLength                                            RunLengthType;
+  typedef typename LabelerType::LineEncodingType                                     LineEncodingType;
 
   OutputPixelType m_OutputBackgroundValue;
   InputPixelType  m_InputForegroundValue;
@@ -243,15 +199,10 @@ private:
 
   bool m_FullyConnected;
 
-  std::vector< SizeValueType >   m_NumberOfLabels;
-  std::vector< SizeValueType >   m_FirstLineIdToJoin;
-
-  typename Barrier::Pointer m_Barrier;
-
   ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
 
 #if !defined( ITK_WRAPPING_PARSER )
-  LineMapType m_LineMap;
+  LabelerType m_Labeler;
 #endif
 };
 } // end namespace itk
@@ -20,7 +20,9 @@
 
 #include "itkImageBase.h"
 #include "itkWeakPointer.h"
+#include "itkIntTypes.h"
 #include <map>
+#include <vector>
 
 namespace itk
 {
@@ -52,6 +54,18 @@ namespace itk
  *   }
  * \endcode
  *
+ * The lines of the objects can also be copied in an optional compact
+ * representation with BuildCompactRepresentation(): a single run table,
+ * with the start index along each dimension and the length of the runs in
+ * separate arrays, sorted by object then index, and, when the labels are
+ * dense enough, an index from the labels to the objects.  The filters that
+ * only read the lines of their input, such as LabelMapToLabelImageFilter,
+ * ShapeLabelMapFilter and LabelMapToAttributeImageFilter, use it when it is
+ * available, and GetLabelObject() and HasLabel() use the label index.  The
+ * compact representation is a snapshot: it is released by the methods of
+ * the label map that add, remove or modify objects, and must be rebuilt
+ * after the lines of the objects are modified directly.  It is not grafted.
+ *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * This implementation was taken from the Insight Journal paper:
@@ -279,6 +293,70 @@ public:
    */
   void Optimize();
 
+  /**
+   * Build the compact representation of the lines of the label objects.
+   * This method throws an exception if the index or the length of a line
+   * does not fit in 32 bits.
+   */
+  void BuildCompactRepresentation();
+
+  /**
+   * Release the memory of the compact representation.
+   */
+  void ReleaseCompactRepresentation();
+
+  /**
+   * Return true if the compact representation is available.
+   */
+  bool HasCompactRepresentation() const
+  {
+    return m_HasCompactRepresentation;
+  }
+
+  /**
+   * Return true if the compact representation has a dense index from the
+   * labels to the objects.  It is built when the labels are integers that
+   * span at most four times the number of objects, plus 1024.
+   */
+  bool HasDenseLabelIndex() const
+  {
+    return !m_CompactLabelIndex.empty();
+  }
+
+  /**
+   * Return the number of runs of the compact representation.
+   */
+  SizeValueType GetNumberOfCompactRuns() const
+  {
+    return static_cast< SizeValueType >( m_CompactRunLengths.size() );
+  }
+
+  /**
+   * Get the range [begin, end) of the runs of the object with the label
+   * given in parameter in the compact representation.  Return false if the
+   * compact representation is not available or has no object with this
+   * label.
+   */
+  bool GetCompactRuns(const LabelType & label, SizeValueType & begin, SizeValueType & end) const;
+
+  /**
+   * Return the index and the length of a run of the compact representation.
+   */
+  IndexType GetCompactRunIndex(SizeValueType run) const
+  {
+    IndexType idx;
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      idx[i] = m_CompactRunIndices[i][run];
+      }
+    return idx;
+  }
+
+  LengthType GetCompactRunLength(SizeValueType run) const
+  {
+    return m_CompactRunLengths[run];
+  }
+
   /** \class ConstIterator
    * \brief A forward iterator over the LabelObjects of a LabelMap
    * \ingroup ITKLabelMap
@@ -464,6 +542,22 @@ private:
   LabelObjectContainerType m_LabelObjectContainer;
   LabelType                m_BackgroundValue;
 
+  /** The compact representation: the runs of all the objects, the first
+   * run of each object in label order, followed by the number of runs, the
+   * labels and the objects in label order, and the position of each label
+   * from the smallest one when the labels are dense enough. */
+  bool                             m_HasCompactRepresentation;
+  std::vector< int32_t >           m_CompactRunIndices[ImageDimension];
+  std::vector< uint32_t >          m_CompactRunLengths;
+  std::vector< SizeValueType >     m_CompactRunBegins;
+  std::vector< LabelType >         m_CompactLabels;
+  std::vector< LabelObjectType * > m_CompactLabelObjects;
+  std::vector< SizeValueType >     m_CompactLabelIndex;
+
+  /** Get the position of the object with the label given in parameter in
+   * the compact representation. */
+  bool GetCompactPosition(const LabelType & label, SizeValueType & position) const;
+
   void AddPixel( const LabelObjectContainerIterator& it,
                  const IndexType& idx,
                  const LabelType& iLabel );
@@ -30,6 +30,7 @@
 
 #include "itkLabelMap.h"
 #include "itkProcessObject.h"
+#include "itkLabelObjectLineComparator.h"
 
 #include <algorithm>
 
@@ -40,6 +41,7 @@ template< typename TLabelObject >
 LabelMap< TLabelObject >
 ::LabelMap()
 {
+  m_HasCompactRepresentation = false;
   m_BackgroundValue = NumericTraits< LabelType >::ZeroValue();
   this->Initialize();
 }
@@ -55,6 +57,9 @@ LabelMap< TLabelObject >
   os << indent << "BackgroundValue: "
      << static_cast< typename NumericTraits< LabelType >::PrintType >( m_BackgroundValue ) << std::endl;
   os << indent << "LabelObjectContainer: " << &m_LabelObjectContainer << std::endl;
+  os << indent << "HasCompactRepresentation: " << m_HasCompactRepresentation << std::endl;
+  os << indent << "NumberOfCompactRuns: " << m_CompactRunLengths.size() << std::endl;
+  os << indent << "HasDenseLabelIndex: " << this->HasDenseLabelIndex() << std::endl;
 }
 
 
@@ -88,7 +93,9 @@ LabelMap< TLabelObject >
   // call the superclass' implementation
   Superclass::Graft(imgData);
 
-  // Now copy anything remaining that is needed
+  // Now copy anything remaining that is needed.  The compact representation
+  // is not grafted.
+  this->ReleaseCompactRepresentation();
   if( &m_LabelObjectContainer != &(imgData->m_LabelObjectContainer) )
     {
     m_LabelObjectContainer.clear();
@@ -133,6 +140,11 @@ LabelMap< TLabelObject >
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << " is the background label.");
     }
+  SizeValueType position;
+  if ( this->GetCompactPosition( label, position ) )
+    {
+    return m_CompactLabelObjects[position];
+    }
   LabelObjectContainerIterator it = m_LabelObjectContainer.find( label );
   if ( it == m_LabelObjectContainer.end() )
     {
@@ -156,6 +168,11 @@ LabelMap< TLabelObject >
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << " is the background label.");
     }
+  SizeValueType position;
+  if ( this->GetCompactPosition( label, position ) )
+    {
+    return m_CompactLabelObjects[position];
+    }
   LabelObjectContainerConstIterator it = m_LabelObjectContainer.find( label );
   if ( it == m_LabelObjectContainer.end() )
     {
@@ -173,6 +190,11 @@ bool
 LabelMap< TLabelObject >
 ::HasLabel(const LabelType label) const
 {
+  if ( m_HasCompactRepresentation )
+    {
+    SizeValueType position;
+    return this->GetCompactPosition( label, position );
+    }
   return m_LabelObjectContainer.find(label) != m_LabelObjectContainer.end();
 }
 
@@ -312,6 +334,7 @@ LabelMap< TLabelObject >
     return;
     }
 
+  this->ReleaseCompactRepresentation();
   if ( it != m_LabelObjectContainer.end() )
     {
     // the label already exist - add the pixel to it
@@ -342,6 +365,7 @@ LabelMap< TLabelObject >
     // the label already exist - add the pixel to it
     if( it->second->RemoveIndex(idx) )
       {
+      this->ReleaseCompactRepresentation();
       if( it->second->Empty() )
         {
         this->RemoveLabelObject(it->second);
@@ -384,6 +408,7 @@ LabelMap< TLabelObject >
     return;
     }
 
+  this->ReleaseCompactRepresentation();
   LabelObjectContainerIterator it = m_LabelObjectContainer.find(label);
 
   if ( it != m_LabelObjectContainer.end() )
@@ -430,6 +455,7 @@ LabelMap< TLabelObject >
 {
   itkAssertOrThrowMacro( ( labelObject != ITK_NULLPTR ), "Input LabelObject can't be Null" );
 
+  this->ReleaseCompactRepresentation();
   m_LabelObjectContainer[labelObject->GetLabel()] = labelObject;
   this->Modified();
 }
@@ -523,6 +549,7 @@ LabelMap< TLabelObject >
                       << static_cast< typename NumericTraits< LabelType >::PrintType >( label )
                       << " is the background label.");
     }
+  this->ReleaseCompactRepresentation();
   m_LabelObjectContainer.erase(label);
   this->Modified();
 }
@@ -533,6 +560,7 @@ void
 LabelMap< TLabelObject >
 ::ClearLabels()
 {
+  this->ReleaseCompactRepresentation();
   if ( !m_LabelObjectContainer.empty() )
     {
     m_LabelObjectContainer.clear();
@@ -614,9 +642,161 @@ LabelMap< TLabelObject >
     assert( ( it->second.IsNotNull() ) );
     it->second->Optimize();
     }
+  this->ReleaseCompactRepresentation();
   this->Modified();
 }
 
+
+template< typename TLabelObject >
+void
+LabelMap< TLabelObject >
+::BuildCompactRepresentation()
+{
+  this->ReleaseCompactRepresentation();
+
+  typedef typename LabelObjectType::LineType LineType;
+
+  SizeValueType numberOfRuns = 0;
+  for ( LabelObjectContainerConstIterator it = m_LabelObjectContainer.begin();
+        it != m_LabelObjectContainer.end();
+        it++ )
+    {
+    numberOfRuns += it->second->GetNumberOfLines();
+    }
+  const SizeValueType numberOfObjects = this->GetNumberOfLabelObjects();
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    m_CompactRunIndices[i].reserve( numberOfRuns );
+    }
+  m_CompactRunLengths.reserve( numberOfRuns );
+  m_CompactRunBegins.reserve( numberOfObjects + 1 );
+  m_CompactLabels.reserve( numberOfObjects );
+  m_CompactLabelObjects.reserve( numberOfObjects );
+
+  // copy the lines of each object sorted by index
+  std::vector< LineType > lines;
+  Functor::LabelObjectLineComparator< LineType > comparator;
+  m_CompactRunBegins.push_back( 0 );
+  for ( LabelObjectContainerConstIterator it = m_LabelObjectContainer.begin();
+        it != m_LabelObjectContainer.end();
+        it++ )
+    {
+    LabelObjectType * labelObject = it->second;
+    const SizeValueType numberOfLines = labelObject->GetNumberOfLines();
+    lines.clear();
+    for ( SizeValueType l = 0; l < numberOfLines; l++ )
+      {
+      lines.push_back( labelObject->GetLine( l ) );
+      }
+    std::stable_sort( lines.begin(), lines.end(), comparator );
+
+    for ( SizeValueType l = 0; l < numberOfLines; l++ )
+      {
+      const IndexType & idx = lines[l].GetIndex();
+      for ( unsigned int i = 0; i < ImageDimension; i++ )
+        {
+        if ( idx[i] < NumericTraits< int32_t >::NonpositiveMin() || idx[i] > NumericTraits< int32_t >::max() )
+          {
+          this->ReleaseCompactRepresentation();
+          itkExceptionMacro(<< "The index " << idx << " does not fit in the compact representation.");
+          }
+        m_CompactRunIndices[i].push_back( static_cast< int32_t >( idx[i] ) );
+        }
+      if ( lines[l].GetLength() > NumericTraits< uint32_t >::max() )
+        {
+        this->ReleaseCompactRepresentation();
+        itkExceptionMacro(<< "The length " << lines[l].GetLength() << " does not fit in the compact representation.");
+        }
+      m_CompactRunLengths.push_back( static_cast< uint32_t >( lines[l].GetLength() ) );
+      }
+    m_CompactRunBegins.push_back( m_CompactRunLengths.size() );
+    m_CompactLabels.push_back( it->first );
+    m_CompactLabelObjects.push_back( labelObject );
+    }
+
+  // index the objects by label when the labels are dense enough
+  if ( NumericTraits< LabelType >::is_integer && numberOfObjects > 0 )
+    {
+    const LabelType minimum = m_CompactLabels.front();
+    const double    range = static_cast< double >( m_CompactLabels.back() ) - static_cast< double >( minimum ) + 1.0;
+    if ( range <= 4.0 * numberOfObjects + 1024.0 )
+      {
+      m_CompactLabelIndex.assign( static_cast< SizeValueType >( range ), NumericTraits< SizeValueType >::max() );
+      for ( SizeValueType position = 0; position < numberOfObjects; position++ )
+        {
+        m_CompactLabelIndex[static_cast< SizeValueType >( m_CompactLabels[position] - minimum )] = position;
+        }
+      }
+    }
+
+  m_HasCompactRepresentation = true;
+}
+
+
+template< typename TLabelObject >
+void
+LabelMap< TLabelObject >
+::ReleaseCompactRepresentation()
+{
+  if ( !m_HasCompactRepresentation )
+    {
+    return;
+    }
+  // swap the containers with empty ones to release their memory
+  for ( unsigned int i = 0; i < ImageDimension; i++ )
+    {
+    std::vector< int32_t >().swap( m_CompactRunIndices[i] );
+    }
+  std::vector< uint32_t >().swap( m_CompactRunLengths );
+  std::vector< SizeValueType >().swap( m_CompactRunBegins );
+  std::vector< LabelType >().swap( m_CompactLabels );
+  std::vector< LabelObjectType * >().swap( m_CompactLabelObjects );
+  std::vector< SizeValueType >().swap( m_CompactLabelIndex );
+  m_HasCompactRepresentation = false;
+}
+
+
+template< typename TLabelObject >
+bool
+LabelMap< TLabelObject >
+::GetCompactPosition(const LabelType & label, SizeValueType & position) const
+{
+  if ( !m_HasCompactRepresentation || m_CompactLabels.empty()
+       || label < m_CompactLabels.front() || m_CompactLabels.back() < label )
+    {
+    return false;
+    }
+  if ( !m_CompactLabelIndex.empty() )
+    {
+    position = m_CompactLabelIndex[static_cast< SizeValueType >( label - m_CompactLabels.front() )];
+    return position != NumericTraits< SizeValueType >::max();
+    }
+  typename std::vector< LabelType >::const_iterator it =
+    std::lower_bound( m_CompactLabels.begin(), m_CompactLabels.end(), label );
+  if ( it == m_CompactLabels.end() || *it != label )
+    {
+    return false;
+    }
+  position = static_cast< SizeValueType >( it - m_CompactLabels.begin() );
+  return true;
+}
+
+
+template< typename TLabelObject >
+bool
+LabelMap< TLabelObject >
+::GetCompactRuns(const LabelType & label, SizeValueType & begin, SizeValueType & end) const
+{
+  SizeValueType position;
+  if ( !this->GetCompactPosition( label, position ) )
+    {
+    return false;
+    }
+  begin = m_CompactRunBegins[position];
+  end = m_CompactRunBegins[position + 1];
+  return true;
+}
+
 } // end namespace itk
 
 #endif
@@ -30,6 +30,9 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkFastMutexLock.h"
+#include "itkAtomicInt.h"
+#include <utility>
+#include <vector>
 
 namespace itk
 {
@@ -42,6 +45,13 @@ namespace itk
  * With that class, the developer doesn't need to take care of iterating over all the objects in
  * the image, or to manage by hand the threads.
  *
+ * The label objects are listed before the threads are started, sorted by
+ * decreasing size, and grouped in batches of similar total size.  Each
+ * thread claims the next batch with an atomic counter, so the largest
+ * objects are processed first and the threads don't contend on a lock for
+ * every object.  ThreadedProcessLabelObject() must not remove other label
+ * objects than the one it processes.
+ *
  * \author Gaetan Lehmann. Biologie du Developpement et de la Reproduction, INRA de Jouy-en-Josas, France.
  *
  * This implementation was taken from the Insight Journal paper:
@@ -123,9 +133,18 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(LabelMapFilter);
 
-  typename InputImageType::Iterator m_LabelObjectIterator;
-  float                             m_InverseNumberOfLabelObjects;
-  SizeValueType                     m_NumberOfLabelObjectsProcessed;
+  typedef std::pair< SizeValueType, LabelObjectType * > SizedLabelObjectType;
+
+  static bool IsLarger(const SizedLabelObjectType & a, const SizedLabelObjectType & b)
+  {
+    return a.first > b.first;
+  }
+
+  std::vector< LabelObjectType * > m_LabelObjects;
+  std::vector< SizeValueType >     m_LabelObjectBatchEnds;
+  AtomicInt< SizeValueType >       m_NextLabelObjectBatch;
+  float                            m_InverseNumberOfLabelObjects;
+  AtomicInt< SizeValueType >       m_NumberOfLabelObjectsProcessed;
 };
 } // end namespace itk
 
@@ -28,13 +28,14 @@
 #ifndef itkLabelMapFilter_hxx
 #define itkLabelMapFilter_hxx
 #include "itkLabelMapFilter.h"
-#include "itkMutexLockHolder.h"
+#include <algorithm>
 
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
 LabelMapFilter< TInputImage, TOutputImage >
 ::LabelMapFilter():
+  m_NextLabelObjectBatch( 0 ),
   m_InverseNumberOfLabelObjects( 1.0f ),
   m_NumberOfLabelObjectsProcessed( 1 )
 {
@@ -76,20 +77,53 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::BeforeThreadedGenerateData()
 {
-  // initialize the iterator
-  m_LabelObjectIterator =  typename InputImageType::Iterator(this->GetLabelMap());
-//  m_LabelObjectIterator = typename InputImageType::Iterator(this->GetLabelMap());
+  // list the label objects, the largest first, so the threads end with the
+  // small ones. The objects of the same size stay in the order of their
+  // labels.
+  std::vector< SizedLabelObjectType > sizedLabelObjects;
+  sizedLabelObjects.reserve( this->GetLabelMap()->GetNumberOfLabelObjects() );
+  SizeValueType totalSize = 0;
+  for ( typename InputImageType::Iterator it( this->GetLabelMap() ); !it.IsAtEnd(); ++it )
+    {
+    LabelObjectType * labelObject = it.GetLabelObject();
+    const SizeValueType size = labelObject->Size();
+    sizedLabelObjects.push_back( SizedLabelObjectType( size, labelObject ) );
+    totalSize += size;
+    }
+  std::stable_sort( sizedLabelObjects.begin(), sizedLabelObjects.end(), &Self::IsLarger );
+
+  // group them in batches of about 1/16 of the work of a thread, of at most
+  // 256 objects
+  const SizeValueType batchSize =
+    std::max< SizeValueType >( totalSize / ( 16 * this->GetNumberOfThreads() ), 1 );
+  m_LabelObjects.clear();
+  m_LabelObjects.reserve( sizedLabelObjects.size() );
+  m_LabelObjectBatchEnds.clear();
+  SizeValueType sizeInBatch = 0;
+  SizeValueType firstInBatch = 0;
+  for ( SizeValueType i = 0; i < sizedLabelObjects.size(); i++ )
+    {
+    m_LabelObjects.push_back( sizedLabelObjects[i].second );
+    sizeInBatch += sizedLabelObjects[i].first;
+    if ( sizeInBatch >= batchSize || i + 1 - firstInBatch == 256 || i + 1 == sizedLabelObjects.size() )
+      {
+      m_LabelObjectBatchEnds.push_back( i + 1 );
+      sizeInBatch = 0;
+      firstInBatch = i + 1;
+      }
+    }
+  m_NextLabelObjectBatch = 0;
 
-  // and the mutex
+  // the mutex for the subclasses modifying the label map
   m_LabelObjectContainerLock = FastMutexLock::New();
 
-  if(Math::ExactlyEquals(this->GetLabelMap()->GetNumberOfLabelObjects(), 0.0))
+  if( m_LabelObjects.empty() )
     {
     m_InverseNumberOfLabelObjects = NumericTraits<float>::max();
     }
   else
     {
-    m_InverseNumberOfLabelObjects = 1.0f/this->GetLabelMap()->GetNumberOfLabelObjects();
+    m_InverseNumberOfLabelObjects = 1.0f / m_LabelObjects.size();
     }
 
   m_NumberOfLabelObjectsProcessed = 0;
@@ -100,6 +134,8 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::AfterThreadedGenerateData()
 {
+  m_LabelObjects.clear();
+  m_LabelObjectBatchEnds.clear();
   this->UpdateProgress(1.0);
 }
 
@@ -108,51 +144,41 @@ void
 LabelMapFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData( const OutputImageRegionType &, ThreadIdType threadId )
 {
+  const SizeValueType numberOfBatches = m_LabelObjectBatchEnds.size();
   while ( true )
     {
-    LabelObjectType *labelObject;
-    // begin mutex lock
-    {
-    MutexLockHolder< FastMutexLock > lock(*m_LabelObjectContainerLock );
-
-    if ( m_LabelObjectIterator.IsAtEnd() )
+    // claim the next batch
+    const SizeValueType batch = m_NextLabelObjectBatch++;
+    if ( batch >= numberOfBatches )
       {
-      // mutex lock holder deleted
       return;
       }
 
-    // get the label object
-    labelObject = m_LabelObjectIterator.GetLabelObject();
-
-    // increment the iterator now, so it will not be invalidated if the object
-    // is destroyed
-    ++m_LabelObjectIterator;
-    ++m_NumberOfLabelObjectsProcessed;
-
-    // unlock the mutex, so the other threads can get an object
-    }
-    // end mutex lock
-
-
-    // and run the user defined method for that object
-    this->ThreadedProcessLabelObject(labelObject);
-
-    if (threadId==0)
+    const SizeValueType begin = ( batch == 0 ) ? 0 : m_LabelObjectBatchEnds[batch - 1];
+    const SizeValueType end = m_LabelObjectBatchEnds[batch];
+    for ( SizeValueType i = begin; i < end; i++ )
       {
-      const float progress = m_InverseNumberOfLabelObjects*m_NumberOfLabelObjectsProcessed;
-      this->UpdateProgress(progress);
+      // run the user defined method for that object. It may destroy the
+      // object, which is not accessed anymore.
+      this->ThreadedProcessLabelObject( m_LabelObjects[i] );
+
+      // all threads needs to check the abort flag
+      if ( this->GetAbortGenerateData() )
+        {
+        std::string    msg;
+        ProcessAborted e(__FILE__, __LINE__);
+        msg += "Object " + std::string(this->GetNameOfClass() ) + ": AbortGenerateDataOn";
+        e.SetDescription(msg);
+        throw e;
+        }
       }
 
-    // all threads needs to check the abort flag
-    if ( this->GetAbortGenerateData() )
+    const SizeValueType numberOfLabelObjectsProcessed = ( m_NumberOfLabelObjectsProcessed += end - begin );
+    if (threadId==0)
       {
-      std::string    msg;
-      ProcessAborted e(__FILE__, __LINE__);
-      msg += "Object " + std::string(this->GetNameOfClass() ) + ": AbortGenerateDataOn";
-      e.SetDescription(msg);
-      throw e;
+      const float progress = m_InverseNumberOfLabelObjects*numberOfLabelObjectsProcessed;
+      this->UpdateProgress(progress);
       }
-
     }
 }
 
@@ -81,6 +81,26 @@ LabelMapToAttributeImageFilter<TInputImage, TOutputImage, TAttributeAccessor>
     const LabelObjectType * labelObject = loit.GetLabelObject();
     const AttributeValueType & attribute = accessor( labelObject );
 
+    // fill the runs of the compact representation of the input when it is
+    // available
+    SizeValueType begin;
+    SizeValueType end;
+    if ( input->GetCompactRuns( labelObject->GetLabel(), begin, end ) )
+      {
+      OutputImagePixelType * buffer = output->GetBufferPointer();
+      for ( SizeValueType run = begin; run < end; ++run )
+        {
+        OutputImagePixelType * pixel = buffer + output->ComputeOffset( input->GetCompactRunIndex( run ) );
+        const SizeValueType length = input->GetCompactRunLength( run );
+        for ( SizeValueType i = 0; i < length; ++i, ++pixel )
+          {
+          *pixel = static_cast<OutputImagePixelType>( attribute );
+          progress.CompletedPixel();
+          }
+        }
+      continue;
+      }
+
     typename LabelObjectType::ConstIndexIterator it( labelObject );
     while( ! it.IsAtEnd() )
       {
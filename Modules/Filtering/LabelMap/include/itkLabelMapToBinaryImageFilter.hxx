@@ -145,11 +145,23 @@ LabelMapToBinaryImageFilter< TInputImage, TOutputImage >
 ::ThreadedProcessLabelObject(LabelObjectType *labelObject)
 {
   OutputImageType *output = this->GetOutput();
-  typename LabelObjectType::ConstIndexIterator it( labelObject );
-  while( ! it.IsAtEnd() )
+
+  // fill the lines one after the other, to avoid the computation of the
+  // offset of each pixel
+  typename OutputImageType::SizeType lineSize;
+  lineSize.Fill( 1 );
+  typename LabelObjectType::ConstLineIterator lit( labelObject );
+  while( ! lit.IsAtEnd() )
     {
-    output->SetPixel( it.GetIndex(), this->m_ForegroundValue );
-    ++it;
+    lineSize[0] = lit.GetLine().GetLength();
+    const typename OutputImageType::RegionType lineRegion( lit.GetLine().GetIndex(), lineSize );
+    ImageRegionIterator< OutputImageType > it( output, lineRegion );
+    while( ! it.IsAtEnd() )
+      {
+      it.Set( this->m_ForegroundValue );
+      ++it;
+      }
+    ++lit;
     }
 }
 
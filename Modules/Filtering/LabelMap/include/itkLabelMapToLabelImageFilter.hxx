@@ -22,6 +22,8 @@
 #include "itkNumericTraits.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIterator.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -54,12 +56,39 @@ LabelMapToLabelImageFilter< TInputImage, TOutputImage >
 ::ThreadedProcessLabelObject(LabelObjectType *labelObject)
 {
   const typename LabelObjectType::LabelType & label = labelObject->GetLabel();
-  typename LabelObjectType::ConstIndexIterator it( labelObject );
 
-  while( !it.IsAtEnd() )
+  // fill the runs of the compact representation of the input when it is
+  // available
+  const InputImageType * input = this->GetInput();
+  SizeValueType begin;
+  SizeValueType end;
+  if ( input->GetCompactRuns( label, begin, end ) )
     {
-    this->m_OutputImage->SetPixel( it.GetIndex(), label );
-    ++it;
+    OutputImagePixelType * buffer = this->m_OutputImage->GetBufferPointer();
+    for ( SizeValueType run = begin; run < end; ++run )
+      {
+      OutputImagePixelType * first = buffer + this->m_OutputImage->ComputeOffset( input->GetCompactRunIndex( run ) );
+      std::fill( first, first + input->GetCompactRunLength( run ), static_cast< OutputImagePixelType >( label ) );
+      }
+    return;
+    }
+
+  // fill the lines one after the other, to avoid the computation of the
+  // offset of each pixel
+  typename OutputImageType::SizeType lineSize;
+  lineSize.Fill( 1 );
+  typename LabelObjectType::ConstLineIterator lit( labelObject );
+  while( !lit.IsAtEnd() )
+    {
+    lineSize[0] = lit.GetLine().GetLength();
+    const typename OutputImageType::RegionType lineRegion( lit.GetLine().GetIndex(), lineSize );
+    ImageRegionIterator< OutputImageType > it( this->m_OutputImage, lineRegion );
+    while( !it.IsAtEnd() )
+      {
+      it.Set( label );
+      ++it;
+      }
+    ++lit;
     }
 }
 
@@ -18,7 +18,7 @@
 #ifndef itkLabelObject_h
 #define itkLabelObject_h
 
-#include <deque>
+#include <vector>
 #include "itkLightObject.h"
 #include "itkLabelObjectLine.h"
 #include "itkWeakPointer.h"
@@ -250,7 +250,7 @@ public:
     }
 
   private:
-    typedef typename std::deque< LineType >            LineContainerType;
+    typedef typename std::vector< LineType >           LineContainerType;
     typedef typename LineContainerType::const_iterator InternalIteratorType;
     InternalIteratorType m_Iterator;
     InternalIteratorType m_Begin;
@@ -345,7 +345,7 @@ public:
 
   private:
 
-    typedef typename std::deque< LineType >            LineContainerType;
+    typedef typename std::vector< LineType >           LineContainerType;
     typedef typename LineContainerType::const_iterator InternalIteratorType;
     void NextValidLine()
     {
@@ -373,7 +373,7 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(LabelObject);
 
-  typedef typename std::deque< LineType >    LineContainerType;
+  typedef typename std::vector< LineType >   LineContainerType;
 
   LineContainerType m_LineContainer;
   LabelType         m_Label;
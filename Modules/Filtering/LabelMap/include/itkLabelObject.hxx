@@ -230,7 +230,7 @@ typename LabelObject< TLabel, VImageDimension >::SizeValueType
 LabelObject< TLabel, VImageDimension >
 ::Size() const
 {
-  int size = 0;
+  SizeValueType size = 0;
 
   for ( typename LineContainerType::const_iterator it = m_LineContainer.begin();
         it != m_LineContainer.end();
@@ -288,6 +288,7 @@ LabelObject< TLabel, VImageDimension >
   itkAssertOrThrowMacro ( ( src != ITK_NULLPTR ), "Null Pointer" );
   // clear original lines and copy lines
   m_LineContainer.clear();
+  m_LineContainer.reserve( src->GetNumberOfLines() );
   for( size_t i = 0; i < src->GetNumberOfLines(); ++i )
     {
     this->AddLine( src->GetLine( static_cast< SizeValueType >( i ) ) );
@@ -330,9 +331,11 @@ LabelObject< TLabel, VImageDimension >
 {
   if ( !m_LineContainer.empty() )
     {
-    // first copy the lines in another container and clear the current one
-    LineContainerType lineContainer = m_LineContainer;
-    m_LineContainer.clear();
+    // first move the lines in another container; the current one keeps
+    // enough memory for the optimized lines
+    LineContainerType lineContainer;
+    lineContainer.swap( m_LineContainer );
+    m_LineContainer.reserve( lineContainer.size() );
 
     // reorder the lines
     typename Functor::LabelObjectLineComparator< LineType > comparator;
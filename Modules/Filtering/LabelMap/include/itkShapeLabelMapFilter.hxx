@@ -111,12 +111,27 @@ ShapeLabelMapFilter< TImage, TLabelImage >
 
   typedef typename LabelObjectType::LengthType  LengthType;
 
-  // Iterate over all the lines
-  typename LabelObjectType::ConstLineIterator lit( labelObject );
-  while( ! lit.IsAtEnd() )
+  // Iterate over all the lines, from the compact representation of the
+  // input when it is available
+  const ImageType * input = this->GetInput();
+  SizeValueType     firstRun = 0;
+  SizeValueType     endRun = 0;
+  const bool        useCompactRuns = input->GetCompactRuns( labelObject->GetLabel(), firstRun, endRun );
+  const SizeValueType numberOfLines = useCompactRuns ? endRun - firstRun : labelObject->GetNumberOfLines();
+  for ( SizeValueType line = 0; line < numberOfLines; ++line )
     {
-    const IndexType & idx = lit.GetLine().GetIndex();
-    LengthType     length = lit.GetLine().GetLength();
+    IndexType  idx;
+    LengthType length;
+    if ( useCompactRuns )
+      {
+      idx = input->GetCompactRunIndex( firstRun + line );
+      length = input->GetCompactRunLength( firstRun + line );
+      }
+    else
+      {
+      idx = labelObject->GetLine( line ).GetIndex();
+      length = labelObject->GetLine( line ).GetLength();
+      }
 
     // Update the nbOfPixels
     nbOfPixels += length;
@@ -266,7 +281,6 @@ ShapeLabelMapFilter< TImage, TLabelImage >
       centralMoments[i][0] += cm;
       centralMoments[0][i] += cm;
       }
-    ++lit;
     }
 
   // final computation
@@ -462,7 +476,7 @@ ShapeLabelMapFilter< TImage, TLabelImage >
 ::ComputePerimeter(LabelObjectType *labelObject)
 {
   // store the lines in a N-1D image of vectors
-  typedef std::deque< typename LabelObjectType::LineType > VectorLineType;
+  typedef std::vector< typename LabelObjectType::LineType > VectorLineType;
   typedef itk::Image< VectorLineType, ImageDimension - 1 > LineImageType;
   typename LineImageType::Pointer lineImage = LineImageType::New();
   typename LineImageType::IndexType lIdx;
@@ -488,17 +502,37 @@ ShapeLabelMapFilter< TImage, TLabelImage >
 
   // std::cout << "lineContainer.size(): " << lineContainer.size() << std::endl;
 
-  // Iterate over all the lines and fill the image of lines
-  typename LabelObjectType::ConstLineIterator lit( labelObject );
-  while( ! lit.IsAtEnd() )
+  // Iterate over all the lines and fill the image of lines, from the compact
+  // representation of the input when it is available
+  const ImageType * input = this->GetInput();
+  SizeValueType     firstRun = 0;
+  SizeValueType     endRun = 0;
+  if ( input->GetCompactRuns( labelObject->GetLabel(), firstRun, endRun ) )
     {
-    const IndexType & idx = lit.GetLine().GetIndex();
-    for( unsigned int i=0; i<ImageDimension-1; i++ )
+    for ( SizeValueType run = firstRun; run < endRun; ++run )
       {
-      lIdx[i] = idx[i+1];
+      const IndexType idx = input->GetCompactRunIndex( run );
+      for( unsigned int i=0; i<ImageDimension-1; i++ )
+        {
+        lIdx[i] = idx[i+1];
+        }
+      lineImage->GetPixel( lIdx ).push_back(
+        typename LabelObjectType::LineType( idx, input->GetCompactRunLength( run ) ) );
+      }
+    }
+  else
+    {
+    typename LabelObjectType::ConstLineIterator lit( labelObject );
+    while( ! lit.IsAtEnd() )
+      {
+      const IndexType & idx = lit.GetLine().GetIndex();
+      for( unsigned int i=0; i<ImageDimension-1; i++ )
+        {
+        lIdx[i] = idx[i+1];
+        }
+      lineImage->GetPixel( lIdx ).push_back( lit.GetLine() );
+      ++lit;
       }
-    lineImage->GetPixel( lIdx ).push_back( lit.GetLine() );
-    ++lit;
     }
 
   // a data structure to store the number of intercepts on each direction
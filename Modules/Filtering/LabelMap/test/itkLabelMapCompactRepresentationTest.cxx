@@ -0,0 +1,278 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkLabelImageToLabelMapFilter.h"
+#include "itkLabelMapToLabelImageFilter.h"
+#include "itkLabelMapToAttributeImageFilter.h"
+#include "itkShapeLabelObject.h"
+#include "itkShapeLabelMapFilter.h"
+#include "itkShapeLabelObjectAccessors.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the compact representation of LabelMap: the run table holds the
+ * lines of the objects sorted by object then index, the label index gives
+ * the same objects as the map, the filters that read it give the same
+ * output as with the lines of the objects, and it is released when the
+ * label map is modified.
+ */
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef unsigned short                                     LabelPixelType;
+typedef itk::Image< LabelPixelType, Dimension >            LabelImageType;
+typedef itk::ShapeLabelObject< LabelPixelType, Dimension > LabelObjectType;
+typedef itk::LabelMap< LabelObjectType >                   LabelMapType;
+typedef itk::Image< float, Dimension >                     AttributeImageType;
+
+// Irregular objects made of blocks with holes, some of them on the border
+// of the image, with labels spaced by the given step.
+LabelImageType::Pointer
+CreateLabelImage( LabelPixelType labelStep )
+{
+  LabelImageType::Pointer image = LabelImageType::New();
+  LabelImageType::SizeType size;
+  size[0] = 41;
+  size[1] = 29;
+  size[2] = 17;
+  LabelImageType::IndexType start;
+  start[0] = -3;
+  start[1] = 2;
+  start[2] = 0;
+  LabelImageType::RegionType region( start, size );
+  image->SetRegions( region );
+  LabelImageType::SpacingType spacing;
+  spacing[0] = 0.5;
+  spacing[1] = 1.0;
+  spacing[2] = 2.0;
+  image->SetSpacing( spacing );
+  image->Allocate();
+
+  unsigned int seed = 3;
+  itk::ImageRegionIteratorWithIndex< LabelImageType > it( image, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const LabelImageType::IndexType idx = it.GetIndex();
+    seed = seed * 1103515245u + 12345u;
+    if( ( seed >> 16 ) % 5 == 0 )
+      {
+      it.Set( 0 );
+      continue;
+      }
+    const LabelPixelType block = static_cast< LabelPixelType >(
+      ( idx[0] + 3 ) / 9 + 5 * ( ( idx[1] - 2 ) / 8 ) + 20 * ( idx[2] / 6 ) );
+    it.Set( static_cast< LabelPixelType >( ( block + 1 ) * labelStep ) );
+    }
+  return image;
+}
+
+LabelMapType::Pointer
+CreateLabelMap( LabelImageType * image )
+{
+  typedef itk::LabelImageToLabelMapFilter< LabelImageType, LabelMapType > ToLabelMapType;
+  ToLabelMapType::Pointer toLabelMap = ToLabelMapType::New();
+  toLabelMap->SetInput( image );
+  toLabelMap->Update();
+  LabelMapType::Pointer labelMap = toLabelMap->GetOutput();
+  labelMap->DisconnectPipeline();
+  labelMap->Optimize();
+  return labelMap;
+}
+
+template< typename TImage >
+bool
+SameImages( const TImage * image1, const TImage * image2 )
+{
+  itk::ImageRegionConstIterator< TImage > it1( image1, image1->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage > it2( image2, image2->GetBufferedRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( itk::Math::NotExactlyEquals( it1.Get(), it2.Get() ) )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+LabelImageType::Pointer
+ToLabelImage( LabelMapType * labelMap )
+{
+  typedef itk::LabelMapToLabelImageFilter< LabelMapType, LabelImageType > ToLabelImageType;
+  ToLabelImageType::Pointer toLabelImage = ToLabelImageType::New();
+  toLabelImage->SetInput( labelMap );
+  toLabelImage->SetNumberOfThreads( 3 );
+  toLabelImage->Update();
+  return toLabelImage->GetOutput();
+}
+
+AttributeImageType::Pointer
+ToAttributeImage( LabelMapType * labelMap )
+{
+  typedef itk::LabelMapToAttributeImageFilter< LabelMapType, AttributeImageType,
+    itk::Functor::PerimeterLabelObjectAccessor< LabelObjectType > > ToAttributeImageType;
+  ToAttributeImageType::Pointer toAttributeImage = ToAttributeImageType::New();
+  toAttributeImage->SetInput( labelMap );
+  toAttributeImage->Update();
+  return toAttributeImage->GetOutput();
+}
+
+LabelMapType::Pointer
+ComputeShape( LabelMapType * labelMap )
+{
+  typedef itk::ShapeLabelMapFilter< LabelMapType > ShapeType;
+  ShapeType::Pointer shape = ShapeType::New();
+  shape->SetInput( labelMap );
+  shape->SetComputePerimeter( true );
+  shape->SetNumberOfThreads( 3 );
+  shape->Update();
+  LabelMapType::Pointer output = shape->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+bool
+SameShapes( const LabelObjectType * object1, const LabelObjectType * object2 )
+{
+  return object1->GetNumberOfPixels() == object2->GetNumberOfPixels()
+    && object1->GetBoundingBox() == object2->GetBoundingBox()
+    && object1->GetCentroid() == object2->GetCentroid()
+    && object1->GetNumberOfPixelsOnBorder() == object2->GetNumberOfPixelsOnBorder()
+    && itk::Math::ExactlyEquals( object1->GetPerimeterOnBorder(), object2->GetPerimeterOnBorder() )
+    && object1->GetPrincipalMoments() == object2->GetPrincipalMoments()
+    && itk::Math::ExactlyEquals( object1->GetElongation(), object2->GetElongation() )
+    && itk::Math::ExactlyEquals( object1->GetPerimeter(), object2->GetPerimeter() );
+}
+}
+
+int itkLabelMapCompactRepresentationTest( int, char *[] )
+{
+  LabelImageType::Pointer image = CreateLabelImage( 1 );
+  LabelMapType::Pointer   labelMap = CreateLabelMap( image );
+  LabelMapType::Pointer   referenceMap = CreateLabelMap( image );
+
+  TEST_EXPECT_TRUE( !labelMap->HasCompactRepresentation() );
+  TEST_EXPECT_TRUE( !labelMap->HasDenseLabelIndex() );
+  itk::SizeValueType begin = 0;
+  itk::SizeValueType end = 0;
+  TEST_EXPECT_TRUE( !labelMap->GetCompactRuns( 1, begin, end ) );
+
+  labelMap->BuildCompactRepresentation();
+  TEST_EXPECT_TRUE( labelMap->HasCompactRepresentation() );
+  TEST_EXPECT_TRUE( labelMap->HasDenseLabelIndex() );
+
+  // The run table holds the lines of each object in the order of the labels.
+  itk::SizeValueType numberOfLines = 0;
+  itk::SizeValueType expectedBegin = 0;
+  for( LabelMapType::ConstIterator it( labelMap ); !it.IsAtEnd(); ++it )
+    {
+    const LabelObjectType * labelObject = it.GetLabelObject();
+    TEST_EXPECT_TRUE( labelMap->GetCompactRuns( it.GetLabel(), begin, end ) );
+    TEST_SET_GET_VALUE( expectedBegin, begin );
+    TEST_SET_GET_VALUE( labelObject->GetNumberOfLines(), end - begin );
+    for( itk::SizeValueType l = 0; l < labelObject->GetNumberOfLines(); ++l )
+      {
+      TEST_SET_GET_VALUE( labelObject->GetLine( l ).GetIndex(), labelMap->GetCompactRunIndex( begin + l ) );
+      TEST_SET_GET_VALUE( labelObject->GetLine( l ).GetLength(), labelMap->GetCompactRunLength( begin + l ) );
+      }
+    TEST_EXPECT_TRUE( labelMap->GetLabelObject( it.GetLabel() ) == labelObject );
+    TEST_EXPECT_TRUE( labelMap->HasLabel( it.GetLabel() ) );
+    numberOfLines += labelObject->GetNumberOfLines();
+    expectedBegin = end;
+    }
+  TEST_SET_GET_VALUE( numberOfLines, labelMap->GetNumberOfCompactRuns() );
+  TEST_EXPECT_TRUE( !labelMap->HasLabel( 1000 ) );
+  TEST_EXPECT_TRUE( !labelMap->GetCompactRuns( 1000, begin, end ) );
+  TRY_EXPECT_EXCEPTION( labelMap->GetLabelObject( 1000 ) );
+
+  // The filters that read the compact representation give the same outputs.
+  TEST_EXPECT_TRUE( SameImages< LabelImageType >( image, ToLabelImage( labelMap ) ) );
+  LabelMapType::Pointer shapeMap = ComputeShape( labelMap );
+  LabelMapType::Pointer referenceShapeMap = ComputeShape( referenceMap );
+  for( LabelMapType::ConstIterator it( referenceShapeMap ); !it.IsAtEnd(); ++it )
+    {
+    if( !SameShapes( it.GetLabelObject(), shapeMap->GetLabelObject( it.GetLabel() ) ) )
+      {
+      std::cerr << "The shape of the object " << it.GetLabel() << " differs." << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  shapeMap->BuildCompactRepresentation();
+  TEST_EXPECT_TRUE( SameImages< AttributeImageType >( ToAttributeImage( referenceShapeMap ),
+                                                      ToAttributeImage( shapeMap ) ) );
+
+  // Lines added out of order are sorted in the run table.
+  LabelMapType::Pointer reversedMap = LabelMapType::New();
+  reversedMap->CopyInformation( labelMap );
+  reversedMap->SetRegions( labelMap->GetLargestPossibleRegion() );
+  for( LabelMapType::ConstIterator it( referenceMap ); !it.IsAtEnd(); ++it )
+    {
+    const LabelObjectType * labelObject = it.GetLabelObject();
+    for( itk::SizeValueType l = labelObject->GetNumberOfLines(); l > 0; --l )
+      {
+      reversedMap->SetLine( labelObject->GetLine( l - 1 ).GetIndex(), labelObject->GetLine( l - 1 ).GetLength(),
+                            it.GetLabel() );
+      }
+    }
+  reversedMap->BuildCompactRepresentation();
+  TEST_SET_GET_VALUE( numberOfLines, reversedMap->GetNumberOfCompactRuns() );
+  TEST_EXPECT_TRUE( reversedMap->GetCompactRuns( 1, begin, end ) );
+  TEST_SET_GET_VALUE( referenceMap->GetLabelObject( 1 )->GetLine( 0 ).GetIndex(),
+                      reversedMap->GetCompactRunIndex( begin ) );
+  TEST_EXPECT_TRUE( SameImages< LabelImageType >( image, ToLabelImage( reversedMap ) ) );
+
+  // Sparse labels are found without the dense index.
+  LabelImageType::Pointer sparseImage = CreateLabelImage( 997 );
+  LabelMapType::Pointer   sparseMap = CreateLabelMap( sparseImage );
+  sparseMap->BuildCompactRepresentation();
+  TEST_EXPECT_TRUE( sparseMap->HasCompactRepresentation() );
+  TEST_EXPECT_TRUE( !sparseMap->HasDenseLabelIndex() );
+  TEST_EXPECT_TRUE( sparseMap->HasLabel( 997 ) );
+  TEST_EXPECT_TRUE( !sparseMap->HasLabel( 998 ) );
+  TEST_EXPECT_TRUE( sparseMap->GetLabelObject( 2 * 997 ) == sparseMap->GetNthLabelObject( 1 ) );
+  TEST_EXPECT_TRUE( SameImages< LabelImageType >( sparseImage, ToLabelImage( sparseMap ) ) );
+
+  // The compact representation is not grafted, and is released when the
+  // label map is modified.
+  LabelMapType::Pointer graftedMap = LabelMapType::New();
+  graftedMap->Graft( labelMap.GetPointer() );
+  TEST_EXPECT_TRUE( !graftedMap->HasCompactRepresentation() );
+
+  LabelObjectType::Pointer removedObject = labelMap->GetLabelObject( 1 );
+  labelMap->RemoveLabel( 1 );
+  TEST_EXPECT_TRUE( !labelMap->HasCompactRepresentation() );
+  TEST_EXPECT_TRUE( !labelMap->HasLabel( 1 ) );
+  labelMap->BuildCompactRepresentation();
+  labelMap->AddLabelObject( removedObject );
+  TEST_EXPECT_TRUE( !labelMap->HasCompactRepresentation() );
+  TEST_EXPECT_TRUE( labelMap->HasLabel( 1 ) );
+  labelMap->BuildCompactRepresentation();
+  LabelImageType::IndexType idx = image->GetLargestPossibleRegion().GetIndex();
+  labelMap->SetPixel( idx, 3 );
+  TEST_EXPECT_TRUE( !labelMap->HasCompactRepresentation() );
+  labelMap->BuildCompactRepresentation();
+  labelMap->ReleaseCompactRepresentation();
+  TEST_EXPECT_TRUE( !labelMap->HasCompactRepresentation() );
+  TEST_SET_GET_VALUE( 0, labelMap->GetNumberOfCompactRuns() );
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,112 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkLabelMap.h"
+#include "itkShapeLabelObject.h"
+#include "itkShapeLabelMapFilter.h"
+#include "itkChangeRegionLabelMapFilter.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Process many label objects of various sizes with several threads: every
+ * object is processed once, with the same results as with a single thread,
+ * and the objects removed while processing are removed from the map.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::ShapeLabelObject< itk::SizeValueType, Dimension > LabelObjectType;
+typedef itk::LabelMap< LabelObjectType >                       LabelMapType;
+
+/** Create a map of objects made of lines of various lengths, in rows of
+ * 10 objects. */
+LabelMapType::Pointer
+CreateLabelMap( itk::SizeValueType numberOfLabelObjects )
+{
+  LabelMapType::Pointer labelMap = LabelMapType::New();
+  LabelMapType::SizeType size;
+  size[0] = 300;
+  size[1] = 2 * ( numberOfLabelObjects / 10 + 1 );
+  labelMap->SetRegions( size );
+  labelMap->Allocate();
+
+  for( itk::SizeValueType label = 1; label <= numberOfLabelObjects; ++label )
+    {
+    LabelMapType::IndexType index;
+    index[0] = ( label % 10 ) * 30;
+    index[1] = 2 * ( label / 10 );
+    labelMap->SetLine( index, 1 + ( label * 7 ) % 29, label );
+    if( label % 3 == 0 )
+      {
+      ++index[1];
+      labelMap->SetLine( index, 1 + ( label * 11 ) % 29, label );
+      }
+    }
+  return labelMap;
+}
+}
+
+int itkLabelMapFilterThreadingTest( int, char *[] )
+{
+  const itk::SizeValueType numberOfLabelObjects = 5000;
+
+  typedef itk::ShapeLabelMapFilter< LabelMapType > ShapeFilterType;
+  std::vector< LabelMapType::Pointer > outputs;
+  for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 7; numberOfThreads += 3 )
+    {
+    ShapeFilterType::Pointer shapeFilter = ShapeFilterType::New();
+    shapeFilter->SetInput( CreateLabelMap( numberOfLabelObjects ) );
+    shapeFilter->SetComputePerimeter( true );
+    shapeFilter->SetNumberOfThreads( numberOfThreads );
+    shapeFilter->Update();
+    outputs.push_back( shapeFilter->GetOutput() );
+    }
+
+  for( itk::SizeValueType label = 1; label <= numberOfLabelObjects; ++label )
+    {
+    const LabelObjectType * expected = outputs[0]->GetLabelObject( label );
+    const itk::SizeValueType expectedNumberOfPixels = 1 + ( label * 7 ) % 29 + ( label % 3 == 0 ? 1 + ( label * 11 ) % 29 : 0 );
+    TEST_EXPECT_EQUAL( expected->GetNumberOfPixels(), expectedNumberOfPixels );
+    for( size_t i = 1; i < outputs.size(); ++i )
+      {
+      const LabelObjectType * labelObject = outputs[i]->GetLabelObject( label );
+      TEST_EXPECT_EQUAL( labelObject->GetNumberOfPixels(), expected->GetNumberOfPixels() );
+      TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( labelObject->GetPerimeter(), expected->GetPerimeter() ) );
+      TEST_EXPECT_EQUAL( labelObject->GetBoundingBox(), expected->GetBoundingBox() );
+      }
+    }
+
+  // the objects outside of the new region are removed by the threads
+  typedef itk::ChangeRegionLabelMapFilter< LabelMapType > ChangeRegionFilterType;
+  ChangeRegionFilterType::Pointer changeRegionFilter = ChangeRegionFilterType::New();
+  changeRegionFilter->SetInput( CreateLabelMap( numberOfLabelObjects ) );
+  LabelMapType::RegionType region;
+  region.SetIndex( 0, 0 );
+  region.SetIndex( 1, 0 );
+  region.SetSize( 0, 300 );
+  region.SetSize( 1, 200 );
+  changeRegionFilter->SetRegion( region );
+  changeRegionFilter->SetNumberOfThreads( 4 );
+  changeRegionFilter->Update();
+  TEST_EXPECT_EQUAL( changeRegionFilter->GetOutput()->GetNumberOfLabelObjects(), 999 );
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
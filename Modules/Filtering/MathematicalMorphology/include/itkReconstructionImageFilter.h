@@ -23,6 +23,7 @@
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
 #include <queue>
+#include <vector>
 
 //#define BASIC
 #define COPY
@@ -43,6 +44,13 @@ namespace itk
  * applications and efficient algorithms" -- IEEE Transactions on
  * Image processing, Vol 2, No 2, pp 176-201, April 1993
  *
+ * The filter is multi-threaded: the image is split in slabs along its
+ * last dimension, and the slabs are reconstructed independently with
+ * the above algorithm, every other slab in parallel.  The values
+ * modified on the boundary of a slab are then propagated in the
+ * neighbor slabs with the FIFO step, until no value changes.  The
+ * result is the same as with a single thread.
+ *
  * \author Richard Beare. Department of Medicine, Monash University,
  * Melbourne, Australia.
  *
@@ -174,6 +182,36 @@ private:
   typedef typename InputImageType::IndexType                InIndexType;
   typedef ConstShapedNeighborhoodIterator< InputImageType > CNInputIterator;
   typedef ShapedNeighborhoodIterator< OutputImageType >     NOutputIterator;
+
+  /** A slab of the image along its last dimension, and the state of its
+   * reconstruction. */
+  struct SlabType
+    {
+    OutputImageRegionType Region;
+    bool                  Processed;
+    bool                  SeedFromPrevious;
+    bool                  SeedFromNext;
+    bool                  FirstRowChanged;
+    bool                  LastRowChanged;
+    bool                  InvalidMarker;
+    };
+  typedef std::vector< SlabType > SlabContainerType;
+
+  struct ThreadStruct
+    {
+    Pointer                 Filter;
+    const MarkerImageType * MarkerImage;
+    const MaskImageType *   MaskImage;
+    SlabContainerType *     Slabs;
+    unsigned int            Parity;
+    };
+
+  /** Reconstruct the slabs of the current parity assigned to a thread. */
+  static ITK_THREAD_RETURN_TYPE ThreaderCallback(void *arg);
+
+  /** Reconstruct a slab, or propagate the modified boundary rows of its
+   * neighbors if it has already been reconstructed. */
+  void ProcessSlab(const MarkerImageType *markerImage, const MaskImageType *maskImage, SlabType & slab);
 }; // end of class
 } // end namespace itk
 
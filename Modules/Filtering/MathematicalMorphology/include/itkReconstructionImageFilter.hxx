@@ -25,6 +25,7 @@
 
 #include "itkConstantPadImageFilter.h"
 #include "itkCropImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 
 namespace itk
 {
@@ -107,13 +108,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
 {
   // Allocate the output
   this->AllocateOutputs();
-  // there are 2 passes that use all pixels and a 3rd that uses some
-  // subset of the pixels. We'll just pretend that the third pass
-  // takes the same as each of the others. Is it OK to update more
-  // often than pixels?
-  ProgressReporter progress(this, 0, this->GetOutput()->GetRequestedRegion().GetNumberOfPixels() * 3);
-
-  TCompare compare;
 
   MarkerImageConstPointer markerImage = this->GetMarkerImage();
   MaskImageConstPointer   maskImage = this->GetMaskImage();
@@ -172,158 +166,318 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     markerImageP = output;
     }
 
-  // declare our queue type
-  typedef typename std::queue< OutputImageIndexType > FifoType;
-  FifoType IndexFifo;
-
-  NOutputIterator   outNIt;
-  InputIteratorType mskIt;
-  CNInputIterator   mskNIt;
-  ISizeType         kernelRadius;
-  kernelRadius.Fill(1);
+  // the region where the reconstruction is computed
+  OutputImageRegionType region;
   if ( m_UseInternalCopy )
     {
+    ISizeType kernelRadius;
+    kernelRadius.Fill(1);
     FaceCalculatorType faceCalculator;
-
-    FaceListType   faceList;
-    FaceListTypeIt fit;
-
-    faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(),
-                              kernelRadius);
+    FaceListType       faceList = faceCalculator(maskImageP, maskImageP->GetLargestPossibleRegion(),
+                                                 kernelRadius);
     // we will only be processing the body region
-    fit = faceList.begin();
-    // must be a better way of doing this
-    NOutputIterator tt(kernelRadius,
-                       markerImageP,
-                       *fit);
-    outNIt = tt;
-
-    InputIteratorType ttt(maskImageP,
-                          *fit);
-    mskIt = ttt;
-    CNInputIterator tttt(kernelRadius,
-                         maskImageP,
-                         *fit);
-    mskNIt = tttt;
+    region = *faceList.begin();
     }
   else
     {
-    NOutputIterator tt( kernelRadius,
-                        markerImageP,
-                        output->GetRequestedRegion() );
-    outNIt = tt;
-
-    InputIteratorType ttt( maskImageP,
-                           output->GetRequestedRegion() );
-    mskIt = ttt;
-    CNInputIterator tttt( kernelRadius,
-                          maskImageP,
-                          output->GetRequestedRegion() );
-    mskNIt = tttt;
+    region = output->GetRequestedRegion();
     }
 
-  setConnectivityPrevious(&outNIt, m_FullyConnected);
-
-  ConstantBoundaryCondition< OutputImageType > oBC;
-  oBC.SetConstant(m_MarkerValue);
-  outNIt.OverrideBoundaryCondition(&oBC);
+  // split the region in slabs along the last dimension. Each slab is
+  // reconstructed independently, the slabs of the same parity in
+  // parallel, and the values propagated across the slab boundaries are
+  // then used as seeds in the neighbor slabs, until no value changes.
+  const SizeValueType numberOfRows = region.GetSize()[OutputImageDimension - 1];
+  SizeValueType       numberOfSlabs = 1;
+  if ( this->GetNumberOfThreads() > 1 )
+    {
+    numberOfSlabs = std::min( static_cast< SizeValueType >( 2 * this->GetNumberOfThreads() ), numberOfRows );
+    }
 
-  mskIt.GoToBegin();
-  // scan in forward raster order
-  for ( outNIt.GoToBegin(), mskIt.GoToBegin(); !outNIt.IsAtEnd(); ++outNIt, ++mskIt )
+  SlabContainerType slabs( numberOfSlabs );
+  for ( SizeValueType s = 0; s < numberOfSlabs; s++ )
     {
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    InputImagePixelType iV = static_cast< OutputImagePixelType >( mskIt.Get() );
+    const SizeValueType firstRow = s * numberOfRows / numberOfSlabs;
+    const SizeValueType endRow = ( s + 1 ) * numberOfRows / numberOfSlabs;
+    slabs[s].Region = region;
+    slabs[s].Region.SetIndex( OutputImageDimension - 1, region.GetIndex()[OutputImageDimension - 1] + firstRow );
+    slabs[s].Region.SetSize( OutputImageDimension - 1, endRow - firstRow );
+    slabs[s].Processed = false;
+    slabs[s].SeedFromPrevious = false;
+    slabs[s].SeedFromNext = false;
+    slabs[s].FirstRowChanged = false;
+    slabs[s].LastRowChanged = false;
+    slabs[s].InvalidMarker = false;
+    }
 
-    // be sure that the pixels in the images follow the preconditions
-    if ( compare(V, iV) )
+  ThreadStruct str;
+  str.Filter = this;
+  str.MarkerImage = markerImageP;
+  str.MaskImage = maskImageP;
+  str.Slabs = &slabs;
+
+  SizeValueType numberOfProcessedSlabs = 0;
+  unsigned int  parity = 0;
+  while ( true )
+    {
+    SizeValueType numberOfPendingSlabs[2] = { 0, 0 };
+    for ( SizeValueType s = 0; s < numberOfSlabs; s++ )
       {
-      if ( compare(0, 1) )
+      if ( !slabs[s].Processed || slabs[s].SeedFromPrevious || slabs[s].SeedFromNext )
         {
-        itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
-        }
-      else
-        {
-        itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
+        ++numberOfPendingSlabs[s % 2];
         }
       }
+    if ( numberOfPendingSlabs[0] + numberOfPendingSlabs[1] == 0 )
+      {
+      break;
+      }
+    if ( numberOfPendingSlabs[parity] == 0 )
+      {
+      parity = 1 - parity;
+      continue;
+      }
+
+    str.Parity = parity;
+    this->GetMultiThreader()->SetNumberOfThreads(
+      std::min( static_cast< SizeValueType >( this->GetNumberOfThreads() ), ( numberOfSlabs + 1 - parity ) / 2 ) );
+    this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+    this->GetMultiThreader()->SingleMethodExecute();
 
-    // visit the previous neighbours
-    typename NOutputIterator::ConstIterator sIt;
-    for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    numberOfProcessedSlabs = 0;
+    for ( SizeValueType s = 0; s < numberOfSlabs; s++ )
       {
-      InputImagePixelType VN = sIt.Get();
-      if ( compare(VN, V) )
+      if ( slabs[s].InvalidMarker )
         {
-        outNIt.SetCenterPixel(VN);
-        V = VN;
+        TCompare compare;
+        if ( compare(0, 1) )
+          {
+          itkExceptionMacro(<< "Marker pixels must be <= mask pixels.");
+          }
+        else
+          {
+          itkExceptionMacro(<< "Marker pixels must be >= mask pixels.");
+          }
+        }
+      // the neighbor slabs must take the modified boundary rows into account
+      if ( slabs[s].FirstRowChanged && s > 0 )
+        {
+        slabs[s - 1].SeedFromNext = true;
+        }
+      if ( slabs[s].LastRowChanged && s + 1 < numberOfSlabs )
+        {
+        slabs[s + 1].SeedFromPrevious = true;
+        }
+      slabs[s].FirstRowChanged = false;
+      slabs[s].LastRowChanged = false;
+      if ( slabs[s].Processed )
+        {
+        ++numberOfProcessedSlabs;
         }
       }
+    this->UpdateProgress( static_cast< float >( numberOfProcessedSlabs ) / numberOfSlabs );
+    parity = 1 - parity;
+    }
 
-    // this step clamps to the mask
-    if ( compare(V, iV) )
-      {
-      outNIt.SetCenterPixel(iV);
-      }
+  if ( m_UseInternalCopy )
+    {
+    typedef typename itk::CropImageFilter< InputImageType, OutputImageType > CropType;
+    typename CropType::Pointer crop = CropType::New();
 
-    progress.CompletedPixel();
+    crop->SetInput(markerImageP);
+    crop->SetUpperBoundaryCropSize(padSize);
+    crop->SetLowerBoundaryCropSize(padSize);
+    crop->GraftOutput( this->GetOutput() );
+    /** execute the minipipeline */
+    crop->Update();
+
+    /** graft the minipipeline output back into this filter's output */
+    this->GraftOutput( crop->GetOutput() );
     }
+}
 
-  // now for the reverse raster order pass
-  // reset the neighborhood
-  setConnectivityLater(&outNIt, m_FullyConnected);
-  outNIt.OverrideBoundaryCondition(&oBC);
-  outNIt.GoToEnd();
-  //mskIt.GoToEnd();
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+ITK_THREAD_RETURN_TYPE
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ThreaderCallback(void *arg)
+{
+  const ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  const ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+  ThreadStruct *str = (ThreadStruct *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  // the slabs of the same parity don't share any pixel or neighbor, so
+  // they can be processed concurrently
+  SlabContainerType & slabs = *str->Slabs;
+  for ( SizeValueType s = str->Parity + 2 * threadId; s < slabs.size(); s += 2 * threadCount )
+    {
+    str->Filter->ProcessSlab(str->MarkerImage, str->MaskImage, slabs[s]);
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< typename TInputImage, typename TOutputImage, typename TCompare >
+void
+ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
+::ProcessSlab(const MarkerImageType *markerImageP, const MaskImageType *maskImageP, SlabType & slab)
+{
+  TCompare compare;
+
+  const OutputImageRegionType & region = slab.Region;
+  const IndexValueType firstRow = region.GetIndex()[OutputImageDimension - 1];
+  const IndexValueType lastRow = firstRow + static_cast< IndexValueType >( region.GetSize()[OutputImageDimension - 1] ) - 1;
+
+  OutputImageRegionType firstRowRegion = region;
+  firstRowRegion.SetSize(OutputImageDimension - 1, 1);
+  OutputImageRegionType lastRowRegion = firstRowRegion;
+  lastRowRegion.SetIndex(OutputImageDimension - 1, lastRow);
+
+  // keep the boundary rows to detect the changes which must be
+  // propagated to the neighbor slabs
+  std::vector< OutputImagePixelType > firstRowValues;
+  std::vector< OutputImagePixelType > lastRowValues;
+  for ( InputIteratorType it( markerImageP, firstRowRegion ); !it.IsAtEnd(); ++it )
+    {
+    firstRowValues.push_back( it.Get() );
+    }
+  for ( InputIteratorType it( markerImageP, lastRowRegion ); !it.IsAtEnd(); ++it )
+    {
+    lastRowValues.push_back( it.Get() );
+    }
 
+  // declare our queue type
+  typedef typename std::queue< OutputImageIndexType > FifoType;
+  FifoType IndexFifo;
+
+  ISizeType kernelRadius;
+  kernelRadius.Fill(1);
+  NOutputIterator outNIt(kernelRadius, markerImageP, region);
+  CNInputIterator mskNIt(kernelRadius, maskImageP, region);
+
+  ConstantBoundaryCondition< OutputImageType > oBC;
+  oBC.SetConstant(m_MarkerValue);
   ConstantBoundaryCondition< InputImageType > iBC;
   iBC.SetConstant(m_MarkerValue);
 
-  setConnectivityLater(&mskNIt, m_FullyConnected);
-  mskNIt.OverrideBoundaryCondition(&iBC);
-
   typename NOutputIterator::IndexListType oIndexList, mIndexList;
   typename NOutputIterator::IndexListType::const_iterator oLIt, mLIt;
 
-  oIndexList = outNIt.GetActiveIndexList();
-  mIndexList = mskNIt.GetActiveIndexList();
-
-  mskNIt.GoToEnd();
-  while ( !outNIt.IsAtBegin() )
+  if ( !slab.Processed )
     {
-    --outNIt;
-    --mskNIt;
-    InputImagePixelType V = outNIt.GetCenterPixel();
-    typename NOutputIterator::ConstIterator sIt;
-    for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+    // the raster and anti-raster passes take the neighbor slabs into
+    // account, so the pending seeds are not needed anymore
+    slab.Processed = true;
+    slab.SeedFromPrevious = false;
+    slab.SeedFromNext = false;
+
+    InputIteratorType mskIt(maskImageP, region);
+
+    setConnectivityPrevious(&outNIt, m_FullyConnected);
+    outNIt.OverrideBoundaryCondition(&oBC);
+
+    // scan in forward raster order
+    for ( outNIt.GoToBegin(), mskIt.GoToBegin(); !outNIt.IsAtEnd(); ++outNIt, ++mskIt )
       {
-      InputImagePixelType VN = sIt.Get();
-      if ( compare(VN, V) )
+      InputImagePixelType V = outNIt.GetCenterPixel();
+      InputImagePixelType iV = static_cast< OutputImagePixelType >( mskIt.Get() );
+
+      // be sure that the pixels in the images follow the preconditions
+      if ( compare(V, iV) )
+        {
+        slab.InvalidMarker = true;
+        return;
+        }
+
+      // visit the previous neighbours
+      typename NOutputIterator::ConstIterator sIt;
+      for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+        {
+        InputImagePixelType VN = sIt.Get();
+        if ( compare(VN, V) )
+          {
+          outNIt.SetCenterPixel(VN);
+          V = VN;
+          }
+        }
+
+      // this step clamps to the mask
+      if ( compare(V, iV) )
         {
-        outNIt.SetCenterPixel(VN);
-        V = VN;
+        outNIt.SetCenterPixel(iV);
         }
       }
-    InputImagePixelType iV = mskNIt.GetCenterPixel();
-    if ( compare(V, iV) )
+
+    // now for the reverse raster order pass
+    // reset the neighborhood
+    setConnectivityLater(&outNIt, m_FullyConnected);
+    outNIt.OverrideBoundaryCondition(&oBC);
+    outNIt.GoToEnd();
+
+    setConnectivityLater(&mskNIt, m_FullyConnected);
+    mskNIt.OverrideBoundaryCondition(&iBC);
+
+    oIndexList = outNIt.GetActiveIndexList();
+    mIndexList = mskNIt.GetActiveIndexList();
+
+    mskNIt.GoToEnd();
+    while ( !outNIt.IsAtBegin() )
       {
-      outNIt.SetCenterPixel(iV);
-      V = iV;
-      }
+      --outNIt;
+      --mskNIt;
+      InputImagePixelType V = outNIt.GetCenterPixel();
+      typename NOutputIterator::ConstIterator sIt;
+      for ( sIt = outNIt.Begin(); !sIt.IsAtEnd(); ++sIt )
+        {
+        InputImagePixelType VN = sIt.Get();
+        if ( compare(VN, V) )
+          {
+          outNIt.SetCenterPixel(VN);
+          V = VN;
+          }
+        }
+      InputImagePixelType iV = mskNIt.GetCenterPixel();
+      if ( compare(V, iV) )
+        {
+        outNIt.SetCenterPixel(iV);
+        V = iV;
+        }
 
-    // now put indexes in the fifo
-    //typename CNInputIterator::ConstIterator mIt;
-    for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin(); oLIt != oIndexList.end(); ++oLIt, ++mLIt )
+      // now put indexes in the fifo
+      for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin(); oLIt != oIndexList.end(); ++oLIt, ++mLIt )
+        {
+        InputImagePixelType VN = outNIt.GetPixel(*oLIt);
+        InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
+        if ( compare(V, VN) && compare(iN, VN) )
+          {
+          IndexFifo.push( outNIt.GetIndex() );
+          break;
+          }
+        }
+      }
+    }
+  else
+    {
+    // propagate the values of the modified boundary rows of the
+    // neighbor slabs
+    OutputImageRegionType seedRegion = firstRowRegion;
+    if ( slab.SeedFromPrevious )
       {
-      InputImagePixelType VN = outNIt.GetPixel(*oLIt);
-      InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
-      if ( compare(V, VN) && compare(iN, VN) )
+      seedRegion.SetIndex(OutputImageDimension - 1, firstRow - 1);
+      for ( ImageRegionConstIteratorWithIndex< OutputImageType > it( markerImageP, seedRegion ); !it.IsAtEnd(); ++it )
         {
-        IndexFifo.push( outNIt.GetIndex() );
-        break;
+        IndexFifo.push( it.GetIndex() );
         }
       }
-    progress.CompletedPixel();
+    if ( slab.SeedFromNext )
+      {
+      seedRegion.SetIndex(OutputImageDimension - 1, lastRow + 1);
+      for ( ImageRegionConstIteratorWithIndex< OutputImageType > it( markerImageP, seedRegion ); !it.IsAtEnd(); ++it )
+        {
+        IndexFifo.push( it.GetIndex() );
+        }
+      }
+    slab.SeedFromPrevious = false;
+    slab.SeedFromNext = false;
     }
 
   // Now we want to check the full neighborhood
@@ -335,9 +489,6 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
   mIndexList = mskNIt.GetActiveIndexList();
   // now process the fifo - this fill the parts that weren't dealt
   // with by the raster and anti-raster passes
-  //typename NOutputIterator::Iterator sIt;
-  typename CNInputIterator::ConstIterator mIt;
-
   while ( !IndexFifo.empty() )
     {
     InputImageIndexType I = IndexFifo.front();
@@ -345,11 +496,21 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
     // reposition the iterators
     outNIt += I - outNIt.GetIndex();
     mskNIt += I - mskNIt.GetIndex();
+    // the neighbors outside of the slab are owned by another slab
+    const bool onSlabBoundary = I[OutputImageDimension - 1] <= firstRow || I[OutputImageDimension - 1] >= lastRow;
     InputImagePixelType V = outNIt.GetCenterPixel();
     for ( oLIt = oIndexList.begin(), mLIt = mIndexList.begin();
           oLIt != oIndexList.end();
           ++oLIt, ++mLIt )
       {
+      if ( onSlabBoundary )
+        {
+        const IndexValueType row = outNIt.GetIndex(*oLIt)[OutputImageDimension - 1];
+        if ( row < firstRow || row > lastRow )
+          {
+          continue;
+          }
+        }
       InputImagePixelType VN = outNIt.GetPixel(*oLIt);
       InputImagePixelType iN = mskNIt.GetPixel(*mLIt);
       // candidate for dilation via flooding
@@ -368,23 +529,25 @@ ReconstructionImageFilter< TInputImage, TOutputImage, TCompare >
         IndexFifo.push( outNIt.GetIndex(*oLIt) );
         }
       }
-    progress.CompletedPixel();
     }
 
-  if ( m_UseInternalCopy )
+  typename std::vector< OutputImagePixelType >::const_iterator vIt = firstRowValues.begin();
+  for ( InputIteratorType it( markerImageP, firstRowRegion ); !it.IsAtEnd(); ++it, ++vIt )
     {
-    typedef typename itk::CropImageFilter< InputImageType, OutputImageType > CropType;
-    typename CropType::Pointer crop = CropType::New();
-
-    crop->SetInput(markerImageP);
-    crop->SetUpperBoundaryCropSize(padSize);
-    crop->SetLowerBoundaryCropSize(padSize);
-    crop->GraftOutput( this->GetOutput() );
-    /** execute the minipipeline */
-    crop->Update();
-
-    /** graft the minipipeline output back into this filter's output */
-    this->GraftOutput( crop->GetOutput() );
+    if ( Math::NotExactlyEquals( it.Get(), *vIt ) )
+      {
+      slab.FirstRowChanged = true;
+      break;
+      }
+    }
+  vIt = lastRowValues.begin();
+  for ( InputIteratorType it( markerImageP, lastRowRegion ); !it.IsAtEnd(); ++it, ++vIt )
+    {
+    if ( Math::NotExactlyEquals( it.Get(), *vIt ) )
+      {
+      slab.LastRowChanged = true;
+      break;
+      }
     }
 }
 
@@ -0,0 +1,190 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkReconstructionByDilationImageFilter.h"
+#include "itkReconstructionByErosionImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Compare the reconstructions computed with several threads to the one
+ * computed with a single thread, on random masks where the values must
+ * be propagated across the slabs processed by the threads.
+ */
+
+namespace
+{
+
+template< typename TImage >
+typename TImage::Pointer
+CreateRandomImage( const typename TImage::SizeType & size, double maximum,
+                   itk::Statistics::MersenneTwisterRandomVariateGenerator * generator )
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions( size );
+  image->Allocate();
+  for( itk::ImageRegionIterator< TImage > it( image, image->GetLargestPossibleRegion() ); !it.IsAtEnd(); ++it )
+    {
+    // mostly high values, with some walls
+    const double value = generator->GetVariate() < 0.3 ? 0.0 : generator->GetUniformVariate( 0.0, maximum );
+    it.Set( static_cast< typename TImage::PixelType >( value ) );
+    }
+  return image;
+}
+
+template< typename TImage >
+typename TImage::Pointer
+CreateMarkerImage( const TImage * mask, typename TImage::PixelType background, double seedProbability,
+                   itk::Statistics::MersenneTwisterRandomVariateGenerator * generator )
+{
+  typename TImage::Pointer marker = TImage::New();
+  marker->SetRegions( mask->GetLargestPossibleRegion() );
+  marker->Allocate();
+  itk::ImageRegionConstIterator< TImage > mIt( mask, mask->GetLargestPossibleRegion() );
+  for( itk::ImageRegionIterator< TImage > it( marker, marker->GetLargestPossibleRegion() ); !it.IsAtEnd(); ++it, ++mIt )
+    {
+    it.Set( generator->GetVariate() < seedProbability ? mIt.Get() : background );
+    }
+  return marker;
+}
+
+template< typename TFilter >
+int
+CompareThreads( const typename TFilter::InputImageType * marker, const typename TFilter::InputImageType * mask )
+{
+  typedef typename TFilter::OutputImageType                                   OutputImageType;
+  typedef typename itk::NumericTraits< typename OutputImageType::PixelType >::PrintType PrintType;
+
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; ++fullyConnected )
+    {
+    for( unsigned int useInternalCopy = 0; useInternalCopy < 2; ++useInternalCopy )
+      {
+      typename OutputImageType::Pointer reference;
+      const itk::ThreadIdType numberOfThreads[] = { 1, 2, 3, 8 };
+      for( unsigned int t = 0; t < 4; ++t )
+        {
+        typename TFilter::Pointer filter = TFilter::New();
+        filter->SetMarkerImage( marker );
+        filter->SetMaskImage( mask );
+        filter->SetFullyConnected( fullyConnected );
+        filter->SetUseInternalCopy( useInternalCopy );
+        filter->SetNumberOfThreads( numberOfThreads[t] );
+        TRY_EXPECT_NO_EXCEPTION( filter->Update() );
+
+        typename OutputImageType::Pointer output = filter->GetOutput();
+        output->DisconnectPipeline();
+        if( t == 0 )
+          {
+          reference = output;
+          continue;
+          }
+
+        itk::ImageRegionConstIterator< OutputImageType > rIt( reference, reference->GetLargestPossibleRegion() );
+        itk::ImageRegionConstIterator< OutputImageType >          oIt( output, output->GetLargestPossibleRegion() );
+        for( ; !rIt.IsAtEnd(); ++rIt, ++oIt )
+          {
+          if( itk::Math::NotExactlyEquals( rIt.Get(), oIt.Get() ) )
+            {
+            std::cerr << "Test failed!" << std::endl;
+            std::cerr << "Error in " << filter->GetNameOfClass() << " with " << numberOfThreads[t]
+                      << " threads, FullyConnected: " << fullyConnected << ", UseInternalCopy: " << useInternalCopy
+                      << " at index " << oIt.GetIndex() << ": "
+                      << static_cast< PrintType >( oIt.Get() ) << " instead of "
+                      << static_cast< PrintType >( rIt.Get() ) << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        }
+      }
+    }
+  return EXIT_SUCCESS;
+}
+
+}
+
+int itkReconstructionImageFilterThreadingTest( int, char *[] )
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  // 2D images of unsigned char, and an image with less rows than slabs
+  typedef itk::Image< unsigned char, 2 > ImageType2D;
+  typedef itk::ReconstructionByDilationImageFilter< ImageType2D, ImageType2D > DilationFilterType2D;
+  typedef itk::ReconstructionByErosionImageFilter< ImageType2D, ImageType2D >  ErosionFilterType2D;
+
+  ImageType2D::SizeType size2D;
+  size2D[0] = 67;
+  size2D[1] = 53;
+  ImageType2D::SizeType thinSize2D;
+  thinSize2D[0] = 101;
+  thinSize2D[1] = 3;
+  const ImageType2D::SizeType sizes2D[] = { size2D, thinSize2D };
+  for( unsigned int s = 0; s < 2; ++s )
+    {
+    ImageType2D::Pointer mask = CreateRandomImage< ImageType2D >( sizes2D[s], 255.0, generator );
+    ImageType2D::Pointer marker = CreateMarkerImage< ImageType2D >( mask, 0, 0.01, generator );
+    if( CompareThreads< DilationFilterType2D >( marker, mask ) == EXIT_FAILURE )
+      {
+      return EXIT_FAILURE;
+      }
+    marker = CreateMarkerImage< ImageType2D >( mask, 255, 0.01, generator );
+    if( CompareThreads< ErosionFilterType2D >( marker, mask ) == EXIT_FAILURE )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // 3D images of float
+  typedef itk::Image< float, 3 > ImageType3D;
+  typedef itk::ReconstructionByDilationImageFilter< ImageType3D, ImageType3D > DilationFilterType3D;
+  typedef itk::ReconstructionByErosionImageFilter< ImageType3D, ImageType3D >  ErosionFilterType3D;
+
+  ImageType3D::SizeType size3D;
+  size3D[0] = 23;
+  size3D[1] = 19;
+  size3D[2] = 31;
+  ImageType3D::Pointer mask3D = CreateRandomImage< ImageType3D >( size3D, 100.0, generator );
+  ImageType3D::Pointer marker3D = CreateMarkerImage< ImageType3D >( mask3D, 0.0f, 0.002, generator );
+  if( CompareThreads< DilationFilterType3D >( marker3D, mask3D ) == EXIT_FAILURE )
+    {
+    return EXIT_FAILURE;
+    }
+  marker3D = CreateMarkerImage< ImageType3D >( mask3D, 100.0f, 0.002, generator );
+  if( CompareThreads< ErosionFilterType3D >( marker3D, mask3D ) == EXIT_FAILURE )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // a marker above the mask must still be detected
+  ImageType2D::Pointer mask = CreateRandomImage< ImageType2D >( size2D, 200.0, generator );
+  ImageType2D::Pointer marker = CreateMarkerImage< ImageType2D >( mask, 0, 0.01, generator );
+  ImageType2D::IndexType index;
+  index[0] = 10;
+  index[1] = 50;
+  marker->SetPixel( index, 255 );
+  DilationFilterType2D::Pointer filter = DilationFilterType2D::New();
+  filter->SetMarkerImage( marker );
+  filter->SetMaskImage( mask );
+  filter->SetNumberOfThreads( 4 );
+  TRY_EXPECT_EXCEPTION( filter->Update() );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -238,6 +238,7 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     SingleFilterPointer singleFilter = SingleFilterType::New();
     singleFilter->SetOperator(oper[0]);
     singleFilter->SetInput(localInput);
+    singleFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
     progress->RegisterInternalFilter(singleFilter, 1.0f / m_FilterDimensionality);
 
     // Graft this filters output onto the mini-pipeline so the mini-pipeline
@@ -264,6 +265,7 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     firstFilter->SetOperator(oper[0]);
     firstFilter->ReleaseDataFlagOn();
     firstFilter->SetInput(localInput);
+    firstFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
     progress->RegisterInternalFilter(firstFilter, 1.0f / numberOfStages);
 
     // Middle filters convolves from real to real
@@ -275,6 +277,7 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
         IntermediateFilterPointer f = IntermediateFilterType::New();
         f->SetOperator(oper[i]);
         f->ReleaseDataFlagOn();
+        f->SetNumberOfThreads( this->GetNumberOfThreads() );
         progress->RegisterInternalFilter(f, 1.0f / numberOfStages);
 
         if ( i == 1 )
@@ -295,6 +298,7 @@ DiscreteGaussianImageFilter< TInputImage, TOutputImage >
     LastFilterPointer lastFilter = LastFilterType::New();
     lastFilter->SetOperator(oper[filterDimensionality - 1]);
     lastFilter->ReleaseDataFlagOn();
+    lastFilter->SetNumberOfThreads( this->GetNumberOfThreads() );
     if ( filterDimensionality > 2 )
       {
       lastFilter->SetInput( intermediateFilters[filterDimensionality - 3]->GetOutput() );
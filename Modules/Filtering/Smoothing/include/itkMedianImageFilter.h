@@ -20,6 +20,7 @@
 
 #include "itkBoxImageFilter.h"
 #include "itkImage.h"
+#include "itkIsSame.h"
 
 namespace itk
 {
@@ -35,6 +36,20 @@ namespace itk
  * This filter requires that the input pixel type provides an operator<()
  * (LessThan Comparable).
  *
+ * Several algorithms are available to compute the median, and by default
+ * the filter picks one from the pixel type and the size of the
+ * neighborhood:
+ *  - SelectionAlgorithm copies every neighborhood and partially sorts it
+ *    with std::nth_element. 3x3 neighborhoods of scalar pixels use a
+ *    fixed sorting network instead. This works for any pixel type.
+ *  - HistogramAlgorithm slides a two level histogram along the first
+ *    dimension of the image, so that only the leaving and entering
+ *    hyperplanes of the neighborhood are updated at each pixel, and
+ *    tracks the median incrementally. It is only available for integer
+ *    pixel types of at most 16 bits stored in an itk::Image, and is much
+ *    faster for large radii.
+ * Both algorithms produce the same output.
+ *
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -64,8 +79,8 @@ public:
   typedef TOutputImage OutputImageType;
 
   /** Standard class typedefs. */
-  typedef MedianImageFilter                                     Self;
-  typedef ImageToImageFilter< InputImageType, OutputImageType > Superclass;
+  typedef MedianImageFilter                                 Self;
+  typedef BoxImageFilter< InputImageType, OutputImageType > Superclass;
   typedef SmartPointer< Self >                                  Pointer;
   typedef SmartPointer< const Self >                            ConstPointer;
 
@@ -84,6 +99,22 @@ public:
 
   typedef typename InputImageType::SizeType InputSizeType;
 
+  /** Algorithm used to compute the median. AutomaticAlgorithm picks the
+   * histogram algorithm when it is available for the input pixel type and
+   * the neighborhood is larger than 3x3x3, and the selection algorithm
+   * otherwise. */
+  typedef enum {
+    AutomaticAlgorithm = 0,
+    SelectionAlgorithm,
+    HistogramAlgorithm
+    } AlgorithmType;
+
+  /** Set/Get the algorithm used to compute the median. When the histogram
+   * algorithm is not available for the input image type, the selection
+   * algorithm is used. Defaults to AutomaticAlgorithm. */
+  itkSetMacro(Algorithm, AlgorithmType);
+  itkGetConstMacro(Algorithm, AlgorithmType);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   // Begin concept checking
   itkConceptMacro( SameDimensionCheck,
@@ -112,8 +143,45 @@ protected:
   void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                             ThreadIdType threadId) ITK_OVERRIDE;
 
+  virtual void PrintSelf(std::ostream & os, Indent indent) const ITK_OVERRIDE;
+
+  /** True when the histogram algorithm can process the input image type:
+   * integer pixels of at most 16 bits in a plain itk::Image. */
+  typedef typename mpl::If<
+    std::numeric_limits< InputPixelType >::is_specialized
+    && std::numeric_limits< InputPixelType >::is_integer
+    && ( sizeof( InputPixelType ) <= 2 )
+    && IsSame< InputImageType, Image< InputPixelType, InputImageDimension > >::Value,
+    mpl::TrueType, mpl::FalseType >::Type HistogramSupportedType;
+
+  /** Compute the median of each neighborhood by copying and partially
+   * sorting it. */
+  void SelectionThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                     ThreadIdType threadId);
+
+  /** Compute the median of each neighborhood with a histogram slid along
+   * the first dimension. */
+  void HistogramThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                     ThreadIdType threadId, mpl::TrueType);
+  void HistogramThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                     ThreadIdType threadId, mpl::FalseType);
+
+  /** Median of nine values with the sorting network of Paeth (Graphics
+   * Gems, 1990): 19 compare-exchanges. The values are reordered. */
+  static InputPixelType MedianOfNine(InputPixelType *p);
+
+  static void SortExchange(InputPixelType & a, InputPixelType & b)
+  {
+    if ( b < a )
+      {
+      std::swap(a, b);
+      }
+  }
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(MedianImageFilter);
+
+  AlgorithmType m_Algorithm;
 };
 } // end namespace itk
 
@@ -25,6 +25,7 @@
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
+#include "itkImageScanlineIterator.h"
 
 #include <vector>
 #include <algorithm>
@@ -33,7 +34,8 @@ namespace itk
 {
 template< typename TInputImage, typename TOutputImage >
 MedianImageFilter< TInputImage, TOutputImage >
-::MedianImageFilter()
+::MedianImageFilter() :
+  m_Algorithm(AutomaticAlgorithm)
 {}
 
 template< typename TInputImage, typename TOutputImage >
@@ -41,6 +43,39 @@ void
 MedianImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
+{
+  bool useHistogram = HistogramSupportedType::Value;
+  if ( m_Algorithm == SelectionAlgorithm )
+    {
+    useHistogram = false;
+    }
+  else if ( m_Algorithm == AutomaticAlgorithm )
+    {
+    // Selecting the median of up to 3x3x3 values is cheaper than
+    // maintaining a histogram of 256 or 65536 bins.
+    SizeValueType neighborhoodSize = 1;
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+      neighborhoodSize *= 2 * this->GetRadius()[d] + 1;
+      }
+    useHistogram = useHistogram && neighborhoodSize > 27;
+    }
+
+  if ( useHistogram )
+    {
+    this->HistogramThreadedGenerateData( outputRegionForThread, threadId, HistogramSupportedType() );
+    }
+  else
+    {
+    this->SelectionThreadedGenerateData( outputRegionForThread, threadId );
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::SelectionThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                ThreadIdType threadId)
 {
   // Allocate output
   typename OutputImageType::Pointer output = this->GetOutput();
@@ -58,6 +93,11 @@ MedianImageFilter< TInputImage, TOutputImage >
   // always a median index (if there where an even number of pixels
   // in the neighborhood we have to average the middle two values).
 
+  // The sorting network is only used with scalar pixels, for which
+  // operator< is a total order and it selects the same value as
+  // std::nth_element.
+  const bool scalarPixel = std::numeric_limits< InputPixelType >::is_specialized;
+
   ZeroFluxNeumannBoundaryCondition< InputImageType > nbc;
   std::vector< InputPixelType >                      pixels;
   // Process each of the boundary faces.  These are N-d regions which border
@@ -73,20 +113,28 @@ MedianImageFilter< TInputImage, TOutputImage >
     bit.GoToBegin();
     const unsigned int neighborhoodSize = bit.Size();
     const unsigned int medianPosition = neighborhoodSize / 2;
+    const bool useSortingNetwork = scalarPixel && neighborhoodSize == 9;
+    pixels.resize(neighborhoodSize);
     while ( !bit.IsAtEnd() )
       {
       // collect all the pixels in the neighborhood, note that we use
       // GetPixel on the NeighborhoodIterator to honor the boundary conditions
-      pixels.resize(neighborhoodSize);
       for ( unsigned int i = 0; i < neighborhoodSize; ++i )
         {
         pixels[i] = ( bit.GetPixel(i) );
         }
 
       // get the median value
-      const typename std::vector< InputPixelType >::iterator medianIterator = pixels.begin() + medianPosition;
-      std::nth_element( pixels.begin(), medianIterator, pixels.end() );
-      it.Set( static_cast< typename OutputImageType::PixelType >( *medianIterator ) );
+      if ( useSortingNetwork )
+        {
+        it.Set( static_cast< typename OutputImageType::PixelType >( MedianOfNine( &pixels[0] ) ) );
+        }
+      else
+        {
+        const typename std::vector< InputPixelType >::iterator medianIterator = pixels.begin() + medianPosition;
+        std::nth_element( pixels.begin(), medianIterator, pixels.end() );
+        it.Set( static_cast< typename OutputImageType::PixelType >( *medianIterator ) );
+        }
 
       ++bit;
       ++it;
@@ -94,6 +142,212 @@ MedianImageFilter< TInputImage, TOutputImage >
       }
     }
 }
+
+template< typename TInputImage, typename TOutputImage >
+typename MedianImageFilter< TInputImage, TOutputImage >::InputPixelType
+MedianImageFilter< TInputImage, TOutputImage >
+::MedianOfNine(InputPixelType *p)
+{
+  SortExchange(p[1], p[2]); SortExchange(p[4], p[5]); SortExchange(p[7], p[8]);
+  SortExchange(p[0], p[1]); SortExchange(p[3], p[4]); SortExchange(p[6], p[7]);
+  SortExchange(p[1], p[2]); SortExchange(p[4], p[5]); SortExchange(p[7], p[8]);
+  SortExchange(p[0], p[3]); SortExchange(p[5], p[8]); SortExchange(p[4], p[7]);
+  SortExchange(p[3], p[6]); SortExchange(p[1], p[4]); SortExchange(p[2], p[5]);
+  SortExchange(p[4], p[7]); SortExchange(p[4], p[2]); SortExchange(p[6], p[4]);
+  SortExchange(p[4], p[2]);
+  return p[4];
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::HistogramThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                ThreadIdType threadId, mpl::FalseType)
+{
+  this->SelectionThreadedGenerateData( outputRegionForThread, threadId );
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::HistogramThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                                ThreadIdType threadId, mpl::TrueType)
+{
+  typedef typename InputImageType::IndexType InputIndexType;
+
+  OutputImageType *      output = this->GetOutput();
+  const InputImageType * input  = this->GetInput();
+
+  const InputSizeType & radius = this->GetRadius();
+
+  // The neighborhood is clamped to the buffered region, which is the same
+  // as the zero flux Neumann boundary condition used by the selection
+  // algorithm.
+  const InputImageRegionType & bufferedRegion = input->GetBufferedRegion();
+  const InputIndexType         bufferStart = bufferedRegion.GetIndex();
+  InputIndexType               bufferEnd;
+  for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+    bufferEnd[d] = bufferStart[d] + static_cast< IndexValueType >( bufferedRegion.GetSize(d) ) - 1;
+    }
+  const OffsetValueType * offsetTable = input->GetOffsetTable();
+  const InputPixelType *  buffer = input->GetBufferPointer();
+
+  // Two level histogram: the coarse bins count the values of 2^shift
+  // consecutive fine bins, so that the median can skip over empty ranges.
+  const unsigned int   numberOfBits = 8 * sizeof( InputPixelType );
+  const unsigned int   coarseShift = numberOfBits / 2;
+  const SizeValueType  numberOfBins = static_cast< SizeValueType >( 1 ) << numberOfBits;
+  const SizeValueType  coarseBinSize = static_cast< SizeValueType >( 1 ) << coarseShift;
+  const long           minimumValue = static_cast< long >( NumericTraits< InputPixelType >::NonpositiveMin() );
+  std::vector< SizeValueType > histogram( numberOfBins, 0 );
+  std::vector< SizeValueType > coarseHistogram( numberOfBins >> coarseShift, 0 );
+
+  // The hyperplane of the neighborhood orthogonal to the first dimension.
+  SizeValueType slabSize = 1;
+  for ( unsigned int d = 1; d < InputImageDimension; ++d )
+    {
+    slabSize *= 2 * radius[d] + 1;
+    }
+  const SizeValueType neighborhoodSize = slabSize * ( 2 * radius[0] + 1 );
+  const SizeValueType medianRank = neighborhoodSize / 2;
+  std::vector< OffsetValueType > slabOffsets( slabSize );
+
+  const IndexValueType lineStart = outputRegionForThread.GetIndex(0);
+  const IndexValueType lineEnd = lineStart + static_cast< IndexValueType >( outputRegionForThread.GetSize(0) );
+  const IndexValueType radius0 = static_cast< IndexValueType >( radius[0] );
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  ImageScanlineIterator< OutputImageType > it( output, outputRegionForThread );
+  while ( !it.IsAtEnd() )
+    {
+    // Offsets of the slab, relative to the beginning of its buffer line.
+    const InputIndexType lineIndex = it.GetIndex();
+    for ( SizeValueType s = 0; s < slabSize; ++s )
+      {
+      OffsetValueType offset = 0;
+      SizeValueType   remainder = s;
+      for ( unsigned int d = 1; d < InputImageDimension; ++d )
+        {
+        const SizeValueType width = 2 * radius[d] + 1;
+        IndexValueType      position = lineIndex[d] - static_cast< IndexValueType >( radius[d] )
+                                       + static_cast< IndexValueType >( remainder % width );
+        remainder /= width;
+        position = std::max( bufferStart[d], std::min( bufferEnd[d], position ) );
+        offset += ( position - bufferStart[d] ) * offsetTable[d];
+        }
+      slabOffsets[s] = offset;
+      }
+
+    // Fill the histogram with the neighborhood of the first pixel of the
+    // line, then find its median from the bottom of the histogram.
+    SizeValueType median = 0;
+    SizeValueType below = 0;
+    for ( IndexValueType x = lineStart - radius0; x <= lineStart + radius0; ++x )
+      {
+      const InputPixelType *column = buffer + ( std::max( bufferStart[0], std::min( bufferEnd[0], x ) ) - bufferStart[0] );
+      for ( SizeValueType s = 0; s < slabSize; ++s )
+        {
+        const SizeValueType bin = static_cast< SizeValueType >( static_cast< long >( column[slabOffsets[s]] ) - minimumValue );
+        ++histogram[bin];
+        ++coarseHistogram[bin >> coarseShift];
+        }
+      }
+
+    for ( IndexValueType x = lineStart; ; )
+      {
+      // Move the median to the bin holding the value of rank medianRank,
+      // that is, the one satisfying
+      // below <= medianRank < below + histogram[median], where below is
+      // the number of values in the lower bins.
+      while ( below > medianRank )
+        {
+        const SizeValueType previousCoarse = ( median >> coarseShift ) - 1;
+        if ( ( median & ( coarseBinSize - 1 ) ) == 0
+             && below - coarseHistogram[previousCoarse] > medianRank )
+          {
+          below -= coarseHistogram[previousCoarse];
+          median -= coarseBinSize;
+          }
+        else
+          {
+          --median;
+          below -= histogram[median];
+          }
+        }
+      while ( below + histogram[median] <= medianRank )
+        {
+        if ( ( median & ( coarseBinSize - 1 ) ) == 0
+             && below + coarseHistogram[median >> coarseShift] <= medianRank )
+          {
+          below += coarseHistogram[median >> coarseShift];
+          median += coarseBinSize;
+          }
+        else
+          {
+          below += histogram[median];
+          ++median;
+          }
+        }
+
+      it.Set( static_cast< OutputPixelType >( static_cast< InputPixelType >( static_cast< long >( median ) + minimumValue ) ) );
+      progress.CompletedPixel();
+      ++it;
+      if ( x + 1 == lineEnd )
+        {
+        break;
+        }
+
+      // Slide the neighborhood by one pixel along the line.
+      const InputPixelType *leaving =
+        buffer + ( std::max( bufferStart[0], std::min( bufferEnd[0], x - radius0 ) ) - bufferStart[0] );
+      const InputPixelType *entering =
+        buffer + ( std::max( bufferStart[0], std::min( bufferEnd[0], x + radius0 + 1 ) ) - bufferStart[0] );
+      for ( SizeValueType s = 0; s < slabSize; ++s )
+        {
+        const SizeValueType leavingBin =
+          static_cast< SizeValueType >( static_cast< long >( leaving[slabOffsets[s]] ) - minimumValue );
+        --histogram[leavingBin];
+        --coarseHistogram[leavingBin >> coarseShift];
+        below -= ( leavingBin < median );
+
+        const SizeValueType enteringBin =
+          static_cast< SizeValueType >( static_cast< long >( entering[slabOffsets[s]] ) - minimumValue );
+        ++histogram[enteringBin];
+        ++coarseHistogram[enteringBin >> coarseShift];
+        below += ( enteringBin < median );
+        }
+      ++x;
+      }
+
+    // Empty the histogram for the next line, without touching all the
+    // bins.
+    const IndexValueType lastX = lineEnd - 1;
+    for ( IndexValueType x = lastX - radius0; x <= lastX + radius0; ++x )
+      {
+      const InputPixelType *column = buffer + ( std::max( bufferStart[0], std::min( bufferEnd[0], x ) ) - bufferStart[0] );
+      for ( SizeValueType s = 0; s < slabSize; ++s )
+        {
+        const SizeValueType bin = static_cast< SizeValueType >( static_cast< long >( column[slabOffsets[s]] ) - minimumValue );
+        --histogram[bin];
+        --coarseHistogram[bin >> coarseShift];
+        }
+      }
+
+    it.NextLine();
+    }
+}
+
+template< typename TInputImage, typename TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "Algorithm: " << static_cast< int >( m_Algorithm ) << std::endl;
+}
 } // end namespace itk
 
 #endif
@@ -0,0 +1,117 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkRandomImageSource.h"
+#include "itkMedianImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTestingMacros.h"
+
+namespace
+{
+// Compare the histogram and selection algorithms of the median filter on a
+// random image, for the given radius.
+template< typename TImage >
+int MedianImageFilterAlgorithmCompare( typename TImage::SizeType & imageSize,
+                                       typename TImage::SizeType & radius,
+                                       typename TImage::PixelType minimum,
+                                       typename TImage::PixelType maximum )
+{
+  typedef itk::RandomImageSource< TImage >       SourceType;
+  typedef itk::MedianImageFilter< TImage, TImage > FilterType;
+
+  typename SourceType::Pointer source = SourceType::New();
+  source->SetSize( imageSize );
+  source->SetMin( minimum );
+  source->SetMax( maximum );
+  source->Update();
+
+  typename FilterType::Pointer selection = FilterType::New();
+  selection->SetInput( source->GetOutput() );
+  selection->SetRadius( radius );
+  selection->SetAlgorithm( FilterType::SelectionAlgorithm );
+  TEST_SET_GET_VALUE( FilterType::SelectionAlgorithm, selection->GetAlgorithm() );
+  selection->Update();
+
+  typename FilterType::Pointer histogram = FilterType::New();
+  histogram->SetInput( source->GetOutput() );
+  histogram->SetRadius( radius );
+  histogram->SetAlgorithm( FilterType::HistogramAlgorithm );
+  TEST_SET_GET_VALUE( FilterType::HistogramAlgorithm, histogram->GetAlgorithm() );
+  histogram->Update();
+
+  itk::ImageRegionConstIterator< TImage > sit( selection->GetOutput(),
+                                               selection->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< TImage > hit( histogram->GetOutput(),
+                                               histogram->GetOutput()->GetBufferedRegion() );
+  for (; !sit.IsAtEnd(); ++sit, ++hit )
+    {
+    if ( sit.Get() != hit.Get() )
+      {
+      std::cerr << "Test failed!" << std::endl;
+      std::cerr << "Radius " << radius << ", at index " << sit.GetIndex() << ": selection median "
+                << static_cast< typename itk::NumericTraits< typename TImage::PixelType >::PrintType >( sit.Get() )
+                << " differs from histogram median "
+                << static_cast< typename itk::NumericTraits< typename TImage::PixelType >::PrintType >( hit.Get() )
+                << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  return EXIT_SUCCESS;
+}
+}
+
+int itkMedianImageFilterAlgorithmTest( int, char* [] )
+{
+  typedef itk::Image< unsigned char, 2 > UCharImageType;
+  typedef itk::Image< short, 3 >         ShortImageType;
+
+  int testStatus = EXIT_SUCCESS;
+
+  UCharImageType::SizeType ucharSize;
+  ucharSize[0] = 37;
+  ucharSize[1] = 29;
+  for ( unsigned int r = 1; r <= 6; ++r )
+    {
+    UCharImageType::SizeType radius;
+    radius[0] = r;
+    radius[1] = ( r + 1 ) / 2;
+    if ( MedianImageFilterAlgorithmCompare< UCharImageType >( ucharSize, radius, 0, 255 ) == EXIT_FAILURE )
+      {
+      testStatus = EXIT_FAILURE;
+      }
+    }
+
+  ShortImageType::SizeType shortSize;
+  shortSize[0] = 19;
+  shortSize[1] = 11;
+  shortSize[2] = 7;
+  for ( unsigned int r = 1; r <= 3; ++r )
+    {
+    ShortImageType::SizeType radius;
+    radius.Fill( r );
+    // A narrow range exercises repeated values, a wide one sparse
+    // histograms.
+    if ( MedianImageFilterAlgorithmCompare< ShortImageType >( shortSize, radius, -3, 4 ) == EXIT_FAILURE
+         || MedianImageFilterAlgorithmCompare< ShortImageType >( shortSize, radius, -32768, 32767 ) == EXIT_FAILURE )
+      {
+      testStatus = EXIT_FAILURE;
+      }
+    }
+
+  return testStatus;
+}
@@ -20,6 +20,7 @@
 
 #include "itkIntTypes.h"
 #include "itkObjectToObjectOptimizerBase.h"
+#include "itkObjectToObjectOptimizerEvaluateCandidatesThreader.h"
 
 namespace itk
 {
@@ -72,6 +73,13 @@ namespace itk
  * the number of steps along each dimension, a side of the region is
  * stepLength*(2*numberOfSteps[d]+1)*scaling[d].
  *
+ * The grid positions are independent, so they can be evaluated concurrently
+ * when copies of the metric are given with SetMetricClones(): the positions
+ * are then evaluated by batches, each thread evaluating its part of a batch
+ * with its own metric.  The IterationEvents are still invoked for every
+ * position in the order of the grid, and the results are identical to those
+ * of the sequential walk.
+ *
  * \ingroup ITKOptimizersv4
  */
 template<typename TInternalComputationValueType>
@@ -103,6 +111,11 @@ public:
   /** Scales type */
   typedef typename Superclass::ScalesType       ScalesType;
 
+  /** Type of the threader evaluating the grid positions concurrently */
+  typedef ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+                                                         EvaluateCandidatesThreaderType;
+  typedef typename EvaluateCandidatesThreaderType::MetricsListType MetricsListType;
+
   virtual void StartOptimization(bool doOnlyInitialization = false) ITK_OVERRIDE;
 
   /** Start optimization */
@@ -137,6 +150,19 @@ public:
     return m_InitialPosition;
   }
 
+  /** Set/Get copies of the metric used to evaluate the grid positions
+   * concurrently, one per thread, up to the number of threads of the
+   * optimizer.  Each copy must be initialized like the metric, with its own
+   * transform, and should use a single thread (e.g. with
+   * ImageToImageMetricv4::SetMaximumNumberOfThreads(1)).  The grid is walked
+   * sequentially with the metric when no copy is given, which is the
+   * default. */
+  void SetMetricClones(const MetricsListType & metrics);
+  const MetricsListType & GetMetricClones() const
+  {
+    return m_MetricClones;
+  }
+
 protected:
   ExhaustiveOptimizerv4();
   virtual ~ExhaustiveOptimizerv4() {}
@@ -147,6 +173,9 @@ protected:
 
   void IncrementIndex(ParametersType & param);
 
+  /** Walk the grid evaluating the positions with the metric clones. */
+  void ResumeWalkingWithMetricClones();
+
 protected:
   ParametersType  m_InitialPosition;
   MeasureType     m_CurrentValue;
@@ -163,6 +192,9 @@ private:
   ITK_DISALLOW_COPY_AND_ASSIGN(ExhaustiveOptimizerv4);
 
   std::ostringstream m_StopConditionDescription;
+
+  MetricsListType                                   m_MetricClones;
+  typename EvaluateCandidatesThreaderType::Pointer  m_EvaluateCandidatesThreader;
 };
 } // end namespace itk
 
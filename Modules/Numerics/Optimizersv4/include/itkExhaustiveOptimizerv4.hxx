@@ -36,6 +36,7 @@ ExhaustiveOptimizerv4<TInternalComputationValueType>
   m_StopConditionDescription("")
 {
   this->m_NumberOfIterations = 0;
+  this->m_EvaluateCandidatesThreader = EvaluateCandidatesThreaderType::New();
 }
 
 template<typename TInternalComputationValueType>
@@ -111,6 +112,12 @@ ExhaustiveOptimizerv4<TInternalComputationValueType>
   itkDebugMacro("ResumeWalk");
   m_Stop = false;
 
+  if ( !m_MetricClones.empty() )
+    {
+    this->ResumeWalkingWithMetricClones();
+    return;
+    }
+
   while ( !m_Stop )
     {
     ParametersType currentPosition = this->GetCurrentPosition();
@@ -150,6 +157,99 @@ ExhaustiveOptimizerv4<TInternalComputationValueType>
     }
 }
 
+template<typename TInternalComputationValueType>
+void
+ExhaustiveOptimizerv4<TInternalComputationValueType>
+::ResumeWalkingWithMetricClones(void)
+{
+  typedef typename EvaluateCandidatesThreaderType::ParametersListType ParametersListType;
+  typedef typename EvaluateCandidatesThreaderType::MeasuresListType   MeasuresListType;
+
+  // The positions are evaluated by batches, so that the positions of a large
+  // grid are not all stored at once.
+  const SizeValueType batchSize = 256 * std::max< SizeValueType >( 1, this->m_NumberOfThreads );
+
+  ParametersListType positions;
+  ParametersListType indices;
+  bool               completed = false;
+
+  while ( !m_Stop )
+    {
+    positions.clear();
+    indices.clear();
+    while ( !completed && positions.size() < batchSize )
+      {
+      positions.push_back( this->GetCurrentPosition() );
+      indices.push_back( m_CurrentIndex );
+      this->AdvanceOneStep();
+      completed = m_Stop;
+      }
+    m_Stop = false;
+
+    ParametersType       nextPosition = this->GetCurrentPosition();
+    const ParametersType nextIndex = m_CurrentIndex;
+    const std::string    completedDescription = m_StopConditionDescription.str();
+
+    m_EvaluateCandidatesThreader->EvaluateCandidates( this, m_MetricClones, positions );
+    const MeasuresListType & values = m_EvaluateCandidatesThreader->GetCandidateValues();
+
+    // Report the positions in the order of the grid, as the sequential walk
+    // does.
+    SizeValueType i = 0;
+    while ( i < positions.size() )
+      {
+      m_CurrentIndex = indices[i];
+      this->m_Metric->SetParameters( positions[i] );
+      if ( m_EvaluateCandidatesThreader->GetCandidateFailed( i ) )
+        {
+        m_EvaluateCandidatesThreader->RethrowFirstException();
+        }
+
+      m_CurrentValue = values[i];
+      if ( m_CurrentValue > m_MaximumMetricValue )
+        {
+        m_MaximumMetricValue = m_CurrentValue;
+        m_MaximumMetricValuePosition = positions[i];
+        }
+      if ( m_CurrentValue < m_MinimumMetricValue )
+        {
+        m_MinimumMetricValue = m_CurrentValue;
+        m_MinimumMetricValuePosition = positions[i];
+        }
+
+      m_StopConditionDescription.str("");
+      m_StopConditionDescription << this->GetNameOfClass() << ": Running. ";
+      m_StopConditionDescription << "@ index " << this->GetCurrentIndex() << " value is " << m_CurrentValue;
+
+      this->InvokeEvent( IterationEvent() );
+      this->m_CurrentIteration++;
+      ++i;
+      if ( m_Stop )
+        {
+        break;
+        }
+      }
+
+    // Move to the position following the last reported one.
+    if ( i < positions.size() )
+      {
+      m_CurrentIndex = indices[i];
+      this->m_Metric->SetParameters( positions[i] );
+      }
+    else
+      {
+      m_CurrentIndex = nextIndex;
+      this->m_Metric->SetParameters( nextPosition );
+      if ( completed )
+        {
+        m_Stop = true;
+        m_StopConditionDescription.str("");
+        m_StopConditionDescription << completedDescription;
+        }
+      }
+    }
+}
+
 template<typename TInternalComputationValueType>
 void
 ExhaustiveOptimizerv4<TInternalComputationValueType>
@@ -235,6 +335,15 @@ ExhaustiveOptimizerv4<TInternalComputationValueType>
   this->Modified();
 }
 
+template<typename TInternalComputationValueType>
+void
+ExhaustiveOptimizerv4<TInternalComputationValueType>
+::SetMetricClones(const MetricsListType & metrics)
+{
+  m_MetricClones = metrics;
+  this->Modified();
+}
+
 template<typename TInternalComputationValueType>
 void
 ExhaustiveOptimizerv4<TInternalComputationValueType>
@@ -252,6 +361,7 @@ ExhaustiveOptimizerv4<TInternalComputationValueType>
   os << indent << "MinimumMetricValue = " << m_MinimumMetricValue << std::endl;
   os << indent << "MinimumMetricValuePosition = " << m_MinimumMetricValuePosition << std::endl;
   os << indent << "MaximumMetricValuePosition = " << m_MaximumMetricValuePosition << std::endl;
+  os << indent << "NumberOfMetricClones = " << m_MetricClones.size() << std::endl;
 }
 } // end namespace itk
 
@@ -20,6 +20,7 @@
 
 #include "itkObjectToObjectOptimizerBase.h"
 #include "itkGradientDescentOptimizerv4.h"
+#include "itkObjectToObjectOptimizerEvaluateCandidatesThreader.h"
 
 namespace itk
 {
@@ -34,6 +35,11 @@ namespace itk
    *   focus modifying the parameter sample space.  This is why we place the burden on the user to provide
    *   the parameter samples over which to optimize.
    *
+   *   When no local optimizer is set, the start points are independent metric evaluations, which are
+   *   performed concurrently if copies of the metric are given with SetMetricClones().  The
+   *   IterationEvents are still invoked for every start point in order, and the results are identical
+   *   to those of the sequential search.
+   *
    * \ingroup ITKOptimizersv4
    */
 template<typename TInternalComputationValueType>
@@ -93,6 +99,11 @@ public:
   typedef typename Superclass::MeasureType          MeasureType;
   typedef std::vector< MeasureType >                MetricValuesListType;
 
+  /** Type of the threader evaluating the start points concurrently */
+  typedef ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+                                                    EvaluateCandidatesThreaderType;
+  typedef typename EvaluateCandidatesThreaderType::MetricsListType MetricsListType;
+
   /** Get stop condition enum */
   itkGetConstReferenceMacro(StopCondition, StopConditionType);
 
@@ -131,6 +142,15 @@ public:
 
   inline ParameterListSizeType GetBestParametersIndex( ) { return this->m_BestParametersIndex; }
 
+  /** Set/Get copies of the metric used to evaluate the start points
+   * concurrently, one per thread, up to the number of threads of the
+   * optimizer.  Each copy must be initialized like the metric, with its own
+   * transform, and should use a single thread (e.g. with
+   * ImageToImageMetricv4::SetMaximumNumberOfThreads(1)).  The copies are not
+   * used when a local optimizer is set. */
+  void SetMetricClones( const MetricsListType & metrics );
+  const MetricsListType & GetMetricClones() const;
+
 protected:
   /** Default constructor */
   MultiStartOptimizerv4Template();
@@ -148,6 +168,9 @@ protected:
   MeasureType                   m_MaximumMetricValue;
   ParameterListSizeType         m_BestParametersIndex;
   OptimizerPointer              m_LocalOptimizer;
+  MetricsListType               m_MetricClones;
+
+  typename EvaluateCandidatesThreaderType::Pointer m_EvaluateCandidatesThreader;
 
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(MultiStartOptimizerv4Template);
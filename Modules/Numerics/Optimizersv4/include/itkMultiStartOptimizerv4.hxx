@@ -37,6 +37,7 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
   this->m_MaximumMetricValue=NumericTraits<MeasureType>::max();
   this->m_MinimumMetricValue = this->m_MaximumMetricValue;
   m_LocalOptimizer = ITK_NULLPTR;
+  m_EvaluateCandidatesThreader = EvaluateCandidatesThreaderType::New();
 }
 
 //-------------------------------------------------------------------
@@ -54,6 +55,7 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
   Superclass::PrintSelf(os, indent);
   os << indent << "Stop condition:"<< this->m_StopCondition << std::endl;
   os << indent << "Stop condition description: " << this->m_StopConditionDescription.str()  << std::endl;
+  os << indent << "Number of metric clones: " << this->m_MetricClones.size() << std::endl;
 }
 
 //-------------------------------------------------------------------
@@ -87,6 +89,25 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
   return this->m_MetricValuesList;
 }
 
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+void
+MultiStartOptimizerv4Template<TInternalComputationValueType>
+::SetMetricClones( const MetricsListType & metrics )
+{
+  this->m_MetricClones = metrics;
+  this->Modified();
+}
+
+//-------------------------------------------------------------------
+template<typename TInternalComputationValueType>
+const typename MultiStartOptimizerv4Template<TInternalComputationValueType>::MetricsListType &
+MultiStartOptimizerv4Template<TInternalComputationValueType>
+::GetMetricClones() const
+{
+  return this->m_MetricClones;
+}
+
 //-------------------------------------------------------------------
 template<typename TInternalComputationValueType>
 typename MultiStartOptimizerv4Template<TInternalComputationValueType>::ParametersType
@@ -177,6 +198,17 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
   this->m_StopConditionDescription << this->GetNameOfClass() << ": ";
   this->InvokeEvent( StartEvent() );
 
+  /* Without local optimizer, the remaining start points are evaluated
+   * concurrently with the metric clones, and reported in order below. */
+  const bool useMetricClones = !this->m_MetricClones.empty() && this->m_LocalOptimizer.IsNull();
+  const SizeValueType firstIteration = this->m_CurrentIteration;
+  if( useMetricClones && this->m_CurrentIteration < this->m_NumberOfIterations )
+    {
+    ParametersListType startPoints( this->m_ParametersList.begin() + this->m_CurrentIteration,
+                                    this->m_ParametersList.begin() + this->m_NumberOfIterations );
+    this->m_EvaluateCandidatesThreader->EvaluateCandidates( this, this->m_MetricClones, startPoints );
+    }
+
   this->m_Stop = false;
   while( ! this->m_Stop )
     {
@@ -184,13 +216,25 @@ MultiStartOptimizerv4Template<TInternalComputationValueType>
     try
       {
       this->m_Metric->SetParameters( this->m_ParametersList[ this->m_CurrentIteration ] );
-      if (  this->m_LocalOptimizer )
+      if( useMetricClones )
+        {
+        const SizeValueType startPoint = this->m_CurrentIteration - firstIteration;
+        if( this->m_EvaluateCandidatesThreader->GetCandidateFailed( startPoint ) )
+          {
+          itkExceptionMacro("The evaluation of start point " << this->m_CurrentIteration << " failed.");
+          }
+        this->m_CurrentMetricValue = this->m_EvaluateCandidatesThreader->GetCandidateValues()[startPoint];
+        }
+      else
         {
-        this->m_LocalOptimizer->SetMetric( this->m_Metric );
-        this->m_LocalOptimizer->StartOptimization();
-        this->m_ParametersList[this->m_CurrentIteration] = this->m_Metric->GetParameters();
+        if (  this->m_LocalOptimizer )
+          {
+          this->m_LocalOptimizer->SetMetric( this->m_Metric );
+          this->m_LocalOptimizer->StartOptimization();
+          this->m_ParametersList[this->m_CurrentIteration] = this->m_Metric->GetParameters();
+          }
+        this->m_CurrentMetricValue = this->m_Metric->GetValue();
         }
-      this->m_CurrentMetricValue = this->m_Metric->GetValue();
       this->m_MetricValuesList.push_back(this->m_CurrentMetricValue);
       }
     catch ( ExceptionObject & )
@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkObjectToObjectOptimizerEvaluateCandidatesThreader_h
+#define itkObjectToObjectOptimizerEvaluateCandidatesThreader_h
+
+#include "itkDomainThreader.h"
+#include "itkThreadedIndexedContainerPartitioner.h"
+#include "itkObjectToObjectOptimizerBase.h"
+
+#include <vector>
+
+namespace itk
+{
+
+/** \class ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate
+ * \brief Evaluate the metric at a list of candidate parameters concurrently,
+ * for optimizers sampling the parameter space such as ExhaustiveOptimizerv4
+ * and MultiStartOptimizerv4.
+ *
+ * Each thread evaluates a contiguous range of candidates with its own copy of
+ * the metric: thread \c i uses the metric \c i of the list given to
+ * EvaluateCandidates(), so at most as many threads as metrics are used.  The
+ * value of each candidate is stored at the index of the candidate, so that the
+ * results do not depend on the number of threads.
+ *
+ * An exception thrown by a metric marks the candidate as failed, and the
+ * evaluation of the other candidates continues.
+ *
+ * \ingroup ITKOptimizersv4
+ */
+template<typename TInternalComputationValueType>
+class ITK_TEMPLATE_EXPORT ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate
+  : public DomainThreader< ThreadedIndexedContainerPartitioner, ObjectToObjectOptimizerBaseTemplate<TInternalComputationValueType> >
+{
+public:
+  /** Standard class typedefs. */
+  typedef ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate                 Self;
+  typedef DomainThreader< ThreadedIndexedContainerPartitioner, ObjectToObjectOptimizerBaseTemplate<TInternalComputationValueType> >
+                                                                                    Superclass;
+  typedef SmartPointer< Self >                                                      Pointer;
+  typedef SmartPointer< const Self >                                                ConstPointer;
+
+  itkTypeMacro( ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate, DomainThreader );
+
+  itkNewMacro( Self );
+
+  typedef typename Superclass::DomainType    DomainType;
+  typedef typename Superclass::AssociateType AssociateType;
+  typedef DomainType                         IndexRangeType;
+
+  typedef typename AssociateType::MetricType          MetricType;
+  typedef typename AssociateType::MetricTypePointer   MetricTypePointer;
+  typedef typename AssociateType::ParametersType      ParametersType;
+  typedef typename AssociateType::MeasureType         MeasureType;
+  typedef std::vector< MetricTypePointer >            MetricsListType;
+  typedef std::vector< ParametersType >               ParametersListType;
+  typedef std::vector< MeasureType >                  MeasuresListType;
+
+  /** Evaluate the metrics at the candidates, using up to the number of
+   * threads of the optimizer and one metric per thread. */
+  void EvaluateCandidates( AssociateType * optimizer, const MetricsListType & metrics,
+                           ParametersListType & candidates );
+
+  /** Get the metric values of the candidates.  The value of a failed
+   * candidate is undefined. */
+  const MeasuresListType & GetCandidateValues() const
+  {
+    return this->m_CandidateValues;
+  }
+
+  /** Get whether the evaluation of a candidate threw an exception. */
+  bool GetCandidateFailed( SizeValueType candidate ) const
+  {
+    return this->m_CandidateFailed[candidate] != 0;
+  }
+
+  /** Throw the exception of the first failed candidate, if any. */
+  void RethrowFirstException() const;
+
+protected:
+  virtual void BeforeThreadedExecution() ITK_OVERRIDE;
+
+  virtual void ThreadedExecution( const IndexRangeType & subrange,
+                                  const ThreadIdType threadId ) ITK_OVERRIDE;
+
+  ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate();
+  virtual ~ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate() {}
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate);
+
+  const MetricsListType *        m_Metrics;
+  ParametersListType *           m_Candidates;
+  MeasuresListType               m_CandidateValues;
+  std::vector< char >            m_CandidateFailed;
+
+  /** First exception thrown in each thread. */
+  std::vector< char >            m_ThreadFailed;
+  std::vector< ExceptionObject > m_ThreadExceptions;
+};
+
+/** This helps to meet backward compatibility */
+typedef ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<double> ObjectToObjectOptimizerEvaluateCandidatesThreader;
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkObjectToObjectOptimizerEvaluateCandidatesThreader.hxx"
+#endif
+
+#endif
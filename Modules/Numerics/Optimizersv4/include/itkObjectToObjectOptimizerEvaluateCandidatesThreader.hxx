@@ -0,0 +1,126 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkObjectToObjectOptimizerEvaluateCandidatesThreader_hxx
+#define itkObjectToObjectOptimizerEvaluateCandidatesThreader_hxx
+
+#include "itkObjectToObjectOptimizerEvaluateCandidatesThreader.h"
+
+namespace itk
+{
+
+template<typename TInternalComputationValueType>
+ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+::ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate() :
+  m_Metrics( ITK_NULLPTR ),
+  m_Candidates( ITK_NULLPTR )
+{
+}
+
+template<typename TInternalComputationValueType>
+void
+ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+::EvaluateCandidates( AssociateType * optimizer, const MetricsListType & metrics,
+                      ParametersListType & candidates )
+{
+  if( metrics.empty() )
+    {
+    itkExceptionMacro( "No metric is available to evaluate the candidates." );
+    }
+
+  const SizeValueType numberOfCandidates = static_cast< SizeValueType >( candidates.size() );
+  this->m_CandidateValues.resize( numberOfCandidates );
+  this->m_CandidateFailed.assign( numberOfCandidates, 0 );
+  this->m_ThreadFailed.clear();
+  this->m_ThreadExceptions.clear();
+  if( numberOfCandidates == 0 )
+    {
+    return;
+    }
+
+  this->m_Metrics = &metrics;
+  this->m_Candidates = &candidates;
+
+  const SizeValueType numberOfThreads = std::max< SizeValueType >( 1,
+    std::min< SizeValueType >( optimizer->GetNumberOfThreads(),
+      std::min< SizeValueType >( metrics.size(), numberOfCandidates ) ) );
+  this->SetMaximumNumberOfThreads( static_cast< ThreadIdType >( numberOfThreads ) );
+
+  IndexRangeType fullRange;
+  fullRange[0] = 0;
+  fullRange[1] = numberOfCandidates - 1;
+  this->Execute( optimizer, fullRange );
+
+  this->m_Metrics = ITK_NULLPTR;
+  this->m_Candidates = ITK_NULLPTR;
+}
+
+template<typename TInternalComputationValueType>
+void
+ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+::BeforeThreadedExecution()
+{
+  const ThreadIdType numberOfThreads = this->GetNumberOfThreadsUsed();
+  this->m_ThreadFailed.assign( numberOfThreads, 0 );
+  this->m_ThreadExceptions.resize( numberOfThreads );
+}
+
+template<typename TInternalComputationValueType>
+void
+ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+::ThreadedExecution( const IndexRangeType & subrange,
+                     const ThreadIdType threadId )
+{
+  MetricType * metric = (*this->m_Metrics)[threadId];
+  for( IndexValueType candidate = subrange[0]; candidate <= subrange[1]; ++candidate )
+    {
+    try
+      {
+      metric->SetParameters( (*this->m_Candidates)[candidate] );
+      this->m_CandidateValues[candidate] = metric->GetValue();
+      }
+    catch( ExceptionObject & exc )
+      {
+      this->m_CandidateFailed[candidate] = 1;
+      if( !this->m_ThreadFailed[threadId] )
+        {
+        this->m_ThreadFailed[threadId] = 1;
+        this->m_ThreadExceptions[threadId] = exc;
+        }
+      }
+    }
+}
+
+template<typename TInternalComputationValueType>
+void
+ObjectToObjectOptimizerEvaluateCandidatesThreaderTemplate<TInternalComputationValueType>
+::RethrowFirstException() const
+{
+  // The threads evaluate increasing ranges of candidates, so the first
+  // failed thread holds the exception of the first failed candidate.
+  for( size_t t = 0; t < this->m_ThreadFailed.size(); ++t )
+    {
+    if( this->m_ThreadFailed[t] )
+      {
+      throw this->m_ThreadExceptions[t];
+      }
+    }
+}
+
+} // end namespace itk
+
+#endif
@@ -27,6 +27,7 @@
 #include "itkOptimizerParameterScalesEstimator.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkRegistrationParameterScalesEstimatorProcessSamplesThreader.h"
 
 namespace itk
 {
@@ -48,6 +49,12 @@ namespace itk
  * The virtual domain point set can be retrieved from a metric using the
  * GetVirtualTransformedPointSet() method within the metric.
  *
+ * The samples of each sampling strategy are kept until the estimator or the
+ * virtual domain of the metric is modified, so switching between the
+ * strategies of EstimateScales() and EstimateStepScale() does not sample the
+ * virtual domain again.  Subclasses process the sample points in parallel
+ * with ProcessSamplesInParallel().
+ *
  * \ingroup ITKOptimizersv4
  */
 template < typename TMetric >
@@ -111,6 +118,9 @@ public:
   /** Type of Jacobian of transform. */
   typedef typename TMetric::JacobianType            JacobianType;
 
+  /** Type of the range of sample indices processed by a thread. */
+  typedef ThreadedIndexedContainerPartitioner::IndexRangeType  IndexRangeType;
+
   /** SetMetric sets the metric used in the estimation process.
    *  The transforms from the metric will be used for estimation, along
    *  with the images when appropriate.
@@ -150,6 +160,17 @@ public:
   /** Set the sampling strategy automatically for step scale estimation. */
   virtual void SetStepScaleSamplingStrategy();
 
+  /** Set/Get the maximum number of threads used to process the sample points.
+   * Defaults to the global default number of threads. */
+  itkSetClampMacro( NumberOfThreads, ThreadIdType, 1, ITK_MAX_THREADS );
+  itkGetConstMacro( NumberOfThreads, ThreadIdType );
+
+  /** Process the sample points of the given range of indices.
+   * This function is used in RegistrationParameterScalesEstimatorProcessSamplesThreader
+   * to process the sample points in parallel.  The default implementation
+   * does nothing. */
+  virtual void ProcessSamplesOverSubRange( const IndexRangeType & subrange, const ThreadIdType threadId );
+
 protected:
   RegistrationParameterScalesEstimator();
   ~RegistrationParameterScalesEstimator(){};
@@ -163,8 +184,9 @@ protected:
   itkSetMacro(NumberOfRandomSamples, SizeValueType);
 
   /** Set the sampling strategy. This is called from SetScalesSamplingStrategy() and
-   *  SetStepScaleSamplingStrategy(). */
-  itkSetMacro(SamplingStrategy, SamplingStrategyType);
+   *  SetStepScaleSamplingStrategy(). The samples are cached per strategy, so
+   *  this does not modify the estimator. */
+  void SetSamplingStrategy( SamplingStrategyType samplingStrategy );
 
   /**
    * Check if the transform is a general affine transform that maps a line
@@ -188,6 +210,11 @@ protected:
   /** Compute the transform Jacobian at a physical point. */
   void ComputeSquaredJacobianNorms( const VirtualPointType  & p, ParametersType & squareNorms);
 
+  /** Call ProcessSamplesOverSubRange() in parallel on contiguous ranges of the
+   * sample points.  Few samples, e.g. the corners of the virtual domain, are
+   * processed in the calling thread. */
+  void ProcessSamplesInParallel();
+
   /** Check if the transform being optimized has local support. */
   bool TransformHasLocalSupportForScalesEstimation();
 
@@ -249,6 +276,9 @@ protected:
   /** Keep track of the last sampling time. */
   mutable TimeStamp             m_SamplingTime;
 
+  /** the maximum number of threads used to process the sample points */
+  ThreadIdType                  m_NumberOfThreads;
+
   /**  the number of samples in the virtual domain */
   SizeValueType                 m_NumberOfRandomSamples;
 
@@ -260,6 +290,9 @@ protected:
   // the threadhold to decide if the number of random samples uses logarithm
   static ITK_CONSTEXPR_VAR SizeValueType    SizeOfSmallDomain = 1000;
 
+  // the minimum number of sample points processed by a thread
+  static ITK_CONSTEXPR_VAR SizeValueType    MinimumNumberOfSamplesPerThread = 64;
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RegistrationParameterScalesEstimator);
 
@@ -272,6 +305,19 @@ private:
   // sampling stategy
   SamplingStrategyType          m_SamplingStrategy;
 
+  // the strategy m_SamplePoints were sampled with
+  SamplingStrategyType          m_SamplePointsStrategy;
+
+  // the samples of the other strategies and their sampling times, indexed
+  // by strategy
+  std::vector< SamplePointContainerType >  m_CachedSamplePoints;
+  std::vector< TimeStamp >                 m_CachedSamplingTimes;
+
+  typename DomainThreader< ThreadedIndexedContainerPartitioner, Self >::Pointer m_ProcessSamplesThreader;
+
+  /** Check that samples taken at the given time are still valid. */
+  bool IsSamplingUpToDate( const TimeStamp & samplingTime ) const;
+
 }; //class RegistrationParameterScalesEstimator
 
 
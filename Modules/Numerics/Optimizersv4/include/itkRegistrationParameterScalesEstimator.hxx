@@ -43,6 +43,15 @@ RegistrationParameterScalesEstimator< TMetric >
   // the default radius of the central region for sampling
   this->m_CentralRegionRadius = 5;
 
+  this->m_NumberOfThreads = MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  this->m_SamplePointsStrategy = FullDomainSampling;
+  this->m_CachedSamplePoints.resize( VirtualDomainPointSetSampling + 1 );
+  this->m_CachedSamplingTimes.resize( VirtualDomainPointSetSampling + 1 );
+
+  typedef RegistrationParameterScalesEstimatorProcessSamplesThreader< TMetric > ProcessSamplesThreaderType;
+  this->m_ProcessSamplesThreader = ProcessSamplesThreaderType::New();
+
   // the metric object must be set before EstimateScales()
 }
 
@@ -322,6 +331,25 @@ RegistrationParameterScalesEstimator< TMetric >
     }
 }
 
+/** Set the sampling strategy without modifying the estimator, since the
+ *  samples are cached per strategy. */
+template< typename TMetric >
+void
+RegistrationParameterScalesEstimator< TMetric >
+::SetSamplingStrategy( SamplingStrategyType samplingStrategy )
+{
+  this->m_SamplingStrategy = samplingStrategy;
+}
+
+/** Check that samples taken at the given time are still valid. */
+template< typename TMetric >
+bool
+RegistrationParameterScalesEstimator< TMetric >
+::IsSamplingUpToDate( const TimeStamp & samplingTime ) const
+{
+  return !(samplingTime < this->GetTimeStamp()) && !(samplingTime < this->m_Metric->GetVirtualDomainTimeStamp());
+}
+
 /** Sample the virtual domain with phyical points
  *  and store the results into this->m_SamplePoints.
  */
@@ -330,7 +358,20 @@ void
 RegistrationParameterScalesEstimator< TMetric >
 ::SampleVirtualDomain()
 {
-  if ( !(this->m_SamplingTime < this->GetTimeStamp()) && !(this->m_SamplingTime < this->m_Metric->GetVirtualDomainTimeStamp()) )
+  if ( this->m_SamplePointsStrategy == this->m_SamplingStrategy && this->IsSamplingUpToDate( this->m_SamplingTime ) )
+    {
+    return;
+    }
+
+  // Keep the samples of the previous strategy, and restore the samples of
+  // the current one.  Swapping also reuses the memory of the containers.
+  this->m_CachedSamplePoints[this->m_SamplePointsStrategy].swap( this->m_SamplePoints );
+  this->m_CachedSamplingTimes[this->m_SamplePointsStrategy] = this->m_SamplingTime;
+  this->m_SamplePoints.swap( this->m_CachedSamplePoints[this->m_SamplingStrategy] );
+  this->m_SamplingTime = this->m_CachedSamplingTimes[this->m_SamplingStrategy];
+  this->m_SamplePointsStrategy = this->m_SamplingStrategy;
+
+  if ( !this->m_SamplePoints.empty() && this->IsSamplingUpToDate( this->m_SamplingTime ) )
     {
     return;
     }
@@ -368,8 +409,45 @@ RegistrationParameterScalesEstimator< TMetric >
     itkExceptionMacro("No sample points were created.");
     }
 
-  this->Modified();
-  this->m_SamplingTime = this->GetTimeStamp();
+  this->m_SamplingTime.Modified();
+}
+
+/** Process the sample points in parallel. */
+template< typename TMetric >
+void
+RegistrationParameterScalesEstimator< TMetric >
+::ProcessSamplesInParallel()
+{
+  const SizeValueType numSamples = static_cast< SizeValueType >( this->m_SamplePoints.size() );
+  if( numSamples == 0 )
+    {
+    return;
+    }
+
+  const SizeValueType minimumNumberOfSamplesPerThread = MinimumNumberOfSamplesPerThread;
+  const SizeValueType numberOfThreads = std::max< SizeValueType >( 1,
+    std::min< SizeValueType >( this->m_NumberOfThreads, numSamples / minimumNumberOfSamplesPerThread ) );
+
+  IndexRangeType fullRange;
+  fullRange[0] = 0;
+  fullRange[1] = numSamples - 1;
+  if( numberOfThreads == 1 )
+    {
+    this->ProcessSamplesOverSubRange( fullRange, 0 );
+    }
+  else
+    {
+    this->m_ProcessSamplesThreader->SetMaximumNumberOfThreads( static_cast< ThreadIdType >( numberOfThreads ) );
+    this->m_ProcessSamplesThreader->Execute( this, fullRange );
+    }
+}
+
+/** The default implementation does nothing. */
+template< typename TMetric >
+void
+RegistrationParameterScalesEstimator< TMetric >
+::ProcessSamplesOverSubRange( const IndexRangeType & itkNotUsed(subrange), const ThreadIdType itkNotUsed(threadId) )
+{
 }
 
 /**
@@ -720,6 +798,7 @@ RegistrationParameterScalesEstimator< TMetric >
 
   os << indent << "m_TransformForward = " << this->m_TransformForward << std::endl;
   os << indent << "m_SamplingStrategy = " << this->m_SamplingStrategy << std::endl;
+  os << indent << "m_NumberOfThreads = " << this->m_NumberOfThreads << std::endl;
 
   os << indent << "m_VirtualDomainPointSet = " << this->m_VirtualDomainPointSet.GetPointer() << std::endl;
 }
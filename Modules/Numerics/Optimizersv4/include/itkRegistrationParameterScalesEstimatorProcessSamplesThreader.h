@@ -0,0 +1,74 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkRegistrationParameterScalesEstimatorProcessSamplesThreader_h
+#define itkRegistrationParameterScalesEstimatorProcessSamplesThreader_h
+
+#include "itkDomainThreader.h"
+#include "itkThreadedIndexedContainerPartitioner.h"
+
+namespace itk
+{
+
+template< typename TMetric >
+class RegistrationParameterScalesEstimator;
+
+/** \class RegistrationParameterScalesEstimatorProcessSamplesThreader
+ * \brief Process the sample points of the virtual domain in parallel for
+ * RegistrationParameterScalesEstimator.
+ *
+ * Each thread processes a contiguous range of sample indices.
+ * \ingroup ITKOptimizersv4
+ */
+template< typename TMetric >
+class ITK_TEMPLATE_EXPORT RegistrationParameterScalesEstimatorProcessSamplesThreader
+  : public DomainThreader< ThreadedIndexedContainerPartitioner, RegistrationParameterScalesEstimator< TMetric > >
+{
+public:
+  /** Standard class typedefs. */
+  typedef RegistrationParameterScalesEstimatorProcessSamplesThreader     Self;
+  typedef DomainThreader< ThreadedIndexedContainerPartitioner, RegistrationParameterScalesEstimator< TMetric > >
+                                                                         Superclass;
+  typedef SmartPointer< Self >                                           Pointer;
+  typedef SmartPointer< const Self >                                     ConstPointer;
+
+  itkTypeMacro( RegistrationParameterScalesEstimatorProcessSamplesThreader, DomainThreader );
+
+  itkNewMacro( Self );
+
+  typedef typename Superclass::DomainType    DomainType;
+  typedef typename Superclass::AssociateType AssociateType;
+  typedef DomainType                         IndexRangeType;
+
+protected:
+  virtual void ThreadedExecution( const IndexRangeType & subrange,
+                                  const ThreadIdType threadId ) ITK_OVERRIDE;
+
+  RegistrationParameterScalesEstimatorProcessSamplesThreader() {}
+  virtual ~RegistrationParameterScalesEstimatorProcessSamplesThreader() {}
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(RegistrationParameterScalesEstimatorProcessSamplesThreader);
+};
+
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkRegistrationParameterScalesEstimatorProcessSamplesThreader.hxx"
+#endif
+
+#endif
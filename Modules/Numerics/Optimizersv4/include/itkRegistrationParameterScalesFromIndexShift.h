@@ -60,6 +60,7 @@ public:
   typedef typename Superclass::FixedTransformType        FixedTransformType;
   typedef typename Superclass::JacobianType              JacobianType;
   typedef typename Superclass::VirtualImageConstPointer  VirtualImageConstPointer;
+  typedef typename Superclass::IndexRangeType            IndexRangeType;
 
   typedef typename TMetric::FixedImageType               FixedImageType;
   typedef typename TMetric::MovingImageType              MovingImageType;
@@ -79,6 +80,9 @@ public:
 
   typedef typename itk::ContinuousIndex< MovingPointValueType, MovingImageType::ImageDimension >         MovingContinuousIndexType;
 
+  /** Map the sample points of the given range with the transform. */
+  virtual void ProcessSamplesOverSubRange( const IndexRangeType & subrange, const ThreadIdType threadId ) ITK_OVERRIDE;
+
 protected:
   RegistrationParameterScalesFromIndexShift();
   ~RegistrationParameterScalesFromIndexShift(){};
@@ -94,7 +98,7 @@ private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RegistrationParameterScalesFromIndexShift);
 
   template <typename TTransform>
-  void ComputeSampleShiftsInternal(const ParametersType &deltaParameters, ScalesType &localShifts);
+  void ProcessSamplesOverSubRangeInternal(const IndexRangeType & subrange);
 
 }; //class RegistrationParameterScalesFromIndexShift
 
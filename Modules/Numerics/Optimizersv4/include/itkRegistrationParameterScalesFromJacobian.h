@@ -35,6 +35,10 @@ namespace itk
  * of the image domain. The sampling by default is a uniform random
  * distribution.
  *
+ * The sample points are processed in parallel.  For a BSplineTransform of
+ * order 3, only the weights of the control points supporting each sample
+ * point are computed instead of the full Jacobian.
+ *
  * \ingroup ITKOptimizersv4
  */
 template < typename TMetric >
@@ -67,6 +71,7 @@ public:
   typedef typename Superclass::FixedTransformType        FixedTransformType;
   typedef typename Superclass::JacobianType              JacobianType;
   typedef typename Superclass::VirtualImageConstPointer  VirtualImageConstPointer;
+  typedef typename Superclass::IndexRangeType            IndexRangeType;
 
   /** Estimate parameter scales. */
   virtual void EstimateScales(ScalesType &scales) ITK_OVERRIDE;
@@ -94,6 +99,10 @@ public:
   virtual void EstimateLocalStepScales(const ParametersType &step,
     ScalesType &localStepScales) ITK_OVERRIDE;
 
+  /** Accumulate the squared Jacobian norms or compute the step scales of
+   * the sample points in the given range. */
+  virtual void ProcessSamplesOverSubRange( const IndexRangeType & subrange, const ThreadIdType threadId ) ITK_OVERRIDE;
+
 protected:
   RegistrationParameterScalesFromJacobian();
   ~RegistrationParameterScalesFromJacobian(){};
@@ -109,6 +118,23 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RegistrationParameterScalesFromJacobian);
 
+  template< typename TTransform >
+  void ProcessSamplesOverSubRangeInternal( const TTransform * transform, const IndexRangeType & subrange,
+                                           const ThreadIdType threadId );
+
+  /** The computation done by ProcessSamplesOverSubRange(). */
+  typedef enum { SquaredJacobianNorms = 0,
+                 SampleStepScales }                     SampleOperationType;
+
+  SampleOperationType            m_SampleOperation;
+
+  /** The sums of the squared Jacobian norms of each thread. */
+  std::vector< ParametersType >  m_ThreadSquaredJacobianNorms;
+
+  /** The step and the step scales of the samples, set in ComputeSampleStepScales(). */
+  const ParametersType *         m_Step;
+  ScalesType *                   m_SampleScales;
+
 }; //class RegistrationParameterScalesFromJacobian
 
 
@@ -19,13 +19,17 @@
 #define itkRegistrationParameterScalesFromJacobian_hxx
 
 #include "itkRegistrationParameterScalesFromJacobian.h"
+#include "itkBSplineBaseTransform.h"
 
 namespace itk
 {
 
 template< typename TMetric >
 RegistrationParameterScalesFromJacobian< TMetric >
-::RegistrationParameterScalesFromJacobian()
+::RegistrationParameterScalesFromJacobian() :
+  m_SampleOperation( SquaredJacobianNorms ),
+  m_Step( ITK_NULLPTR ),
+  m_SampleScales( ITK_NULLPTR )
 {
 }
 
@@ -54,16 +58,15 @@ RegistrationParameterScalesFromJacobian< TMetric >
   norms.Fill( NumericTraits< typename ParametersType::ValueType >::ZeroValue() );
   parameterScales.Fill( NumericTraits< typename ScalesType::ValueType >::OneValue() );
 
-  // checking each sample point
-  for (SizeValueType c=0; c<numSamples; c++)
+  // accumulate the squared norms of each thread, then sum them in order
+  this->m_ThreadSquaredJacobianNorms.assign( this->GetNumberOfThreads(), norms );
+  this->m_SampleOperation = SquaredJacobianNorms;
+  this->ProcessSamplesInParallel();
+  for (ThreadIdType t=0; t<this->m_ThreadSquaredJacobianNorms.size(); t++)
     {
-    const VirtualPointType point = this->m_SamplePoints[c];
-
-    ParametersType squaredNorms(numPara);
-    this->ComputeSquaredJacobianNorms( point, squaredNorms );
-
-    norms = norms + squaredNorms;
-    } //for numSamples
+    norms += this->m_ThreadSquaredJacobianNorms[t];
+    }
+  this->m_ThreadSquaredJacobianNorms.clear();
 
   if (numSamples > 0)
     {
@@ -152,59 +155,135 @@ RegistrationParameterScalesFromJacobian< TMetric >
 ::ComputeSampleStepScales(const ParametersType &step, ScalesType &sampleScales)
 {
   const SizeValueType numSamples = static_cast<const SizeValueType>( this->m_SamplePoints.size() );
+  sampleScales.SetSize(numSamples);
+
+  this->m_Step = &step;
+  this->m_SampleScales = &sampleScales;
+  this->m_SampleOperation = SampleStepScales;
+  this->ProcessSamplesInParallel();
+  this->m_Step = ITK_NULLPTR;
+  this->m_SampleScales = ITK_NULLPTR;
+}
+
+template< typename TMetric >
+void
+RegistrationParameterScalesFromJacobian< TMetric >
+::ProcessSamplesOverSubRange( const IndexRangeType & subrange, const ThreadIdType threadId )
+{
+  if (this->GetTransformForward())
+    {
+    this->ProcessSamplesOverSubRangeInternal( this->m_Metric->GetMovingTransform(), subrange, threadId );
+    }
+  else
+    {
+    this->ProcessSamplesOverSubRangeInternal( this->m_Metric->GetFixedTransform(), subrange, threadId );
+    }
+}
+
+/**
+ *  Process the sample points of a range with Jacobian buffers allocated
+ *  once per thread.  The Jacobian of a B-spline transform is sparse: each
+ *  parameter of the control points supporting a point has the weight of its
+ *  control point in its own dimension, and all other parameters are zero.
+ */
+template< typename TMetric >
+template< typename TTransform >
+void
+RegistrationParameterScalesFromJacobian< TMetric >
+::ProcessSamplesOverSubRangeInternal( const TTransform * transform, const IndexRangeType & subrange,
+                                      const ThreadIdType threadId )
+{
+  typedef BSplineBaseTransform< typename TTransform::ScalarType, TTransform::OutputSpaceDimension, 3 > BSplineTransformType;
+  const BSplineTransformType * bsplineTransform = dynamic_cast< const BSplineTransformType * >( transform );
+
   const SizeValueType dim = this->GetDimension();
   const SizeValueType numPara = this->GetNumberOfLocalParameters();
+  const bool isDisplacementField = this->IsDisplacementFieldTransform();
 
-  sampleScales.SetSize(numSamples);
-
-  itk::Array<FloatType> dTdt(dim);
+  typename BSplineTransformType::WeightsType weights;
+  typename BSplineTransformType::ParameterIndexArrayType indexes;
+  SizeValueType numParaPerDim = 0;
+  if( bsplineTransform )
+    {
+    weights.SetSize( bsplineTransform->GetNumberOfAffectedWeights() );
+    indexes.SetSize( bsplineTransform->GetNumberOfAffectedWeights() );
+    numParaPerDim = bsplineTransform->GetNumberOfParametersPerDimension();
+    }
 
   JacobianType jacobianCache(dim,dim);
-  JacobianType jacobian(dim,
-                        (this->GetTransformForward() ?
-                         this->m_Metric->GetMovingTransform()->GetNumberOfParameters()
-                         : this->m_Metric->GetFixedTransform()->GetNumberOfParameters()));
+  JacobianType jacobian(dim,numPara);
+  itk::Array<FloatType> dTdt(dim);
 
+  ParametersType *squaredNorms = ITK_NULLPTR;
+  if( this->m_SampleOperation == SquaredJacobianNorms )
+    {
+    squaredNorms = &( this->m_ThreadSquaredJacobianNorms[threadId] );
+    }
 
-  // checking each sample point
-  for (SizeValueType c=0; c<numSamples; c++)
+  for (IndexValueType c=subrange[0]; c<=subrange[1]; c++)
     {
     const VirtualPointType &point = this->m_SamplePoints[c];
 
-    if (this->GetTransformForward())
-      {
-      this->m_Metric->GetMovingTransform()->
-        ComputeJacobianWithRespectToParametersCachedTemporaries(point,
-                                                                jacobian,
-                                                                jacobianCache);
-      }
-    else
+    if( bsplineTransform )
       {
-      this->m_Metric->GetFixedTransform()->
-        ComputeJacobianWithRespectToParametersCachedTemporaries(point,
-                                                                jacobian,
-                                                                jacobianCache);
-      }
-
-    if( !this->IsDisplacementFieldTransform() )
-      {
-      dTdt = jacobian * step;
+      bsplineTransform->ComputeJacobianFromBSplineWeightsWithRespectToPosition( point, weights, indexes );
+      if( squaredNorms )
+        {
+        for (SizeValueType k=0; k<weights.Size(); k++)
+          {
+          const FloatType squaredWeight = weights[k] * weights[k];
+          for (SizeValueType d=0; d<dim; d++)
+            {
+            (*squaredNorms)[indexes[k] + d * numParaPerDim] += squaredWeight;
+            }
+          }
+        continue;
+        }
+      for (SizeValueType d=0; d<dim; d++)
+        {
+        dTdt[d] = NumericTraits< FloatType >::ZeroValue();
+        for (SizeValueType k=0; k<weights.Size(); k++)
+          {
+          dTdt[d] += weights[k] * (*this->m_Step)[indexes[k] + d * numParaPerDim];
+          }
+        }
       }
     else
       {
-      SizeValueType offset = this->m_Metric->ComputeParameterOffsetFromVirtualPoint(point, numPara);
+      transform->ComputeJacobianWithRespectToParametersCachedTemporaries(point, jacobian, jacobianCache);
+      if( squaredNorms )
+        {
+        for (SizeValueType p=0; p<numPara; p++)
+          {
+          FloatType squaredNorm = NumericTraits< FloatType >::ZeroValue();
+          for (SizeValueType d=0; d<dim; d++)
+            {
+            squaredNorm += jacobian[d][p] * jacobian[d][p];
+            }
+          (*squaredNorms)[p] += squaredNorm;
+          }
+        continue;
+        }
 
-      ParametersType localStep(numPara);
-      for (SizeValueType p=0; p<numPara; p++)
+      // the step of a displacement field transform is restricted to the
+      // local parameters of the point
+      SizeValueType offset = 0;
+      if( isDisplacementField )
         {
-        localStep[p] = step[offset + p];
+        offset = this->m_Metric->ComputeParameterOffsetFromVirtualPoint(point, numPara);
+        }
+      for (SizeValueType d=0; d<dim; d++)
+        {
+        dTdt[d] = NumericTraits< FloatType >::ZeroValue();
+        for (SizeValueType p=0; p<jacobian.cols(); p++)
+          {
+          dTdt[d] += jacobian[d][p] * (*this->m_Step)[offset + p];
+          }
         }
-      dTdt = jacobian * localStep;
       }
 
-    sampleScales[c] = dTdt.two_norm();
+    (*this->m_SampleScales)[c] = dTdt.two_norm();
     }
-
 }
 
 /** Print the information about this class */
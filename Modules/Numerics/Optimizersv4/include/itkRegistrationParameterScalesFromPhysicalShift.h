@@ -60,6 +60,10 @@ public:
   typedef typename Superclass::FixedTransformType        FixedTransformType;
   typedef typename Superclass::JacobianType              JacobianType;
   typedef typename Superclass::VirtualImageConstPointer  VirtualImageConstPointer;
+  typedef typename Superclass::IndexRangeType            IndexRangeType;
+
+  /** Map the sample points of the given range with the transform. */
+  virtual void ProcessSamplesOverSubRange( const IndexRangeType & subrange, const ThreadIdType threadId ) ITK_OVERRIDE;
 
 protected:
   RegistrationParameterScalesFromPhysicalShift();
@@ -73,7 +77,7 @@ private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RegistrationParameterScalesFromPhysicalShift);
 
   template <typename TTransform>
-  void ComputeSampleShiftsInternal(const ParametersType &deltaParameters, ScalesType &localShifts);
+  void ProcessSamplesOverSubRangeInternal(const IndexRangeType & subrange);
 
 }; //class RegistrationParameterScalesFromPhysicalShift
 
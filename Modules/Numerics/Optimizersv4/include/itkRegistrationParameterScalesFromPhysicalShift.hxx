@@ -33,14 +33,22 @@ template< typename TMetric >
 void
 RegistrationParameterScalesFromPhysicalShift< TMetric >
 ::ComputeSampleShifts(const ParametersType &deltaParameters, ScalesType &sampleShifts)
+{
+  this->ComputeSampleShiftsInParallel(deltaParameters, sampleShifts);
+}
+
+template< typename TMetric >
+void
+RegistrationParameterScalesFromPhysicalShift< TMetric >
+::ProcessSamplesOverSubRange(const IndexRangeType & subrange, const ThreadIdType itkNotUsed(threadId))
 {
   if (this->GetTransformForward())
     {
-    this->ComputeSampleShiftsInternal<MovingTransformType>(deltaParameters, sampleShifts);
+    this->ProcessSamplesOverSubRangeInternal<MovingTransformType>(subrange);
     }
   else
     {
-    this->ComputeSampleShiftsInternal<FixedTransformType>(deltaParameters, sampleShifts);
+    this->ProcessSamplesOverSubRangeInternal<FixedTransformType>(subrange);
     }
 }
 
@@ -48,46 +56,36 @@ template< typename TMetric >
 template< typename TTransform >
 void
 RegistrationParameterScalesFromPhysicalShift< TMetric >
-::ComputeSampleShiftsInternal(const ParametersType &deltaParameters, ScalesType &sampleShifts)
+::ProcessSamplesOverSubRangeInternal(const IndexRangeType & subrange)
 {
   typedef typename TTransform::OutputPointType TransformOutputType;
+  const SizeValueType dim = TransformOutputType::PointDimension;
 
-  // We save the old parameters and apply the delta parameters to calculate the
-  // voxel shift. After it is done, we will reset to the old parameters.
-  TransformBaseTemplate<typename TMetric::MeasureType> *transform = const_cast<TransformBaseTemplate<typename TMetric::MeasureType> *>(this->GetTransform());
-  const ParametersType oldParameters = transform->GetParameters();
-
-  const SizeValueType numSamples = static_cast<const SizeValueType>( this->m_SamplePoints.size() );
-
-  VirtualPointType point;
   TransformOutputType newMappedVoxel;
+  TransformOutputType oldMappedVoxel;
 
-  // store the old mapped indices to reduce calls to Transform::SetParameters()
-  std::vector<TransformOutputType> oldMappedVoxels(numSamples);
-  sampleShifts.SetSize(numSamples);
-
-  // compute the indices mapped by the old transform
-  for (SizeValueType c=0; c<numSamples; c++)
+  for (IndexValueType c=subrange[0]; c<=subrange[1]; c++)
     {
-    point = this->m_SamplePoints[c];
-    this->template TransformPoint<TransformOutputType>(point, oldMappedVoxels[c]);
+    this->template TransformPoint<TransformOutputType>(this->m_SamplePoints[c], newMappedVoxel);
+    FloatType *oldCoordinates = &( this->m_MappedSampleCoordinates[c * dim] );
+
+    if (this->m_SampleOperation == Superclass::StoreMappedSamplePoints)
+      {
+      for (SizeValueType d=0; d<dim; d++)
+        {
+        oldCoordinates[d] = newMappedVoxel[d];
+        }
+      }
+    else
+      {
+      for (SizeValueType d=0; d<dim; d++)
+        {
+        oldMappedVoxel[d] = oldCoordinates[d];
+        }
+      // find the local shift for each sample point
+      (*this->m_SampleShifts)[c] = newMappedVoxel.EuclideanDistanceTo(oldMappedVoxel);
+      }
     }
-
-  // Apply the delta parameters to the transform
-  this->UpdateTransformParameters(deltaParameters);
-
-  // compute the indices mapped by the new transform
-  for (SizeValueType c=0; c<numSamples; c++)
-    {
-    point = this->m_SamplePoints[c];
-    this->template TransformPoint<TransformOutputType>(point, newMappedVoxel);
-
-    // find the local shift for each sample point
-    sampleShifts[c] = newMappedVoxel.EuclideanDistanceTo(oldMappedVoxels[c]);
-  }
-
-  // restore the parameters in the transform
-  transform->SetParameters(oldParameters);
 }
 
 /** Print the information about this class */
@@ -36,6 +36,10 @@ namespace itk
  * differently depending on the type of metric transform or metric type.
  * See RegistrationParameterScalesEstimator documentation.
  *
+ * Derived classes map the sample points in parallel in
+ * ProcessSamplesOverSubRange(), once before and once after the variation of
+ * the parameters.
+ *
  * \sa RegistrationParameterScalesEstimator
  * \ingroup ITKOptimizersv4
  */
@@ -67,6 +71,7 @@ public:
   typedef typename Superclass::FixedTransformType        FixedTransformType;
   typedef typename Superclass::JacobianType              JacobianType;
   typedef typename Superclass::VirtualImageConstPointer  VirtualImageConstPointer;
+  typedef typename Superclass::IndexRangeType            IndexRangeType;
 
   /** Estimate parameter scales */
   virtual void EstimateScales(ScalesType &scales) ITK_OVERRIDE;
@@ -96,6 +101,25 @@ protected:
    */
   virtual void ComputeSampleShifts(const ParametersType &deltaParameters, ScalesType &localShifts) = 0;
 
+  /** Compute the sample shifts by processing the sample points in parallel
+   * with ProcessSamplesOverSubRange(), once to store the points mapped by the
+   * current transform and once to compute their shifts after applying
+   * deltaParameters.  The transform parameters are restored afterwards. */
+  void ComputeSampleShiftsInParallel(const ParametersType &deltaParameters, ScalesType &localShifts);
+
+  /** The computation done by ProcessSamplesOverSubRange(). */
+  typedef enum { StoreMappedSamplePoints = 0,
+                 ComputeShiftsFromMappedSamplePoints }  SampleOperationType;
+
+  SampleOperationType       m_SampleOperation;
+
+  /** The coordinates of the sample points mapped by the transform before
+   * the parameter variation, stored contiguously per sample. */
+  std::vector< FloatType >  m_MappedSampleCoordinates;
+
+  /** The shifts of the sample points, set in ComputeSampleShiftsInParallel(). */
+  ScalesType *              m_SampleShifts;
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(RegistrationParameterScalesFromShiftBase);
 
@@ -25,7 +25,9 @@ namespace itk
 
 template< typename TMetric >
 RegistrationParameterScalesFromShiftBase< TMetric >
-::RegistrationParameterScalesFromShiftBase()
+::RegistrationParameterScalesFromShiftBase() :
+  m_SampleOperation( StoreMappedSamplePoints ),
+  m_SampleShifts( ITK_NULLPTR )
 {
   this->m_SmallParameterVariation = 0.01;
 }
@@ -221,6 +223,43 @@ RegistrationParameterScalesFromShiftBase< TMetric >
   return maxShift;
 }
 
+/**
+ * Compute the sample shifts with the sample points mapped in parallel.
+ */
+template< typename TMetric >
+void
+RegistrationParameterScalesFromShiftBase< TMetric >
+::ComputeSampleShiftsInParallel(const ParametersType &deltaParameters, ScalesType &sampleShifts)
+{
+  // We save the old parameters and apply the delta parameters to calculate the
+  // voxel shift. After it is done, we will reset to the old parameters.
+  TransformBaseTemplate<typename TMetric::MeasureType> *transform = const_cast<TransformBaseTemplate<typename TMetric::MeasureType> *>(this->GetTransform());
+  const ParametersType oldParameters = transform->GetParameters();
+
+  const SizeValueType numSamples = static_cast<const SizeValueType>( this->m_SamplePoints.size() );
+
+  // store the old mapped points to reduce calls to Transform::SetParameters()
+  this->m_MappedSampleCoordinates.resize( numSamples * this->GetDimension() );
+  sampleShifts.SetSize(numSamples);
+  this->m_SampleShifts = &sampleShifts;
+
+  // compute the points mapped by the old transform
+  this->m_SampleOperation = StoreMappedSamplePoints;
+  this->ProcessSamplesInParallel();
+
+  // Apply the delta parameters to the transform
+  this->UpdateTransformParameters(deltaParameters);
+
+  // compute the points mapped by the new transform and their shifts
+  this->m_SampleOperation = ComputeShiftsFromMappedSamplePoints;
+  this->ProcessSamplesInParallel();
+
+  // restore the parameters in the transform
+  transform->SetParameters(oldParameters);
+
+  this->m_SampleShifts = ITK_NULLPTR;
+}
+
 /** Print the information about this class */
 template< typename TMetric >
 void
@@ -0,0 +1,362 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkCommand.h"
+#include "itkExhaustiveOptimizerv4.h"
+#include "itkMultiStartOptimizerv4.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the concurrent evaluation of the grid positions of
+ * ExhaustiveOptimizerv4 and of the start points of MultiStartOptimizerv4 with
+ * metric clones: the reported iterations and the results are identical to
+ * those of the sequential evaluation.
+ */
+
+namespace
+{
+
+/** Quadratic metric of three parameters, throwing an exception when the
+ * first parameter equals the failing value. */
+class MetricClonesTestMetric : public itk::ObjectToObjectMetricBase
+{
+public:
+  typedef MetricClonesTestMetric          Self;
+  typedef itk::ObjectToObjectMetricBase   Superclass;
+  typedef itk::SmartPointer<Self>         Pointer;
+  typedef itk::SmartPointer<const Self>   ConstPointer;
+  itkNewMacro( Self );
+
+  enum { SpaceDimension = 3 };
+
+  MetricClonesTestMetric() :
+    m_Parameters( SpaceDimension ),
+    m_FailingValue( 1000.0 )
+  {
+    m_Parameters.Fill( 0.0 );
+  }
+
+  virtual MeasureType GetValue() const ITK_OVERRIDE
+  {
+    const double x = m_Parameters[0];
+    const double y = m_Parameters[1];
+    const double z = m_Parameters[2];
+    if( itk::Math::ExactlyEquals( x, m_FailingValue ) )
+      {
+      itkExceptionMacro( "Failing value" );
+      }
+    return 0.5 * ( 3 * x * x + 4 * x * y + 6 * y * y + z * z ) - 2 * x + 8 * y + 0.1 * z;
+  }
+
+  virtual void GetDerivative( DerivativeType & derivative ) const ITK_OVERRIDE
+  {
+    derivative.SetSize( SpaceDimension );
+    derivative.Fill( 0.0 );
+  }
+
+  virtual void GetValueAndDerivative( MeasureType & value, DerivativeType & derivative ) const ITK_OVERRIDE
+  {
+    value = this->GetValue();
+    this->GetDerivative( derivative );
+  }
+
+  virtual void Initialize() throw ( itk::ExceptionObject ) ITK_OVERRIDE {}
+
+  virtual unsigned int GetNumberOfLocalParameters() const ITK_OVERRIDE
+  {
+    return SpaceDimension;
+  }
+
+  virtual unsigned int GetNumberOfParameters() const ITK_OVERRIDE
+  {
+    return SpaceDimension;
+  }
+
+  virtual void SetParameters( ParametersType & parameters ) ITK_OVERRIDE
+  {
+    m_Parameters = parameters;
+  }
+
+  virtual const ParametersType & GetParameters() const ITK_OVERRIDE
+  {
+    return m_Parameters;
+  }
+
+  virtual bool HasLocalSupport() const ITK_OVERRIDE
+  {
+    return false;
+  }
+
+  virtual void UpdateTransformParameters( const DerivativeType &, ParametersValueType ) ITK_OVERRIDE {}
+
+  void SetFailingValue( double value )
+  {
+    m_FailingValue = value;
+  }
+
+private:
+  ParametersType m_Parameters;
+  double         m_FailingValue;
+};
+
+typedef itk::ExhaustiveOptimizerv4<double>      ExhaustiveOptimizerType;
+typedef itk::MultiStartOptimizerv4              MultiStartOptimizerType;
+typedef ExhaustiveOptimizerType::MetricsListType MetricsListType;
+typedef MetricClonesTestMetric::ParametersType   ParametersType;
+
+/** Record the index, position and value of every iteration, and stop the
+ * optimizer at the given iteration. */
+class IterationRecorder : public itk::Command
+{
+public:
+  typedef IterationRecorder          Self;
+  typedef itk::Command               Superclass;
+  typedef itk::SmartPointer<Self>    Pointer;
+  itkNewMacro( Self );
+
+  virtual void Execute( const itk::Object * caller, const itk::EventObject & ) ITK_OVERRIDE
+  {
+    const ExhaustiveOptimizerType * exhaustive = dynamic_cast<const ExhaustiveOptimizerType *>( caller );
+    const MultiStartOptimizerType * multiStart = dynamic_cast<const MultiStartOptimizerType *>( caller );
+    const itk::ObjectToObjectOptimizerBase * optimizer = dynamic_cast<const itk::ObjectToObjectOptimizerBase *>( caller );
+    const ParametersType & position = optimizer->GetCurrentPosition();
+    for( unsigned int i = 0; i < position.Size(); ++i )
+      {
+      m_Records.push_back( position[i] );
+      }
+    if( exhaustive != ITK_NULLPTR )
+      {
+      m_Records.push_back( exhaustive->GetCurrentValue() );
+      for( unsigned int i = 0; i < exhaustive->GetCurrentIndex().Size(); ++i )
+        {
+        m_Records.push_back( exhaustive->GetCurrentIndex()[i] );
+        }
+      }
+    if( multiStart != ITK_NULLPTR )
+      {
+      m_Records.push_back( multiStart->GetCurrentMetricValue() );
+      }
+    if( optimizer->GetCurrentIteration() == m_StopIteration )
+      {
+      if( exhaustive != ITK_NULLPTR )
+        {
+        const_cast<ExhaustiveOptimizerType *>( exhaustive )->StopWalking();
+        }
+      }
+  }
+
+  virtual void Execute( itk::Object * caller, const itk::EventObject & event ) ITK_OVERRIDE
+  {
+    this->Execute( static_cast<const itk::Object *>( caller ), event );
+  }
+
+  std::vector<double> m_Records;
+  itk::SizeValueType  m_StopIteration;
+
+protected:
+  IterationRecorder() : m_StopIteration( itk::NumericTraits<itk::SizeValueType>::max() ) {}
+};
+
+MetricsListType
+CreateMetricClones( unsigned int numberOfClones, double failingValue )
+{
+  MetricsListType clones;
+  for( unsigned int i = 0; i < numberOfClones; ++i )
+    {
+    MetricClonesTestMetric::Pointer clone = MetricClonesTestMetric::New();
+    clone->SetFailingValue( failingValue );
+    clones.push_back( clone.GetPointer() );
+    }
+  return clones;
+}
+
+/** Run the exhaustive optimizer and return the records of its iterations and
+ * its results. */
+std::vector<double>
+RunExhaustive( unsigned int numberOfClones, double failingValue, itk::SizeValueType stopIteration,
+               bool & exceptionCaught )
+{
+  MetricClonesTestMetric::Pointer metric = MetricClonesTestMetric::New();
+  metric->SetFailingValue( failingValue );
+  ParametersType initialPosition( 3 );
+  initialPosition[0] = 0.0;
+  initialPosition[1] = -4.0;
+  initialPosition[2] = 1.0;
+  metric->SetParameters( initialPosition );
+
+  ExhaustiveOptimizerType::Pointer optimizer = ExhaustiveOptimizerType::New();
+  optimizer->SetMetric( metric );
+  optimizer->SetNumberOfThreads( 4 );
+  optimizer->SetMetricClones( CreateMetricClones( numberOfClones, failingValue ) );
+  ExhaustiveOptimizerType::ScalesType scales( 3 );
+  scales[0] = 1.0;
+  scales[1] = 1.0;
+  scales[2] = 0.5;
+  optimizer->SetScales( scales );
+  optimizer->SetStepLength( 0.5 );
+  ExhaustiveOptimizerType::StepsType steps( 3 );
+  steps[0] = 10;
+  steps[1] = 10;
+  steps[2] = 4;
+  optimizer->SetNumberOfSteps( steps );
+
+  IterationRecorder::Pointer recorder = IterationRecorder::New();
+  recorder->m_StopIteration = stopIteration;
+  optimizer->AddObserver( itk::IterationEvent(), recorder );
+
+  exceptionCaught = false;
+  try
+    {
+    optimizer->StartOptimization();
+    }
+  catch( itk::ExceptionObject & )
+    {
+    exceptionCaught = true;
+    }
+
+  std::vector<double> results = recorder->m_Records;
+  results.push_back( optimizer->GetCurrentIteration() );
+  results.push_back( optimizer->GetMinimumMetricValue() );
+  results.push_back( optimizer->GetMaximumMetricValue() );
+  for( unsigned int i = 0; i < 3; ++i )
+    {
+    results.push_back( optimizer->GetMinimumMetricValuePosition()[i] );
+    results.push_back( optimizer->GetMaximumMetricValuePosition()[i] );
+    results.push_back( optimizer->GetCurrentIndex()[i] );
+    results.push_back( optimizer->GetCurrentPosition()[i] );
+    }
+  std::cout << "  " << numberOfClones << " clones: " << optimizer->GetCurrentIteration() << " iterations, "
+            << optimizer->GetStopConditionDescription() << std::endl;
+  return results;
+}
+
+/** Run the multi-start optimizer and return the records of its iterations
+ * and its results. */
+std::vector<double>
+RunMultiStart( unsigned int numberOfClones, double failingValue )
+{
+  MetricClonesTestMetric::Pointer metric = MetricClonesTestMetric::New();
+  metric->SetFailingValue( failingValue );
+
+  MultiStartOptimizerType::ParametersListType parametersList;
+  for( unsigned int i = 0; i < 200; ++i )
+    {
+    ParametersType parameters( 3 );
+    parameters[0] = static_cast<double>( i % 7 ) - 3.0;
+    parameters[1] = static_cast<double>( i % 11 ) - 5.0;
+    parameters[2] = static_cast<double>( i % 5 ) * 0.5;
+    if( i % 50 == 10 )
+      {
+      parameters[0] = 2.5;
+      }
+    parametersList.push_back( parameters );
+    }
+
+  MultiStartOptimizerType::Pointer optimizer = MultiStartOptimizerType::New();
+  optimizer->SetMetric( metric );
+  optimizer->SetNumberOfThreads( 4 );
+  optimizer->SetMetricClones( CreateMetricClones( numberOfClones, failingValue ) );
+  optimizer->SetParametersList( parametersList );
+  ParametersType scales( 3 );
+  scales.Fill( 1.0 );
+  optimizer->SetScales( scales );
+
+  IterationRecorder::Pointer recorder = IterationRecorder::New();
+  optimizer->AddObserver( itk::IterationEvent(), recorder );
+  optimizer->StartOptimization();
+
+  std::vector<double> results = recorder->m_Records;
+  const MultiStartOptimizerType::MetricValuesListType & values = optimizer->GetMetricValuesList();
+  results.insert( results.end(), values.begin(), values.end() );
+  results.push_back( optimizer->GetBestParametersIndex() );
+  for( unsigned int i = 0; i < 3; ++i )
+    {
+    results.push_back( optimizer->GetCurrentPosition()[i] );
+    }
+  std::cout << "  " << numberOfClones << " clones: " << values.size() << " values, best start point "
+            << optimizer->GetBestParametersIndex() << std::endl;
+  return results;
+}
+
+bool
+CompareResults( const std::vector<double> & reference, const std::vector<double> & results )
+{
+  if( reference.size() != results.size() )
+    {
+    std::cerr << "Got " << results.size() << " results instead of " << reference.size() << std::endl;
+    return false;
+    }
+  for( size_t i = 0; i < reference.size(); ++i )
+    {
+    if( itk::Math::NotExactlyEquals( reference[i], results[i] ) )
+      {
+      std::cerr << "Result " << i << " is " << results[i] << " instead of " << reference[i] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+} // end namespace
+
+int itkOptimizerv4MetricClonesTest( int, char *[] )
+{
+  ExhaustiveOptimizerType::Pointer exhaustive = ExhaustiveOptimizerType::New();
+  TEST_SET_GET_VALUE( 0, exhaustive->GetMetricClones().size() );
+  MetricsListType clones = CreateMetricClones( 2, 1000.0 );
+  exhaustive->SetMetricClones( clones );
+  TEST_SET_GET_VALUE( 2, exhaustive->GetMetricClones().size() );
+
+  bool exceptionCaught = false;
+  bool referenceExceptionCaught = false;
+  const itk::SizeValueType noStop = itk::NumericTraits<itk::SizeValueType>::max();
+
+  // The 21 x 21 x 9 grid positions are evaluated by several batches.
+  std::cout << "Exhaustive search" << std::endl;
+  const std::vector<double> reference = RunExhaustive( 0, 1000.0, noStop, referenceExceptionCaught );
+  TEST_EXPECT_TRUE( !referenceExceptionCaught );
+  TEST_SET_GET_VALUE( 21 * 21 * 9, reference[reference.size() - 15] );
+  for( unsigned int numberOfClones = 1; numberOfClones <= 4; numberOfClones *= 2 )
+    {
+    TEST_EXPECT_TRUE( CompareResults( reference, RunExhaustive( numberOfClones, 1000.0, noStop, exceptionCaught ) ) );
+    TEST_EXPECT_TRUE( !exceptionCaught );
+    }
+
+  // Stop from an observer in the middle of a batch.
+  std::cout << "Exhaustive search stopped at iteration 1500" << std::endl;
+  const std::vector<double> stoppedReference = RunExhaustive( 0, 1000.0, 1500, referenceExceptionCaught );
+  TEST_EXPECT_TRUE( CompareResults( stoppedReference, RunExhaustive( 4, 1000.0, 1500, exceptionCaught ) ) );
+
+  // A failing position interrupts the search at the same position.
+  std::cout << "Exhaustive search with a failing position" << std::endl;
+  const std::vector<double> failedReference = RunExhaustive( 0, 1.5, noStop, referenceExceptionCaught );
+  TEST_EXPECT_TRUE( referenceExceptionCaught );
+  TEST_EXPECT_TRUE( CompareResults( failedReference, RunExhaustive( 4, 1.5, noStop, exceptionCaught ) ) );
+  TEST_EXPECT_TRUE( exceptionCaught );
+
+  // The failing start points are skipped.
+  std::cout << "Multi-start search" << std::endl;
+  const std::vector<double> multiStartReference = RunMultiStart( 0, 2.5 );
+  for( unsigned int numberOfClones = 1; numberOfClones <= 4; numberOfClones *= 2 )
+    {
+    TEST_EXPECT_TRUE( CompareResults( multiStartReference, RunMultiStart( numberOfClones, 2.5 ) ) );
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
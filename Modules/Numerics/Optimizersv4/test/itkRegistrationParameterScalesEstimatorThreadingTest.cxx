@@ -0,0 +1,251 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkRegistrationParameterScalesFromJacobian.h"
+#include "itkRegistrationParameterScalesFromPhysicalShift.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkBSplineTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the parallel processing of the sample points by the scales
+ * estimators: the sparse Jacobians of a B-spline transform give the same
+ * scales as its dense Jacobians, the results do not depend on the number of
+ * threads, and the samples are not recomputed when switching between the
+ * estimation of the scales and of the step scale.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image<double, Dimension>                                 ImageType;
+typedef itk::MeanSquaresImageToImageMetricv4<ImageType, ImageType>    MetricType;
+typedef itk::RegistrationParameterScalesFromJacobian<MetricType>      JacobianEstimatorType;
+typedef JacobianEstimatorType::ScalesType                             ScalesType;
+typedef JacobianEstimatorType::ParametersType                         ParametersType;
+
+/** Expose the sampling time of the physical shift estimator. */
+class PhysicalShiftEstimatorType:
+  public itk::RegistrationParameterScalesFromPhysicalShift<MetricType>
+{
+public:
+  typedef PhysicalShiftEstimatorType                                  Self;
+  typedef itk::RegistrationParameterScalesFromPhysicalShift<MetricType> Superclass;
+  typedef itk::SmartPointer<Self>                                     Pointer;
+
+  itkNewMacro( Self );
+
+  itk::ModifiedTimeType GetSamplingTime() const
+    {
+    return this->m_SamplingTime.GetMTime();
+    }
+
+  itk::SizeValueType GetNumberOfSamples() const
+    {
+    return static_cast<itk::SizeValueType>( this->m_SamplePoints.size() );
+    }
+};
+
+bool
+CheckEqual( const char * description, double value, double expected, double tolerance )
+{
+  if( std::abs( value - expected ) > tolerance * std::max( 1.0, std::abs( expected ) ) )
+    {
+    std::cerr << "Failed: " << description << " is " << value << " instead of " << expected << std::endl;
+    return false;
+    }
+  return true;
+}
+
+bool
+CheckEqual( const char * description, const ScalesType & values, const ScalesType & expected, double tolerance )
+{
+  if( values.Size() != expected.Size() )
+    {
+    std::cerr << "Failed: " << description << " have " << values.Size() << " values instead of "
+              << expected.Size() << std::endl;
+    return false;
+    }
+  for( unsigned int i = 0; i < values.Size(); ++i )
+    {
+    if( !CheckEqual( description, values[i], expected[i], tolerance ) )
+      {
+      std::cerr << "  at index " << i << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkRegistrationParameterScalesEstimatorThreadingTest( int, char *[] )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill( 64 );
+  image->SetRegions( size );
+  image->Allocate();
+  image->FillBuffer( 0.0 );
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( image );
+  metric->SetMovingImage( image );
+  metric->SetVirtualDomainFromImage( image );
+
+  bool testPassed = true;
+
+  // B-spline transform: the sparse Jacobians are compared with the dense
+  // Jacobians computed through a composite transform.
+  typedef itk::BSplineTransform<double, Dimension, 3> BSplineTransformType;
+  BSplineTransformType::Pointer bsplineTransform = BSplineTransformType::New();
+  BSplineTransformType::PhysicalDimensionsType physicalDimensions;
+  BSplineTransformType::MeshSizeType meshSize;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    physicalDimensions[d] = size[d] - 1;
+    meshSize[d] = 6;
+    }
+  bsplineTransform->SetTransformDomainOrigin( image->GetOrigin() );
+  bsplineTransform->SetTransformDomainPhysicalDimensions( physicalDimensions );
+  bsplineTransform->SetTransformDomainMeshSize( meshSize );
+  bsplineTransform->SetTransformDomainDirection( image->GetDirection() );
+
+  ParametersType bsplineParameters( bsplineTransform->GetNumberOfParameters() );
+  ParametersType bsplineStep( bsplineTransform->GetNumberOfParameters() );
+  for( unsigned int p = 0; p < bsplineParameters.Size(); ++p )
+    {
+    bsplineParameters[p] = 0.1 * std::sin( 0.7 * p );
+    bsplineStep[p] = std::cos( 1.3 * p );
+    }
+  bsplineTransform->SetParameters( bsplineParameters );
+
+  typedef itk::CompositeTransform<double, Dimension> CompositeTransformType;
+  CompositeTransformType::Pointer compositeTransform = CompositeTransformType::New();
+  compositeTransform->AddTransform( bsplineTransform );
+
+  ScalesType denseScales;
+  ScalesType sparseScales;
+  double denseStepScale;
+  double sparseStepScale;
+
+  JacobianEstimatorType::Pointer jacobianEstimator = JacobianEstimatorType::New();
+  jacobianEstimator->SetMetric( metric );
+  TEST_SET_GET_VALUE( itk::MultiThreader::GetGlobalDefaultNumberOfThreads(), jacobianEstimator->GetNumberOfThreads() );
+  jacobianEstimator->SetNumberOfThreads( 4 );
+  TEST_SET_GET_VALUE( 4, jacobianEstimator->GetNumberOfThreads() );
+
+  metric->SetMovingTransform( compositeTransform );
+  jacobianEstimator->EstimateScales( denseScales );
+  denseStepScale = jacobianEstimator->EstimateStepScale( bsplineStep );
+
+  metric->SetMovingTransform( bsplineTransform );
+  jacobianEstimator->EstimateScales( sparseScales );
+  sparseStepScale = jacobianEstimator->EstimateStepScale( bsplineStep );
+
+  testPassed &= CheckEqual( "B-spline Jacobian scales", sparseScales, denseScales, 1e-12 );
+  testPassed &= CheckEqual( "B-spline Jacobian step scale", sparseStepScale, denseStepScale, 1e-12 );
+  std::cout << "B-spline step scale: " << sparseStepScale << std::endl;
+
+  jacobianEstimator->SetNumberOfThreads( 1 );
+  ScalesType singleThreadScales;
+  jacobianEstimator->EstimateScales( singleThreadScales );
+  testPassed &= CheckEqual( "B-spline Jacobian scales with one thread", singleThreadScales, sparseScales, 1e-12 );
+  testPassed &= CheckEqual( "B-spline Jacobian step scale with one thread",
+                            jacobianEstimator->EstimateStepScale( bsplineStep ), sparseStepScale, 1e-12 );
+
+  // Displacement field transform
+  typedef itk::DisplacementFieldTransform<double, Dimension> DisplacementFieldTransformType;
+  typedef DisplacementFieldTransformType::DisplacementFieldType DisplacementFieldType;
+  DisplacementFieldType::Pointer field = DisplacementFieldType::New();
+  field->CopyInformation( image );
+  field->SetRegions( image->GetLargestPossibleRegion() );
+  field->Allocate();
+  itk::ImageRegionIteratorWithIndex<DisplacementFieldType> fieldIt( field, field->GetLargestPossibleRegion() );
+  for( fieldIt.GoToBegin(); !fieldIt.IsAtEnd(); ++fieldIt )
+    {
+    DisplacementFieldType::PixelType displacement;
+    displacement[0] = 0.5 * std::sin( 0.1 * fieldIt.GetIndex()[1] );
+    displacement[1] = 0.5 * std::cos( 0.2 * fieldIt.GetIndex()[0] );
+    fieldIt.Set( displacement );
+    }
+  DisplacementFieldTransformType::Pointer displacementFieldTransform = DisplacementFieldTransformType::New();
+  displacementFieldTransform->SetDisplacementField( field );
+  metric->SetMovingTransform( displacementFieldTransform );
+
+  ParametersType displacementStep( displacementFieldTransform->GetNumberOfParameters() );
+  for( unsigned int p = 0; p < displacementStep.Size(); ++p )
+    {
+    displacementStep[p] = std::sin( 0.3 * p );
+    }
+
+  ScalesType localStepScales;
+  jacobianEstimator->SetNumberOfThreads( 1 );
+  const double singleThreadJacobianStepScale = jacobianEstimator->EstimateStepScale( displacementStep );
+  jacobianEstimator->SetNumberOfThreads( 4 );
+  testPassed &= CheckEqual( "Displacement field Jacobian step scale",
+                            jacobianEstimator->EstimateStepScale( displacementStep ), singleThreadJacobianStepScale, 1e-12 );
+
+  PhysicalShiftEstimatorType::Pointer shiftEstimator = PhysicalShiftEstimatorType::New();
+  shiftEstimator->SetMetric( metric );
+  shiftEstimator->SetNumberOfThreads( 1 );
+  ScalesType singleThreadShiftScales;
+  shiftEstimator->EstimateScales( singleThreadShiftScales );
+  const double singleThreadShiftStepScale = shiftEstimator->EstimateStepScale( displacementStep );
+  ScalesType singleThreadLocalStepScales;
+  shiftEstimator->EstimateLocalStepScales( displacementStep, singleThreadLocalStepScales );
+
+  shiftEstimator->SetNumberOfThreads( 4 );
+  ScalesType shiftScales;
+  shiftEstimator->EstimateScales( shiftScales );
+  const itk::ModifiedTimeType scalesSamplingTime = shiftEstimator->GetSamplingTime();
+  const double shiftStepScale = shiftEstimator->EstimateStepScale( displacementStep );
+  const itk::ModifiedTimeType stepScaleSamplingTime = shiftEstimator->GetSamplingTime();
+  shiftEstimator->EstimateLocalStepScales( displacementStep, localStepScales );
+
+  testPassed &= CheckEqual( "Displacement field shift scales", shiftScales, singleThreadShiftScales, 1e-12 );
+  testPassed &= CheckEqual( "Displacement field shift step scale", shiftStepScale, singleThreadShiftStepScale, 1e-12 );
+  testPassed &= CheckEqual( "Displacement field local step scales", localStepScales, singleThreadLocalStepScales, 1e-12 );
+  std::cout << "Displacement field shift step scale: " << shiftStepScale << std::endl;
+
+  // The central region samples of the scales and the full domain samples of
+  // the step scale are both kept.
+  shiftEstimator->EstimateScales( shiftScales );
+  TEST_SET_GET_VALUE( scalesSamplingTime, shiftEstimator->GetSamplingTime() );
+  TEST_SET_GET_VALUE( 121, shiftEstimator->GetNumberOfSamples() );
+  shiftEstimator->EstimateStepScale( displacementStep );
+  TEST_SET_GET_VALUE( stepScaleSamplingTime, shiftEstimator->GetSamplingTime() );
+  TEST_SET_GET_VALUE( image->GetLargestPossibleRegion().GetNumberOfPixels(), shiftEstimator->GetNumberOfSamples() );
+
+  // Modifying the estimator invalidates the samples.
+  shiftEstimator->SetCentralRegionRadius( 3 );
+  shiftEstimator->EstimateScales( shiftScales );
+  TEST_SET_GET_VALUE( 49, shiftEstimator->GetNumberOfSamples() );
+  shiftEstimator->EstimateStepScale( displacementStep );
+  TEST_EXPECT_TRUE( shiftEstimator->GetSamplingTime() > stepScaleSamplingTime );
+
+  if( !testPassed )
+    {
+    std::cerr << "Test failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed" << std::endl;
+  return EXIT_SUCCESS;
+}
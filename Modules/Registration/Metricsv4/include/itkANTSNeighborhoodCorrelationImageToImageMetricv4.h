@@ -51,9 +51,12 @@ namespace itk {
  * the evaluation up considerably and works well in practice. This assumption
  * is the main differentiation of this approach from a more generic one.
  *
- * 2) The evaluation uses on-the-fly queues with multi-threading and a sliding
- * neighborhood window. This is described in the above paper and specifically
- * optimized for dense registration.
+ * 2) The images are evaluated once at each point, and the sums over the
+ * neighborhoods are computed with box filters, separably within each slice
+ * and over a sliding window of slices. This follows the sliding window of
+ * the above paper and is specifically optimized for dense registration.
+ * With TInternalComputationValueType = float, the sums are accumulated in
+ * single precision.
  *
  *  Example of usage:
  *
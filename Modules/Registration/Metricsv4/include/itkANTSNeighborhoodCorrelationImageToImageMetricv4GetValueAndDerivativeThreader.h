@@ -40,10 +40,15 @@ struct IdentityHelper
 
 /** \class ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader
  * \brief Threading implementation for ANTS CC metric \c ANTSNeighborhoodCorrelationImageToImageMetricv4 .
- * Supports both dense and sparse threading ways. The dense threader iterates over the whole image domain
- * in order and use a neighborhood scanning window to compute the local cross correlation metric and
- * its derivative incrementally inside the window. The sparse threader uses a sampled point set partitioner to
- * computer local cross correlation only at the sampled positions.
+ * Supports both dense and sparse threading ways. The dense threader evaluates the fixed and moving images
+ * once at each point of its sub region, grown by the neighborhood radius, and computes the neighborhood
+ * sums needed by the local cross correlation with box filters: the sums over the neighborhood are
+ * computed separably inside each slice of the last dimension, and the slice sums are added over a
+ * sliding window of slices. The sub region is processed in tiles so that the buffers of a slice stay
+ * small. All the sums use InternalComputationValueType, so that a metric instantiated with float
+ * only accumulates in single precision, over contiguous arrays the compiler can vectorize.
+ * The sparse threader uses a sampled point set partitioner to
+ * computer local cross correlation only at the sampled positions, with a neighborhood scanning window.
  *
  * This threader class is designed to host the dense and sparse threader under the same name so most computation
  * routine functions and interior member variables can be shared. This eliminates the need to duplicate codes
@@ -280,6 +285,20 @@ protected:
     const ScanParametersType &scanParameters, DerivativeType &deriv,
     MeasureType &local_cc, const ThreadIdType threadId) const;
 
+  /** Compute the local cross correlation and its derivative at all the
+   * points of a tile of the dense threader's sub region, adding the
+   * results to the per-thread variables. */
+  void ProcessDenseTile( const ImageRegionType & tile, MeasureType & metricValueSum,
+                         const ThreadIdType threadId );
+
+  /** Sum the values of \c input over a window of 2 * radius + 1 points
+   * along dimension \c dimension of an array of size \c size, stored
+   * with the first dimension varying fastest. The windows are clipped
+   * at the borders of the array. */
+  static void BoxSumAlongDimension( const QueueRealType * input, QueueRealType * output,
+                                    const SizeValueType * size, unsigned int numberOfDimensions,
+                                    unsigned int dimension, SizeValueType radius );
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader);
 
@@ -38,66 +38,332 @@ ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TD
     itkExceptionMacro("Dynamic casting of associate pointer failed.");
     }
 
-  VirtualPointType     virtualPoint;
-  MeasureType          metricValueResult = NumericTraits< MeasureType >::ZeroValue();
-  MeasureType          metricValueSum = NumericTraits< MeasureType >::ZeroValue();
-  bool                 pointIsValid;
-  ScanIteratorType     scanIt;
-  ScanParametersType   scanParameters;
-  ScanMemType          scanMem;
+  MeasureType metricValueSum = NumericTraits< MeasureType >::ZeroValue();
+
+  /* Process the sub region in tiles along the last dimension of the
+   * slices, so that the buffers of a slice of a tile, grown by the radius,
+   * hold at most about MaximumTileSliceSize points. */
+  const unsigned int tileDimension = ( TImageToImageMetric::VirtualImageDimension > 1 )
+    ? TImageToImageMetric::VirtualImageDimension - 2 : 0;
+  const SizeValueType MaximumTileSliceSize = 32768;
+  const RadiusType radius = this->m_ANTSAssociate->GetRadius();
+  SizeValueType grownSliceSize = 1;
+  for( unsigned int d = 0; d < tileDimension; ++d )
+    {
+    grownSliceSize *= virtualImageSubRegion.GetSize(d) + 2 * radius[d];
+    }
+  SizeValueType tileSize = virtualImageSubRegion.GetSize(tileDimension);
+  if( TImageToImageMetric::VirtualImageDimension > 1 )
+    {
+    const SizeValueType maximumGrownTileSize = std::max( MaximumTileSliceSize / grownSliceSize,
+                                                         static_cast< SizeValueType >( 2 * radius[tileDimension] + 1 ) );
+    tileSize = std::min( tileSize, maximumGrownTileSize - 2 * radius[tileDimension] );
+    }
 
-  DerivativeType & localDerivativeResult = this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives;
+  ImageRegionType tile = virtualImageSubRegion;
+  const IndexValueType tileEnd = virtualImageSubRegion.GetIndex(tileDimension)
+    + static_cast< IndexValueType >( virtualImageSubRegion.GetSize(tileDimension) );
+  for( IndexValueType tileBegin = virtualImageSubRegion.GetIndex(tileDimension); tileBegin < tileEnd;
+       tileBegin += static_cast< IndexValueType >( tileSize ) )
+    {
+    tile.SetIndex( tileDimension, tileBegin );
+    tile.SetSize( tileDimension, std::min( tileSize, static_cast< SizeValueType >( tileEnd - tileBegin ) ) );
+    this->ProcessDenseTile( tile, metricValueSum, threadId );
+    }
+
+  /* Store metric value result for this thread. */
+  this->m_GetValueAndDerivativePerThreadVariables[threadId].Measure = metricValueSum;
+}
 
-  /* Create an iterator over the virtual sub region */
-  // this->m_ANTSAssociate->InitializeScanning( virtualImageSubRegion, scanIt, scanMem, scanParameters );
-  this->InitializeScanning( virtualImageSubRegion, scanIt, scanMem, scanParameters );
+template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
+::ProcessDenseTile( const ImageRegionType & tile, MeasureType & metricValueSum, const ThreadIdType threadId )
+{
+  typedef InternalComputationValueType LocalRealType;
 
-  /* Iterate over the sub region */
-  scanIt.GoToBegin();
-  while (!scanIt.IsAtEnd())
+  const unsigned int ImageDimension = TImageToImageMetric::VirtualImageDimension;
+  /* The tile is scanned slice by slice along the last dimension. */
+  const unsigned int SliceDimension = ImageDimension - 1;
+  enum { FIXED = 0, MOVING, FIXED2, MOVING2, FIXEDMOVING, COUNT, NumberOfSums };
+
+  const RadiusType radius = this->m_ANTSAssociate->GetRadius();
+  const bool computeDerivative = this->m_ANTSAssociate->GetComputeDerivative();
+  const bool gradientSourceIncludesMoving = this->m_ANTSAssociate->GetGradientSourceIncludesMoving();
+
+  /* The points that are in the neighborhood of a point of the tile. */
+  ImageRegionType evaluationRegion = tile;
+  evaluationRegion.PadByRadius( radius );
+  evaluationRegion.Crop( this->m_ANTSAssociate->GetVirtualRegion() );
+
+  SizeValueType evaluationSliceSize[ImageDimension];
+  SizeValueType tileOffset[ImageDimension];
+  SizeValueType tileStride[ImageDimension];
+  SizeValueType evaluationSliceNumberOfPoints = 1;
+  SizeValueType tileSliceNumberOfPoints = 1;
+  for( unsigned int d = 0; d < SliceDimension; ++d )
     {
-    /* Get the virtual point */
-    this->m_ANTSAssociate->TransformVirtualIndexToPhysicalPoint( scanIt.GetIndex(), virtualPoint );
+    evaluationSliceSize[d] = evaluationRegion.GetSize(d);
+    tileOffset[d] = static_cast< SizeValueType >( tile.GetIndex(d) - evaluationRegion.GetIndex(d) );
+    tileStride[d] = tileSliceNumberOfPoints;
+    evaluationSliceNumberOfPoints *= evaluationRegion.GetSize(d);
+    tileSliceNumberOfPoints *= tile.GetSize(d);
+    }
 
-    /* Call the user method in derived classes to do the specific
-     * calculations for value and derivative. */
-    try
+  /* Ring buffers holding, for the last 2 * radius + 1 slices, the
+   * neighborhood sums within the slice and the values at the points of
+   * the tile. */
+  const SizeValueType ringLength = 2 * radius[SliceDimension] + 1;
+  std::vector< LocalRealType > sliceValues( NumberOfSums * evaluationSliceNumberOfPoints );
+  std::vector< LocalRealType > sliceWork( NumberOfSums * evaluationSliceNumberOfPoints );
+  std::vector< LocalRealType > ringSums( ringLength * NumberOfSums * tileSliceNumberOfPoints );
+  std::vector< LocalRealType > ringFixed( ringLength * tileSliceNumberOfPoints );
+  std::vector< LocalRealType > ringMoving( ringLength * tileSliceNumberOfPoints );
+  std::vector< unsigned char > ringIsValid( ringLength * tileSliceNumberOfPoints );
+  std::vector< MovingImagePointType > ringMappedMovingPoints( computeDerivative ? ringLength * tileSliceNumberOfPoints : 0 );
+  std::vector< LocalRealType > windowSums( NumberOfSums * tileSliceNumberOfPoints );
+
+  ScanIteratorType   scanIt;
+  ScanParametersType scanParameters;
+  ScanMemType        scanMem;
+  scanMem.movingImageGradient.Fill( NumericTraits< typename MovingImageGradientType::ValueType >::ZeroValue() );
+  MeasureType metricValueResult = NumericTraits< MeasureType >::ZeroValue();
+  DerivativeType & localDerivativeResult = this->m_GetValueAndDerivativePerThreadVariables[threadId].LocalDerivatives;
+
+  const IndexValueType evaluationBegin = evaluationRegion.GetIndex(SliceDimension);
+  const IndexValueType evaluationEnd = evaluationBegin + static_cast< IndexValueType >( evaluationRegion.GetSize(SliceDimension) );
+  const IndexValueType tileBegin = tile.GetIndex(SliceDimension);
+  const IndexValueType tileEnd = tileBegin + static_cast< IndexValueType >( tile.GetSize(SliceDimension) );
+  const IndexValueType sliceRadius = static_cast< IndexValueType >( radius[SliceDimension] );
+
+  VirtualIndexType        virtualIndex;
+  VirtualPointType        virtualPoint;
+  FixedImagePointType     mappedFixedPoint;
+  FixedImagePixelType     fixedImageValue;
+  MovingImagePointType    mappedMovingPoint;
+  MovingImagePixelType    movingImageValue;
+
+  for( IndexValueType z = evaluationBegin; z < evaluationEnd + sliceRadius; ++z )
+    {
+    if( z < evaluationEnd )
       {
-      this->UpdateQueues(scanIt, scanMem, scanParameters, threadId);
-      pointIsValid = this->ComputeInformationFromQueues(scanIt, scanMem, scanParameters, threadId);
-      if( pointIsValid )
+      /* Evaluate the images at the points of the slice, and store the values
+       * at the points of the tile for when the slice is at the center of
+       * the window. */
+      const SizeValueType ringSlot = static_cast< SizeValueType >( z - evaluationBegin ) % ringLength;
+      std::fill( sliceValues.begin(), sliceValues.end(), NumericTraits< LocalRealType >::ZeroValue() );
+      std::fill( ringIsValid.begin() + ringSlot * tileSliceNumberOfPoints,
+                 ringIsValid.begin() + ( ringSlot + 1 ) * tileSliceNumberOfPoints, 0 );
+      virtualIndex = evaluationRegion.GetIndex();
+      virtualIndex[SliceDimension] = z;
+      for( SizeValueType j = 0; j < evaluationSliceNumberOfPoints; ++j )
+        {
+        this->m_ANTSAssociate->TransformVirtualIndexToPhysicalPoint( virtualIndex, virtualPoint );
+        bool pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, fixedImageValue );
+        if( pointIsValid )
+          {
+          pointIsValid = this->m_ANTSAssociate->TransformAndEvaluateMovingPoint( virtualPoint, mappedMovingPoint, movingImageValue );
+          }
+        if( pointIsValid )
+          {
+          const LocalRealType fixedValue = fixedImageValue;
+          const LocalRealType movingValue = movingImageValue;
+          sliceValues[FIXED * evaluationSliceNumberOfPoints + j] = fixedValue;
+          sliceValues[MOVING * evaluationSliceNumberOfPoints + j] = movingValue;
+          sliceValues[FIXED2 * evaluationSliceNumberOfPoints + j] = fixedValue * fixedValue;
+          sliceValues[MOVING2 * evaluationSliceNumberOfPoints + j] = movingValue * movingValue;
+          sliceValues[FIXEDMOVING * evaluationSliceNumberOfPoints + j] = fixedValue * movingValue;
+          sliceValues[COUNT * evaluationSliceNumberOfPoints + j] = NumericTraits< LocalRealType >::OneValue();
+
+          bool isInTile = true;
+          SizeValueType tileJ = 0;
+          for( unsigned int d = 0; d < SliceDimension; ++d )
+            {
+            const SizeValueType i = static_cast< SizeValueType >( virtualIndex[d] - tile.GetIndex(d) );
+            isInTile = isInTile && virtualIndex[d] >= tile.GetIndex(d) && i < tile.GetSize(d);
+            tileJ += i * tileStride[d];
+            }
+          if( isInTile )
+            {
+            const SizeValueType ringJ = ringSlot * tileSliceNumberOfPoints + tileJ;
+            ringFixed[ringJ] = fixedValue;
+            ringMoving[ringJ] = movingValue;
+            ringIsValid[ringJ] = 1;
+            if( computeDerivative )
+              {
+              ringMappedMovingPoints[ringJ] = mappedMovingPoint;
+              }
+            }
+          }
+        /* Next point of the slice, first dimension fastest. */
+        for( unsigned int d = 0; d < SliceDimension; ++d )
+          {
+          if( ++virtualIndex[d] < evaluationRegion.GetIndex(d) + static_cast< IndexValueType >( evaluationSliceSize[d] ) )
+            {
+            break;
+            }
+          virtualIndex[d] = evaluationRegion.GetIndex(d);
+          }
+        }
+
+      /* Neighborhood sums within the slice, one dimension at a time. */
+      LocalRealType * input = &sliceValues[0];
+      LocalRealType * output = &sliceWork[0];
+      for( unsigned int d = 0; d < SliceDimension; ++d )
+        {
+        for( unsigned int q = 0; q < NumberOfSums; ++q )
+          {
+          Self::BoxSumAlongDimension( input + q * evaluationSliceNumberOfPoints, output + q * evaluationSliceNumberOfPoints,
+                                      evaluationSliceSize, SliceDimension, d, radius[d] );
+          }
+        std::swap( input, output );
+        }
+
+      /* Keep the sums at the points of the tile. */
+      for( unsigned int q = 0; q < NumberOfSums; ++q )
         {
-        this->ComputeMovingTransformDerivative(scanIt, scanMem, scanParameters, localDerivativeResult, metricValueResult, threadId );
+        LocalRealType * ringSlotSums = &ringSums[( ringSlot * NumberOfSums + q ) * tileSliceNumberOfPoints];
+        const LocalRealType * sums = input + q * evaluationSliceNumberOfPoints;
+        for( SizeValueType tileJ = 0; tileJ < tileSliceNumberOfPoints; ++tileJ )
+          {
+          SizeValueType evaluationJ = 0;
+          SizeValueType evaluationStride = 1;
+          SizeValueType remainder = tileJ;
+          for( unsigned int d = 0; d < SliceDimension; ++d )
+            {
+            evaluationJ += ( remainder % tile.GetSize(d) + tileOffset[d] ) * evaluationStride;
+            remainder /= tile.GetSize(d);
+            evaluationStride *= evaluationSliceSize[d];
+            }
+          ringSlotSums[tileJ] = sums[evaluationJ];
+          }
         }
       }
-    catch (ExceptionObject & exc)
+
+    /* Once all the slices of its window are evaluated, process the slice
+     * at the center of the window. */
+    const IndexValueType center = z - sliceRadius;
+    if( center < tileBegin || center >= tileEnd )
       {
-      //NOTE: there must be a cleaner way to do this:
-      std::string msg("Caught exception: \n");
-      msg += exc.what();
-      ExceptionObject err(__FILE__, __LINE__, msg);
-      throw err;
+      continue;
+      }
+    std::fill( windowSums.begin(), windowSums.end(), NumericTraits< LocalRealType >::ZeroValue() );
+    const IndexValueType windowBegin = std::max( center - sliceRadius, evaluationBegin );
+    const IndexValueType windowEnd = std::min( center + sliceRadius + 1, evaluationEnd );
+    for( IndexValueType w = windowBegin; w < windowEnd; ++w )
+      {
+      const LocalRealType * slotSums = &ringSums[( static_cast< SizeValueType >( w - evaluationBegin ) % ringLength )
+                                                 * NumberOfSums * tileSliceNumberOfPoints];
+      LocalRealType * sums = &windowSums[0];
+      for( SizeValueType k = 0; k < NumberOfSums * tileSliceNumberOfPoints; ++k )
+        {
+        sums[k] += slotSums[k];
+        }
       }
 
-    /* Assign the results */
-    if ( pointIsValid )
+    const SizeValueType centerSlot = static_cast< SizeValueType >( center - evaluationBegin ) % ringLength;
+    virtualIndex = tile.GetIndex();
+    virtualIndex[SliceDimension] = center;
+    for( SizeValueType tileJ = 0; tileJ < tileSliceNumberOfPoints; ++tileJ )
       {
-      this->m_GetValueAndDerivativePerThreadVariables[threadId].NumberOfValidPoints++;
-      metricValueSum -= metricValueResult;
-      /* Store the result. This depends on what type of
-       * transform is being used. */
-      if( this->GetComputeDerivative() )
+      const SizeValueType ringJ = centerSlot * tileSliceNumberOfPoints + tileJ;
+      const LocalRealType count = windowSums[COUNT * tileSliceNumberOfPoints + tileJ];
+      if( count > NumericTraits< LocalRealType >::ZeroValue() && ringIsValid[ringJ] )
+        {
+        const LocalRealType sumFixed       = windowSums[FIXED * tileSliceNumberOfPoints + tileJ];
+        const LocalRealType sumMoving      = windowSums[MOVING * tileSliceNumberOfPoints + tileJ];
+        const LocalRealType sumFixed2      = windowSums[FIXED2 * tileSliceNumberOfPoints + tileJ];
+        const LocalRealType sumMoving2     = windowSums[MOVING2 * tileSliceNumberOfPoints + tileJ];
+        const LocalRealType sumFixedMoving = windowSums[FIXEDMOVING * tileSliceNumberOfPoints + tileJ];
+
+        const LocalRealType fixedMean  = sumFixed  / count;
+        const LocalRealType movingMean = sumMoving / count;
+
+        scanMem.sFixedFixed   = sumFixed2 - fixedMean * sumFixed - fixedMean * sumFixed + count * fixedMean * fixedMean;
+        scanMem.sMovingMoving = sumMoving2 - movingMean * sumMoving - movingMean * sumMoving + count * movingMean * movingMean;
+        scanMem.sFixedMoving  = sumFixedMoving - movingMean * sumFixed - fixedMean * sumMoving + count * movingMean * fixedMean;
+        scanMem.fixedA        = ringFixed[ringJ] - fixedMean;
+        scanMem.movingA       = ringMoving[ringJ] - movingMean;
+
+        if( computeDerivative )
+          {
+          this->m_ANTSAssociate->TransformVirtualIndexToPhysicalPoint( virtualIndex, scanMem.virtualPoint );
+          if( gradientSourceIncludesMoving )
+            {
+            this->m_ANTSAssociate->ComputeMovingImageGradientAtPoint( ringMappedMovingPoints[ringJ], scanMem.movingImageGradient );
+            }
+          }
+
+        this->ComputeMovingTransformDerivative( scanIt, scanMem, scanParameters, localDerivativeResult, metricValueResult, threadId );
+
+        this->m_GetValueAndDerivativePerThreadVariables[threadId].NumberOfValidPoints++;
+        metricValueSum -= metricValueResult;
+        if( computeDerivative )
+          {
+          this->StorePointDerivativeResult( virtualIndex, threadId );
+          }
+        }
+      /* Next point of the tile slice, first dimension fastest. */
+      for( unsigned int d = 0; d < SliceDimension; ++d )
         {
-        this->StorePointDerivativeResult( scanIt.GetIndex(), threadId );
+        if( ++virtualIndex[d] < tile.GetIndex(d) + static_cast< IndexValueType >( tile.GetSize(d) ) )
+          {
+          break;
+          }
+        virtualIndex[d] = tile.GetIndex(d);
         }
       }
+    }
+}
 
-    //next index
-    ++scanIt;
+template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
+void
+ANTSNeighborhoodCorrelationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TNeighborhoodCorrelationMetric >
+::BoxSumAlongDimension( const QueueRealType * input, QueueRealType * output,
+                        const SizeValueType * size, unsigned int numberOfDimensions,
+                        unsigned int dimension, SizeValueType radius )
+{
+  /* The array is a sequence of blocks of size[dimension] rows along the
+   * dimension, each row being a contiguous run of stride values. The sum
+   * over the window is the sum of the array shifted by whole rows, each
+   * shift being a contiguous loop. */
+  SizeValueType stride = 1;
+  for( unsigned int d = 0; d < dimension; ++d )
+    {
+    stride *= size[d];
+    }
+  const SizeValueType length = size[dimension];
+  SizeValueType numberOfBlocks = 1;
+  for( unsigned int d = dimension + 1; d < numberOfDimensions; ++d )
+    {
+    numberOfBlocks *= size[d];
     }
+  const SizeValueType blockSize = stride * length;
+  const OffsetValueType window = static_cast< OffsetValueType >( radius );
 
-  /* Store metric value result for this thread. */
-  this->m_GetValueAndDerivativePerThreadVariables[threadId].Measure = metricValueSum;
+  for( SizeValueType block = 0; block < numberOfBlocks; ++block )
+    {
+    const QueueRealType * blockInput = input + block * blockSize;
+    QueueRealType * blockOutput = output + block * blockSize;
+    std::copy( blockInput, blockInput + blockSize, blockOutput );
+    for( OffsetValueType shift = -window; shift <= window; ++shift )
+      {
+      if( shift == 0 || static_cast< SizeValueType >( std::abs( shift ) ) >= length )
+        {
+        continue;
+        }
+      /* Rows i of the output receive the rows i + shift of the input. */
+      const SizeValueType firstRow = shift < 0 ? static_cast< SizeValueType >( -shift ) : 0;
+      const SizeValueType lastRow = shift > 0 ? length - static_cast< SizeValueType >( shift ) : length;
+      QueueRealType * out = blockOutput + firstRow * stride;
+      const QueueRealType * in = blockInput + ( static_cast< OffsetValueType >( firstRow ) + shift ) * static_cast< OffsetValueType >( stride );
+      const SizeValueType count = ( lastRow - firstRow ) * stride;
+      for( SizeValueType k = 0; k < count; ++k )
+        {
+        out[k] += in[k];
+        }
+      }
+    }
 }
 
 template < typename TDomainPartitioner, typename TImageToImageMetric, typename TNeighborhoodCorrelationMetric >
@@ -99,13 +99,45 @@ namespace itk
  * Point sets are set via SetFixedSampledPointSet, and the point set is enabled
  * for use by calling SetUseFixedSampledPointSet.
  * \note If the point set is sparse, the option SetUse[Fixed|Moving]ImageGradientFilter
- * typically should be disabled to avoid excessive computation. However,
- * the gradient values of the fixed image are not cached
- * when using a point set (there are plans for this in the future), so
- * depending on the number of iterations (when used during optimization)
- * and the level of sparsity, it may be more efficient to
- * use a gradient image filter for it because it will only be
- * calculated once.
+ * typically should be disabled to avoid excessive computation. The gradient
+ * values of the fixed image are then only cached across evaluations when
+ * UseFixedSampleCache is enabled, see below.
+ *
+ * Fixed Sample Cache
+ *
+ * When the fixed side of the metric does not change between evaluations,
+ * as during a registration where only the moving transform is optimized,
+ * the mapping of each domain point into the fixed image, its validity with
+ * respect to the fixed mask and image buffer, the fixed image value and the
+ * fixed image gradient are the same at every iteration.
+ * With SetUseFixedSampleCache(true), they are computed once for all the
+ * points of the domain, dense or sampled, and stored in arrays that are
+ * reused by the following evaluations. The cache is rebuilt when the
+ * metric, the fixed image, transform, mask or interpolator, the virtual
+ * domain or the fixed image gradient source are modified.
+ * The cache is only read by threaders that evaluate the points through
+ * ImageToImageMetricv4GetValueAndDerivativeThreaderBase::ProcessVirtualPoint,
+ * e.g. MeanSquares and MattesMutualInformation.
+ * \warning The modification of a sub-transform of a composite fixed
+ * transform is not detected. Call Modified() on the metric in that case.
+ *
+ * Stochastic Sampling
+ *
+ * With SetNumberOfStochasticSamples(n), n > 0, each evaluation uses only n
+ * points drawn at random, with replacement, from a candidate pool: the
+ * virtual sampled point set when UseFixedSampledPointSet is on, or all the
+ * points of the virtual region otherwise. A new set of points is drawn
+ * every StochasticSamplingInterval evaluations, counted from the last call
+ * to Initialize(). This is meant for stochastic gradient descent, e.g. with
+ * GradientDescentOptimizerv4, where a small random subset of the domain,
+ * typically one or two percent, gives an unbiased estimate of the
+ * derivative at a fraction of the cost of a full evaluation.
+ * The points are drawn in parallel, by fixed size blocks that each use their
+ * own random number generator stream, seeded from StochasticSamplingSeed,
+ * the block and the draw. The drawn points therefore do not depend on the
+ * number of threads. The stochastic samples are evaluated with the sparse
+ * threaders, and read the fixed sample cache when it is active, so the
+ * fixed side of a candidate point is only computed once.
  *
  * Vector Images
  *
@@ -430,6 +462,30 @@ public:
   /** Get the virtual domain sampling point set */
   itkGetModifiableObjectMacro(VirtualSampledPointSet, VirtualPointSetType);
 
+  /** Set/Get flag to cache the fixed side of the domain points across
+   * evaluations. This uses memory for each point of the domain.
+   * See main documentation. Default is false. */
+  itkSetMacro(UseFixedSampleCache, bool);
+  itkGetConstReferenceMacro(UseFixedSampleCache, bool);
+  itkBooleanMacro(UseFixedSampleCache);
+
+  /** Set/Get the number of points drawn at random from the candidate pool
+   * to evaluate the metric. 0, the default, disables stochastic sampling
+   * and evaluates all the points of the domain.
+   * See main documentation. */
+  itkSetMacro(NumberOfStochasticSamples, SizeValueType);
+  itkGetConstMacro(NumberOfStochasticSamples, SizeValueType);
+
+  /** Set/Get the number of evaluations between two draws of the stochastic
+   * samples. Default is 1, i.e. new points at every evaluation. */
+  itkSetClampMacro(StochasticSamplingInterval, SizeValueType, 1, NumericTraits<SizeValueType>::max());
+  itkGetConstMacro(StochasticSamplingInterval, SizeValueType);
+
+  /** Set/Get the seed of the random number generators used to draw the
+   * stochastic samples. */
+  itkSetMacro(StochasticSamplingSeed, int);
+  itkGetConstMacro(StochasticSamplingSeed, int);
+
   /** Set/Get the gradient filter */
   itkSetObjectMacro( FixedImageGradientFilter, FixedImageGradientFilterType );
   itkGetModifiableObjectMacro(FixedImageGradientFilter, FixedImageGradientFilterType );
@@ -487,8 +543,8 @@ public:
 
   /** Get the number of points in the domain used to evaluate
    * the metric. This will differ depending on whether a sampled
-   * point set or dense sampling is used, and will be greater than
-   * or equal to GetNumberOfValidPoints(). */
+   * point set, dense sampling or stochastic sampling is used, and will
+   * be greater than or equal to GetNumberOfValidPoints(). */
   SizeValueType GetNumberOfDomainPoints() const;
 
   /** Set/Get the option for applying floating point resolution truncation
@@ -583,6 +639,27 @@ protected:
    * a registration loop. */
   virtual void InitializeForIteration() const;
 
+  /** Compute the fixed sample cache when UseFixedSampleCache is on and the
+   * cache is out of date, and set whether the current evaluation uses it.
+   * Called by InitializeForIteration. */
+  virtual void UpdateFixedSampleCache() const;
+
+  /** Draw new stochastic samples when stochastic sampling is on and the
+   * sampling interval has elapsed. Called by InitializeForIteration. */
+  virtual void UpdateStochasticSamples() const;
+
+  /** Whether the evaluation iterates over a list of points, the
+   * stochastic samples or the virtual sampled point set, with the sparse
+   * threaders, rather than over the virtual region. */
+  bool GetUseSparseSampling() const
+    {
+    return this->m_UseFixedSampledPointSet || this->m_NumberOfStochasticSamples > 0;
+    }
+
+  /** Get the number of points of the domain the metric samples from: the
+   * points of the virtual sampled point set, or of the virtual region. */
+  SizeValueType GetNumberOfCandidatePoints() const;
+
   /**
    * Transform a point from VirtualImage domain to FixedImage domain and evaluate.
    * This function also checks if mapped point is within the mask if
@@ -692,6 +769,33 @@ protected:
   /** Flag to use FixedSampledPointSet, i.e. Sparse sampling. */
   bool                                    m_UseFixedSampledPointSet;
 
+  /** Fixed sample cache, stored as one array per quantity and indexed by
+   * the position of the point in the domain: the offset in the virtual
+   * region for dense sampling, or the point identifier in the virtual
+   * sampled point set. The virtual indices are only stored for sparse
+   * sampling, and the gradients only when the gradient source includes
+   * the fixed image. */
+  bool                                       m_UseFixedSampleCache;
+  mutable bool                               m_FixedSampleCacheIsActive;
+  mutable ModifiedTimeType                   m_FixedSampleCacheTime;
+  mutable std::vector<VirtualPointType>       m_FixedSampleCacheVirtualPoints;
+  mutable std::vector<VirtualIndexType>       m_FixedSampleCacheVirtualIndices;
+  mutable std::vector<FixedImagePointType>    m_FixedSampleCacheMappedPoints;
+  mutable std::vector<FixedImagePixelType>    m_FixedSampleCachePixelValues;
+  mutable std::vector<FixedImageGradientType> m_FixedSampleCacheGradients;
+  mutable std::vector<bool>                   m_FixedSampleCacheValidity;
+
+  /** Stochastic samples of the current evaluation. The identifiers are the
+   * positions of the points among the candidate points, as used to index
+   * the fixed sample cache. */
+  SizeValueType                              m_NumberOfStochasticSamples;
+  SizeValueType                              m_StochasticSamplingInterval;
+  int                                        m_StochasticSamplingSeed;
+  mutable SizeValueType                      m_StochasticSamplingEvaluationCount;
+  mutable std::vector<SizeValueType>         m_StochasticSampleIdentifiers;
+  mutable std::vector<VirtualPointType>      m_StochasticSampleVirtualPoints;
+  mutable std::vector<VirtualIndexType>      m_StochasticSampleVirtualIndices;
+
   ImageToImageMetricv4();
   virtual ~ImageToImageMetricv4();
 
@@ -701,6 +805,22 @@ private:
   /** Map the fixed point set samples to the virtual domain */
   void MapFixedSampledPointSetToVirtual();
 
+  /** Latest modification time of the objects the fixed sample cache
+   * depends on. */
+  ModifiedTimeType GetFixedSampleCacheDependenciesMTime() const;
+
+  /** Data passed to the threads drawing the stochastic samples. */
+  struct StochasticSamplingThreadStruct
+    {
+    const Self *  Metric;
+    SizeValueType NumberOfCandidatePoints;
+    SizeValueType BlockSize;
+    SizeValueType Draw;
+    };
+
+  /** Draw the stochastic samples of the blocks assigned to a thread. */
+  static ITK_THREAD_RETURN_TYPE StochasticSamplingThreaderCallback( void * arg );
+
   /** Transform a point. Avoid cast if possible */
   void LocalTransformPoint(const typename FixedTransformType::OutputPointType &virtualPoint,
                            typename FixedTransformType::OutputPointType &mappedFixedPoint) const
@@ -24,6 +24,8 @@
 #include "itkCompositeTransform.h"
 #include "itkLinearInterpolateImageFunction.h"
 #include "itkIdentityTransform.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
 
 namespace itk
 {
@@ -67,6 +69,15 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
   this->m_UseMovingImageGradientFilter = true;
   this->m_UseFixedSampledPointSet      = false;
 
+  this->m_UseFixedSampleCache      = false;
+  this->m_FixedSampleCacheIsActive = false;
+  this->m_FixedSampleCacheTime     = 0;
+
+  this->m_NumberOfStochasticSamples         = 0;
+  this->m_StochasticSamplingInterval        = 1;
+  this->m_StochasticSamplingSeed            = Statistics::MersenneTwisterRandomVariateGenerator::GetNextSeed();
+  this->m_StochasticSamplingEvaluationCount = 0;
+
   this->m_FloatingPointCorrectionResolution = 1e6;
   this->m_UseFloatingPointCorrection = false;
 
@@ -152,6 +163,9 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     this->MapFixedSampledPointSetToVirtual();
     }
 
+  /* Draw new stochastic samples at the next evaluation. */
+  this->m_StochasticSamplingEvaluationCount = 0;
+
   /* Inititialize interpolators. */
   itkDebugMacro("Initialize Interpolators");
   this->m_FixedInterpolator->SetInputImage( this->m_FixedImage );
@@ -246,7 +260,7 @@ void
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::GetValueAndDerivativeExecute() const
 {
-  if( this->m_UseFixedSampledPointSet ) // sparse sampling
+  if( this->GetUseSparseSampling() ) // sparse or stochastic sampling
     {
     SizeValueType numberOfPoints = this->GetNumberOfDomainPoints();
     if( numberOfPoints < 1 )
@@ -280,6 +294,217 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
     /* Clear derivative final result. */
     this->m_DerivativeResult->Fill( NumericTraits< DerivativeValueType >::ZeroValue() );
     }
+
+  this->UpdateFixedSampleCache();
+  this->UpdateStochasticSamples();
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+ModifiedTimeType
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::GetFixedSampleCacheDependenciesMTime() const
+{
+  ModifiedTimeType mtime = this->GetMTime();
+  mtime = std::max( mtime, this->m_FixedImage->GetMTime() );
+  mtime = std::max( mtime, this->m_FixedTransform->GetMTime() );
+  mtime = std::max( mtime, this->m_FixedInterpolator->GetMTime() );
+  mtime = std::max( mtime, this->m_VirtualImage->GetMTime() );
+  if( this->m_FixedImageMask )
+    {
+    mtime = std::max( mtime, this->m_FixedImageMask->GetMTime() );
+    }
+  if( this->m_UseFixedSampledPointSet )
+    {
+    mtime = std::max( mtime, this->m_VirtualSampledPointSet->GetMTime() );
+    }
+  if( this->GetGradientSourceIncludesFixed() )
+    {
+    if( this->m_UseFixedImageGradientFilter )
+      {
+      mtime = std::max( mtime, this->m_FixedImageGradientImage->GetMTime() );
+      }
+    else
+      {
+      mtime = std::max( mtime, this->m_FixedImageGradientCalculator->GetMTime() );
+      }
+    }
+  return mtime;
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::UpdateFixedSampleCache() const
+{
+  if( ! this->m_UseFixedSampleCache )
+    {
+    this->m_FixedSampleCacheIsActive = false;
+    this->m_FixedSampleCacheVirtualPoints.clear();
+    this->m_FixedSampleCacheVirtualIndices.clear();
+    this->m_FixedSampleCacheMappedPoints.clear();
+    this->m_FixedSampleCachePixelValues.clear();
+    this->m_FixedSampleCacheGradients.clear();
+    this->m_FixedSampleCacheValidity.clear();
+    return;
+    }
+
+  const ModifiedTimeType dependenciesMTime = this->GetFixedSampleCacheDependenciesMTime();
+  const SizeValueType    numberOfPoints = this->GetNumberOfCandidatePoints();
+  if( this->m_FixedSampleCacheIsActive
+      && dependenciesMTime <= this->m_FixedSampleCacheTime
+      && this->m_FixedSampleCacheValidity.size() == numberOfPoints )
+    {
+    return;
+    }
+
+  const bool cacheGradients = this->GetGradientSourceIncludesFixed();
+
+  this->m_FixedSampleCacheVirtualPoints.resize( numberOfPoints );
+  this->m_FixedSampleCacheMappedPoints.resize( numberOfPoints );
+  this->m_FixedSampleCachePixelValues.resize( numberOfPoints );
+  this->m_FixedSampleCacheValidity.assign( numberOfPoints, false );
+  this->m_FixedSampleCacheGradients.resize( cacheGradients ? numberOfPoints : 0 );
+  this->m_FixedSampleCacheVirtualIndices.resize( this->m_UseFixedSampledPointSet ? numberOfPoints : 0 );
+
+  if( this->m_UseFixedSampledPointSet )
+    {
+    for( SizeValueType i = 0; i < numberOfPoints; ++i )
+      {
+      this->m_FixedSampleCacheVirtualPoints[i] = this->m_VirtualSampledPointSet->GetPoint( i );
+      this->m_VirtualImage->TransformPhysicalPointToIndex( this->m_FixedSampleCacheVirtualPoints[i],
+                                                           this->m_FixedSampleCacheVirtualIndices[i] );
+      }
+    }
+  else
+    {
+    /* Same order as ImageRegionConstIteratorWithIndex over the virtual region. */
+    typedef ImageRegionConstIteratorWithIndex< VirtualImageType > IteratorType;
+    SizeValueType i = 0;
+    for( IteratorType it( this->m_VirtualImage, this->GetVirtualRegion() ); !it.IsAtEnd(); ++it, ++i )
+      {
+      this->m_VirtualImage->TransformIndexToPhysicalPoint( it.GetIndex(), this->m_FixedSampleCacheVirtualPoints[i] );
+      }
+    }
+
+  for( SizeValueType i = 0; i < numberOfPoints; ++i )
+    {
+    const bool pointIsValid = this->TransformAndEvaluateFixedPoint( this->m_FixedSampleCacheVirtualPoints[i],
+                                                                    this->m_FixedSampleCacheMappedPoints[i],
+                                                                    this->m_FixedSampleCachePixelValues[i] );
+    this->m_FixedSampleCacheValidity[i] = pointIsValid;
+    if( pointIsValid && cacheGradients )
+      {
+      this->ComputeFixedImageGradientAtPoint( this->m_FixedSampleCacheMappedPoints[i],
+                                              this->m_FixedSampleCacheGradients[i] );
+      }
+    }
+
+  this->m_FixedSampleCacheTime = dependenciesMTime;
+  this->m_FixedSampleCacheIsActive = true;
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::UpdateStochasticSamples() const
+{
+  if( this->m_NumberOfStochasticSamples == 0 )
+    {
+    this->m_StochasticSampleIdentifiers.clear();
+    this->m_StochasticSampleVirtualPoints.clear();
+    this->m_StochasticSampleVirtualIndices.clear();
+    return;
+    }
+
+  const SizeValueType evaluation = this->m_StochasticSamplingEvaluationCount++;
+  if( evaluation % this->m_StochasticSamplingInterval != 0
+      && this->m_StochasticSampleIdentifiers.size() == this->m_NumberOfStochasticSamples )
+    {
+    return;
+    }
+
+  const SizeValueType numberOfCandidatePoints = this->GetNumberOfCandidatePoints();
+  if( numberOfCandidatePoints < 1 )
+    {
+    itkExceptionMacro("There are no candidate points to draw the stochastic samples from.");
+    }
+
+  this->m_StochasticSampleIdentifiers.resize( this->m_NumberOfStochasticSamples );
+  this->m_StochasticSampleVirtualPoints.resize( this->m_NumberOfStochasticSamples );
+  this->m_StochasticSampleVirtualIndices.resize( this->m_NumberOfStochasticSamples );
+
+  StochasticSamplingThreadStruct str;
+  str.Metric = this;
+  str.NumberOfCandidatePoints = numberOfCandidatePoints;
+  str.BlockSize = 4096;
+  str.Draw = evaluation / this->m_StochasticSamplingInterval;
+
+  MultiThreader * multiThreader = this->m_SparseGetValueAndDerivativeThreader->GetMultiThreader();
+  multiThreader->SetSingleMethod( Self::StochasticSamplingThreaderCallback, &str );
+  multiThreader->SingleMethodExecute();
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+ITK_THREAD_RETURN_TYPE
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::StochasticSamplingThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const StochasticSamplingThreadStruct * str = static_cast< StochasticSamplingThreadStruct * >( info->UserData );
+  const Self * metric = str->Metric;
+
+  typedef Statistics::MersenneTwisterRandomVariateGenerator RandomizerType;
+  typename RandomizerType::Pointer randomizer = RandomizerType::New();
+  const typename RandomizerType::IntegerType largestIdentifier =
+    static_cast< typename RandomizerType::IntegerType >( str->NumberOfCandidatePoints - 1 );
+
+  const VirtualImageType *         virtualImage = metric->m_VirtualImage;
+  const VirtualRegionType          virtualRegion = metric->GetVirtualRegion();
+  const SizeValueType              numberOfSamples = metric->m_NumberOfStochasticSamples;
+  const SizeValueType              numberOfBlocks = ( numberOfSamples + str->BlockSize - 1 ) / str->BlockSize;
+
+  /* Blocks are assigned round robin, each one with its own generator stream. */
+  for( SizeValueType block = info->ThreadID; block < numberOfBlocks; block += info->NumberOfThreads )
+    {
+    randomizer->SetSeed( static_cast< typename RandomizerType::IntegerType >(
+                           metric->m_StochasticSamplingSeed + str->Draw * numberOfBlocks + block ) );
+    const SizeValueType end = std::min( numberOfSamples, ( block + 1 ) * str->BlockSize );
+    for( SizeValueType i = block * str->BlockSize; i < end; ++i )
+      {
+      const SizeValueType identifier = randomizer->GetIntegerVariate( largestIdentifier );
+      metric->m_StochasticSampleIdentifiers[i] = identifier;
+      if( metric->m_FixedSampleCacheIsActive )
+        {
+        metric->m_StochasticSampleVirtualPoints[i] = metric->m_FixedSampleCacheVirtualPoints[identifier];
+        }
+      else if( metric->m_UseFixedSampledPointSet )
+        {
+        metric->m_StochasticSampleVirtualPoints[i] = metric->m_VirtualSampledPointSet->GetPoint( identifier );
+        }
+      if( metric->m_UseFixedSampledPointSet )
+        {
+        virtualImage->TransformPhysicalPointToIndex( metric->m_StochasticSampleVirtualPoints[i],
+                                                     metric->m_StochasticSampleVirtualIndices[i] );
+        }
+      else
+        {
+        /* Same order as ImageRegionConstIteratorWithIndex over the virtual region. */
+        VirtualIndexType & virtualIndex = metric->m_StochasticSampleVirtualIndices[i];
+        SizeValueType offset = identifier;
+        for( unsigned int d = 0; d < VirtualImageDimension; ++d )
+          {
+          virtualIndex[d] = virtualRegion.GetIndex(d) + static_cast< IndexValueType >( offset % virtualRegion.GetSize(d) );
+          offset /= virtualRegion.GetSize(d);
+          }
+        if( ! metric->m_FixedSampleCacheIsActive )
+          {
+          virtualImage->TransformIndexToPhysicalPoint( virtualIndex, metric->m_StochasticSampleVirtualPoints[i] );
+          }
+        }
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
 }
 
 template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
@@ -494,7 +719,7 @@ ThreadIdType
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::GetMaximumNumberOfThreads() const
 {
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseSparseSampling() )
     {
     return this->m_SparseGetValueAndDerivativeThreader->GetMaximumNumberOfThreads();
     }
@@ -506,7 +731,7 @@ ThreadIdType
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::GetNumberOfThreadsUsed() const
 {
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseSparseSampling() )
     {
     return this->m_SparseGetValueAndDerivativeThreader->GetNumberOfThreadsUsed();
     }
@@ -572,6 +797,18 @@ template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, type
 SizeValueType
 ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
 ::GetNumberOfDomainPoints() const
+{
+  if( this->m_NumberOfStochasticSamples > 0 )
+    {
+    return this->m_NumberOfStochasticSamples;
+    }
+  return this->GetNumberOfCandidatePoints();
+}
+
+template<typename TFixedImage,typename TMovingImage,typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+SizeValueType
+ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputationValueType, TMetricTraits>
+::GetNumberOfCandidatePoints() const
 {
   if( this->m_UseFixedSampledPointSet )
     {
@@ -597,7 +834,11 @@ ImageToImageMetricv4<TFixedImage, TMovingImage, TVirtualImage, TInternalComputat
      << indent << "GetUseFixedImageGradientFilter: " << this->GetUseFixedImageGradientFilter() << std::endl
      << indent << "GetUseMovingImageGradientFilter: " << this->GetUseMovingImageGradientFilter() << std::endl
      << indent << "UseFloatingPointCorrection: " << this->GetUseFloatingPointCorrection() << std::endl
-     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl;
+     << indent << "FloatingPointCorrectionResolution: " << this->GetFloatingPointCorrectionResolution() << std::endl
+     << indent << "UseFixedSampleCache: " << this->GetUseFixedSampleCache() << std::endl
+     << indent << "NumberOfStochasticSamples: " << this->GetNumberOfStochasticSamples() << std::endl
+     << indent << "StochasticSamplingInterval: " << this->GetStochasticSamplingInterval() << std::endl
+     << indent << "StochasticSamplingSeed: " << this->GetStochasticSamplingSeed() << std::endl;
 
   itkPrintSelfObjectMacro( FixedImage );
   itkPrintSelfObjectMacro( MovingImage );
@@ -33,11 +33,32 @@ ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedImageRegionPartitione
   typename VirtualImageType::ConstPointer virtualImage = this->m_Associate->GetVirtualImage();
   typedef ImageRegionConstIteratorWithIndex< VirtualImageType > IteratorType;
   VirtualPointType virtualPoint;
-  for( IteratorType it( virtualImage, imageSubRegion ); !it.IsAtEnd(); ++it )
+  if( this->m_Associate->m_FixedSampleCacheIsActive )
     {
-    const VirtualIndexType & virtualIndex = it.GetIndex();
-    virtualImage->TransformIndexToPhysicalPoint( virtualIndex, virtualPoint );
-    this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+    /* The cache is ordered as the points of the whole virtual region. */
+    const typename VirtualImageType::RegionType virtualRegion = this->m_Associate->GetVirtualRegion();
+    SizeValueType & cacheIndex = this->m_GetValueAndDerivativePerThreadVariables[threadId].FixedSampleCacheIndex;
+    for( IteratorType it( virtualImage, imageSubRegion ); !it.IsAtEnd(); ++it )
+      {
+      const VirtualIndexType & virtualIndex = it.GetIndex();
+      cacheIndex = 0;
+      SizeValueType stride = 1;
+      for( unsigned int d = 0; d < VirtualImageType::ImageDimension; ++d )
+        {
+        cacheIndex += static_cast< SizeValueType >( virtualIndex[d] - virtualRegion.GetIndex(d) ) * stride;
+        stride *= virtualRegion.GetSize(d);
+        }
+      this->ProcessVirtualPoint( virtualIndex, this->m_Associate->m_FixedSampleCacheVirtualPoints[cacheIndex], threadId );
+      }
+    }
+  else
+    {
+    for( IteratorType it( virtualImage, imageSubRegion ); !it.IsAtEnd(); ++it )
+      {
+      const VirtualIndexType & virtualIndex = it.GetIndex();
+      virtualImage->TransformIndexToPhysicalPoint( virtualIndex, virtualPoint );
+      this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+      }
     }
   //Finalize per thread actions
   this->m_Associate->FinalizeThread( threadId );
@@ -55,11 +76,34 @@ ImageToImageMetricv4GetValueAndDerivativeThreader< ThreadedIndexedContainerParti
   const ElementIdentifierType end   = indexSubRange[1];
   VirtualIndexType virtualIndex;
   typename VirtualImageType::ConstPointer virtualImage = this->m_Associate->GetVirtualImage();
-  for( ElementIdentifierType i = begin; i <= end; ++i )
+  if( this->m_Associate->m_NumberOfStochasticSamples > 0 )
+    {
+    /* The stochastic samples index the fixed sample cache through their identifiers. */
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].FixedSampleCacheIndex =
+        this->m_Associate->m_StochasticSampleIdentifiers[i];
+      this->ProcessVirtualPoint( this->m_Associate->m_StochasticSampleVirtualIndices[i],
+                                 this->m_Associate->m_StochasticSampleVirtualPoints[i], threadId );
+      }
+    }
+  else if( this->m_Associate->m_FixedSampleCacheIsActive )
+    {
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      this->m_GetValueAndDerivativePerThreadVariables[threadId].FixedSampleCacheIndex = i;
+      this->ProcessVirtualPoint( this->m_Associate->m_FixedSampleCacheVirtualIndices[i],
+                                 this->m_Associate->m_FixedSampleCacheVirtualPoints[i], threadId );
+      }
+    }
+  else
     {
-    const VirtualPointType & virtualPoint = virtualSampledPointSet->GetPoint( i );
-    virtualImage->TransformPhysicalPointToIndex( virtualPoint, virtualIndex );
-    this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      const VirtualPointType & virtualPoint = virtualSampledPointSet->GetPoint( i );
+      virtualImage->TransformPhysicalPointToIndex( virtualPoint, virtualIndex );
+      this->ProcessVirtualPoint( virtualIndex, virtualPoint, threadId );
+      }
     }
   //Finalize per thread actions
   this->m_Associate->FinalizeThread( threadId );
@@ -108,6 +108,8 @@ protected:
   /** Method called by the threaders to process the given virtual point.  This
    * in turn calls \c TransformAndEvaluateFixedPoint, \c
    * TransformAndEvaluateMovingPoint, and \c ProcessPoint.
+   * When the metric uses its fixed sample cache, the fixed point, value and
+   * gradient are read from the cache instead.
    * And adds entries to m_MeasurePerThread and m_LocalDerivativesPerThread,
    * m_NumberOfValidPointsPerThread. */
   virtual bool ProcessVirtualPoint( const VirtualIndexType & virtualIndex,
@@ -178,6 +180,9 @@ protected:
      * classes for efficiency. */
     JacobianType                 MovingTransformJacobian;
     JacobianType                 MovingTransformJacobianPositional;
+    /** Position in the fixed sample cache of the point being processed,
+     * set by ThreadedExecution when the metric uses the cache. */
+    SizeValueType                FixedSampleCacheIndex;
     };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, GetValueAndDerivativePerThreadStruct,
                                             PaddedGetValueAndDerivativePerThreadStruct);
@@ -189,26 +189,44 @@ ImageToImageMetricv4GetValueAndDerivativeThreaderBase< TDomainPartitioner, TImag
   bool                        pointIsValid = false;
   MeasureType                 metricValueResult;
 
-  /* Transform the point into fixed and moving spaces, and evaluate.
-   * Do this in a try block to catch exceptions and print more useful info
-   * then we otherwise get when exceptions are caught in MultiThreader. */
-  try
+  if( this->m_Associate->m_FixedSampleCacheIsActive )
     {
-    pointIsValid = this->m_Associate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, mappedFixedPixelValue);
-    if( pointIsValid &&
-        this->m_Associate->GetComputeDerivative() &&
-        this->m_Associate->GetGradientSourceIncludesFixed() )
+    const SizeValueType cacheIndex = this->m_GetValueAndDerivativePerThreadVariables[threadId].FixedSampleCacheIndex;
+    pointIsValid = this->m_Associate->m_FixedSampleCacheValidity[cacheIndex];
+    if( pointIsValid )
       {
-      this->m_Associate->ComputeFixedImageGradientAtPoint( mappedFixedPoint, mappedFixedImageGradient );
+      mappedFixedPoint = this->m_Associate->m_FixedSampleCacheMappedPoints[cacheIndex];
+      mappedFixedPixelValue = this->m_Associate->m_FixedSampleCachePixelValues[cacheIndex];
+      if( this->m_Associate->GetComputeDerivative() &&
+          this->m_Associate->GetGradientSourceIncludesFixed() )
+        {
+        mappedFixedImageGradient = this->m_Associate->m_FixedSampleCacheGradients[cacheIndex];
+        }
       }
     }
-  catch( ExceptionObject & exc )
+  else
     {
-    //NOTE: there must be a cleaner way to do this:
-    std::string msg("Caught exception: \n");
-    msg += exc.what();
-    ExceptionObject err(__FILE__, __LINE__, msg);
-    throw err;
+    /* Transform the point into fixed and moving spaces, and evaluate.
+     * Do this in a try block to catch exceptions and print more useful info
+     * then we otherwise get when exceptions are caught in MultiThreader. */
+    try
+      {
+      pointIsValid = this->m_Associate->TransformAndEvaluateFixedPoint( virtualPoint, mappedFixedPoint, mappedFixedPixelValue);
+      if( pointIsValid &&
+          this->m_Associate->GetComputeDerivative() &&
+          this->m_Associate->GetGradientSourceIncludesFixed() )
+        {
+        this->m_Associate->ComputeFixedImageGradientAtPoint( mappedFixedPoint, mappedFixedImageGradient );
+        }
+      }
+    catch( ExceptionObject & exc )
+      {
+      //NOTE: there must be a cleaner way to do this:
+      std::string msg("Caught exception: \n");
+      msg += exc.what();
+      ExceptionObject err(__FILE__, __LINE__, msg);
+      throw err;
+      }
     }
   if( !pointIsValid )
     {
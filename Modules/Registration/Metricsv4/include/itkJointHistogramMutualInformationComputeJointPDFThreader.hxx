@@ -53,6 +53,15 @@ JointHistogramMutualInformationComputeJointPDFThreader< ThreadedIndexedContainer
   typedef typename VirtualPointSetType::MeshTraits::PointIdentifier ElementIdentifierType;
   const ElementIdentifierType begin = indexSubRange[0];
   const ElementIdentifierType end   = indexSubRange[1];
+  if( this->m_Associate->m_NumberOfStochasticSamples > 0 )
+    {
+    for( ElementIdentifierType i = begin; i <= end; ++i )
+      {
+      this->ProcessPoint( this->m_Associate->m_StochasticSampleVirtualIndices[i],
+                          this->m_Associate->m_StochasticSampleVirtualPoints[i], threadId );
+      }
+    return;
+    }
   for( ElementIdentifierType i = begin; i <= end; ++i )
     {
     virtualPoint = this->m_Associate->m_VirtualSampledPointSet->GetPoint( i );
@@ -20,6 +20,7 @@
 
 #include "itkDomainThreader.h"
 #include "itkImage.h"
+#include <vector>
 
 namespace itk
 {
@@ -30,6 +31,12 @@ namespace itk
  * This is a helper to compute the joint pdf image for the
  * JointHistogramMutualInformationImageToImageMetricv4.
  *
+ * Each thread counts its samples in a flat histogram laid out like the
+ * buffer of the joint pdf, with the bin of a sample computed directly from
+ * the origin and spacing of the joint pdf. The per-thread histograms are
+ * then summed and normalized into the joint pdf, in parallel when the
+ * histograms are large enough.
+ *
  * \ingroup ITKMetricsv4
  */
 template < typename TDomainPartitioner, typename TJointHistogramMetric >
@@ -56,6 +63,7 @@ public:
   typedef typename JointHistogramMetricType::VirtualPointType  VirtualPointType;
   typedef typename JointHistogramMetricType::JointPDFType      JointPDFType;
   typedef typename JointHistogramMetricType::JointPDFIndexType JointPDFIndexType;
+  typedef typename JointHistogramMetricType::JointPDFIndexValueType JointPDFIndexValueType;
   typedef typename JointHistogramMetricType::JointPDFPointType JointPDFPointType;
   typedef typename JointHistogramMetricType::JointPDFValueType JointPDFValueType;
 
@@ -76,12 +84,27 @@ protected:
   /** Collect the results per and normalize. */
   virtual void AfterThreadedExecution() ITK_OVERRIDE;
 
-  typedef Image< SizeValueType, 2 >                   JointHistogramType;
-  //TODO: This needs updating
+  /** Sum the per-thread histograms over the bins [begin, end) of the joint
+   * pdf buffer, and normalize them by the total count. */
+  void ReduceJointHistograms( SizeValueType begin, SizeValueType end );
+
+  /** Data passed to the threads reducing the per-thread histograms. */
+  struct JointHistogramReductionStruct
+    {
+    Self *        Threader;
+    SizeValueType Size;
+    };
+
+  /** Reduce a contiguous part of the per-thread histograms. */
+  static ITK_THREAD_RETURN_TYPE ReduceJointHistogramsThreaderCallback( void * arg );
+
+  /** Flat histogram, in the buffer order of the joint pdf. */
+  typedef std::vector< SizeValueType > JointHistogramType;
+
   struct JointHistogramMIPerThreadStruct
     {
-    typename JointHistogramType::Pointer JointHistogram;
-    SizeValueType                        JointHistogramCount;
+    JointHistogramType JointHistogram;
+    SizeValueType      JointHistogramCount;
     };
   itkPadStruct( ITK_CACHE_LINE_ALIGNMENT, JointHistogramMIPerThreadStruct,
                                             PaddedJointHistogramMIPerThreadStruct);
@@ -89,6 +112,12 @@ protected:
                                                AlignedJointHistogramMIPerThreadStruct );
   AlignedJointHistogramMIPerThreadStruct * m_JointHistogramMIPerThreadVariables;
 
+  /** Geometry of the joint pdf, cached before the threaded execution to
+   * compute the histogram bins. */
+  JointPDFPointType m_JointPDFOrigin;
+  JointPDFPointType m_JointPDFInverseSpacing;
+  SizeValueType     m_JointPDFSize[2];
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(JointHistogramMutualInformationComputeJointPDFThreaderBase);
 };
@@ -20,7 +20,7 @@
 
 #include "itkJointHistogramMutualInformationComputeJointPDFThreaderBase.h"
 
-#include "itkImageRegionIterator.h"
+#include "itkMath.h"
 
 namespace itk
 {
@@ -44,19 +44,22 @@ void
 JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
 ::BeforeThreadedExecution()
 {
+  const JointPDFType * jointPDF = this->m_Associate->m_JointPDF;
+  const typename JointPDFType::SizeType & jointPDFSize = jointPDF->GetBufferedRegion().GetSize();
+  for( unsigned int d = 0; d < 2; ++d )
+    {
+    this->m_JointPDFOrigin[d] = jointPDF->GetOrigin()[d];
+    this->m_JointPDFInverseSpacing[d] = 1.0 / jointPDF->GetSpacing()[d];
+    this->m_JointPDFSize[d] = jointPDFSize[d];
+    }
+  const SizeValueType numberOfBins = this->m_JointPDFSize[0] * this->m_JointPDFSize[1];
+
   const ThreadIdType numThreadsUsed = this->GetNumberOfThreadsUsed();
   delete[] this->m_JointHistogramMIPerThreadVariables;
   this->m_JointHistogramMIPerThreadVariables = new AlignedJointHistogramMIPerThreadStruct[ numThreadsUsed ];
   for( ThreadIdType i = 0; i < numThreadsUsed; ++i )
     {
-    if( this->m_JointHistogramMIPerThreadVariables[i].JointHistogram.IsNull() )
-      {
-      this->m_JointHistogramMIPerThreadVariables[i].JointHistogram = JointHistogramType::New();
-      }
-    this->m_JointHistogramMIPerThreadVariables[i].JointHistogram->CopyInformation( this->m_Associate->m_JointPDF );
-    this->m_JointHistogramMIPerThreadVariables[i].JointHistogram->SetRegions( this->m_Associate->m_JointPDF->GetLargestPossibleRegion() );
-    this->m_JointHistogramMIPerThreadVariables[i].JointHistogram->Allocate();
-    this->m_JointHistogramMIPerThreadVariables[i].JointHistogram->FillBuffer( NumericTraits< SizeValueType >::ZeroValue() );
+    this->m_JointHistogramMIPerThreadVariables[i].JointHistogram.assign( numberOfBins, NumericTraits< SizeValueType >::ZeroValue() );
     this->m_JointHistogramMIPerThreadVariables[i].JointHistogramCount = NumericTraits< SizeValueType >::ZeroValue();
     }
 }
@@ -98,16 +101,24 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
     {
     JointPDFPointType jointPDFpoint;
     this->m_Associate->ComputeJointPDFPoint( fixedImageValue, movingImageValue, jointPDFpoint );
-    JointPDFIndexType jointPDFIndex;
-    this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->TransformPhysicalPointToIndex( jointPDFpoint, jointPDFIndex );
-    if( this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->GetBufferedRegion().IsInside( jointPDFIndex ) )
+    // Round to the nearest bin as TransformPhysicalPointToIndex does. The
+    // range is checked before the rounding, which also rejects NaN values.
+    SizeValueType offset = 0;
+    SizeValueType stride = 1;
+    for( unsigned int d = 0; d < 2; ++d )
       {
-      typename JointHistogramType::PixelType jointHistogramPixel;
-      jointHistogramPixel = this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->GetPixel( jointPDFIndex );
-      jointHistogramPixel++;
-      this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram->SetPixel( jointPDFIndex, jointHistogramPixel );
-      this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogramCount++;
+      const typename JointPDFPointType::ValueType continuousIndex =
+        ( jointPDFpoint[d] - this->m_JointPDFOrigin[d] ) * this->m_JointPDFInverseSpacing[d];
+      if( !( continuousIndex >= -0.5 && continuousIndex < this->m_JointPDFSize[d] - 0.5 ) )
+        {
+        return;
+        }
+      const JointPDFIndexValueType index = Math::RoundHalfIntegerUp< JointPDFIndexValueType >( continuousIndex );
+      offset += static_cast< SizeValueType >( index ) * stride;
+      stride *= this->m_JointPDFSize[d];
       }
+    ++this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogram[offset];
+    ++this->m_JointHistogramMIPerThreadVariables[threadId].JointHistogramCount;
     }
 }
 
@@ -118,7 +129,6 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
 {
   const ThreadIdType numberOfThreadsUsed = this->GetNumberOfThreadsUsed();
 
-  typedef typename JointHistogramType::PixelType JointHistogramPixelType;
   this->m_Associate->m_JointHistogramTotalCount = NumericTraits<SizeValueType>::ZeroValue();
   for( ThreadIdType i = 0; i < numberOfThreadsUsed; ++i )
     {
@@ -131,32 +141,61 @@ JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner,
     return;
     }
 
-  typedef ImageRegionIterator< JointPDFType > JointPDFIteratorType;
-  JointPDFIteratorType jointPDFIt( this->m_Associate->m_JointPDF, this->m_Associate->m_JointPDF->GetBufferedRegion() );
-  jointPDFIt.GoToBegin();
-  typedef ImageRegionConstIterator< JointHistogramType > JointHistogramIteratorType;
-  std::vector< JointHistogramIteratorType > jointHistogramPerThreadIts;
-  for( ThreadIdType i = 0; i < numberOfThreadsUsed; ++i )
+  // Reduce in parallel only when the histograms are large enough to pay
+  // for starting the threads.
+  const SizeValueType numberOfBins = this->m_JointPDFSize[0] * this->m_JointPDFSize[1];
+  if( numberOfThreadsUsed > 1 && numberOfBins * numberOfThreadsUsed >= 65536 )
     {
-    jointHistogramPerThreadIts.push_back( JointHistogramIteratorType( this->m_JointHistogramMIPerThreadVariables[i].JointHistogram,
-        this->m_JointHistogramMIPerThreadVariables[i].JointHistogram->GetBufferedRegion() ) );
-    jointHistogramPerThreadIts[i].GoToBegin();
+    JointHistogramReductionStruct str;
+    str.Threader = this;
+    str.Size = numberOfBins;
+
+    MultiThreader * multiThreader = this->GetMultiThreader();
+    multiThreader->SetSingleMethod( Self::ReduceJointHistogramsThreaderCallback, &str );
+    multiThreader->SingleMethodExecute();
+    }
+  else
+    {
+    this->ReduceJointHistograms( 0, numberOfBins );
     }
+}
 
-  JointHistogramPixelType jointHistogramPixel;
-  while( !jointPDFIt.IsAtEnd() )
+template< typename TDomainPartitioner, typename TJointHistogramMetric >
+void
+JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
+::ReduceJointHistograms( SizeValueType begin, SizeValueType end )
+{
+  const ThreadIdType numberOfThreadsUsed = this->GetNumberOfThreadsUsed();
+  const JointPDFValueType totalCount = static_cast< JointPDFValueType >( this->m_Associate->m_JointHistogramTotalCount );
+  JointPDFValueType * const jointPDFPtr = this->m_Associate->m_JointPDF->GetBufferPointer();
+
+  for( SizeValueType bin = begin; bin < end; ++bin )
     {
-    jointHistogramPixel = NumericTraits< JointHistogramPixelType >::ZeroValue();
+    SizeValueType jointHistogramValue = NumericTraits< SizeValueType >::ZeroValue();
     for( ThreadIdType i = 0; i < numberOfThreadsUsed; ++i )
       {
-      jointHistogramPixel += jointHistogramPerThreadIts[i].Get();
-      ++jointHistogramPerThreadIts[i];
+      jointHistogramValue += this->m_JointHistogramMIPerThreadVariables[i].JointHistogram[bin];
       }
-    jointPDFIt.Set( static_cast< JointPDFValueType >( jointHistogramPixel ) / static_cast< JointPDFValueType >( this->m_Associate->m_JointHistogramTotalCount ) );
-    ++jointPDFIt;
+    jointPDFPtr[bin] = static_cast< JointPDFValueType >( jointHistogramValue ) / totalCount;
     }
 }
 
+template< typename TDomainPartitioner, typename TJointHistogramMetric >
+ITK_THREAD_RETURN_TYPE
+JointHistogramMutualInformationComputeJointPDFThreaderBase< TDomainPartitioner, TJointHistogramMetric >
+::ReduceJointHistogramsThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const JointHistogramReductionStruct * str = static_cast< JointHistogramReductionStruct * >( info->UserData );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+
+  str->Threader->ReduceJointHistograms( str->Size * threadId / threadCount,
+                                        str->Size * ( threadId + 1 ) / threadCount );
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 } // end namespace itk
 
 #endif
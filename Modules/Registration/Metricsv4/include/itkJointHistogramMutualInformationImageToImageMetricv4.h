@@ -157,6 +157,12 @@ protected:
   /** Compute the metric value. For internal use. */
   MeasureType ComputeValue() const;
 
+  /** Smooth the joint pdf in place with a separable discrete Gaussian
+   * kernel of variance \c VarianceForJointPDFSmoothing, in pixel units and
+   * with zero flux Neumann boundaries. This gives the result of
+   * DiscreteGaussianImageFilter without running an image pipeline. */
+  void SmoothJointPDF() const;
+
   /** Compute the point location with the JointPDF image.  Returns false if the
    * point is not inside the image. */
   inline void ComputeJointPDFPoint( const FixedImagePixelType fixedImageValue, const MovingImagePixelType movingImageValue, JointPDFPointType & jointPDFpoint ) const;
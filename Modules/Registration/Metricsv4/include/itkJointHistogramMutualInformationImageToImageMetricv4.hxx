@@ -21,7 +21,7 @@
 #include "itkCompensatedSummation.h"
 #include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
 #include "itkImageIterator.h"
-#include "itkDiscreteGaussianImageFilter.h"
+#include "itkGaussianOperator.h"
 
 namespace itk
 {
@@ -225,7 +225,7 @@ JointHistogramMutualInformationImageToImageMetricv4<TFixedImage,TMovingImage,TVi
   /**
    * First, we compute the joint histogram
    */
-  if( this->m_UseFixedSampledPointSet )
+  if( this->GetUseSparseSampling() )
     {
     SizeValueType numberOfPoints = this->GetNumberOfDomainPoints();
     if( numberOfPoints < 1 )
@@ -245,54 +245,86 @@ JointHistogramMutualInformationImageToImageMetricv4<TFixedImage,TMovingImage,TVi
   // Optionally smooth the joint pdf
   if (this->m_VarianceForJointPDFSmoothing > NumericTraits< JointPDFValueType >::ZeroValue() )
     {
-    typedef DiscreteGaussianImageFilter<JointPDFType,JointPDFType> DgType;
-    typename DgType::Pointer dg = DgType::New();
-    dg->SetInput(this->m_JointPDF);
-    dg->SetVariance(this->m_VarianceForJointPDFSmoothing);
-    dg->SetUseImageSpacingOff();
-    dg->SetMaximumError(.01f);
-    dg->Update();
-    this->m_JointPDF = ( dg->GetOutput() );
+    this->SmoothJointPDF();
     }
 
   // Compute moving image marginal PDF by summing over fixed image bins.
-  typedef ImageLinearIteratorWithIndex<JointPDFType> JointPDFLinearIterator;
-  JointPDFLinearIterator linearIter(m_JointPDF, m_JointPDF->GetBufferedRegion() );
-  linearIter.SetDirection( 0 );
-  linearIter.GoToBegin();
-  unsigned int fixedIndex = 0;
+  const SizeValueType numberOfBins0 = this->m_JointPDF->GetBufferedRegion().GetSize()[0];
+  const SizeValueType numberOfBins1 = this->m_JointPDF->GetBufferedRegion().GetSize()[1];
+  const JointPDFValueType * const jointPDFPtr = this->m_JointPDF->GetBufferPointer();
+  PDFValueType * const fixedImageMarginalPDFPtr = this->m_FixedImageMarginalPDF->GetBufferPointer();
+  PDFValueType * const movingImageMarginalPDFPtr = this->m_MovingImageMarginalPDF->GetBufferPointer();
   CompensatedSummation< TInternalComputationValueType > sum;
-  while( !linearIter.IsAtEnd() )
+  for( SizeValueType j = 0; j < numberOfBins1; ++j )
     {
     sum.ResetToZero();
-    while( !linearIter.IsAtEndOfLine() )
+    const JointPDFValueType * const line = jointPDFPtr + j * numberOfBins0;
+    for( SizeValueType i = 0; i < numberOfBins0; ++i )
       {
-      sum += linearIter.Get();
-      ++linearIter;
+      sum += line[i];
       }
-    MarginalPDFIndexType mind;
-    mind[0] = fixedIndex;
-    m_FixedImageMarginalPDF->SetPixel(mind,static_cast<PDFValueType>(sum.GetSum()));
-    linearIter.NextLine();
-    ++fixedIndex;
+    fixedImageMarginalPDFPtr[j] = static_cast<PDFValueType>(sum.GetSum());
     }
 
-  linearIter.SetDirection( 1 );
-  linearIter.GoToBegin();
-  unsigned int movingIndex = 0;
-  while( !linearIter.IsAtEnd() )
+  for( SizeValueType i = 0; i < numberOfBins0; ++i )
     {
     sum.ResetToZero();
-    while( !linearIter.IsAtEndOfLine() )
+    for( SizeValueType j = 0; j < numberOfBins1; ++j )
       {
-      sum += linearIter.Get();
-      ++linearIter;
+      sum += jointPDFPtr[i + j * numberOfBins0];
+      }
+    movingImageMarginalPDFPtr[i] = static_cast<PDFValueType>(sum.GetSum());
+    }
+}
+
+template <typename TFixedImage, typename TMovingImage, typename TVirtualImage, typename TInternalComputationValueType, typename TMetricTraits>
+void
+JointHistogramMutualInformationImageToImageMetricv4<TFixedImage,TMovingImage,TVirtualImage,TInternalComputationValueType, TMetricTraits>
+::SmoothJointPDF() const
+{
+  // Same kernel as DiscreteGaussianImageFilter with a maximum error of .01.
+  typedef typename NumericTraits< JointPDFValueType >::RealType RealType;
+  GaussianOperator< RealType, 1 > gaussianOperator;
+  gaussianOperator.SetVariance( this->m_VarianceForJointPDFSmoothing );
+  gaussianOperator.SetMaximumError( .01f );
+  gaussianOperator.SetMaximumKernelWidth( 32 );
+  gaussianOperator.CreateDirectional();
+  const OffsetValueType radius = static_cast< OffsetValueType >( gaussianOperator.GetRadius( 0 ) );
+  const OffsetValueType kernelSize = static_cast< OffsetValueType >( gaussianOperator.Size() );
+
+  const OffsetValueType size0 = static_cast< OffsetValueType >( this->m_JointPDF->GetBufferedRegion().GetSize()[0] );
+  const OffsetValueType size1 = static_cast< OffsetValueType >( this->m_JointPDF->GetBufferedRegion().GetSize()[1] );
+  JointPDFValueType * const jointPDFPtr = this->m_JointPDF->GetBufferPointer();
+
+  // Like DiscreteGaussianImageFilter, smooth along the last dimension first
+  // into a real valued buffer, then along the first one.
+  std::vector< RealType > smoothed( size0 * size1 );
+  for( OffsetValueType j = 0; j < size1; ++j )
+    {
+    for( OffsetValueType i = 0; i < size0; ++i )
+      {
+      RealType value = NumericTraits< RealType >::ZeroValue();
+      for( OffsetValueType k = 0; k < kernelSize; ++k )
+        {
+        const OffsetValueType jj = std::min( std::max( j + k - radius, OffsetValueType( 0 ) ), size1 - 1 );
+        value += gaussianOperator[k] * static_cast< RealType >( jointPDFPtr[i + jj * size0] );
+        }
+      smoothed[i + j * size0] = value;
+      }
+    }
+  for( OffsetValueType j = 0; j < size1; ++j )
+    {
+    const RealType * const line = &smoothed[j * size0];
+    for( OffsetValueType i = 0; i < size0; ++i )
+      {
+      RealType value = NumericTraits< RealType >::ZeroValue();
+      for( OffsetValueType k = 0; k < kernelSize; ++k )
+        {
+        const OffsetValueType ii = std::min( std::max( i + k - radius, OffsetValueType( 0 ) ), size0 - 1 );
+        value += gaussianOperator[k] * line[ii];
+        }
+      jointPDFPtr[i + j * size0] = static_cast< JointPDFValueType >( value );
       }
-    MarginalPDFIndexType mind;
-    mind[0] = movingIndex;
-    m_MovingImageMarginalPDF->SetPixel(mind,static_cast<PDFValueType>(sum.GetSum()));
-    linearIter.NextLine();
-    ++movingIndex;
     }
 }
 
@@ -64,8 +64,15 @@ namespace itk
  * \warning Local-support transforms are not yet supported. If used,
  * an exception is thrown during Initialize().
  *
- * \note The per-iteration post-processing code is not multi-threaded, but could be
- * readily be made so for a small performance gain.
+ * With a global-support transform, each thread accumulates the joint PDF
+ * derivatives into its own buffer, and the buffers are summed in parallel
+ * after the threaded execution. When these buffers would exceed
+ * MaximumThreaderJointPDFDerivativesSize elements, e.g. for a transform
+ * with many parameters, the threads instead share a single buffer that
+ * they update in batches under a lock.
+ *
+ * \note The rest of the per-iteration post-processing code is not
+ * multi-threaded, but could be readily be made so for a small performance gain.
  * See GetValueCommonAfterThreadedExecution(), GetValueAndDerivative()
  * and threader::AfterThreadedExecution().
  *
@@ -153,6 +160,13 @@ public:
   itkSetClampMacro( NumberOfHistogramBins, SizeValueType, 5, NumericTraits<SizeValueType>::max() );
   itkGetConstReferenceMacro(NumberOfHistogramBins, SizeValueType);
 
+  /** Maximum number of elements allocated for the per-thread joint PDF
+   * derivatives, summed over all the threads but the first one. Above it,
+   * the threads share the accumulation buffer of the first thread.
+   * Only used with global-support transforms. Default is 2^24. */
+  itkSetMacro(MaximumThreaderJointPDFDerivativesSize, SizeValueType);
+  itkGetConstMacro(MaximumThreaderJointPDFDerivativesSize, SizeValueType);
+
   virtual void Initialize(void) throw ( itk::ExceptionObject ) ITK_OVERRIDE;
 
   /** The marginal PDFs are stored as std::vector. */
@@ -340,6 +354,13 @@ private:
   SimpleFastMutexLock                       m_JointPDFDerivativesLock;
   typename JointPDFDerivativesType::Pointer m_JointPDFDerivatives;
 
+  /** Per-thread joint PDF derivatives, used instead of the derivative
+   * managers when m_UseThreaderJointPDFDerivatives is true. The first one
+   * is m_JointPDFDerivatives. */
+  typename std::vector<typename JointPDFDerivativesType::Pointer> m_ThreaderJointPDFDerivatives;
+  bool                                                            m_UseThreaderJointPDFDerivatives;
+  SizeValueType                                                   m_MaximumThreaderJointPDFDerivativesSize;
+
   PDFValueType m_JointPDFSum;
 
   /** Store the per-point local derivative result by parzen window bin.
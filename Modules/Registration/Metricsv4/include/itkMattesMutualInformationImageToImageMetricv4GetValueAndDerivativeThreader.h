@@ -118,6 +118,19 @@ protected:
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader);
 
+  /** Data passed to the threads reducing the per-thread joint PDF
+   * derivatives. */
+  struct JointPDFDerivativesReductionStruct
+    {
+    Self *        Threader;
+    PDFValueType  NormalizationFactor;
+    SizeValueType Size;
+    };
+
+  /** Sum a part of the per-thread joint PDF derivatives into the joint PDF
+   * derivatives of the metric, and normalize it. */
+  static ITK_THREAD_RETURN_TYPE ReduceJointPDFDerivativesThreaderCallback( void * arg );
+
   /** Internal pointer to the Mattes metric object in use by this threader.
    *  This will avoid costly dynamic casting in tight loops. */
   TMattesMutualInformationMetric * m_MattesAssociate;
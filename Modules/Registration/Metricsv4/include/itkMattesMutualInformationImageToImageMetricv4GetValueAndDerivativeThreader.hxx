@@ -212,25 +212,58 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
       // Initialize to zero for accumulation
       this->m_MattesAssociate->m_JointPDFDerivatives->FillBuffer(0.0F);
       }
-    if( ( this->m_MattesAssociate->m_ThreaderDerivativeManager.size() != localNumberOfThreadsUsed ) )
+    // Each thread accumulates into its own copy of the joint PDF derivatives
+    // when the memory allows it, which avoids any locking.
+    const SizeValueType jointPDFDerivativesSize = jointPDFDerivativesRegion.GetNumberOfPixels();
+    this->m_MattesAssociate->m_UseThreaderJointPDFDerivatives =
+      ( localNumberOfThreadsUsed - 1 ) * jointPDFDerivativesSize
+      <= this->m_MattesAssociate->m_MaximumThreaderJointPDFDerivativesSize;
+
+    if( this->m_MattesAssociate->m_UseThreaderJointPDFDerivatives )
       {
-      this->m_MattesAssociate->m_ThreaderDerivativeManager.resize(localNumberOfThreadsUsed);
+      this->m_MattesAssociate->m_ThreaderDerivativeManager.clear();
+      this->m_MattesAssociate->m_ThreaderJointPDFDerivatives.resize(localNumberOfThreadsUsed);
+      this->m_MattesAssociate->m_ThreaderJointPDFDerivatives[0] = this->m_MattesAssociate->m_JointPDFDerivatives;
+      for( ThreadIdType threadId = 1; threadId < localNumberOfThreadsUsed; ++threadId )
+        {
+        typename JointPDFDerivativesType::Pointer & threaderJointPDFDerivatives =
+          this->m_MattesAssociate->m_ThreaderJointPDFDerivatives[threadId];
+        if( threaderJointPDFDerivatives.IsNull() ||
+            ( threaderJointPDFDerivatives->GetBufferedRegion() != jointPDFDerivativesRegion ) )
+          {
+          threaderJointPDFDerivatives = JointPDFDerivativesType::New();
+          threaderJointPDFDerivatives->SetRegions( jointPDFDerivativesRegion );
+          threaderJointPDFDerivatives->Allocate(true);
+          }
+        else
+          {
+          threaderJointPDFDerivatives->FillBuffer(0.0F);
+          }
+        }
       }
-    for( ThreadIdType threadId = 0; threadId < localNumberOfThreadsUsed; ++threadId )
+    else
       {
-      this->m_MattesAssociate->m_ThreaderDerivativeManager[threadId].Initialize(
-        // A heuristic that assumues memory for 2x size of
-        // m_JointPDFDerivati efficient and easy to make, so
-        // split it accross all the threads.  A work unit of at least 400 is needed
-        // when the thread size approaches the number of histograms so that the
-        // there is enough work to be done between thread lockings.
-        std::max<size_t>(500,
-        this->m_MattesAssociate->m_NumberOfHistogramBins * this->m_MattesAssociate->m_NumberOfHistogramBins / localNumberOfThreadsUsed),
-        this->GetCachedNumberOfLocalParameters(),
-        // Need address of the lock
-        &this->m_MattesAssociate->m_JointPDFDerivativesLock,
-        this->m_MattesAssociate->m_JointPDFDerivatives
-        );
+      this->m_MattesAssociate->m_ThreaderJointPDFDerivatives.clear();
+      if( ( this->m_MattesAssociate->m_ThreaderDerivativeManager.size() != localNumberOfThreadsUsed ) )
+        {
+        this->m_MattesAssociate->m_ThreaderDerivativeManager.resize(localNumberOfThreadsUsed);
+        }
+      for( ThreadIdType threadId = 0; threadId < localNumberOfThreadsUsed; ++threadId )
+        {
+        this->m_MattesAssociate->m_ThreaderDerivativeManager[threadId].Initialize(
+          // A heuristic that assumues memory for 2x size of
+          // m_JointPDFDerivati efficient and easy to make, so
+          // split it accross all the threads.  A work unit of at least 400 is needed
+          // when the thread size approaches the number of histograms so that the
+          // there is enough work to be done between thread lockings.
+          std::max<size_t>(500,
+          this->m_MattesAssociate->m_NumberOfHistogramBins * this->m_MattesAssociate->m_NumberOfHistogramBins / localNumberOfThreadsUsed),
+          this->GetCachedNumberOfLocalParameters(),
+          // Need address of the lock
+          &this->m_MattesAssociate->m_JointPDFDerivativesLock,
+          this->m_MattesAssociate->m_JointPDFDerivatives
+          );
+        }
       }
     }
 }
@@ -373,8 +406,12 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
           ( fixedImageParzenWindowIndex  * this->m_MattesAssociate->m_JointPDFDerivatives->GetOffsetTable()[2] )
           + ( pdfMovingIndex * this->m_MattesAssociate->m_JointPDFDerivatives->GetOffsetTable()[1] );
 
-        PDFValueType * derivativeContributionPtr =
-          this->m_MattesAssociate->m_ThreaderDerivativeManager[threadId].GetNextElementAndAddOffset(ThisIndexOffset);
+        // Both the per-thread joint PDF derivatives and the elements of the
+        // derivative manager are zero before the first contribution.
+        const bool useThreaderJointPDFDerivatives = this->m_MattesAssociate->m_UseThreaderJointPDFDerivatives;
+        PDFValueType * derivativeContributionPtr = useThreaderJointPDFDerivatives
+          ? this->m_MattesAssociate->m_ThreaderJointPDFDerivatives[threadId]->GetBufferPointer() + ThisIndexOffset
+          : this->m_MattesAssociate->m_ThreaderDerivativeManager[threadId].GetNextElementAndAddOffset(ThisIndexOffset);
         for( NumberOfParametersType mu = 0, maxElement = this->GetCachedNumberOfLocalParameters(); mu < maxElement;
              ++mu )
           {
@@ -384,10 +421,13 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
             innerProduct += jacobian[dim][mu] * movingImageGradient[dim];
             }
 
-          *(derivativeContributionPtr) = innerProduct * cubicBSplineDerivativeValue;
+          *(derivativeContributionPtr) += innerProduct * cubicBSplineDerivativeValue;
           ++derivativeContributionPtr;
           }
-        this->m_MattesAssociate->m_ThreaderDerivativeManager[threadId].CheckAndReduceIfNecessary();
+        if( !useThreaderJointPDFDerivatives )
+          {
+          this->m_MattesAssociate->m_ThreaderDerivativeManager[threadId].CheckAndReduceIfNecessary();
+          }
         }
       }
 
@@ -460,14 +500,30 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
     const PDFValueType nFactor = -1.0
       / ( this->m_MattesAssociate->m_MovingImageBinSize * this->m_MattesAssociate->GetNumberOfValidPoints() );
 
-    JointPDFDerivativesValueType *const accumulatorPdfDPtrStart =
-      this->m_MattesAssociate->m_JointPDFDerivatives->GetBufferPointer();
-    JointPDFDerivativesValueType *             accumulatorPdfDPtr = accumulatorPdfDPtrStart;
-    JointPDFDerivativesValueType const * const tempThreadPdfDPtrEnd = accumulatorPdfDPtrStart
-      + histogramTotalElementsSize;
-    while( accumulatorPdfDPtr < tempThreadPdfDPtrEnd )
+    if( this->m_MattesAssociate->m_UseThreaderJointPDFDerivatives )
       {
-      *( accumulatorPdfDPtr++ ) *= nFactor;
+      // Sum the per-thread joint PDF derivatives into the first one, each
+      // thread reducing a contiguous part of the buffers.
+      JointPDFDerivativesReductionStruct str;
+      str.Threader = this;
+      str.NormalizationFactor = nFactor;
+      str.Size = histogramTotalElementsSize;
+
+      MultiThreader * multiThreader = this->GetMultiThreader();
+      multiThreader->SetSingleMethod( Self::ReduceJointPDFDerivativesThreaderCallback, &str );
+      multiThreader->SingleMethodExecute();
+      }
+    else
+      {
+      JointPDFDerivativesValueType *const accumulatorPdfDPtrStart =
+        this->m_MattesAssociate->m_JointPDFDerivatives->GetBufferPointer();
+      JointPDFDerivativesValueType *             accumulatorPdfDPtr = accumulatorPdfDPtrStart;
+      JointPDFDerivativesValueType const * const tempThreadPdfDPtrEnd = accumulatorPdfDPtrStart
+        + histogramTotalElementsSize;
+      while( accumulatorPdfDPtr < tempThreadPdfDPtrEnd )
+        {
+        *( accumulatorPdfDPtr++ ) *= nFactor;
+        }
       }
     }
 
@@ -476,6 +532,38 @@ MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomai
   this->m_MattesAssociate->ComputeResults();
 }
 
+template< typename TDomainPartitioner, typename TImageToImageMetric, typename TMattesMutualInformationMetric >
+ITK_THREAD_RETURN_TYPE
+MattesMutualInformationImageToImageMetricv4GetValueAndDerivativeThreader< TDomainPartitioner, TImageToImageMetric, TMattesMutualInformationMetric >
+::ReduceJointPDFDerivativesThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  const JointPDFDerivativesReductionStruct * str = static_cast< JointPDFDerivativesReductionStruct * >( info->UserData );
+  const ThreadIdType threadId = info->ThreadID;
+  const ThreadIdType threadCount = info->NumberOfThreads;
+
+  const std::vector< typename JointPDFDerivativesType::Pointer > & threaderJointPDFDerivatives =
+    str->Threader->m_MattesAssociate->m_ThreaderJointPDFDerivatives;
+  const SizeValueType begin = str->Size * threadId / threadCount;
+  const SizeValueType end = str->Size * ( threadId + 1 ) / threadCount;
+
+  JointPDFDerivativesValueType * const accumulatorPdfDPtr = threaderJointPDFDerivatives[0]->GetBufferPointer();
+  for( size_t t = 1; t < threaderJointPDFDerivatives.size(); ++t )
+    {
+    JointPDFDerivativesValueType const * const tempThreadPdfDPtr = threaderJointPDFDerivatives[t]->GetBufferPointer();
+    for( SizeValueType i = begin; i < end; ++i )
+      {
+      accumulatorPdfDPtr[i] += tempThreadPdfDPtr[i];
+      }
+    }
+  for( SizeValueType i = begin; i < end; ++i )
+    {
+    accumulatorPdfDPtr[i] *= str->NormalizationFactor;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 } // end namespace itk
 
 #endif
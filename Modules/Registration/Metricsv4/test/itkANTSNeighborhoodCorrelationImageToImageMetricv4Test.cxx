@@ -17,6 +17,8 @@
  *=========================================================================*/
 
 #include "itkTranslationTransform.h"
+#include "itkAffineTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
 
 #include "itkANTSNeighborhoodCorrelationImageToImageMetricv4.h"
 #include "itkTestingMacros.h"
@@ -113,6 +115,89 @@ void ANTSNeighborhoodCorrelationImageToImageMetricv4Test_PrintImage(const ImageP
     }
 }
 
+/* Compare the dense and sparse threaders on a 3D image whose slices are
+ * large enough for the dense threader to process them in several tiles. */
+template< typename TInternalComputationValueType >
+bool ANTSNeighborhoodCorrelationImageToImageMetricv4Test_CompareTiledDenseToSparse( double tolerance )
+{
+  const unsigned int Dimension = 3;
+  typedef itk::Image< double, Dimension > ImageType;
+  typedef itk::ANTSNeighborhoodCorrelationImageToImageMetricv4< ImageType, ImageType, ImageType,
+                                                                 TInternalComputationValueType > MetricType;
+
+  ImageType::SizeType size;
+  size[0] = 220;
+  size[1] = 190;
+  size[2] = 4;
+  typename ImageType::Pointer images[2];
+  for( unsigned int i = 0; i < 2; ++i )
+    {
+    images[i] = ImageType::New();
+    images[i]->SetRegions( size );
+    images[i]->Allocate();
+    itk::ImageRegionIteratorWithIndex< ImageType > it( images[i], images[i]->GetLargestPossibleRegion() );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const ImageType::IndexType & index = it.GetIndex();
+      it.Set( std::sin( 0.1 * index[0] + 0.2 * i ) + std::cos( 0.07 * index[1] ) + 0.3 * index[2] );
+      }
+    }
+
+  typedef itk::AffineTransform< TInternalComputationValueType, Dimension > TransformType;
+  typename TransformType::Pointer transform = TransformType::New();
+  typename TransformType::OutputVectorType translation;
+  translation.Fill( 0.4 );
+  transform->Translate( translation );
+
+  typename MetricType::FixedSampledPointSetType::Pointer pointSet = MetricType::FixedSampledPointSetType::New();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( images[0], images[0]->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    ImageType::PointType point;
+    images[0]->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+    typename MetricType::FixedSampledPointSetType::PointType samplePoint;
+    samplePoint.CastFrom( point );
+    pointSet->SetPoint( pointSet->GetNumberOfPoints(), samplePoint );
+    }
+
+  typename MetricType::RadiusType radius;
+  radius.Fill( 2 );
+  typename MetricType::Pointer metrics[2];
+  typename MetricType::MeasureType values[2];
+  typename MetricType::DerivativeType derivatives[2];
+  for( unsigned int m = 0; m < 2; ++m )
+    {
+    metrics[m] = MetricType::New();
+    metrics[m]->SetRadius( radius );
+    metrics[m]->SetFixedImage( images[0] );
+    metrics[m]->SetMovingImage( images[1] );
+    metrics[m]->SetMovingTransform( transform );
+    metrics[m]->SetMaximumNumberOfThreads( 2 );
+    metrics[m]->SetFixedSampledPointSet( pointSet );
+    metrics[m]->SetUseFixedSampledPointSet( m == 1 );
+    metrics[m]->Initialize();
+    metrics[m]->GetValueAndDerivative( values[m], derivatives[m] );
+    }
+
+  std::cout << "Tiled dense value: " << values[0] << ", sparse value: " << values[1] << std::endl;
+  if( metrics[0]->GetNumberOfValidPoints() != metrics[1]->GetNumberOfValidPoints()
+      || itk::Math::abs( values[0] - values[1] ) > tolerance * itk::Math::abs( values[1] ) )
+    {
+    std::cerr << "Results for Value don't match using tiled dense and sparse threaders." << std::endl;
+    return false;
+    }
+  for( unsigned int p = 0; p < derivatives[1].Size(); ++p )
+    {
+    if( itk::Math::abs( derivatives[0][p] - derivatives[1][p] ) > tolerance * ( 1.0 + itk::Math::abs( derivatives[1][p] ) ) )
+      {
+      std::cerr << "Results for derivative don't match using tiled dense and sparse threaders: "
+                << derivatives[0] << " (dense), " << derivatives[1] << " (sparse)" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
 int itkANTSNeighborhoodCorrelationImageToImageMetricv4Test( int, char ** const )
 {
   const itk::SizeValueType ImageDimension = 2;
@@ -425,6 +510,13 @@ int itkANTSNeighborhoodCorrelationImageToImageMetricv4Test( int, char ** const )
               << "  Expected metric max value: " << expectedMetricMax << std::endl;
     }
 
+  // Test the tiled dense threader, accumulating in double and in float.
+  if( ! ANTSNeighborhoodCorrelationImageToImageMetricv4Test_CompareTiledDenseToSparse< double >( 1e-10 )
+      || ! ANTSNeighborhoodCorrelationImageToImageMetricv4Test_CompareTiledDenseToSparse< float >( 1e-3 ) )
+    {
+    return EXIT_FAILURE;
+    }
+
   std::cout << "Test PASSED." << std::endl;
   return EXIT_SUCCESS;
 
@@ -0,0 +1,191 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkAffineTransform.h"
+#include "itkTranslationTransform.h"
+#include "itkImageMaskSpatialObject.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/* Compare the metric computed with and without the fixed sample cache,
+ * with dense and sparse sampling, while the moving transform changes at
+ * each evaluation and the fixed side changes between evaluations. */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< double, Dimension >                                ImageType;
+typedef itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >  MetricType;
+typedef itk::AffineTransform< double, Dimension >                      MovingTransformType;
+typedef itk::TranslationTransform< double, Dimension >                 FixedTransformType;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill( 40 );
+  image->SetRegions( size );
+  ImageType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.5;
+  image->SetSpacing( spacing );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 20.0 - shift;
+    const double y = it.GetIndex()[1] - 20.0;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 150.0 ) );
+    }
+  return image;
+}
+
+bool
+CompareMetrics( MetricType * cached, MetricType * uncached, MovingTransformType * movingTransform )
+{
+  MovingTransformType::ParametersType parameters = movingTransform->GetParameters();
+  for( unsigned int iteration = 0; iteration < 4; ++iteration )
+    {
+    parameters[4] = 0.7 * iteration;
+    parameters[0] = 1.0 + 0.02 * iteration;
+    movingTransform->SetParameters( parameters );
+
+    MetricType::MeasureType    cachedValue;
+    MetricType::MeasureType    uncachedValue;
+    MetricType::DerivativeType cachedDerivative;
+    MetricType::DerivativeType uncachedDerivative;
+    cached->GetValueAndDerivative( cachedValue, cachedDerivative );
+    uncached->GetValueAndDerivative( uncachedValue, uncachedDerivative );
+
+    if( cached->GetNumberOfValidPoints() != uncached->GetNumberOfValidPoints()
+        || itk::Math::abs( cachedValue - uncachedValue ) > 1e-10 * itk::Math::abs( uncachedValue ) )
+      {
+      std::cerr << "Value " << cachedValue << " with cache (" << cached->GetNumberOfValidPoints()
+                << " points) instead of " << uncachedValue << " ("
+                << uncached->GetNumberOfValidPoints() << " points)" << std::endl;
+      return false;
+      }
+    for( unsigned int i = 0; i < uncachedDerivative.Size(); ++i )
+      {
+      if( itk::Math::abs( cachedDerivative[i] - uncachedDerivative[i] ) > 1e-10 * ( 1.0 + itk::Math::abs( uncachedDerivative[i] ) ) )
+        {
+        std::cerr << "Derivative " << cachedDerivative << " with cache instead of "
+                  << uncachedDerivative << std::endl;
+        return false;
+        }
+      }
+    if( !itk::Math::ExactlyEquals( cached->GetValue(), uncached->GetValue() ) )
+      {
+      std::cerr << "GetValue differs with cache" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkImageToImageMetricv4FixedSampleCacheTest( int, char *[] )
+{
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 2.0 );
+
+  MovingTransformType::Pointer movingTransform = MovingTransformType::New();
+  FixedTransformType::Pointer fixedTransform = FixedTransformType::New();
+
+  // Points of a sparse sampling, in the fixed domain
+  MetricType::FixedSampledPointSetType::Pointer pointSet = MetricType::FixedSampledPointSetType::New();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  unsigned int count = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++count )
+    {
+    if( count % 7 == 0 )
+      {
+      ImageType::PointType point;
+      fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      pointSet->SetPoint( pointSet->GetNumberOfPoints(), point );
+      }
+    }
+
+  for( unsigned int sparse = 0; sparse < 2; ++sparse )
+    {
+    MetricType::Pointer metrics[2];
+    for( unsigned int m = 0; m < 2; ++m )
+      {
+      metrics[m] = MetricType::New();
+      metrics[m]->SetFixedImage( fixedImage );
+      metrics[m]->SetMovingImage( movingImage );
+      metrics[m]->SetFixedTransform( fixedTransform );
+      metrics[m]->SetMovingTransform( movingTransform );
+      metrics[m]->SetGradientSource( MetricType::GRADIENT_SOURCE_BOTH );
+      metrics[m]->SetUseFixedImageGradientFilter( false );
+      metrics[m]->SetUseFixedSampledPointSet( sparse != 0 );
+      metrics[m]->SetFixedSampledPointSet( pointSet );
+      metrics[m]->SetMaximumNumberOfThreads( 3 );
+      }
+    MetricType * cached = metrics[0];
+    MetricType * uncached = metrics[1];
+
+    TEST_SET_GET_BOOLEAN( cached, UseFixedSampleCache, true );
+    cached->UseFixedSampleCacheOn();
+
+    cached->Initialize();
+    uncached->Initialize();
+
+    std::cout << "Sparse sampling: " << sparse << std::endl;
+    TEST_EXPECT_TRUE( CompareMetrics( cached, uncached, movingTransform ) );
+
+    // Modifying the fixed transform invalidates the cache.
+    FixedTransformType::OutputVectorType offset;
+    offset[0] = 1.5;
+    offset[1] = -0.5;
+    fixedTransform->Translate( offset );
+    TEST_EXPECT_TRUE( CompareMetrics( cached, uncached, movingTransform ) );
+
+    // So does a fixed image mask.
+    typedef itk::ImageMaskSpatialObject< Dimension > MaskType;
+    MaskType::ImageType::Pointer maskImage = MaskType::ImageType::New();
+    maskImage->CopyInformation( fixedImage );
+    maskImage->SetRegions( fixedImage->GetLargestPossibleRegion() );
+    maskImage->Allocate( true );
+    MaskType::ImageType::IndexType maskStart;
+    maskStart.Fill( 5 );
+    MaskType::ImageType::SizeType maskSize;
+    maskSize.Fill( 20 );
+    MaskType::ImageType::RegionType maskRegion( maskStart, maskSize );
+    itk::ImageRegionIteratorWithIndex< MaskType::ImageType > maskIt( maskImage, maskRegion );
+    for( maskIt.GoToBegin(); !maskIt.IsAtEnd(); ++maskIt )
+      {
+      maskIt.Set( 1 );
+      }
+    MaskType::Pointer mask = MaskType::New();
+    mask->SetImage( maskImage );
+    cached->SetFixedImageMask( mask );
+    uncached->SetFixedImageMask( mask );
+    TEST_EXPECT_TRUE( CompareMetrics( cached, uncached, movingTransform ) );
+
+    fixedTransform->SetIdentity();
+    movingTransform->SetIdentity();
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
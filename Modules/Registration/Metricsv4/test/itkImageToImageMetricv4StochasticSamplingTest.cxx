@@ -0,0 +1,218 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkMattesMutualInformationImageToImageMetricv4.h"
+#include "itkTranslationTransform.h"
+#include "itkGradientDescentOptimizerv4.h"
+#include "itkRegistrationParameterScalesFromPhysicalShift.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/* Test the stochastic sampling of ImageToImageMetricv4: the drawing of
+ * new samples at the requested interval, the independence of the samples
+ * from the number of threads, the use of the fixed sample cache with
+ * dense and sparse candidate points, and a registration with
+ * GradientDescentOptimizerv4. */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< double, Dimension >                                ImageType;
+typedef itk::MeanSquaresImageToImageMetricv4< ImageType, ImageType >  MetricType;
+typedef itk::TranslationTransform< double, Dimension >                 TransformType;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill( 50 );
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 25.0 - shift;
+    const double y = it.GetIndex()[1] - 25.0;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 150.0 ) );
+    }
+  return image;
+}
+
+MetricType::Pointer
+CreateMetric( ImageType * fixedImage, ImageType * movingImage, TransformType * movingTransform )
+{
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage( fixedImage );
+  metric->SetMovingImage( movingImage );
+  metric->SetMovingTransform( movingTransform );
+  metric->SetNumberOfStochasticSamples( 150 );
+  metric->SetStochasticSamplingSeed( 7 );
+  return metric;
+}
+
+bool
+SameResults( MetricType * metric1, MetricType * metric2 )
+{
+  MetricType::MeasureType    value1;
+  MetricType::MeasureType    value2;
+  MetricType::DerivativeType derivative1;
+  MetricType::DerivativeType derivative2;
+  metric1->GetValueAndDerivative( value1, derivative1 );
+  metric2->GetValueAndDerivative( value2, derivative2 );
+  if( metric1->GetNumberOfValidPoints() != metric2->GetNumberOfValidPoints()
+      || itk::Math::abs( value1 - value2 ) > 1e-10 * itk::Math::abs( value2 ) )
+    {
+    std::cerr << "Value " << value1 << " (" << metric1->GetNumberOfValidPoints() << " points) instead of "
+              << value2 << " (" << metric2->GetNumberOfValidPoints() << " points)" << std::endl;
+    return false;
+    }
+  for( unsigned int i = 0; i < derivative2.Size(); ++i )
+    {
+    if( itk::Math::abs( derivative1[i] - derivative2[i] ) > 1e-10 * ( 1.0 + itk::Math::abs( derivative2[i] ) ) )
+      {
+      std::cerr << "Derivative " << derivative1 << " instead of " << derivative2 << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkImageToImageMetricv4StochasticSamplingTest( int, char *[] )
+{
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 2.0 );
+  TransformType::Pointer movingTransform = TransformType::New();
+
+  MetricType::Pointer metric = CreateMetric( fixedImage, movingImage, movingTransform );
+  TEST_SET_GET_VALUE( 150, metric->GetNumberOfStochasticSamples() );
+  TEST_SET_GET_VALUE( 7, metric->GetStochasticSamplingSeed() );
+  TEST_SET_GET_VALUE( 1, metric->GetStochasticSamplingInterval() );
+  metric->SetStochasticSamplingInterval( 0 );
+  TEST_SET_GET_VALUE( 1, metric->GetStochasticSamplingInterval() );
+  metric->Initialize();
+
+  // New samples are drawn at each evaluation.
+  const MetricType::MeasureType firstValue = metric->GetValue();
+  TEST_SET_GET_VALUE( 150, metric->GetNumberOfDomainPoints() );
+  TEST_EXPECT_TRUE( metric->GetNumberOfValidPoints() <= 150 );
+  TEST_EXPECT_TRUE( !itk::Math::ExactlyEquals( firstValue, metric->GetValue() ) );
+
+  // Initialize restarts the sequence of draws.
+  metric->Initialize();
+  TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( firstValue, metric->GetValue() ) );
+
+  // With an interval of 3, the samples are kept for 3 evaluations.
+  metric->SetStochasticSamplingInterval( 3 );
+  metric->Initialize();
+  TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( firstValue, metric->GetValue() ) );
+  TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( firstValue, metric->GetValue() ) );
+  TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( firstValue, metric->GetValue() ) );
+  TEST_EXPECT_TRUE( !itk::Math::ExactlyEquals( firstValue, metric->GetValue() ) );
+
+  // The average of the stochastic values approaches the dense value.
+  metric->SetStochasticSamplingInterval( 1 );
+  metric->Initialize();
+  double averageValue = 0.0;
+  const unsigned int numberOfDraws = 200;
+  for( unsigned int i = 0; i < numberOfDraws; ++i )
+    {
+    averageValue += metric->GetValue() / numberOfDraws;
+    }
+  MetricType::Pointer denseMetric = CreateMetric( fixedImage, movingImage, movingTransform );
+  denseMetric->SetNumberOfStochasticSamples( 0 );
+  denseMetric->Initialize();
+  const MetricType::MeasureType denseValue = denseMetric->GetValue();
+  std::cout << "Average stochastic value " << averageValue << ", dense value " << denseValue << std::endl;
+  TEST_EXPECT_TRUE( itk::Math::abs( averageValue - denseValue ) < 0.1 * denseValue );
+
+  // The samples do not depend on the number of threads, and use the fixed
+  // sample cache with dense and sparse candidate points.
+  MetricType::FixedSampledPointSetType::Pointer pointSet = MetricType::FixedSampledPointSetType::New();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( fixedImage, fixedImage->GetLargestPossibleRegion() );
+  unsigned int count = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++count )
+    {
+    if( count % 3 == 0 )
+      {
+      ImageType::PointType point;
+      fixedImage->TransformIndexToPhysicalPoint( it.GetIndex(), point );
+      pointSet->SetPoint( pointSet->GetNumberOfPoints(), point );
+      }
+    }
+  for( unsigned int sparse = 0; sparse < 2; ++sparse )
+    {
+    MetricType::Pointer metric1 = CreateMetric( fixedImage, movingImage, movingTransform );
+    MetricType::Pointer metric2 = CreateMetric( fixedImage, movingImage, movingTransform );
+    metric1->SetNumberOfStochasticSamples( 10000 );
+    metric2->SetNumberOfStochasticSamples( 10000 );
+    metric1->SetMaximumNumberOfThreads( 1 );
+    metric2->SetMaximumNumberOfThreads( 4 );
+    metric2->UseFixedSampleCacheOn();
+    metric1->SetFixedSampledPointSet( pointSet );
+    metric2->SetFixedSampledPointSet( pointSet );
+    metric1->SetUseFixedSampledPointSet( sparse != 0 );
+    metric2->SetUseFixedSampledPointSet( sparse != 0 );
+    metric1->Initialize();
+    metric2->Initialize();
+    std::cout << "Sparse sampling: " << sparse << std::endl;
+    for( unsigned int i = 0; i < 3; ++i )
+      {
+      TEST_EXPECT_TRUE( SameResults( metric1, metric2 ) );
+      }
+    }
+
+  // Other metrics evaluate the stochastic samples through the same threaders.
+  typedef itk::MattesMutualInformationImageToImageMetricv4< ImageType, ImageType > MattesMetricType;
+  MattesMetricType::Pointer mattesMetric = MattesMetricType::New();
+  mattesMetric->SetFixedImage( fixedImage );
+  mattesMetric->SetMovingImage( movingImage );
+  mattesMetric->SetMovingTransform( movingTransform );
+  mattesMetric->SetNumberOfStochasticSamples( 500 );
+  mattesMetric->Initialize();
+  MattesMetricType::MeasureType    mattesValue;
+  MattesMetricType::DerivativeType mattesDerivative;
+  TRY_EXPECT_NO_EXCEPTION( mattesMetric->GetValueAndDerivative( mattesValue, mattesDerivative ) );
+  TEST_SET_GET_VALUE( 500, mattesMetric->GetNumberOfDomainPoints() );
+
+  // Stochastic gradient descent with 5% of the points at each iteration.
+  metric->SetNumberOfStochasticSamples( 125 );
+  metric->Initialize();
+  typedef itk::RegistrationParameterScalesFromPhysicalShift< MetricType > ScalesEstimatorType;
+  ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+  scalesEstimator->SetMetric( metric );
+  typedef itk::GradientDescentOptimizerv4 OptimizerType;
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetMetric( metric );
+  optimizer->SetScalesEstimator( scalesEstimator );
+  optimizer->SetMaximumStepSizeInPhysicalUnits( 0.2 );
+  optimizer->SetNumberOfIterations( 150 );
+  optimizer->StartOptimization();
+
+  const TransformType::ParametersType & parameters = movingTransform->GetParameters();
+  std::cout << "Registered translation " << parameters << std::endl;
+  TEST_EXPECT_TRUE( itk::Math::abs( parameters[0] - 2.0 ) < 0.1 );
+  TEST_EXPECT_TRUE( itk::Math::abs( parameters[1] ) < 0.1 );
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
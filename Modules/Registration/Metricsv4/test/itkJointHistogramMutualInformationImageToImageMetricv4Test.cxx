@@ -19,6 +19,7 @@
 #include "itkMath.h"
 #include "itkJointHistogramMutualInformationImageToImageMetricv4.h"
 #include "itkTranslationTransform.h"
+#include "itkDiscreteGaussianImageFilter.h"
 #include "itkMath.h"
 
 /* Simple test to verify that class builds and runs.
@@ -164,6 +165,54 @@ int itkJointHistogramMutualInformationImageToImageMetricv4Test( int , char * []
     }
   movingTransform->SetIdentity();
 
+  // The joint pdf does not depend on the number of threads, including when
+  // the per-thread histograms are reduced in parallel, and its smoothing
+  // matches DiscreteGaussianImageFilter.
+  const unsigned int numberOfHistogramBins = 130;
+  MetricType::JointPDFType::Pointer jointPDFs[3];
+  for( unsigned int i = 0; i < 3; ++i )
+    {
+    MetricType::Pointer threadedMetric = MetricType::New();
+    threadedMetric->SetFixedImage( fixedImage );
+    threadedMetric->SetMovingImage( movingImage );
+    threadedMetric->SetMovingTransform( movingTransform );
+    threadedMetric->SetNumberOfHistogramBins( numberOfHistogramBins );
+    threadedMetric->SetMaximumNumberOfThreads( i == 1 ? 4 : 1 );
+    if( i == 2 )
+      {
+      threadedMetric->SetVarianceForJointPDFSmoothing( 0 );
+      }
+    threadedMetric->Initialize();
+    threadedMetric->GetValue();
+    jointPDFs[i] = threadedMetric->GetJointPDF();
+    }
+
+  typedef itk::DiscreteGaussianImageFilter< MetricType::JointPDFType, MetricType::JointPDFType > GaussianFilterType;
+  GaussianFilterType::Pointer gaussianFilter = GaussianFilterType::New();
+  gaussianFilter->SetInput( jointPDFs[2] );
+  gaussianFilter->SetVariance( metric->GetVarianceForJointPDFSmoothing() );
+  gaussianFilter->SetUseImageSpacingOff();
+  gaussianFilter->SetMaximumError( .01f );
+  gaussianFilter->Update();
+  itk::ImageRegionConstIterator< MetricType::JointPDFType > itFiltered( gaussianFilter->GetOutput(), jointPDFs[0]->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< MetricType::JointPDFType > it1( jointPDFs[0], jointPDFs[0]->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< MetricType::JointPDFType > it4( jointPDFs[1], jointPDFs[1]->GetBufferedRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it4, ++itFiltered )
+    {
+    if( itk::Math::abs( it1.Get() - itFiltered.Get() ) > 1e-14 )
+      {
+      std::cerr << "Smoothed joint pdf " << it1.Get() << " instead of "
+                << itFiltered.Get() << " at " << it1.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    if( itk::Math::NotExactlyEquals( it1.Get(), it4.Get() ) )
+      {
+      std::cerr << "Joint pdf " << it4.Get() << " with 4 threads instead of "
+                << it1.Get() << " at " << it1.GetIndex() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
   std::cout << "Test passed." << std::endl;
 
   //exercise methods
@@ -411,6 +411,28 @@ int TestMattesMetricWithAffineTransform(
       }
     }
 
+//---------------------------------------------------------
+// Check that the per-thread joint PDF derivatives and the
+// shared, locked ones give the same derivative
+//---------------------------------------------------------
+  metric->SetMaximumNumberOfThreads( 4 );
+  metric->Initialize();
+  metric->GetValueAndDerivative( metricValueWithDerivative, derivative );
+
+  metric->SetMaximumThreaderJointPDFDerivativesSize( 0 );
+  typename MetricType::DerivativeType lockedDerivative( numberOfParameters );
+  typename MetricType::MeasureType lockedValue;
+  metric->GetValueAndDerivative( lockedValue, lockedDerivative );
+  for( unsigned int i = 0; i < numberOfParameters; ++i )
+    {
+    if( itk::Math::abs( derivative[i] - lockedDerivative[i] ) > 1e-10 * ( 1.0 + itk::Math::abs( derivative[i] ) ) )
+      {
+      std::cout << "Derivative " << i << " differs between the per-thread and the shared joint PDF derivatives: "
+                << derivative[i] << " vs " << lockedDerivative[i] << std::endl;
+      testFailed = true;
+      }
+    }
+
   if( testFailed )
     {
     return EXIT_FAILURE;
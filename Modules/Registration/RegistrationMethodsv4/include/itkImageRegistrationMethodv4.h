@@ -30,6 +30,7 @@
 #include "itkShrinkImageFilter.h"
 #include "itkIdentityTransform.h"
 #include "itkTransformParametersAdaptorBase.h"
+#include "itkImageRegistrationPyramidCache.h"
 
 #include <vector>
 
@@ -79,6 +80,13 @@ namespace itk
  * given stage so typical use will be to assign the base adaptor class to
  * level 0 of all stages but we leave that open to the user.
  *
+ * Pyramid cache:  The fixed and moving images are smoothed at each level.
+ * When the same smoothing sigmas are used by the levels of several stages,
+ * an ImageRegistrationPyramidCache can be set on all the stages so that each
+ * smoothed image is computed only once.  Optionally, the smoothed images of
+ * all the levels can be computed in one parallel pass at the beginning of
+ * each stage (see PrecomputePyramid).
+ *
  * Output: The output is the updated transform.
  *
  * \author Nick Tustison
@@ -118,6 +126,9 @@ public:
   typedef typename MovingImageType::Pointer                           MovingImagePointer;
   typedef std::vector<MovingImagePointer>                             MovingImagesContainerType;
 
+  typedef ImageRegistrationPyramidCache<FixedImageType, MovingImageType> PyramidCacheType;
+  typedef typename PyramidCacheType::Pointer                          PyramidCachePointer;
+
   typedef TPointSet                                                   PointSetType;
   typedef typename PointSetType::ConstPointer                         PointSetConstPointer;
   typedef std::vector<PointSetConstPointer>                           PointSetsContainerType;
@@ -377,6 +388,23 @@ public:
   itkGetConstMacro( SmoothingSigmasAreSpecifiedInPhysicalUnits, bool );
   itkBooleanMacro( SmoothingSigmasAreSpecifiedInPhysicalUnits );
 
+  /**
+   * Set/Get the cache of the smoothed fixed and moving images.  When a cache is set,
+   * the smoothed images are taken from it and computed only once for a given image
+   * and smoothing sigma.  The same cache can be shared by the stages of a multistage
+   * registration.  By default, no cache is used and the images are smoothed at each level.
+   */
+  itkSetObjectMacro( PyramidCache, PyramidCacheType );
+  itkGetModifiableObjectMacro( PyramidCache, PyramidCacheType );
+
+  /**
+   * Set/Get whether to smooth the images of all the levels in one parallel pass at
+   * the first level (default false).  A pyramid cache is created if none was set.
+   */
+  itkSetMacro( PrecomputePyramid, bool );
+  itkGetConstMacro( PrecomputePyramid, bool );
+  itkBooleanMacro( PrecomputePyramid );
+
   /** Make a DataObject of the correct type to be used as the specified output. */
   typedef ProcessObject::DataObjectPointerArraySizeType DataObjectPointerArraySizeType;
   using Superclass::MakeOutput;
@@ -504,6 +532,8 @@ protected:
   std::vector<ShrinkFactorsPerDimensionContainerType>             m_ShrinkFactorsPerLevel;
   SmoothingSigmasArrayType                                        m_SmoothingSigmasPerLevel;
   bool                                                            m_SmoothingSigmasAreSpecifiedInPhysicalUnits;
+  PyramidCachePointer                                             m_PyramidCache;
+  bool                                                            m_PrecomputePyramid;
 
   bool                                                            m_ReseedIterator;
   int                                                             m_RandomSeed;
@@ -20,7 +20,6 @@
 
 #include "itkImageRegistrationMethodv4.h"
 
-#include "itkDiscreteGaussianImageFilter.h"
 #include "itkGradientDescentOptimizerv4.h"
 #include "itkImageRandomConstIteratorWithIndex.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
@@ -70,6 +69,8 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
 
   this->m_InitializeCenterOfLinearOutputTransform = true;
 
+  this->m_PrecomputePyramid = false;
+
   this->m_CompositeTransform = CompositeTransformType::New();
 
   typedef MattesMutualInformationImageToImageMetricv4<FixedImageType, MovingImageType, VirtualImageType, RealType> DefaultMetricType;
@@ -576,6 +577,34 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
     itkExceptionMacro( "Invalid metric conversion." );
     }
 
+  // Optionally smooth the images of all the levels at once.
+  if( level == 0 && this->m_PrecomputePyramid )
+    {
+    if( this->m_PyramidCache.IsNull() )
+      {
+      this->m_PyramidCache = PyramidCacheType::New();
+      }
+    typename PyramidCacheType::FixedImagesContainerType fixedImages;
+    typename PyramidCacheType::MovingImagesContainerType movingImages;
+    for( SizeValueType n = 0; n < this->m_NumberOfMetrics; n++ )
+      {
+      if( this->m_Metric->GetMetricCategory() == MetricType::IMAGE_METRIC ||
+          ( this->m_Metric->GetMetricCategory() == MetricType::MULTI_METRIC &&
+            multiMetric->GetMetricQueue()[n]->GetMetricCategory() == MetricType::IMAGE_METRIC ) )
+        {
+        fixedImages.push_back( this->GetFixedImage( n ) );
+        movingImages.push_back( this->GetMovingImage( n ) );
+        }
+      }
+    typename PyramidCacheType::VariancesContainerType variances;
+    for( SizeValueType l = 0; l < this->m_NumberOfLevels; l++ )
+      {
+      variances.push_back( itk::Math::sqr( this->m_SmoothingSigmasPerLevel[l] ) );
+      }
+    this->m_PyramidCache->ComputeSmoothedImages( fixedImages, movingImages, variances,
+      this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits, this->GetNumberOfThreads() );
+    }
+
   // We update the fixed and moving images for the image metrics and
   // the fixed and moving point sets for the point set metrics.  Note
   // that we set the point sets here just like we set the images.
@@ -602,41 +631,21 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
         ( this->m_Metric->GetMetricCategory() == MetricType::MULTI_METRIC &&
           multiMetric->GetMetricQueue()[n]->GetMetricCategory() == MetricType::IMAGE_METRIC ) )
       {
-      typedef DiscreteGaussianImageFilter<FixedImageType, FixedImageType> FixedImageSmoothingFilterType;
-      typename FixedImageSmoothingFilterType::Pointer fixedImageSmoothingFilter = FixedImageSmoothingFilterType::New();
-      if( this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits == true )
+      const double variance = itk::Math::sqr( this->m_SmoothingSigmasPerLevel[level] );
+      if( this->m_PyramidCache.IsNotNull() )
         {
-        fixedImageSmoothingFilter->SetUseImageSpacingOn();
+        this->m_FixedSmoothImages[n] = this->m_PyramidCache->GetSmoothedFixedImage( this->GetFixedImage( n ),
+          variance, this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits );
+        this->m_MovingSmoothImages[n] = this->m_PyramidCache->GetSmoothedMovingImage( this->GetMovingImage( n ),
+          variance, this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits );
         }
       else
         {
-        fixedImageSmoothingFilter->SetUseImageSpacingOff();
+        this->m_FixedSmoothImages[n] = PyramidCacheType::SmoothImage( this->GetFixedImage( n ),
+          variance, this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits );
+        this->m_MovingSmoothImages[n] = PyramidCacheType::SmoothImage( this->GetMovingImage( n ),
+          variance, this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits );
         }
-      fixedImageSmoothingFilter->SetVariance( itk::Math::sqr( this->m_SmoothingSigmasPerLevel[level] ) );
-      fixedImageSmoothingFilter->SetMaximumError( 0.01 );
-      fixedImageSmoothingFilter->SetInput( this->GetFixedImage( n ) );
-
-      this->m_FixedSmoothImages[n] = fixedImageSmoothingFilter->GetOutput();
-      this->m_FixedSmoothImages[n]->Update();
-      this->m_FixedSmoothImages[n]->DisconnectPipeline();
-
-      typedef DiscreteGaussianImageFilter<MovingImageType, MovingImageType> MovingImageSmoothingFilterType;
-      typename MovingImageSmoothingFilterType::Pointer movingImageSmoothingFilter = MovingImageSmoothingFilterType::New();
-      if( this->m_SmoothingSigmasAreSpecifiedInPhysicalUnits == true )
-        {
-        movingImageSmoothingFilter->SetUseImageSpacingOn();
-        }
-      else
-        {
-        movingImageSmoothingFilter->SetUseImageSpacingOff();
-        }
-      movingImageSmoothingFilter->SetVariance( itk::Math::sqr( this->m_SmoothingSigmasPerLevel[level] ) );
-      movingImageSmoothingFilter->SetMaximumError( 0.01 );
-      movingImageSmoothingFilter->SetInput( this->GetMovingImage( n ) );
-
-      this->m_MovingSmoothImages[n] = movingImageSmoothingFilter->GetOutput();
-      this->m_MovingSmoothImages[n]->Update();
-      this->m_MovingSmoothImages[n]->DisconnectPipeline();
 
       // Update the image metric
 
@@ -1163,6 +1172,12 @@ ImageRegistrationMethodv4<TFixedImage, TMovingImage, TTransform, TVirtualImage,
 
   os << indent << "InitializeCenterOfLinearOutputTransform: "
      << ( m_InitializeCenterOfLinearOutputTransform ? "On" : "Off" ) << std::endl;
+
+  os << indent << "PrecomputePyramid: " << ( this->m_PrecomputePyramid ? "On" : "Off" ) << std::endl;
+  if( this->m_PyramidCache.IsNotNull() )
+    {
+    os << indent << "PyramidCache: " << this->m_PyramidCache.GetPointer() << std::endl;
+    }
 }
 
 /*
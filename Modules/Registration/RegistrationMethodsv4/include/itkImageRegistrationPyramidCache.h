@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageRegistrationPyramidCache_h
+#define itkImageRegistrationPyramidCache_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+
+#include <map>
+#include <vector>
+
+namespace itk
+{
+
+/** \class ImageRegistrationPyramidCache
+ * \brief Cache of the smoothed fixed and moving images of a multi-resolution
+ * registration.
+ *
+ * At each level, ImageRegistrationMethodv4 and its subclasses smooth the
+ * fixed and moving images with a DiscreteGaussianImageFilter.  The levels of
+ * the successive stages of a multistage registration (e.g. rigid, affine,
+ * then SyN) often use the same smoothing sigmas, so the same images are
+ * smoothed again in each stage.
+ *
+ * This cache stores the smoothed images, keyed by the input image, its
+ * modification time, the variance of the smoothing and whether the variance
+ * is specified in physical units.  The same cache can be set on several
+ * registration methods sharing the fixed and moving image types, so that each
+ * smoothed image is computed only once.  The images of all the levels can
+ * also be computed in one parallel pass with ComputeSmoothedImages().
+ *
+ * Cached images are shared with the metrics and must not be modified.  They
+ * are kept until Clear() is called or the cache is destroyed.
+ *
+ * \ingroup ITKRegistrationMethodsv4
+ */
+template<typename TFixedImage, typename TMovingImage = TFixedImage>
+class ITK_TEMPLATE_EXPORT ImageRegistrationPyramidCache
+:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageRegistrationPyramidCache             Self;
+  typedef Object                                    Superclass;
+  typedef SmartPointer<Self>                        Pointer;
+  typedef SmartPointer<const Self>                  ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro( Self );
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro( ImageRegistrationPyramidCache, Object );
+
+  typedef TFixedImage                                     FixedImageType;
+  typedef typename FixedImageType::Pointer                FixedImagePointer;
+  typedef std::vector<const FixedImageType *>             FixedImagesContainerType;
+  typedef TMovingImage                                    MovingImageType;
+  typedef typename MovingImageType::Pointer               MovingImagePointer;
+  typedef std::vector<const MovingImageType *>            MovingImagesContainerType;
+  typedef std::vector<double>                             VariancesContainerType;
+
+  /** Get the fixed image smoothed with the given variance, computing and
+   * caching it on the first request. */
+  FixedImagePointer GetSmoothedFixedImage( const FixedImageType * image, double variance, bool useImageSpacing );
+
+  /** Get the moving image smoothed with the given variance, computing and
+   * caching it on the first request. */
+  MovingImagePointer GetSmoothedMovingImage( const MovingImageType * image, double variance, bool useImageSpacing );
+
+  /** Compute and cache the smoothed images of every given fixed and moving
+   * image for every given variance, in one parallel pass.  Each missing image
+   * is computed by its own DiscreteGaussianImageFilter, and the filters run
+   * concurrently on at most numberOfThreads threads, or on the global default
+   * number of threads when it is zero. */
+  void ComputeSmoothedImages( const FixedImagesContainerType & fixedImages,
+                              const MovingImagesContainerType & movingImages,
+                              const VariancesContainerType & variances,
+                              bool useImageSpacing,
+                              ThreadIdType numberOfThreads = 0 );
+
+  /** Remove all the cached images. */
+  void Clear();
+
+  /** Get the number of cached images. */
+  SizeValueType GetNumberOfCachedImages() const;
+
+  /** Get the number of smoothed images computed since the creation of the
+   * cache.  This is a helper function for reporting observations. */
+  itkGetConstMacro( NumberOfComputedImages, SizeValueType );
+
+  /** Smooth an image with a DiscreteGaussianImageFilter as
+   * ImageRegistrationMethodv4 does at each level, without caching it. */
+  template<typename TImage>
+  static typename TImage::Pointer SmoothImage( const TImage * image, double variance, bool useImageSpacing,
+                                               ThreadIdType numberOfThreads = 0 );
+
+protected:
+  ImageRegistrationPyramidCache();
+  virtual ~ImageRegistrationPyramidCache() {}
+  virtual void PrintSelf( std::ostream & os, Indent indent ) const ITK_OVERRIDE;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN( ImageRegistrationPyramidCache );
+
+  struct CacheKey
+    {
+    const DataObject * Image;
+    ModifiedTimeType   ImageModifiedTime;
+    double             Variance;
+    bool               UseImageSpacing;
+
+    bool operator<( const CacheKey & other ) const;
+    };
+
+  /** The cached image keeps a reference to its input so that the address of
+   * the input is not reused while the entry exists. */
+  struct CacheEntry
+    {
+    DataObject::ConstPointer Input;
+    DataObject::Pointer      SmoothedImage;
+    };
+
+  typedef std::map<CacheKey, CacheEntry> CacheType;
+
+  typedef DataObject::Pointer (*SmoothFunctionType)( const DataObject *, double, bool, ThreadIdType );
+
+  /** A smoothed image computed during ComputeSmoothedImages(). */
+  struct SmoothingTask
+    {
+    CacheKey            Key;
+    CacheEntry          Entry;
+    DataObject::Pointer LocalInput;
+    SmoothFunctionType  Smooth;
+    };
+
+  struct SmoothingThreadStruct
+    {
+    std::vector<SmoothingTask> * Tasks;
+    ThreadIdType                 NumberOfThreadsPerTask;
+    };
+
+  static ITK_THREAD_RETURN_TYPE SmoothingThreaderCallback( void * arg );
+
+  template<typename TImage>
+  static DataObject::Pointer SmoothDataObject( const DataObject * image, double variance, bool useImageSpacing,
+                                               ThreadIdType numberOfThreads );
+
+  template<typename TImage>
+  typename TImage::Pointer GetSmoothedImage( const TImage * image, double variance, bool useImageSpacing );
+
+  template<typename TImage>
+  void AddSmoothingTasks( const std::vector<const TImage *> & images, const VariancesContainerType & variances,
+                          bool useImageSpacing, std::vector<SmoothingTask> & tasks ) const;
+
+  static CacheKey MakeKey( const DataObject * image, double variance, bool useImageSpacing );
+
+  /** Remove the entries of the image of the key computed before its last
+   * modification, since they will never be requested again. */
+  void RemoveStaleEntries( const CacheKey & key );
+
+  CacheType     m_Cache;
+  SizeValueType m_NumberOfComputedImages;
+};
+} // end namespace itk
+
+#ifndef ITK_MANUAL_INSTANTIATION
+#include "itkImageRegistrationPyramidCache.hxx"
+#endif
+
+#endif
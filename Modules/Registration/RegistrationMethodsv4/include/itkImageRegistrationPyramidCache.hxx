@@ -0,0 +1,303 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef itkImageRegistrationPyramidCache_hxx
+#define itkImageRegistrationPyramidCache_hxx
+
+#include "itkImageRegistrationPyramidCache.h"
+
+#include "itkDiscreteGaussianImageFilter.h"
+
+namespace itk
+{
+
+template<typename TFixedImage, typename TMovingImage>
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::ImageRegistrationPyramidCache() :
+  m_NumberOfComputedImages( 0 )
+{
+}
+
+template<typename TFixedImage, typename TMovingImage>
+bool
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>::CacheKey
+::operator<( const CacheKey & other ) const
+{
+  if( this->Image != other.Image )
+    {
+    return std::less<const DataObject *>()( this->Image, other.Image );
+    }
+  if( this->ImageModifiedTime != other.ImageModifiedTime )
+    {
+    return this->ImageModifiedTime < other.ImageModifiedTime;
+    }
+  if( this->Variance != other.Variance )
+    {
+    return this->Variance < other.Variance;
+    }
+  return this->UseImageSpacing < other.UseImageSpacing;
+}
+
+template<typename TFixedImage, typename TMovingImage>
+typename ImageRegistrationPyramidCache<TFixedImage, TMovingImage>::CacheKey
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::MakeKey( const DataObject * image, double variance, bool useImageSpacing )
+{
+  CacheKey key;
+  key.Image = image;
+  key.ImageModifiedTime = image->GetMTime();
+  key.Variance = variance;
+  key.UseImageSpacing = useImageSpacing;
+  return key;
+}
+
+template<typename TFixedImage, typename TMovingImage>
+template<typename TImage>
+typename TImage::Pointer
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::SmoothImage( const TImage * image, double variance, bool useImageSpacing, ThreadIdType numberOfThreads )
+{
+  typedef DiscreteGaussianImageFilter<TImage, TImage> SmoothingFilterType;
+  typename SmoothingFilterType::Pointer smoothingFilter = SmoothingFilterType::New();
+  if( useImageSpacing == true )
+    {
+    smoothingFilter->SetUseImageSpacingOn();
+    }
+  else
+    {
+    smoothingFilter->SetUseImageSpacingOff();
+    }
+  smoothingFilter->SetVariance( variance );
+  smoothingFilter->SetMaximumError( 0.01 );
+  if( numberOfThreads > 0 )
+    {
+    smoothingFilter->SetNumberOfThreads( numberOfThreads );
+    }
+  smoothingFilter->SetInput( image );
+
+  typename TImage::Pointer smoothedImage = smoothingFilter->GetOutput();
+  smoothedImage->Update();
+  smoothedImage->DisconnectPipeline();
+  return smoothedImage;
+}
+
+template<typename TFixedImage, typename TMovingImage>
+template<typename TImage>
+DataObject::Pointer
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::SmoothDataObject( const DataObject * image, double variance, bool useImageSpacing, ThreadIdType numberOfThreads )
+{
+  typename TImage::Pointer smoothedImage =
+    SmoothImage<TImage>( static_cast<const TImage *>( image ), variance, useImageSpacing, numberOfThreads );
+  return smoothedImage.GetPointer();
+}
+
+template<typename TFixedImage, typename TMovingImage>
+void
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::RemoveStaleEntries( const CacheKey & key )
+{
+  for( typename CacheType::iterator stale = this->m_Cache.begin(); stale != this->m_Cache.end(); )
+    {
+    if( stale->first.Image == key.Image && stale->first.ImageModifiedTime != key.ImageModifiedTime )
+      {
+      this->m_Cache.erase( stale++ );
+      }
+    else
+      {
+      ++stale;
+      }
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage>
+template<typename TImage>
+typename TImage::Pointer
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::GetSmoothedImage( const TImage * image, double variance, bool useImageSpacing )
+{
+  if( image == ITK_NULLPTR )
+    {
+    itkExceptionMacro( "The image to smooth is not present." );
+    }
+
+  const CacheKey key = MakeKey( image, variance, useImageSpacing );
+  typename CacheType::const_iterator it = this->m_Cache.find( key );
+  if( it != this->m_Cache.end() )
+    {
+    itkDebugMacro( "Reusing the cached image smoothed with variance " << variance );
+    return dynamic_cast<TImage *>( it->second.SmoothedImage.GetPointer() );
+    }
+
+  this->RemoveStaleEntries( key );
+
+  typename TImage::Pointer smoothedImage = SmoothImage<TImage>( image, variance, useImageSpacing );
+  CacheEntry & entry = this->m_Cache[key];
+  entry.Input = image;
+  entry.SmoothedImage = smoothedImage.GetPointer();
+  ++this->m_NumberOfComputedImages;
+  return smoothedImage;
+}
+
+template<typename TFixedImage, typename TMovingImage>
+typename ImageRegistrationPyramidCache<TFixedImage, TMovingImage>::FixedImagePointer
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::GetSmoothedFixedImage( const FixedImageType * image, double variance, bool useImageSpacing )
+{
+  return this->GetSmoothedImage<FixedImageType>( image, variance, useImageSpacing );
+}
+
+template<typename TFixedImage, typename TMovingImage>
+typename ImageRegistrationPyramidCache<TFixedImage, TMovingImage>::MovingImagePointer
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::GetSmoothedMovingImage( const MovingImageType * image, double variance, bool useImageSpacing )
+{
+  return this->GetSmoothedImage<MovingImageType>( image, variance, useImageSpacing );
+}
+
+template<typename TFixedImage, typename TMovingImage>
+template<typename TImage>
+void
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::AddSmoothingTasks( const std::vector<const TImage *> & images, const VariancesContainerType & variances,
+                     bool useImageSpacing, std::vector<SmoothingTask> & tasks ) const
+{
+  for( size_t i = 0; i < images.size(); i++ )
+    {
+    if( images[i] == ITK_NULLPTR )
+      {
+      continue;
+      }
+    for( size_t v = 0; v < variances.size(); v++ )
+      {
+      const CacheKey key = MakeKey( images[i], variances[v], useImageSpacing );
+      bool isScheduled = ( this->m_Cache.find( key ) != this->m_Cache.end() );
+      for( size_t t = 0; t < tasks.size() && !isScheduled; t++ )
+        {
+        isScheduled = !( tasks[t].Key < key ) && !( key < tasks[t].Key );
+        }
+      if( isScheduled )
+        {
+        continue;
+        }
+
+      // Each filter gets its own image object sharing the pixel buffer of the
+      // input, so that the concurrent pipelines do not update the same
+      // requested region.
+      typename TImage::Pointer localInput = TImage::New();
+      localInput->Graft( images[i] );
+
+      SmoothingTask task;
+      task.Key = key;
+      task.Entry.Input = images[i];
+      task.LocalInput = localInput.GetPointer();
+      task.Smooth = &Self::template SmoothDataObject<TImage>;
+      tasks.push_back( task );
+      }
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage>
+void
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::ComputeSmoothedImages( const FixedImagesContainerType & fixedImages,
+                         const MovingImagesContainerType & movingImages,
+                         const VariancesContainerType & variances,
+                         bool useImageSpacing,
+                         ThreadIdType numberOfThreads )
+{
+  std::vector<SmoothingTask> tasks;
+  this->AddSmoothingTasks<FixedImageType>( fixedImages, variances, useImageSpacing, tasks );
+  this->AddSmoothingTasks<MovingImageType>( movingImages, variances, useImageSpacing, tasks );
+  if( tasks.empty() )
+    {
+    return;
+    }
+
+  // Run one filter per thread, and split the remaining threads between the
+  // filters.
+  const ThreadIdType maximumNumberOfThreads =
+    ( numberOfThreads > 0 ) ? numberOfThreads : MultiThreader::GetGlobalDefaultNumberOfThreads();
+  const ThreadIdType numberOfConcurrentTasks =
+    static_cast<ThreadIdType>( std::min<size_t>( tasks.size(), maximumNumberOfThreads ) );
+
+  SmoothingThreadStruct str;
+  str.Tasks = &tasks;
+  str.NumberOfThreadsPerTask = std::max<ThreadIdType>( 1, maximumNumberOfThreads / static_cast<ThreadIdType>( tasks.size() ) );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfConcurrentTasks );
+  threader->SetSingleMethod( Self::SmoothingThreaderCallback, &str );
+  threader->SingleMethodExecute();
+
+  for( size_t t = 0; t < tasks.size(); t++ )
+    {
+    this->RemoveStaleEntries( tasks[t].Key );
+    this->m_Cache[tasks[t].Key] = tasks[t].Entry;
+    }
+  this->m_NumberOfComputedImages += tasks.size();
+}
+
+template<typename TFixedImage, typename TMovingImage>
+ITK_THREAD_RETURN_TYPE
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::SmoothingThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SmoothingThreadStruct * str = static_cast<SmoothingThreadStruct *>( info->UserData );
+  std::vector<SmoothingTask> & tasks = *( str->Tasks );
+
+  for( size_t t = info->ThreadID; t < tasks.size(); t += info->NumberOfThreads )
+    {
+    tasks[t].Entry.SmoothedImage = tasks[t].Smooth( tasks[t].LocalInput, tasks[t].Key.Variance,
+                                                    tasks[t].Key.UseImageSpacing, str->NumberOfThreadsPerTask );
+    tasks[t].LocalInput = ITK_NULLPTR;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<typename TFixedImage, typename TMovingImage>
+void
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::Clear()
+{
+  this->m_Cache.clear();
+}
+
+template<typename TFixedImage, typename TMovingImage>
+SizeValueType
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::GetNumberOfCachedImages() const
+{
+  return static_cast<SizeValueType>( this->m_Cache.size() );
+}
+
+template<typename TFixedImage, typename TMovingImage>
+void
+ImageRegistrationPyramidCache<TFixedImage, TMovingImage>
+::PrintSelf( std::ostream & os, Indent indent ) const
+{
+  Superclass::PrintSelf( os, indent );
+
+  os << indent << "Number of cached images: " << this->m_Cache.size() << std::endl;
+  os << indent << "Number of computed images: " << this->m_NumberOfComputedImages << std::endl;
+}
+
+} // end namespace itk
+
+#endif
@@ -22,6 +22,7 @@
 
 #include "itkImageMaskSpatialObject.h"
 #include "itkDisplacementFieldTransform.h"
+#include "itkVectorLinearInterpolateImageFunction.h"
 
 namespace itk
 {
@@ -38,6 +39,17 @@ namespace itk
  * Output: The output is the updated transform which has been added to the
  * composite transform.
  *
+ * At each iteration, the smoothed update fields are composed with the fixed
+ * and moving half-way displacement fields, the total fields are smoothed and
+ * their inverses are estimated.  These steps are done in place in the buffers
+ * of the half-way fields by multithreaded kernels, and the inversion of each
+ * field starts from the inverse estimated at the previous iteration, so
+ * that no full vector field is allocated per iteration except the update
+ * fields and one scratch field shared by all the steps.  A subclass may
+ * override GaussianSmoothDisplacementField() or InvertDisplacementField(), so
+ * for subclasses the fields are updated with these methods instead, unless
+ * CanUpdateFieldsInPlace() is overridden to return true.
+ *
  * This implementation is based on the source code in Advanced Normalization Tools (ANTs)
  *
  *   Avants, B. B.; Tustison, N. J.; Song, G.; Cook, P. A.; Klein, A. & Gee, J. C.
@@ -222,6 +234,39 @@ protected:
   virtual DisplacementFieldPointer GaussianSmoothDisplacementField( const DisplacementFieldType *, const RealType );
   virtual DisplacementFieldPointer InvertDisplacementField( const DisplacementFieldType *, const DisplacementFieldType * = ITK_NULLPTR );
 
+  /** Return whether the fields are smoothed and inverted in place at each
+   * iteration, without calling GaussianSmoothDisplacementField() and
+   * InvertDisplacementField().  By default, this is only done for this class
+   * itself, so that the overrides of these methods in a subclass are called.
+   * A subclass which does not override them can return true. */
+  virtual bool CanUpdateFieldsInPlace() const;
+
+  /** Replace the displacement field and the inverse field of a half-way
+   * transform by copies, so that the in-place updates do not modify the
+   * fields of a restored state. */
+  void CopyMiddleTransformFields( OutputTransformType * );
+
+  /** Compose the update field with the displacement field of a half-way
+   * transform, smooth the total field and update its inverse, in place when
+   * CanUpdateFieldsInPlace() is true, or with GaussianSmoothDisplacementField()
+   * and InvertDisplacementField() otherwise. */
+  void UpdateMiddleTransform( OutputTransformType *, const DisplacementFieldType * );
+
+  /** Compose the update field with the displacement field of a half-way
+   * transform, smooth the total field and update its inverse, in place.
+   * The fields must be owned by the registration method. */
+  void UpdateMiddleTransformInPlace( OutputTransformType *, const DisplacementFieldType * );
+
+  /** Smooth a displacement field in place as GaussianSmoothDisplacementField()
+   * does.  The unsmoothed field, if not given, is copied in a scratch buffer
+   * when the variance requires it. */
+  void GaussianSmoothDisplacementFieldInPlace( DisplacementFieldType *, const RealType,
+    const DisplacementFieldType * = ITK_NULLPTR );
+
+  /** Refine in place the estimate of the inverse of a displacement field, with
+   * the same algorithm and parameters as InvertDisplacementField(). */
+  void InvertDisplacementFieldInPlace( const DisplacementFieldType *, DisplacementFieldType * );
+
   RealType                                                        m_LearningRate;
 
   OutputTransformPointer                                          m_MovingToMiddleTransform;
@@ -239,6 +284,54 @@ private:
 
   RealType                                                        m_GaussianSmoothingVarianceForTheUpdateField;
   RealType                                                        m_GaussianSmoothingVarianceForTheTotalField;
+
+  typedef Image<RealType, ImageDimension>                                          RealImageType;
+  typedef VectorLinearInterpolateImageFunction<DisplacementFieldType, RealType>    DisplacementFieldInterpolatorType;
+  typedef typename DisplacementFieldType::RegionType                              DisplacementFieldRegionType;
+
+  /** Operations on the displacement fields done by FieldThreaderCallback(). */
+  enum FieldOperationType
+    {
+    COMPOSE_FIELDS,
+    SMOOTH_ALONG_DIRECTION,
+    BLEND_SMOOTHED_FIELD,
+    ESTIMATE_INVERSION_ERROR,
+    UPDATE_INVERSE_FIELD
+    };
+
+  struct FieldThreadStruct
+    {
+    FieldOperationType                          Operation;
+    DisplacementFieldRegionType                 Region;
+    DisplacementFieldType *                     Field;
+    const DisplacementFieldType *               InputField;
+    const DisplacementFieldInterpolatorType *   Interpolator;
+    RealImageType *                             ScaledNormImage;
+    unsigned int                                Direction;
+    std::vector<RealType>                       Kernel;
+    RealType                                    Weight;
+    RealType                                    MaxErrorNorm;
+    std::vector<RealType>                       ThreadMeanErrorNorms;
+    std::vector<RealType>                       ThreadMaxErrorNorms;
+    };
+
+  /** Run an operation on the displacement fields with the multithreader of
+   * the registration, each thread processing a part of the region. */
+  void ExecuteFieldOperation( FieldThreadStruct & str );
+  static ITK_THREAD_RETURN_TYPE FieldThreaderCallback( void * arg );
+
+  static void ThreadedComposeFields( const FieldThreadStruct & str, const DisplacementFieldRegionType & region );
+  static void ThreadedSmoothAlongDirection( const FieldThreadStruct & str, const DisplacementFieldRegionType & region );
+  static void ThreadedBlendSmoothedField( const FieldThreadStruct & str, const DisplacementFieldRegionType & region );
+  static void ThreadedEstimateInversionError( FieldThreadStruct & str, const DisplacementFieldRegionType & region,
+                                              ThreadIdType threadId );
+  static void ThreadedUpdateInverseField( const FieldThreadStruct & str, const DisplacementFieldRegionType & region );
+
+  /** Allocate the scratch buffers with the geometry of the given field. */
+  void AllocateScratchBuffers( const DisplacementFieldType * );
+
+  DisplacementFieldPointer                                        m_ScratchField;
+  typename RealImageType::Pointer                                 m_ScaledNormImage;
 };
 } // end namespace itk
 
@@ -23,13 +23,15 @@
 #include "itkComposeDisplacementFieldsImageFilter.h"
 #include "itkGaussianOperator.h"
 #include "itkImageMaskSpatialObject.h"
+#include "itkImageSourceCommon.h"
 #include "itkImportImageFilter.h"
 #include "itkInvertDisplacementFieldImageFilter.h"
 #include "itkIterationReporter.h"
 #include "itkMultiplyImageFilter.h"
-#include "itkVectorNeighborhoodOperatorImageFilter.h"
 #include "itkWindowConvergenceMonitoringFunction.h"
 
+#include <typeinfo>
+
 namespace itk
 {
 /**
@@ -118,10 +120,17 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
          && this->m_MovingToMiddleTransform->GetInverseDisplacementField() )
          {
          itkDebugMacro( "SyN registration is initialized by restoring the state.");
-         this->m_TransformParametersAdaptorsPerLevel[0]->SetTransform( this->m_MovingToMiddleTransform );
-         this->m_TransformParametersAdaptorsPerLevel[0]->AdaptTransformParameters();
-         this->m_TransformParametersAdaptorsPerLevel[0]->SetTransform( this->m_FixedToMiddleTransform );
-         this->m_TransformParametersAdaptorsPerLevel[0]->AdaptTransformParameters();
+         // The fields are updated in place during the optimization, so the
+         // fields of the restored state are copied once.
+         this->CopyMiddleTransformFields( this->m_MovingToMiddleTransform );
+         this->CopyMiddleTransformFields( this->m_FixedToMiddleTransform );
+         if( this->m_TransformParametersAdaptorsPerLevel[0] )
+           {
+           this->m_TransformParametersAdaptorsPerLevel[0]->SetTransform( this->m_MovingToMiddleTransform );
+           this->m_TransformParametersAdaptorsPerLevel[0]->AdaptTransformParameters();
+           this->m_TransformParametersAdaptorsPerLevel[0]->SetTransform( this->m_FixedToMiddleTransform );
+           this->m_TransformParametersAdaptorsPerLevel[0]->AdaptTransformParameters();
+           }
          }
       else
         {
@@ -196,48 +205,21 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
 
     if ( this->m_AverageMidPointGradients )
       {
-      ImageRegionIteratorWithIndex<DisplacementFieldType> ItF( fixedToMiddleSmoothUpdateField, fixedToMiddleSmoothUpdateField->GetLargestPossibleRegion() );
-      for( ItF.GoToBegin(); !ItF.IsAtEnd(); ++ItF )
+      DisplacementVectorType * fixedUpdateBuffer = fixedToMiddleSmoothUpdateField->GetBufferPointer();
+      DisplacementVectorType * movingUpdateBuffer = movingToMiddleSmoothUpdateField->GetBufferPointer();
+      const SizeValueType numberOfPixels = fixedToMiddleSmoothUpdateField->GetBufferedRegion().GetNumberOfPixels();
+      for( SizeValueType n = 0; n < numberOfPixels; n++ )
         {
-        ItF.Set( ItF.Get() - movingToMiddleSmoothUpdateField->GetPixel( ItF.GetIndex() ) );
-        movingToMiddleSmoothUpdateField->SetPixel( ItF.GetIndex(), -ItF.Get() );
+        fixedUpdateBuffer[n] = fixedUpdateBuffer[n] - movingUpdateBuffer[n];
+        movingUpdateBuffer[n] = -fixedUpdateBuffer[n];
         }
       }
 
-    // Add the update field to both displacement fields (from fixed/moving to middle image) and then smooth
-
-    typedef ComposeDisplacementFieldsImageFilter<DisplacementFieldType> ComposerType;
-
-    typename ComposerType::Pointer fixedComposer = ComposerType::New();
-    fixedComposer->SetDisplacementField( fixedToMiddleSmoothUpdateField );
-    fixedComposer->SetWarpingField( this->m_FixedToMiddleTransform->GetDisplacementField() );
-    fixedComposer->Update();
-
-    DisplacementFieldPointer fixedToMiddleSmoothTotalFieldTmp = this->GaussianSmoothDisplacementField(
-      fixedComposer->GetOutput(), this->m_GaussianSmoothingVarianceForTheTotalField );
-
-    typename ComposerType::Pointer movingComposer = ComposerType::New();
-    movingComposer->SetDisplacementField( movingToMiddleSmoothUpdateField );
-    movingComposer->SetWarpingField( this->m_MovingToMiddleTransform->GetDisplacementField() );
-    movingComposer->Update();
-
-    DisplacementFieldPointer movingToMiddleSmoothTotalFieldTmp = this->GaussianSmoothDisplacementField(
-      movingComposer->GetOutput(), this->m_GaussianSmoothingVarianceForTheTotalField );
-
-    // Iteratively estimate the inverse fields.
+    // Add the update field to both displacement fields (from fixed/moving to middle image), smooth
+    // them and update their inverses.
 
-    DisplacementFieldPointer fixedToMiddleSmoothTotalFieldInverse = this->InvertDisplacementField( fixedToMiddleSmoothTotalFieldTmp, this->m_FixedToMiddleTransform->GetInverseDisplacementField() );
-    DisplacementFieldPointer fixedToMiddleSmoothTotalField = this->InvertDisplacementField( fixedToMiddleSmoothTotalFieldInverse, fixedToMiddleSmoothTotalFieldTmp );
-
-    DisplacementFieldPointer movingToMiddleSmoothTotalFieldInverse = this->InvertDisplacementField( movingToMiddleSmoothTotalFieldTmp, this->m_MovingToMiddleTransform->GetInverseDisplacementField() );
-    DisplacementFieldPointer movingToMiddleSmoothTotalField = this->InvertDisplacementField( movingToMiddleSmoothTotalFieldInverse, movingToMiddleSmoothTotalFieldTmp );
-
-    // Assign the displacement fields and their inverses to the proper transforms.
-    this->m_FixedToMiddleTransform->SetDisplacementField( fixedToMiddleSmoothTotalField );
-    this->m_FixedToMiddleTransform->SetInverseDisplacementField( fixedToMiddleSmoothTotalFieldInverse );
-
-    this->m_MovingToMiddleTransform->SetDisplacementField( movingToMiddleSmoothTotalField );
-    this->m_MovingToMiddleTransform->SetInverseDisplacementField( movingToMiddleSmoothTotalFieldInverse );
+    this->UpdateMiddleTransform( this->m_FixedToMiddleTransform, fixedToMiddleSmoothUpdateField );
+    this->UpdateMiddleTransform( this->m_MovingToMiddleTransform, movingToMiddleSmoothUpdateField );
 
     this->m_CurrentMetricValue = 0.5 * ( movingMetricValue + fixedMetricValue );
 
@@ -250,6 +232,9 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
       }
     reporter.CompletedStep();
     }
+
+  this->m_ScratchField = ITK_NULLPTR;
+  this->m_ScaledNormImage = ITK_NULLPTR;
 }
 
 template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
@@ -264,10 +249,16 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
       fixedImages, fixedPointSets, fixedTransform, movingImages, movingPointSets, movingTransform,
       fixedImageMasks, movingImageMasks, value );
 
-  DisplacementFieldPointer updateField = this->GaussianSmoothDisplacementField( metricGradientField,
-    this->m_GaussianSmoothingVarianceForTheUpdateField );
+  if( this->CanUpdateFieldsInPlace() )
+    {
+    this->GaussianSmoothDisplacementFieldInPlace( metricGradientField, this->m_GaussianSmoothingVarianceForTheUpdateField );
+    }
+  else
+    {
+    metricGradientField = this->GaussianSmoothDisplacementField( metricGradientField, this->m_GaussianSmoothingVarianceForTheUpdateField );
+    }
 
-  DisplacementFieldPointer scaledUpdateField = this->ScaleUpdateField( updateField );
+  DisplacementFieldPointer scaledUpdateField = this->ScaleUpdateField( metricGradientField );
 
   return scaledUpdateField;
 }
@@ -602,8 +593,6 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
     scale /= maxNorm;
     }
 
-  typedef Image<RealType, ImageDimension> RealImageType;
-
   typedef MultiplyImageFilter<DisplacementFieldType, RealImageType, DisplacementFieldType> MultiplierType;
   typename MultiplierType::Pointer multiplier = MultiplierType::New();
   multiplier->SetInput( updateField );
@@ -648,16 +637,150 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
 
   DisplacementFieldPointer smoothField = duplicator->GetModifiableOutput();
 
+  this->GaussianSmoothDisplacementFieldInPlace( smoothField, variance, field );
+
+  return smoothField;
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+bool
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::CanUpdateFieldsInPlace() const
+{
+  return typeid( *this ) == typeid( Self );
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::CopyMiddleTransformFields( OutputTransformType * transform )
+{
+  typedef ImageDuplicator<DisplacementFieldType> DuplicatorType;
+
+  typename DuplicatorType::Pointer duplicator = DuplicatorType::New();
+  duplicator->SetInputImage( transform->GetDisplacementField() );
+  duplicator->Update();
+  DisplacementFieldPointer field = duplicator->GetModifiableOutput();
+
+  typename DuplicatorType::Pointer inverseDuplicator = DuplicatorType::New();
+  inverseDuplicator->SetInputImage( transform->GetInverseDisplacementField() );
+  inverseDuplicator->Update();
+  DisplacementFieldPointer inverseField = inverseDuplicator->GetModifiableOutput();
+
+  // Setting the displacement field resets the inverse field.
+  transform->SetDisplacementField( field );
+  transform->SetInverseDisplacementField( inverseField );
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::UpdateMiddleTransform( OutputTransformType * transform, const DisplacementFieldType * updateField )
+{
+  if( this->CanUpdateFieldsInPlace() )
+    {
+    this->UpdateMiddleTransformInPlace( transform, updateField );
+    return;
+    }
+
+  typedef ComposeDisplacementFieldsImageFilter<DisplacementFieldType> ComposerType;
+
+  typename ComposerType::Pointer composer = ComposerType::New();
+  composer->SetDisplacementField( updateField );
+  composer->SetWarpingField( transform->GetDisplacementField() );
+  composer->Update();
+
+  DisplacementFieldPointer smoothTotalFieldTmp = this->GaussianSmoothDisplacementField( composer->GetOutput(),
+    this->m_GaussianSmoothingVarianceForTheTotalField );
+
+  // Iteratively estimate the inverse field.
+
+  DisplacementFieldPointer smoothTotalFieldInverse = this->InvertDisplacementField( smoothTotalFieldTmp,
+    transform->GetInverseDisplacementField() );
+  DisplacementFieldPointer smoothTotalField = this->InvertDisplacementField( smoothTotalFieldInverse,
+    smoothTotalFieldTmp );
+
+  transform->SetDisplacementField( smoothTotalField );
+  transform->SetInverseDisplacementField( smoothTotalFieldInverse );
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::UpdateMiddleTransformInPlace( OutputTransformType * transform, const DisplacementFieldType * updateField )
+{
+  DisplacementFieldType * field = transform->GetModifiableDisplacementField();
+
+  DisplacementFieldPointer inverseField = transform->GetModifiableInverseDisplacementField();
+  if( inverseField.IsNull() )
+    {
+    inverseField = DisplacementFieldType::New();
+    inverseField->CopyInformation( field );
+    inverseField->SetRegions( field->GetLargestPossibleRegion() );
+    inverseField->Allocate();
+    inverseField->FillBuffer( DisplacementVectorType( 0.0 ) );
+    transform->SetInverseDisplacementField( inverseField );
+    }
+
+  // Compose the update field with the total field.  Each vector of the
+  // composed field only depends on the total field at the same index, so the
+  // result is written in the total field.
+  typename DisplacementFieldInterpolatorType::Pointer interpolator = DisplacementFieldInterpolatorType::New();
+  interpolator->SetInputImage( updateField );
+
+  FieldThreadStruct str;
+  str.Operation = COMPOSE_FIELDS;
+  str.Region = field->GetLargestPossibleRegion();
+  str.Field = field;
+  str.InputField = field;
+  str.Interpolator = interpolator;
+  this->ExecuteFieldOperation( str );
+
+  this->GaussianSmoothDisplacementFieldInPlace( field, this->m_GaussianSmoothingVarianceForTheTotalField );
+
+  // Iteratively estimate the inverse field starting from the previous inverse,
+  // then the total field from the new inverse starting from the smoothed field.
+  this->InvertDisplacementFieldInPlace( field, inverseField );
+  this->InvertDisplacementFieldInPlace( inverseField, field );
+
+  field->Modified();
+  transform->Modified();
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::GaussianSmoothDisplacementFieldInPlace( DisplacementFieldType * field, const RealType variance,
+  const DisplacementFieldType * unsmoothedField )
+{
   if( variance <= 0.0 )
     {
-    return smoothField;
+    return;
+    }
+
+  //make sure boundary does not move
+  RealType weight1 = 1.0;
+  if( variance < 0.5 )
+    {
+    weight1 = 1.0 - 1.0 * ( variance / 0.5 );
+    }
+
+  const typename DisplacementFieldType::RegionType region = field->GetLargestPossibleRegion();
+
+  if( weight1 < 1.0 && unsmoothedField == ITK_NULLPTR )
+    {
+    this->AllocateScratchBuffers( field );
+    std::copy( field->GetBufferPointer(), field->GetBufferPointer() + region.GetNumberOfPixels(),
+      this->m_ScratchField->GetBufferPointer() );
+    unsmoothedField = this->m_ScratchField;
     }
 
   typedef GaussianOperator<RealType, ImageDimension> GaussianSmoothingOperatorType;
   GaussianSmoothingOperatorType gaussianSmoothingOperator;
 
-  typedef VectorNeighborhoodOperatorImageFilter<DisplacementFieldType, DisplacementFieldType> GaussianSmoothingSmootherType;
-  typename GaussianSmoothingSmootherType::Pointer smoother = GaussianSmoothingSmootherType::New();
+  FieldThreadStruct str;
+  str.Operation = SMOOTH_ALONG_DIRECTION;
+  str.Field = field;
 
   for( SizeValueType d = 0; d < ImageDimension; d++ )
     {
@@ -665,47 +788,262 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
     gaussianSmoothingOperator.SetDirection( d );
     gaussianSmoothingOperator.SetVariance( variance );
     gaussianSmoothingOperator.SetMaximumError( 0.001 );
-    gaussianSmoothingOperator.SetMaximumKernelWidth( smoothField->GetRequestedRegion().GetSize()[d] );
+    gaussianSmoothingOperator.SetMaximumKernelWidth( region.GetSize()[d] );
     gaussianSmoothingOperator.CreateDirectional();
 
-    // todo: make sure we only smooth within the buffered region
-    smoother->SetOperator( gaussianSmoothingOperator );
-    smoother->SetInput( smoothField );
-    try
+    str.Kernel.resize( gaussianSmoothingOperator.Size() );
+    for( SizeValueType k = 0; k < gaussianSmoothingOperator.Size(); k++ )
       {
-      smoother->Update();
+      str.Kernel[k] = gaussianSmoothingOperator[k];
       }
-    catch( ExceptionObject & exc )
+
+    // Each thread smoothes the lines starting in its part of the region.
+    str.Direction = d;
+    str.Region = region;
+    str.Region.SetSize( d, 1 );
+    this->ExecuteFieldOperation( str );
+    }
+
+  str.Operation = BLEND_SMOOTHED_FIELD;
+  str.Region = region;
+  str.InputField = ( weight1 < 1.0 ) ? unsmoothedField : ITK_NULLPTR;
+  str.Weight = weight1;
+  this->ExecuteFieldOperation( str );
+
+  field->Modified();
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::InvertDisplacementFieldInPlace( const DisplacementFieldType * field, DisplacementFieldType * inverseField )
+{
+  this->AllocateScratchBuffers( field );
+
+  typename DisplacementFieldInterpolatorType::Pointer interpolator = DisplacementFieldInterpolatorType::New();
+  interpolator->SetInputImage( field );
+
+  FieldThreadStruct str;
+  str.Region = field->GetLargestPossibleRegion();
+  str.Interpolator = interpolator;
+  str.ScaledNormImage = this->m_ScaledNormImage;
+
+  const SizeValueType numberOfPixelsInRegion = str.Region.GetNumberOfPixels();
+  RealType maxErrorNorm = NumericTraits<RealType>::max();
+  RealType meanErrorNorm = NumericTraits<RealType>::max();
+  unsigned int iteration = 0;
+
+  while( iteration++ < 20 && maxErrorNorm > 0.1 && meanErrorNorm > 0.001 )
+    {
+    // The composed field is stored in the scratch field.
+    str.Operation = COMPOSE_FIELDS;
+    str.Field = this->m_ScratchField;
+    str.InputField = inverseField;
+    this->ExecuteFieldOperation( str );
+
+    str.Operation = ESTIMATE_INVERSION_ERROR;
+    this->ExecuteFieldOperation( str );
+
+    meanErrorNorm = NumericTraits<RealType>::ZeroValue();
+    maxErrorNorm = NumericTraits<RealType>::ZeroValue();
+    for( size_t n = 0; n < str.ThreadMeanErrorNorms.size(); n++ )
       {
-      std::string msg( "Caught exception: " );
-      msg += exc.what();
-      itkExceptionMacro( << msg );
+      meanErrorNorm += str.ThreadMeanErrorNorms[n];
+      maxErrorNorm = std::max( maxErrorNorm, str.ThreadMaxErrorNorms[n] );
       }
+    meanErrorNorm /= static_cast<RealType>( numberOfPixelsInRegion );
+
+    str.Operation = UPDATE_INVERSE_FIELD;
+    str.Field = inverseField;
+    str.InputField = this->m_ScratchField;
+    str.Weight = ( iteration == 1 ) ? 0.75 : 0.5;
+    str.MaxErrorNorm = maxErrorNorm;
+    this->ExecuteFieldOperation( str );
+    }
 
-    smoothField = smoother->GetOutput();
-    smoothField->Update();
-    smoothField->DisconnectPipeline();
+  inverseField->Modified();
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::AllocateScratchBuffers( const DisplacementFieldType * field )
+{
+  const typename DisplacementFieldType::RegionType region = field->GetLargestPossibleRegion();
+  if( this->m_ScratchField.IsNull() || this->m_ScratchField->GetBufferedRegion() != region )
+    {
+    this->m_ScratchField = DisplacementFieldType::New();
+    this->m_ScratchField->CopyInformation( field );
+    this->m_ScratchField->SetRegions( region );
+    this->m_ScratchField->Allocate();
+
+    this->m_ScaledNormImage = RealImageType::New();
+    this->m_ScaledNormImage->CopyInformation( field );
+    this->m_ScaledNormImage->SetRegions( region );
+    this->m_ScaledNormImage->Allocate();
     }
+}
 
-  const DisplacementVectorType zeroVector( 0.0 );
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ExecuteFieldOperation( FieldThreadStruct & str )
+{
+  const ThreadIdType numberOfThreads = ImageSourceCommon::GetGlobalDefaultSplitter()->GetNumberOfSplits(
+    str.Region, this->GetNumberOfThreads() );
 
-  //make sure boundary does not move
-  RealType weight1 = 1.0;
-  if( variance < 0.5 )
+  str.ThreadMeanErrorNorms.assign( numberOfThreads, NumericTraits<RealType>::ZeroValue() );
+  str.ThreadMaxErrorNorms.assign( numberOfThreads, NumericTraits<RealType>::ZeroValue() );
+
+  this->GetMultiThreader()->SetNumberOfThreads( numberOfThreads );
+  this->GetMultiThreader()->SetSingleMethod( Self::FieldThreaderCallback, &str );
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+ITK_THREAD_RETURN_TYPE
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::FieldThreaderCallback( void * arg )
+{
+  MultiThreader::ThreadInfoStruct * info = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  FieldThreadStruct * str = static_cast<FieldThreadStruct *>( info->UserData );
+
+  DisplacementFieldRegionType region = str->Region;
+  const ThreadIdType numberOfSplits = ImageSourceCommon::GetGlobalDefaultSplitter()->GetSplit(
+    info->ThreadID, info->NumberOfThreads, region );
+  if( info->ThreadID >= numberOfSplits )
     {
-    weight1 = 1.0 - 1.0 * ( variance / 0.5 );
+    return ITK_THREAD_RETURN_VALUE;
     }
-  RealType weight2 = 1.0 - weight1;
 
-  const typename DisplacementFieldType::RegionType region = field->GetLargestPossibleRegion();
-  const typename DisplacementFieldType::SizeType size = region.GetSize();
-  const typename DisplacementFieldType::IndexType startIndex = region.GetIndex();
+  switch( str->Operation )
+    {
+    case COMPOSE_FIELDS:
+      Self::ThreadedComposeFields( *str, region );
+      break;
+    case SMOOTH_ALONG_DIRECTION:
+      Self::ThreadedSmoothAlongDirection( *str, region );
+      break;
+    case BLEND_SMOOTHED_FIELD:
+      Self::ThreadedBlendSmoothedField( *str, region );
+      break;
+    case ESTIMATE_INVERSION_ERROR:
+      Self::ThreadedEstimateInversionError( *str, region, info->ThreadID );
+      break;
+    case UPDATE_INVERSE_FIELD:
+      Self::ThreadedUpdateInverseField( *str, region );
+      break;
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ThreadedComposeFields( const FieldThreadStruct & str, const DisplacementFieldRegionType & region )
+{
+  // Same computation as ComposeDisplacementFieldsImageFilter, with the
+  // displacement field given by the interpolator and the warping field by
+  // the input field.  The output can be the warping field.
+  const DisplacementFieldType * warpingField = str.InputField;
+
+  ImageRegionConstIteratorWithIndex<DisplacementFieldType> ItW( warpingField, region );
+  ImageRegionIterator<DisplacementFieldType> ItF( str.Field, region );
 
-  ImageRegionConstIteratorWithIndex<DisplacementFieldType> ItF( field, field->GetLargestPossibleRegion() );
-  ImageRegionIteratorWithIndex<DisplacementFieldType> ItS( smoothField, smoothField->GetLargestPossibleRegion() );
-  for( ItF.GoToBegin(), ItS.GoToBegin(); !ItF.IsAtEnd(); ++ItF, ++ItS )
+  typename DisplacementFieldType::PointType pointIn1;
+  typename DisplacementFieldType::PointType pointIn2;
+  typename DisplacementFieldType::PointType pointIn3;
+
+  for( ItW.GoToBegin(), ItF.GoToBegin(); !ItW.IsAtEnd(); ++ItW, ++ItF )
     {
-    typename DisplacementFieldType::IndexType index = ItF.GetIndex();
+    warpingField->TransformIndexToPhysicalPoint( ItW.GetIndex(), pointIn1 );
+
+    const DisplacementVectorType warpVector = ItW.Get();
+
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      pointIn2[d] = pointIn1[d] + warpVector[d];
+      }
+
+    typename DisplacementFieldInterpolatorType::OutputType displacement( 0.0 );
+    if( str.Interpolator->IsInsideBuffer( pointIn2 ) )
+      {
+      displacement = str.Interpolator->Evaluate( pointIn2 );
+      }
+
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      pointIn3[d] = pointIn2[d] + displacement[d];
+      }
+
+    ItF.Set( pointIn3 - pointIn1 );
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ThreadedSmoothAlongDirection( const FieldThreadStruct & str, const DisplacementFieldRegionType & region )
+{
+  // Convolve the lines along the direction with the kernel, with a zero-flux
+  // Neumann boundary condition as VectorNeighborhoodOperatorImageFilter.
+  DisplacementFieldType * field = str.Field;
+  const IndexValueType lineLength = static_cast<IndexValueType>( field->GetBufferedRegion().GetSize()[str.Direction] );
+  const OffsetValueType stride = field->GetOffsetTable()[str.Direction];
+  const IndexValueType radius = static_cast<IndexValueType>( str.Kernel.size() / 2 );
+
+  std::vector<DisplacementVectorType> line( lineLength );
+
+  ImageRegionConstIteratorWithIndex<DisplacementFieldType> It( field, region );
+  for( It.GoToBegin(); !It.IsAtEnd(); ++It )
+    {
+    DisplacementVectorType * linePointer = field->GetBufferPointer() + field->ComputeOffset( It.GetIndex() );
+    for( IndexValueType i = 0; i < lineLength; i++ )
+      {
+      line[i] = linePointer[i * stride];
+      }
+    for( IndexValueType i = 0; i < lineLength; i++ )
+      {
+      DisplacementVectorType sum( NumericTraits<RealType>::ZeroValue() );
+      for( IndexValueType k = 0; k < static_cast<IndexValueType>( str.Kernel.size() ); k++ )
+        {
+        const IndexValueType j = std::min( std::max( i + k - radius, NumericTraits<IndexValueType>::ZeroValue() ), lineLength - 1 );
+        for( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          sum[d] += str.Kernel[k] * line[j][d];
+          }
+        }
+      linePointer[i * stride] = sum;
+      }
+    }
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ThreadedBlendSmoothedField( const FieldThreadStruct & str, const DisplacementFieldRegionType & region )
+{
+  // Average the smoothed field with the unsmoothed one if present, and make
+  // sure the boundary does not move.
+  const typename DisplacementFieldType::RegionType fullRegion = str.Field->GetLargestPossibleRegion();
+  const typename DisplacementFieldType::SizeType size = fullRegion.GetSize();
+  const typename DisplacementFieldType::IndexType startIndex = fullRegion.GetIndex();
+  const DisplacementVectorType zeroVector( 0.0 );
+
+  const RealType weight1 = str.Weight;
+  const RealType weight2 = 1.0 - weight1;
+
+  ImageRegionIteratorWithIndex<DisplacementFieldType> ItS( str.Field, region );
+  const DisplacementVectorType * unsmoothedPointer = ITK_NULLPTR;
+  if( str.InputField )
+    {
+    unsmoothedPointer = str.InputField->GetBufferPointer();
+    }
+
+  for( ItS.GoToBegin(); !ItS.IsAtEnd(); ++ItS )
+    {
+    const typename DisplacementFieldType::IndexType index = ItS.GetIndex();
     bool isOnBoundary = false;
     for ( unsigned int d = 0; d < ImageDimension; d++ )
       {
@@ -719,13 +1057,97 @@ SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtual
       {
       ItS.Set( zeroVector );
       }
+    else if( unsmoothedPointer )
+      {
+      ItS.Set( ItS.Get() * weight1 + unsmoothedPointer[str.Field->ComputeOffset( index )] * weight2 );
+      }
     else
       {
-      ItS.Set( ItS.Get() * weight1 + ItF.Get() * weight2 );
+      ItS.Set( ItS.Get() * weight1 );
       }
     }
+}
 
-  return smoothField;
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ThreadedEstimateInversionError( FieldThreadStruct & str, const DisplacementFieldRegionType & region,
+  ThreadIdType threadId )
+{
+  // Same computation as InvertDisplacementFieldImageFilter: store the norm of
+  // the composed field scaled by the spacing, and negate the composed field.
+  DisplacementVectorType inverseSpacing;
+  for( unsigned int d = 0; d < ImageDimension; ++d )
+    {
+    inverseSpacing[d] = 1.0 / str.Field->GetSpacing()[d];
+    }
+
+  ImageRegionIterator<DisplacementFieldType> ItE( str.Field, region );
+  ImageRegionIterator<RealImageType> ItS( str.ScaledNormImage, region );
+
+  RealType localMean = NumericTraits<RealType>::ZeroValue();
+  RealType localMax  = NumericTraits<RealType>::ZeroValue();
+  for( ItE.GoToBegin(), ItS.GoToBegin(); !ItE.IsAtEnd(); ++ItE, ++ItS )
+    {
+    const DisplacementVectorType & displacement = ItE.Get();
+    RealType scaledNorm = 0.0;
+    for( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      scaledNorm += itk::Math::sqr( displacement[d] * inverseSpacing[d] );
+      }
+    scaledNorm = std::sqrt( scaledNorm );
+
+    localMean += scaledNorm;
+    if( localMax < scaledNorm )
+      {
+      localMax = scaledNorm;
+      }
+
+    ItS.Set( scaledNorm );
+    ItE.Set( -displacement );
+    }
+
+  str.ThreadMeanErrorNorms[threadId] = localMean;
+  str.ThreadMaxErrorNorms[threadId] = localMax;
+}
+
+template<typename TFixedImage, typename TMovingImage, typename TOutputTransform, typename TVirtualImage, typename TPointSet>
+void
+SyNImageRegistrationMethod<TFixedImage, TMovingImage, TOutputTransform, TVirtualImage, TPointSet>
+::ThreadedUpdateInverseField( const FieldThreadStruct & str, const DisplacementFieldRegionType & region )
+{
+  const typename DisplacementFieldType::RegionType fullRegion = str.Field->GetLargestPossibleRegion();
+  const typename DisplacementFieldType::SizeType size = fullRegion.GetSize();
+  const typename DisplacementFieldType::IndexType startIndex = fullRegion.GetIndex();
+  const DisplacementVectorType zeroVector( 0.0 );
+  const RealType epsilon = str.Weight;
+
+  ImageRegionIteratorWithIndex<DisplacementFieldType> ItI( str.Field, region );
+  ImageRegionConstIterator<DisplacementFieldType> ItE( str.InputField, region );
+  ImageRegionConstIterator<RealImageType> ItS( str.ScaledNormImage, region );
+
+  for( ItI.GoToBegin(), ItE.GoToBegin(), ItS.GoToBegin(); !ItI.IsAtEnd(); ++ItI, ++ItE, ++ItS )
+    {
+    DisplacementVectorType update = ItE.Get();
+    const RealType scaledNorm = ItS.Get();
+
+    if( scaledNorm > epsilon * str.MaxErrorNorm )
+      {
+      update *= ( epsilon * str.MaxErrorNorm / scaledNorm );
+      }
+    update = ItI.Get() + update * epsilon;
+    ItI.Set( update );
+
+    const typename DisplacementFieldType::IndexType index = ItI.GetIndex();
+    for( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      if( index[d] == startIndex[d] || index[d] == static_cast<IndexValueType>( size[d] ) - startIndex[d] - 1 )
+        {
+        ItI.Set( zeroVector );
+        break;
+        }
+      }
+    }
 }
 
 /*
@@ -0,0 +1,241 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageRegistrationMethodv4.h"
+#include "itkSyNImageRegistrationMethod.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkGradientDescentOptimizerv4.h"
+#include "itkRegistrationParameterScalesFromPhysicalShift.h"
+#include "itkTranslationTransform.h"
+#include "itkAffineTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the ImageRegistrationPyramidCache: the smoothed images are computed
+ * once for a multistage registration (translation, affine and SyN) sharing
+ * the cache, optionally in one parallel pass, and the registration results
+ * are identical to those obtained without cache.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image<double, Dimension>                                   ImageType;
+typedef itk::ImageRegistrationPyramidCache<ImageType, ImageType>        PyramidCacheType;
+typedef itk::TranslationTransform<double, Dimension>                    TranslationTransformType;
+typedef itk::AffineTransform<double, Dimension>                         AffineTransformType;
+typedef itk::ImageRegistrationMethodv4<ImageType, ImageType, TranslationTransformType> TranslationRegistrationType;
+typedef itk::ImageRegistrationMethodv4<ImageType, ImageType, AffineTransformType>      AffineRegistrationType;
+typedef itk::SyNImageRegistrationMethod<ImageType, ImageType>           SyNRegistrationType;
+typedef itk::MeanSquaresImageToImageMetricv4<ImageType, ImageType>      MetricType;
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill( 48 );
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 24.0 - shift;
+    const double y = it.GetIndex()[1] - 24.0;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 100.0 ) );
+    }
+  return image;
+}
+
+template<typename TRegistration>
+void
+SetUpRegistration( TRegistration * registration, ImageType * fixedImage, ImageType * movingImage,
+                   unsigned int numberOfLevels, unsigned int numberOfIterations )
+{
+  typename TRegistration::ShrinkFactorsArrayType shrinkFactorsPerLevel( numberOfLevels );
+  typename TRegistration::SmoothingSigmasArrayType smoothingSigmasPerLevel( numberOfLevels );
+  for( unsigned int level = 0; level < numberOfLevels; ++level )
+    {
+    shrinkFactorsPerLevel[level] = 1 << ( numberOfLevels - 1 - level );
+    smoothingSigmasPerLevel[level] = numberOfLevels - 1 - level;
+    }
+
+  MetricType::Pointer metric = MetricType::New();
+  registration->SetFixedImage( fixedImage );
+  registration->SetMovingImage( movingImage );
+  registration->SetMetric( metric );
+  registration->SetNumberOfLevels( numberOfLevels );
+  registration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  registration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  registration->SetSmoothingSigmasAreSpecifiedInPhysicalUnits( false );
+
+  typedef itk::RegistrationParameterScalesFromPhysicalShift<MetricType> ScalesEstimatorType;
+  ScalesEstimatorType::Pointer scalesEstimator = ScalesEstimatorType::New();
+  scalesEstimator->SetMetric( metric );
+  scalesEstimator->SetTransformForward( true );
+
+  typedef itk::GradientDescentOptimizerv4 OptimizerType;
+  OptimizerType::Pointer optimizer = OptimizerType::New();
+  optimizer->SetLearningRate( 1.0 );
+  optimizer->SetNumberOfIterations( numberOfIterations );
+  optimizer->SetScalesEstimator( scalesEstimator );
+  registration->SetOptimizer( optimizer );
+}
+
+/** Run a translation, an affine and a SyN stage sharing the given cache, and
+ * return the parameters of the last two stages. */
+std::vector<double>
+RunStages( ImageType * fixedImage, ImageType * movingImage, PyramidCacheType * cache, bool precomputePyramid )
+{
+  TranslationRegistrationType::Pointer translationRegistration = TranslationRegistrationType::New();
+  SetUpRegistration( translationRegistration.GetPointer(), fixedImage, movingImage, 3, 20 );
+  translationRegistration->SetPyramidCache( cache );
+  translationRegistration->SetPrecomputePyramid( precomputePyramid );
+  translationRegistration->Update();
+
+  AffineRegistrationType::Pointer affineRegistration = AffineRegistrationType::New();
+  SetUpRegistration( affineRegistration.GetPointer(), fixedImage, movingImage, 3, 10 );
+  affineRegistration->SetMovingInitialTransform( translationRegistration->GetTransform() );
+  affineRegistration->SetPyramidCache( cache );
+  affineRegistration->SetPrecomputePyramid( precomputePyramid );
+  affineRegistration->Update();
+
+  typedef SyNRegistrationType::OutputTransformType DisplacementFieldTransformType;
+  typedef DisplacementFieldTransformType::DisplacementFieldType DisplacementFieldType;
+  DisplacementFieldType::Pointer displacementField = DisplacementFieldType::New();
+  displacementField->CopyInformation( fixedImage );
+  displacementField->SetRegions( fixedImage->GetBufferedRegion() );
+  displacementField->Allocate();
+  displacementField->FillBuffer( DisplacementFieldType::PixelType( 0.0 ) );
+  DisplacementFieldTransformType::Pointer displacementFieldTransform = DisplacementFieldTransformType::New();
+  displacementFieldTransform->SetDisplacementField( displacementField );
+
+  typedef itk::CompositeTransform<double, Dimension> CompositeTransformType;
+  CompositeTransformType::Pointer compositeTransform = CompositeTransformType::New();
+  compositeTransform->AddTransform( translationRegistration->GetModifiableTransform() );
+  compositeTransform->AddTransform( affineRegistration->GetModifiableTransform() );
+
+  SyNRegistrationType::Pointer synRegistration = SyNRegistrationType::New();
+  SetUpRegistration( synRegistration.GetPointer(), fixedImage, movingImage, 1, 0 );
+  SyNRegistrationType::NumberOfIterationsArrayType numberOfIterationsPerLevel( 1 );
+  numberOfIterationsPerLevel[0] = 3;
+  synRegistration->SetNumberOfIterationsPerLevel( numberOfIterationsPerLevel );
+  synRegistration->SetInitialTransform( displacementFieldTransform );
+  synRegistration->SetMovingInitialTransform( compositeTransform );
+  synRegistration->SetPyramidCache( cache );
+  synRegistration->SetPrecomputePyramid( precomputePyramid );
+  synRegistration->Update();
+
+  std::vector<double> results;
+  const AffineTransformType::ParametersType & affineParameters = affineRegistration->GetTransform()->GetParameters();
+  for( unsigned int i = 0; i < affineParameters.Size(); ++i )
+    {
+    results.push_back( affineParameters[i] );
+    }
+  const DisplacementFieldType * field = synRegistration->GetTransform()->GetDisplacementField();
+  const DisplacementFieldType::PixelType * fieldPtr = field->GetBufferPointer();
+  for( itk::SizeValueType i = 0; i < field->GetBufferedRegion().GetNumberOfPixels(); ++i )
+    {
+    results.push_back( fieldPtr[i][0] );
+    results.push_back( fieldPtr[i][1] );
+    }
+  return results;
+}
+}
+
+int itkImageRegistrationPyramidCacheTest( int, char *[] )
+{
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 2.5 );
+
+  // Cached images are computed once, and recomputed after a modification
+  // of their input.
+  PyramidCacheType::Pointer cache = PyramidCacheType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( cache, ImageRegistrationPyramidCache, Object );
+
+  ImageType::Pointer smoothedImage = cache->GetSmoothedFixedImage( fixedImage, 4.0, false );
+  TEST_EXPECT_EQUAL( smoothedImage, cache->GetSmoothedFixedImage( fixedImage, 4.0, false ) );
+  TEST_EXPECT_TRUE( smoothedImage != cache->GetSmoothedFixedImage( fixedImage, 4.0, true ) );
+  TEST_SET_GET_VALUE( 2, cache->GetNumberOfComputedImages() );
+  fixedImage->Modified();
+  TEST_EXPECT_TRUE( smoothedImage != cache->GetSmoothedFixedImage( fixedImage, 4.0, false ) );
+  TEST_SET_GET_VALUE( 1, cache->GetNumberOfCachedImages() );
+  TEST_SET_GET_VALUE( 3, cache->GetNumberOfComputedImages() );
+
+  ImageType::Pointer uncachedImage = PyramidCacheType::SmoothImage( fixedImage.GetPointer(), 4.0, false );
+  itk::ImageRegionConstIterator<ImageType> itCached( smoothedImage, smoothedImage->GetBufferedRegion() );
+  itk::ImageRegionConstIterator<ImageType> itUncached( uncachedImage, uncachedImage->GetBufferedRegion() );
+  for( ; !itCached.IsAtEnd(); ++itCached, ++itUncached )
+    {
+    TEST_EXPECT_TRUE( itk::Math::ExactlyEquals( itCached.Get(), itUncached.Get() ) );
+    }
+  cache->Clear();
+  TEST_SET_GET_VALUE( 0, cache->GetNumberOfCachedImages() );
+
+  // The parallel pass also drops the images smoothed before a modification
+  // of their input.
+  PyramidCacheType::FixedImagesContainerType fixedImages( 1, fixedImage.GetPointer() );
+  PyramidCacheType::MovingImagesContainerType movingImages( 1, ITK_NULLPTR );
+  PyramidCacheType::VariancesContainerType variances( 2, 1.0 );
+  variances[1] = 4.0;
+  cache->ComputeSmoothedImages( fixedImages, movingImages, variances, false, 1 );
+  TEST_SET_GET_VALUE( 2, cache->GetNumberOfCachedImages() );
+  fixedImage->Modified();
+  cache->ComputeSmoothedImages( fixedImages, movingImages, variances, false, 2 );
+  TEST_SET_GET_VALUE( 2, cache->GetNumberOfCachedImages() );
+  TEST_SET_GET_VALUE( 7, cache->GetNumberOfComputedImages() );
+  cache->Clear();
+
+  // The three stages smooth the fixed and moving images with the sigmas
+  // 2, 1 and 0 only once.
+  const std::vector<double> referenceResults = RunStages( fixedImage, movingImage, ITK_NULLPTR, false );
+
+  PyramidCacheType::Pointer sharedCache = PyramidCacheType::New();
+  const std::vector<double> cachedResults = RunStages( fixedImage, movingImage, sharedCache, false );
+  TEST_SET_GET_VALUE( 6, sharedCache->GetNumberOfComputedImages() );
+
+  PyramidCacheType::Pointer precomputedCache = PyramidCacheType::New();
+  const std::vector<double> precomputedResults = RunStages( fixedImage, movingImage, precomputedCache, true );
+  TEST_SET_GET_VALUE( 6, precomputedCache->GetNumberOfComputedImages() );
+
+  TEST_SET_GET_VALUE( referenceResults.size(), cachedResults.size() );
+  TEST_SET_GET_VALUE( referenceResults.size(), precomputedResults.size() );
+  for( size_t i = 0; i < referenceResults.size(); ++i )
+    {
+    if( itk::Math::NotExactlyEquals( referenceResults[i], cachedResults[i] ) ||
+        itk::Math::NotExactlyEquals( referenceResults[i], precomputedResults[i] ) )
+      {
+      std::cerr << "Result " << i << " is " << cachedResults[i] << " with a cache and "
+                << precomputedResults[i] << " with a precomputed pyramid instead of "
+                << referenceResults[i] << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+  std::cout << "Affine parameters:";
+  for( unsigned int i = 0; i < 6; ++i )
+    {
+    std::cout << " " << referenceResults[i];
+    }
+  std::cout << std::endl;
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
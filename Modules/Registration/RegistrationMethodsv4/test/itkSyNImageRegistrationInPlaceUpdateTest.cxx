@@ -0,0 +1,370 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkSyNImageRegistrationMethod.h"
+#include "itkMeanSquaresImageToImageMetricv4.h"
+#include "itkGaussianOperator.h"
+#include "itkVectorNeighborhoodOperatorImageFilter.h"
+#include "itkInvertDisplacementFieldImageFilter.h"
+#include "itkImageDuplicator.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Test the in-place updates of the half-way fields of
+ * SyNImageRegistrationMethod: the smoothing and the inversion of the
+ * displacement fields give the results of the filter pipelines, and a
+ * registration keeps the fields consistent with their inverses and leaves
+ * the fields of a restored state unchanged.  A subclass which overrides the
+ * smoothing and the inversion of the fields has its overrides called, and
+ * gets the same fields.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image<double, Dimension>                                   ImageType;
+
+class SyNInPlaceUpdateTester
+  : public itk::SyNImageRegistrationMethod<ImageType, ImageType>
+{
+public:
+  typedef SyNInPlaceUpdateTester                                  Self;
+  typedef itk::SyNImageRegistrationMethod<ImageType, ImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                 Pointer;
+  itkNewMacro( Self );
+
+  using Superclass::GaussianSmoothDisplacementField;
+  using Superclass::GaussianSmoothDisplacementFieldInPlace;
+  using Superclass::InvertDisplacementFieldInPlace;
+
+protected:
+  virtual bool CanUpdateFieldsInPlace() const ITK_OVERRIDE
+  {
+    return true;
+  }
+};
+
+class SyNOverridingTester
+  : public itk::SyNImageRegistrationMethod<ImageType, ImageType>
+{
+public:
+  typedef SyNOverridingTester                                     Self;
+  typedef itk::SyNImageRegistrationMethod<ImageType, ImageType>  Superclass;
+  typedef itk::SmartPointer<Self>                                 Pointer;
+  itkNewMacro( Self );
+
+  unsigned int m_NumberOfSmoothings;
+  unsigned int m_NumberOfInversions;
+
+protected:
+  SyNOverridingTester() : m_NumberOfSmoothings( 0 ), m_NumberOfInversions( 0 ) {}
+
+  virtual DisplacementFieldPointer GaussianSmoothDisplacementField( const DisplacementFieldType * field,
+    const RealType variance ) ITK_OVERRIDE
+  {
+    ++m_NumberOfSmoothings;
+    return Superclass::GaussianSmoothDisplacementField( field, variance );
+  }
+
+  virtual DisplacementFieldPointer InvertDisplacementField( const DisplacementFieldType * field,
+    const DisplacementFieldType * inverseFieldEstimate ) ITK_OVERRIDE
+  {
+    ++m_NumberOfInversions;
+    return Superclass::InvertDisplacementField( field, inverseFieldEstimate );
+  }
+};
+
+typedef SyNInPlaceUpdateTester::DisplacementFieldType                   DisplacementFieldType;
+typedef DisplacementFieldType::PixelType                                VectorType;
+
+DisplacementFieldType::Pointer
+CreateField( double amplitude )
+{
+  DisplacementFieldType::Pointer field = DisplacementFieldType::New();
+  DisplacementFieldType::SizeType size;
+  size[0] = 37;
+  size[1] = 29;
+  DisplacementFieldType::SpacingType spacing;
+  spacing[0] = 1.0;
+  spacing[1] = 1.5;
+  field->SetRegions( size );
+  field->SetSpacing( spacing );
+  field->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<DisplacementFieldType> it( field, field->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0];
+    const double y = it.GetIndex()[1];
+    VectorType vector;
+    vector[0] = amplitude * std::sin( 0.2 * x ) * std::cos( 0.15 * y ) + 0.1 * std::sin( 3.0 * x + y );
+    vector[1] = amplitude * std::cos( 0.1 * x + 0.2 * y );
+    it.Set( vector );
+    }
+  return field;
+}
+
+/** Smoothing with the filters previously used by SyNImageRegistrationMethod. */
+DisplacementFieldType::Pointer
+SmoothWithFilters( const DisplacementFieldType * field, double variance )
+{
+  DisplacementFieldType::Pointer smoothField = const_cast<DisplacementFieldType *>( field );
+
+  typedef itk::GaussianOperator<double, Dimension> OperatorType;
+  typedef itk::VectorNeighborhoodOperatorImageFilter<DisplacementFieldType, DisplacementFieldType> SmootherType;
+  for( unsigned int d = 0; d < Dimension; ++d )
+    {
+    OperatorType gaussianOperator;
+    gaussianOperator.SetDirection( d );
+    gaussianOperator.SetVariance( variance );
+    gaussianOperator.SetMaximumError( 0.001 );
+    gaussianOperator.SetMaximumKernelWidth( field->GetLargestPossibleRegion().GetSize()[d] );
+    gaussianOperator.CreateDirectional();
+
+    SmootherType::Pointer smoother = SmootherType::New();
+    smoother->SetOperator( gaussianOperator );
+    smoother->SetInput( smoothField );
+    smoother->Update();
+    smoothField = smoother->GetOutput();
+    smoothField->DisconnectPipeline();
+    }
+
+  const double weight1 = ( variance < 0.5 ) ? 1.0 - variance / 0.5 : 1.0;
+  const double weight2 = 1.0 - weight1;
+  const DisplacementFieldType::SizeType size = field->GetLargestPossibleRegion().GetSize();
+  itk::ImageRegionIteratorWithIndex<DisplacementFieldType> it( smoothField, smoothField->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    bool isOnBoundary = false;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      if( it.GetIndex()[d] == 0 || it.GetIndex()[d] == static_cast<itk::IndexValueType>( size[d] ) - 1 )
+        {
+        isOnBoundary = true;
+        }
+      }
+    if( isOnBoundary )
+      {
+      it.Set( VectorType( 0.0 ) );
+      }
+    else
+      {
+      it.Set( it.Get() * weight1 + field->GetPixel( it.GetIndex() ) * weight2 );
+      }
+    }
+  return smoothField;
+}
+
+double
+MaximumDifference( const DisplacementFieldType * field1, const DisplacementFieldType * field2 )
+{
+  double maximumDifference = 0.0;
+  const itk::SizeValueType numberOfPixels = field1->GetBufferedRegion().GetNumberOfPixels();
+  for( itk::SizeValueType i = 0; i < numberOfPixels; ++i )
+    {
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      maximumDifference = std::max( maximumDifference,
+        itk::Math::abs( field1->GetBufferPointer()[i][d] - field2->GetBufferPointer()[i][d] ) );
+      }
+    }
+  return maximumDifference;
+}
+
+ImageType::Pointer
+CreateImage( double shift )
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill( 40 );
+  image->SetRegions( size );
+  image->Allocate();
+
+  itk::ImageRegionIteratorWithIndex<ImageType> it( image, image->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const double x = it.GetIndex()[0] - 20.0 - shift;
+    const double y = it.GetIndex()[1] - 20.0;
+    it.Set( 100.0 * std::exp( -( x * x + 2.0 * y * y ) / 80.0 ) );
+    }
+  return image;
+}
+}
+
+int itkSyNImageRegistrationInPlaceUpdateTest( int, char *[] )
+{
+  SyNInPlaceUpdateTester::Pointer tester = SyNInPlaceUpdateTester::New();
+
+  // The in-place smoothing gives the result of the filters, with and without
+  // averaging with the unsmoothed field.
+  const double variances[] = { 0.2, 0.5, 3.0 };
+  for( unsigned int v = 0; v < 3; ++v )
+    {
+    DisplacementFieldType::Pointer field = CreateField( 2.0 );
+    DisplacementFieldType::Pointer referenceField = SmoothWithFilters( field, variances[v] );
+    DisplacementFieldType::Pointer smoothField = tester->GaussianSmoothDisplacementField( field, variances[v] );
+    tester->GaussianSmoothDisplacementFieldInPlace( field, variances[v] );
+
+    std::cout << "Variance " << variances[v] << ": maximum difference " << MaximumDifference( field, referenceField )
+              << std::endl;
+    TEST_EXPECT_TRUE( MaximumDifference( field, referenceField ) < 1e-12 );
+    TEST_EXPECT_TRUE( MaximumDifference( smoothField, referenceField ) < 1e-12 );
+    }
+
+  // The in-place inversion gives the result of InvertDisplacementFieldImageFilter
+  // started from the same estimate.
+  DisplacementFieldType::Pointer field = tester->GaussianSmoothDisplacementField( CreateField( 1.5 ), 2.0 );
+  DisplacementFieldType::Pointer inverseEstimate = tester->GaussianSmoothDisplacementField( CreateField( -1.2 ), 2.0 );
+
+  typedef itk::InvertDisplacementFieldImageFilter<DisplacementFieldType> InverterType;
+  InverterType::Pointer inverter = InverterType::New();
+  inverter->SetInput( field );
+  inverter->SetInverseFieldInitialEstimate( inverseEstimate );
+  inverter->SetMaximumNumberOfIterations( 20 );
+  inverter->SetMeanErrorToleranceThreshold( 0.001 );
+  inverter->SetMaxErrorToleranceThreshold( 0.1 );
+  inverter->Update();
+
+  tester->InvertDisplacementFieldInPlace( field, inverseEstimate );
+  std::cout << "Inversion: maximum difference " << MaximumDifference( inverseEstimate, inverter->GetOutput() )
+            << std::endl;
+  TEST_EXPECT_TRUE( MaximumDifference( inverseEstimate, inverter->GetOutput() ) < 1e-10 );
+
+  // A registration updates the half-way fields and their inverses in place.
+  ImageType::Pointer fixedImage = CreateImage( 0.0 );
+  ImageType::Pointer movingImage = CreateImage( 3.0 );
+
+  typedef itk::MeanSquaresImageToImageMetricv4<ImageType, ImageType> MetricType;
+  SyNInPlaceUpdateTester::Pointer registration = SyNInPlaceUpdateTester::New();
+  registration->SetFixedImage( fixedImage );
+  registration->SetMovingImage( movingImage );
+  registration->SetMetric( MetricType::New() );
+  registration->SetNumberOfLevels( 1 );
+  SyNInPlaceUpdateTester::ShrinkFactorsArrayType shrinkFactorsPerLevel( 1 );
+  shrinkFactorsPerLevel[0] = 1;
+  registration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  SyNInPlaceUpdateTester::SmoothingSigmasArrayType smoothingSigmasPerLevel( 1 );
+  smoothingSigmasPerLevel[0] = 0;
+  registration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  SyNInPlaceUpdateTester::NumberOfIterationsArrayType numberOfIterationsPerLevel( 1 );
+  numberOfIterationsPerLevel[0] = 15;
+  registration->SetNumberOfIterationsPerLevel( numberOfIterationsPerLevel );
+  registration->SetLearningRate( 0.5 );
+  TRY_EXPECT_NO_EXCEPTION( registration->Update() );
+
+  const DisplacementFieldType * forwardField = registration->GetTransform()->GetDisplacementField();
+  const DisplacementFieldType * inverseField = registration->GetTransform()->GetInverseDisplacementField();
+  const DisplacementFieldType::IndexType centerIndex = { { 20, 20 } };
+  const VectorType centerDisplacement = forwardField->GetPixel( centerIndex );
+  std::cout << "Displacement at the center: " << centerDisplacement << ", metric value "
+            << registration->GetCurrentMetricValue() << std::endl;
+  TEST_EXPECT_TRUE( centerDisplacement[0] > 1.0 && centerDisplacement[0] < 4.0 );
+
+  double maximumInverseError = 0.0;
+  itk::ImageRegionConstIteratorWithIndex<DisplacementFieldType> it( forwardField, forwardField->GetLargestPossibleRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const DisplacementFieldType::IndexType index = it.GetIndex();
+    if( index[0] < 8 || index[0] > 31 || index[1] < 8 || index[1] > 31 )
+      {
+      continue;
+      }
+    DisplacementFieldType::PointType point;
+    forwardField->TransformIndexToPhysicalPoint( index, point );
+    point += it.Get();
+    itk::ContinuousIndex<double, Dimension> warpedIndex;
+    inverseField->TransformPhysicalPointToContinuousIndex( point, warpedIndex );
+    DisplacementFieldType::IndexType nearestIndex;
+    nearestIndex.CopyWithRound( warpedIndex );
+    const VectorType error = it.Get() + inverseField->GetPixel( nearestIndex );
+    maximumInverseError = std::max( maximumInverseError, error.GetNorm() );
+    }
+  std::cout << "Maximum inverse consistency error: " << maximumInverseError << std::endl;
+  TEST_EXPECT_TRUE( maximumInverseError < 0.5 );
+
+  // The overrides of the smoothing and the inversion are called at each
+  // iteration, and give the same fields.
+  SyNOverridingTester::Pointer overridingRegistration = SyNOverridingTester::New();
+  overridingRegistration->SetFixedImage( fixedImage );
+  overridingRegistration->SetMovingImage( movingImage );
+  overridingRegistration->SetMetric( MetricType::New() );
+  overridingRegistration->SetNumberOfLevels( 1 );
+  overridingRegistration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  overridingRegistration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  overridingRegistration->SetNumberOfIterationsPerLevel( numberOfIterationsPerLevel );
+  overridingRegistration->SetLearningRate( 0.5 );
+  TRY_EXPECT_NO_EXCEPTION( overridingRegistration->Update() );
+
+  const unsigned int numberOfIterations = overridingRegistration->GetCurrentIteration() - 1;
+  std::cout << "Overriding registration: " << numberOfIterations << " iterations, "
+            << overridingRegistration->m_NumberOfSmoothings << " smoothings, "
+            << overridingRegistration->m_NumberOfInversions << " inversions, maximum difference "
+            << MaximumDifference( forwardField, overridingRegistration->GetTransform()->GetDisplacementField() )
+            << std::endl;
+  TEST_EXPECT_TRUE( numberOfIterations > 0 );
+  TEST_EXPECT_EQUAL( overridingRegistration->m_NumberOfSmoothings, 4 * numberOfIterations );
+  TEST_EXPECT_EQUAL( overridingRegistration->m_NumberOfInversions, 4 * numberOfIterations );
+  TEST_EXPECT_TRUE( MaximumDifference( forwardField,
+                                       overridingRegistration->GetTransform()->GetDisplacementField() ) < 1e-6 );
+
+  // A registration restored from the state of the previous one does not
+  // modify the fields of that state.
+  typedef SyNInPlaceUpdateTester::OutputTransformType OutputTransformType;
+  typedef itk::ImageDuplicator<DisplacementFieldType> DuplicatorType;
+  OutputTransformType * middleTransforms[2] =
+    { registration->GetModifiableFixedToMiddleTransform(), registration->GetModifiableMovingToMiddleTransform() };
+  DisplacementFieldType::Pointer restoredFields[4];
+  DisplacementFieldType::Pointer referenceFields[4];
+  for( unsigned int t = 0; t < 2; ++t )
+    {
+    restoredFields[2 * t] = middleTransforms[t]->GetModifiableDisplacementField();
+    restoredFields[2 * t + 1] = middleTransforms[t]->GetModifiableInverseDisplacementField();
+    }
+  for( unsigned int f = 0; f < 4; ++f )
+    {
+    DuplicatorType::Pointer duplicator = DuplicatorType::New();
+    duplicator->SetInputImage( restoredFields[f] );
+    duplicator->Update();
+    referenceFields[f] = duplicator->GetModifiableOutput();
+    }
+
+  SyNInPlaceUpdateTester::Pointer restoredRegistration = SyNInPlaceUpdateTester::New();
+  restoredRegistration->SetFixedImage( fixedImage );
+  restoredRegistration->SetMovingImage( movingImage );
+  restoredRegistration->SetMetric( MetricType::New() );
+  restoredRegistration->SetNumberOfLevels( 1 );
+  restoredRegistration->SetShrinkFactorsPerLevel( shrinkFactorsPerLevel );
+  restoredRegistration->SetSmoothingSigmasPerLevel( smoothingSigmasPerLevel );
+  numberOfIterationsPerLevel[0] = 5;
+  restoredRegistration->SetNumberOfIterationsPerLevel( numberOfIterationsPerLevel );
+  restoredRegistration->SetLearningRate( 0.5 );
+  restoredRegistration->SetFixedToMiddleTransform( middleTransforms[0] );
+  restoredRegistration->SetMovingToMiddleTransform( middleTransforms[1] );
+  TRY_EXPECT_NO_EXCEPTION( restoredRegistration->Update() );
+
+  TEST_EXPECT_TRUE( restoredRegistration->GetFixedToMiddleTransform()->GetDisplacementField() != restoredFields[0] );
+  for( unsigned int f = 0; f < 4; ++f )
+    {
+    TEST_EXPECT_EQUAL( MaximumDifference( restoredFields[f], referenceFields[f] ), 0.0 );
+    }
+
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -28,25 +28,24 @@ namespace itk
  * objects in an artibitrary image.
  *
  * ConnectedComponentFunctorImageFilter labels the objects in an arbitrary
- * image. Each distinct object is assigned a unique label. The filter makes
- * three passes through the image.  The first pass initializes the
- * output.  The second pass labels each foreground pixel such that all
- * the pixels associated with an object either have the same label or
- * have had their labels entered into a equivalency table.  The third
- * pass through the image flattens the equivalency table such that all
- * pixels for an object have the same label.
+ * image. Each distinct object is assigned a unique label. The pixels under
+ * the mask are encoded in runs of connected pixels along the first
+ * dimension, and the runs are labeled with a union-find table by
+ * ScanlineConnectedComponentLabeler, as in ConnectedComponentImageFilter.
+ * Each thread labels the runs of its block of lines, and only the links
+ * between the blocks are merged sequentially.
  *
  * The functor specifies the criteria to join neighboring pixels.  For
  * example a simple intensity threshold difference might be used for
- * scalar imagery.
+ * scalar imagery.  It must be safe to call it from several threads.
  *
- * The final object labels are in no particular order (and some object
- * labels may not be used on the final objects).  You can reorder the
- * labels such that object labels are consecutive and sorted based on
- * object size by passing the output of this filter to a
+ * The final object labels start with 1 and are consecutive, in the raster
+ * order of the first pixel of the objects.  The pixels outside of the mask
+ * get the background value.  You can reorder the labels such that they are
+ * sorted based on object size by passing the output of this filter to a
  * RelabelComponentImageFilter.
  *
- * \sa ImageToImageFilter
+ * \sa ImageToImageFilter ScanlineConnectedComponentLabeler
  * \ingroup ITKConnectedComponents
  */
 
@@ -159,9 +158,32 @@ protected:
   FunctorType m_Functor;
 
   /**
-   * Standard pipeline method.
+   * Standard pipeline methods.
    */
-  void GenerateData() ITK_OVERRIDE;
+  void BeforeThreadedGenerateData() ITK_OVERRIDE;
+
+  void ThreadedGenerateData(const RegionType & outputRegionForThread, ThreadIdType threadId) ITK_OVERRIDE;
+
+private:
+  typedef typename Superclass::RunLengthType    RunLengthType;
+  typedef typename Superclass::LineEncodingType LineEncodingType;
+
+  /** Connectivity of two runs of neighbor lines: some pixels of the runs,
+   * neighbors according to the connectivity of the filter, are joined by
+   * the functor. */
+  class RunsAreJoinedByFunctor
+  {
+public:
+    RunsAreJoinedByFunctor(const InputImageType *input, FunctorType & functor, bool fullyConnected):
+      m_Input(input), m_Functor(&functor), m_FullyConnected(fullyConnected) {}
+
+    bool operator()(const RunLengthType & current, const RunLengthType & neighbor) const;
+
+private:
+    const InputImageType *m_Input;
+    FunctorType          *m_Functor;
+    bool                  m_FullyConnected;
+  };
 };
 } // end namespace itk
 
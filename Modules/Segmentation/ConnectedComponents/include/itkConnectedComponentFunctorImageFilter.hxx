@@ -19,222 +19,126 @@
 #define itkConnectedComponentFunctorImageFilter_hxx
 
 #include "itkConnectedComponentFunctorImageFilter.h"
-#include "itkImageRegionIterator.h"
+#include "itkImageLinearConstIteratorWithIndex.h"
 #include "itkProgressReporter.h"
-#include "itkEquivalencyTable.h"
-#include "itkConstShapedNeighborhoodIterator.h"
-#include "itkConstantBoundaryCondition.h"
 
 namespace itk
 {
 template< typename TInputImage, typename TOutputImage, typename TFunctor, typename TMaskImage >
 void
 ConnectedComponentFunctorImageFilter< TInputImage, TOutputImage, TFunctor, TMaskImage >
-::GenerateData()
+::BeforeThreadedGenerateData()
 {
-  // create an equivalency table
-  EquivalencyTable::Pointer eqTable = EquivalencyTable::New();
-
-  InputPixelType        value, neighborValue;
-  OutputPixelType       label, originalLabel, neighborLabel;
-  OutputPixelType       maxLabel = NumericTraits< OutputPixelType >::ZeroValue();
-  const OutputPixelType maxPossibleLabel = NumericTraits< OutputPixelType >::max();
+  // the mask and the functor are applied while encoding the runs
+  this->InitializeLabeler();
+}
 
-  typename TOutputImage::Pointer output = this->GetOutput();
+template< typename TInputImage, typename TOutputImage, typename TFunctor, typename TMaskImage >
+void
+ConnectedComponentFunctorImageFilter< TInputImage, TOutputImage, TFunctor, TMaskImage >
+::ThreadedGenerateData(const RegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
   typename TInputImage::ConstPointer input = this->GetInput();
+  typename TMaskImage::ConstPointer mask = this->GetMaskImage();
 
-  // Allocate the output and initialize to unlabeled
-  this->AllocateOutputs();
-  output->FillBuffer(maxPossibleLabel);
-
-  // Set up the boundary condition to be zero padded (used on output image)
-  ConstantBoundaryCondition< TOutputImage > BC;
-  BC.SetConstant(NumericTraits< OutputPixelType >::ZeroValue());
-
-  // Neighborhood iterators.  Let's use a shaped neighborhood so we can
-  // restrict the access to face connected neighbors. These iterators
-  // will be applied to both the input and the output image
-  typedef ConstShapedNeighborhoodIterator< TInputImage >  InputNeighborhoodIteratorType;
-  typedef ConstShapedNeighborhoodIterator< TOutputImage > OutputNeighborhoodIteratorType;
-
-  SizeType kernelRadius;
-  kernelRadius.Fill(1);
-
-  InputNeighborhoodIteratorType  init( kernelRadius, input, output->GetRequestedRegion() );
-  OutputNeighborhoodIteratorType onit( kernelRadius, output, output->GetRequestedRegion() );
-  onit.OverrideBoundaryCondition(&BC); // assign the boundary condition
-
-  // only activate the indices that are "previous" to the current
-  // pixel and face connected (exclude the center pixel from the
-  // neighborhood)
-  //
-  unsigned int d;
-  typename OutputNeighborhoodIteratorType::OffsetType offset;
-
-  if ( !this->m_FullyConnected )
+  typedef ImageLinearConstIteratorWithIndex< InputImageType > InputLineIteratorType;
+  typedef ImageLinearConstIteratorWithIndex< MaskImageType >  MaskLineIteratorType;
+  InputLineIteratorType inLineIt(input, outputRegionForThread);
+  inLineIt.SetDirection(0);
+  MaskLineIteratorType maskLineIt;
+  if ( mask )
     {
-    // only activate the "previous" neighbors that are face connected
-    // to the current pixel. do not include the center pixel
-    offset.Fill(0);
-    for ( d = 0; d < InputImageType::ImageDimension; ++d )
-      {
-      offset[d] = -1;
-      init.ActivateOffset(offset);
-      onit.ActivateOffset(offset);
-      offset[d] = 0;
-      }
+    maskLineIt = MaskLineIteratorType(mask, outputRegionForThread);
+    maskLineIt.SetDirection(0);
+    maskLineIt.GoToBegin();
     }
-  else
-    {
-    // activate all "previous" neighbors that are face+edge+vertex
-    // connected to the current pixel. do not include the center pixel
-    unsigned int centerIndex = onit.GetCenterNeighborhoodIndex();
-    for ( d = 0; d < centerIndex; d++ )
-      {
-      offset = onit.GetOffset(d);
-      init.ActivateOffset(offset);
-      onit.ActivateOffset(offset);
-      }
-    }
-
-  // along with a neighborhood iterator on the output, use a standard
-  // iterator on the input and output
-  ImageRegionConstIterator< InputImageType > it;
-  ImageRegionIterator< OutputImageType >     oit;
-  it = ImageRegionConstIterator< InputImageType >( input, output->GetRequestedRegion() );
-  oit = ImageRegionIterator< OutputImageType >( output, output->GetRequestedRegion() );
 
-  // Setup a progress reporter.  We have 2 stages to the algorithm so
-  // pretend we have 2 times the number of pixels
-  ProgressReporter progress( this, 0, 2 * output->GetRequestedRegion().GetNumberOfPixels() );
+  // set the progress reporter to deal with the number of lines
+  const SizeValueType linecountForThread =
+    outputRegionForThread.GetNumberOfPixels() / outputRegionForThread.GetSize()[0];
+  ProgressReporter progress(this, threadId, linecountForThread * 2);
 
-  // if the mask is set mark pixels not under the mask as background
-  typename TMaskImage::ConstPointer mask = this->GetMaskImage();
-  if ( mask )
+  // a run is a sequence of pixels under the mask, each of them joined by
+  // the functor to the previous one
+  SizeValueType lineId = this->m_Labeler.GetLineId( outputRegionForThread.GetIndex() );
+  for ( inLineIt.GoToBegin(); !inLineIt.IsAtEnd(); inLineIt.NextLine() )
     {
-    ImageRegionConstIterator< MaskImageType > mit;
-    mit = ImageRegionConstIterator< MaskImageType >( mask, output->GetRequestedRegion() );
-
-    mit.GoToBegin();
-    oit.GoToBegin();
-    while ( !mit.IsAtEnd() )
+    LineEncodingType & line = this->m_Labeler.GetLine(lineId);
+    bool           inRun = false;
+    InputPixelType previousValue = InputPixelType();
+    inLineIt.GoToBeginOfLine();
+    while ( !inLineIt.IsAtEndOfLine() )
       {
-      if ( mit.Get() == NumericTraits< MaskPixelType >::ZeroValue() )
+      const InputPixelType value = inLineIt.Get();
+      if ( mask && maskLineIt.Get() == NumericTraits< MaskPixelType >::ZeroValue() )
         {
-        // mark pixel as unlabeled
-        oit.Set(NumericTraits< OutputPixelType >::ZeroValue());
+        inRun = false;
         }
-
-      ++mit;
-      ++oit;
-      }
-    }
-
-  // iterate over the image, labeling the objects and defining
-  // equivalence classes.  Use the neighborhood iterator to access the
-  // "previous" neighbor pixels and an output iterator to access the
-  // current pixel
-  init.GoToBegin();
-  onit.GoToBegin();
-  it.GoToBegin();
-  oit.GoToBegin();
-  while ( !oit.IsAtEnd() )
-    {
-    // Get the current pixel label
-    label = oit.Get();
-    value = it.Get();
-    originalLabel = label;
-
-    // If the pixel is not background
-    if ( label != NumericTraits< OutputPixelType >::ZeroValue() )
-      {
-      // loop over the "previous" neighbors to find labels.  this loop
-      // may establish one or more new equivalence classes
-      typename InputNeighborhoodIteratorType::ConstIterator isIt;
-      typename OutputNeighborhoodIteratorType::ConstIterator osIt;
-      for ( isIt = init.Begin(), osIt = onit.Begin(); !osIt.IsAtEnd(); ++isIt, ++osIt )
+      else if ( inRun && m_Functor(value, previousValue) )
         {
-        // get the label of the pixel previous to this one along a
-        // particular dimension (neighbors activated in neighborhood iterator)
-        neighborLabel = osIt.Get();
-
-        // if the previous pixel has a label, verify equivalence or
-        // establish a new equivalence
-        if ( neighborLabel != NumericTraits< OutputPixelType >::ZeroValue() )
-          {
-          // see if current pixel is connected to its neighbor
-          neighborValue = isIt.Get();
-          if ( m_Functor(value, neighborValue) )
-            {
-            // if current pixel is unlabeled, then copy the label from neighbor
-            if ( label == maxPossibleLabel )
-              {
-              // copy the label from the previous pixel
-              label = neighborLabel;
-              }
-            // else if current pixel has a label that is not already
-            // equivalent to the label of the previous pixel, then setup
-            // a new equivalence.
-            else if ( ( label != neighborLabel )
-                      && ( eqTable->RecursiveLookup(label)
-                           != eqTable->RecursiveLookup(neighborLabel) ) )
-              {
-              eqTable->Add(label, neighborLabel);
-              }
-            }
-          }
+        ++line.back().length;
         }
-
-      // if none of the "previous" neighbors were set, then make a new label
-      if ( originalLabel == label )
+      else
         {
-        // create a new entry label
-        if ( maxLabel == maxPossibleLabel )
-          {
-          itkWarningMacro(
-            << "ConnectedComponentFunctorImageFilter::GenerateData: Number of labels " << (long)maxLabel
-            << " exceeds number of available labels " << (long)maxPossibleLabel << " for the output type.");
-          }
-        else
-          {
-          ++maxLabel;
-          }
-
-        // assign the new label
-        label = maxLabel;
+        RunLengthType run;
+        run.length = 1;
+        run.where = inLineIt.GetIndex();
+        run.label = 0;
+        line.push_back(run);
+        inRun = true;
         }
-
-      // Finally, set the output pixel to whatever label we have
-      if ( label != originalLabel )
+      previousValue = value;
+      ++inLineIt;
+      if ( mask )
         {
-        oit.Set(label);
+        ++maskLineIt;
         }
       }
-
-    // move the iterators
-    ++init;
-    ++onit;
-    ++it;
-    ++oit;
+    if ( mask )
+      {
+      maskLineIt.NextLine();
+      }
+    ++lineId;
     progress.CompletedPixel();
     }
 
-  // Flatten the equavalency table
-  eqTable->Flatten();
+  this->m_Labeler.ThreadedResolve( threadId, outputRegionForThread,
+                                   RunsAreJoinedByFunctor(input, m_Functor, this->m_FullyConnected) );
 
-  // remap the labels
-  oit.GoToBegin();
-  while ( !oit.IsAtEnd() )
+  this->ThreadedFillOutput(outputRegionForThread, threadId, progress);
+}
+
+template< typename TInputImage, typename TOutputImage, typename TFunctor, typename TMaskImage >
+bool
+ConnectedComponentFunctorImageFilter< TInputImage, TOutputImage, TFunctor, TMaskImage >
+::RunsAreJoinedByFunctor
+::operator()(const RunLengthType & current, const RunLengthType & neighbor) const
+{
+  // the runs overlap; look for a pixel of the current run joined to one of
+  // its neighbors in the neighbor run
+  const OffsetValueType offset = m_FullyConnected ? 1 : 0;
+  const OffsetValueType cStart = current.where[0];
+  const OffsetValueType cLast = cStart + current.length - 1;
+  const OffsetValueType nStart = neighbor.where[0];
+  const OffsetValueType nLast = nStart + neighbor.length - 1;
+
+  IndexType currentIndex = current.where;
+  IndexType neighborIndex = neighbor.where;
+  for ( OffsetValueType x = std::max(cStart, nStart - offset); x <= std::min(cLast, nLast + offset); ++x )
     {
-    label = oit.Get();
-    // if pixel has a label, write out the final equivalence
-    if ( label != NumericTraits< OutputPixelType >::ZeroValue() )
+    currentIndex[0] = x;
+    const InputPixelType value = m_Input->GetPixel(currentIndex);
+    for ( OffsetValueType nx = std::max(nStart, x - offset); nx <= std::min(nLast, x + offset); ++nx )
       {
-      oit.Set( eqTable->Lookup(label) );
+      neighborIndex[0] = nx;
+      if ( ( *m_Functor )( value, m_Input->GetPixel(neighborIndex) ) )
+        {
+        return true;
+        }
       }
-    ++oit;
-    progress.CompletedPixel();
     }
+  return false;
 }
 } // end namespace itk
 
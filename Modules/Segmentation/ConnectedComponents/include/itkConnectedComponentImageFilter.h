@@ -20,10 +20,9 @@
 
 #include "itkImageToImageFilter.h"
 #include "itkImage.h"
-#include <vector>
-#include <map>
 #include "itkProgressReporter.h"
-#include "itkBarrier.h"
+#include "itkImageRegionSplitterDirection.h"
+#include "itkScanlineConnectedComponentLabeler.h"
 
 namespace itk
 {
@@ -43,11 +42,15 @@ namespace itk
  * component image filter which did not produce consecutive labels or
  * impose any particular ordering.
  *
+ * The runs are labeled with a union-find table by
+ * ScanlineConnectedComponentLabeler: each thread labels the runs of its
+ * block of lines, and only the links between the blocks are merged
+ * sequentially.  The labels do not depend on the number of threads.
+ *
  * After the filter is executed, ObjectCount holds the number of connected components.
  *
- * \sa ImageToImageFilter
+ * \sa ImageToImageFilter ScanlineConnectedComponentLabeler
  *
- * \ingroup SingleThreaded
  * \ingroup ITKConnectedComponents
  *
  * \wiki
@@ -168,6 +171,8 @@ protected:
     m_FullyConnected = false;
     m_ObjectCount = 0;
     m_BackgroundValue = NumericTraits< OutputImagePixelType >::ZeroValue();
+    m_ImageRegionSplitter = ImageRegionSplitterDirection::New();
+    m_ImageRegionSplitter->SetDirection(0);
   }
 
   virtual ~ConnectedComponentImageFilter() {}
@@ -193,82 +198,38 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject * itkNotUsed(output) ) ITK_OVERRIDE;
 
-  bool m_FullyConnected;
+  /** The lines along the first dimension must not be split between the
+   * threads. */
+  virtual const ImageRegionSplitterBase* GetImageRegionSplitter() const ITK_OVERRIDE;
 
-private:
-  ITK_DISALLOW_COPY_AND_ASSIGN(ConnectedComponentImageFilter);
+  typedef ScanlineConnectedComponentLabeler< itkGetStaticConstMacro(ImageDimension) > LabelerType;
+  typedef typename LabelerType::RunLength                                            RunLengthType;
+  typedef typename LabelerType::LineEncodingType                                     LineEncodingType;
 
-  LabelType            m_ObjectCount;
-  OutputImagePixelType m_BackgroundValue;
-
-  // some additional types
-  typedef typename TOutputImage::RegionType::SizeType OutSizeType;
-
-  // types to support the run length encoding of lines
-  class runLength
-  {
-public:
-    // run length information - may be a more type safe way of doing this
-    typename TInputImage::OffsetValueType   length;
-    typename TInputImage::IndexType         where;   // Index of the start of the run
-    LabelType                               label;   // the initial label of the run
-  };
-
-  typedef std::vector< runLength > lineEncoding;
-
-  // the map storing lines
-  typedef std::vector< lineEncoding > LineMapType;
-
-  typedef std::vector< typename TInputImage::OffsetValueType > OffsetVec;
-
-  // the types to support union-find operations
-  typedef std::vector< LabelType > UnionFindType;
-  UnionFindType m_UnionFind;
-  UnionFindType m_Consecutive;
-
-  // functions to support union-find operations
-  void InitUnion( SizeValueType size )
-  {
-    m_UnionFind = UnionFindType(size + 1);
-  }
+  /** Prepare the labeler for the threads processing the requested region of
+   * the output. */
+  void InitializeLabeler();
 
-  void InsertSet(const LabelType label);
+  /** Write the labels of the runs resolved by the labeler to the region of
+   * the output of a thread, and the background value elsewhere. */
+  void ThreadedFillOutput(const RegionType & outputRegionForThread, ThreadIdType threadId,
+                          ProgressReporter & progress);
 
-  SizeValueType LookupSet(const LabelType label);
-
-  void LinkLabels(const LabelType lab1, const LabelType lab2);
-
-  SizeValueType CreateConsecutive();
-
-  //////////////////
-  bool CheckNeighbors(const OutputIndexType & A,
-                      const OutputIndexType & B);
-
-  void CompareLines(lineEncoding & current, const lineEncoding & Neighbour);
-
-  void FillOutput(const LineMapType & LineMap,
-                  ProgressReporter & progress);
+  bool m_FullyConnected;
 
-  void SetupLineOffsets(OffsetVec & LineOffsets);
+#if !defined( ITK_WRAPPING_PARSER )
+  LabelerType m_Labeler;
+#endif
 
-  void Wait()
-  {
-    // use m_NumberOfLabels.size() to get the number of thread used
-    if ( m_NumberOfLabels.size() > 1 )
-      {
-      m_Barrier->Wait();
-      }
-  }
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(ConnectedComponentImageFilter);
 
-  typename std::vector< IdentifierType > m_NumberOfLabels;
-  typename std::vector< IdentifierType > m_FirstLineIdToJoin;
+  LabelType            m_ObjectCount;
+  OutputImagePixelType m_BackgroundValue;
 
-  typename Barrier::Pointer m_Barrier;
+  ImageRegionSplitterDirection::Pointer m_ImageRegionSplitter;
 
   typename TInputImage::ConstPointer m_Input;
-#if !defined( ITK_WRAPPING_PARSER )
-  LineMapType m_LineMap;
-#endif
 };
 } // end namespace itk
 
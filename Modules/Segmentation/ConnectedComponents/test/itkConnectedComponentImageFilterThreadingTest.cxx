@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConnectedComponentImageFilter.h"
+#include "itkScalarConnectedComponentImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+#include <deque>
+
+/*
+ * Compare the labels of ConnectedComponentImageFilter and
+ * ScalarConnectedComponentImageFilter, computed with several numbers of
+ * threads, to the labels of a flood fill visiting the image in raster order.
+ */
+
+namespace
+{
+
+typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+
+template< typename TImage >
+typename TImage::Pointer
+CreateRandomImage( const typename TImage::SizeType & size, unsigned int numberOfValues, GeneratorType * generator )
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions( size );
+  image->Allocate();
+
+  typename TImage::PixelType * buffer = image->GetBufferPointer();
+  for( itk::SizeValueType i = 0; i < image->GetBufferedRegion().GetNumberOfPixels(); ++i )
+    {
+    buffer[i] = static_cast< typename TImage::PixelType >( generator->GetIntegerVariate( numberOfValues - 1 ) );
+    }
+  return image;
+}
+
+/** Label the pixels of the mask joined to their neighbors by the functor,
+ * numbering the objects in the raster order of their first pixel. */
+template< typename TImage, typename TLabelImage, typename TFunctor >
+typename TLabelImage::Pointer
+FloodFillLabels( const TImage * image, const TImage * mask, bool fullyConnected, const TFunctor & functor )
+{
+  typedef typename TImage::IndexType  IndexType;
+  typedef typename TImage::OffsetType OffsetType;
+  const unsigned int Dimension = TImage::ImageDimension;
+  const typename TImage::RegionType region = image->GetLargestPossibleRegion();
+
+  typename TLabelImage::Pointer labels = TLabelImage::New();
+  labels->SetRegions( region );
+  labels->Allocate();
+  labels->FillBuffer( 0 );
+
+  std::vector< OffsetType > offsets;
+  OffsetType offset;
+  offset.Fill( -1 );
+  for( ;; )
+    {
+    unsigned int nonZero = 0;
+    for( unsigned int d = 0; d < Dimension; ++d )
+      {
+      nonZero += ( offset[d] != 0 );
+      }
+    if( nonZero == 1 || ( fullyConnected && nonZero > 0 ) )
+      {
+      offsets.push_back( offset );
+      }
+    unsigned int d = 0;
+    while( d < Dimension && offset[d] == 1 )
+      {
+      offset[d++] = -1;
+      }
+    if( d == Dimension )
+      {
+      break;
+      }
+    ++offset[d];
+    }
+
+  typename TLabelImage::PixelType label = 0;
+  itk::ImageRegionConstIteratorWithIndex< TImage > it( image, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const IndexType start = it.GetIndex();
+    if( mask->GetPixel( start ) == 0 || labels->GetPixel( start ) != 0 )
+      {
+      continue;
+      }
+    ++label;
+    labels->SetPixel( start, label );
+    std::deque< IndexType > front( 1, start );
+    while( !front.empty() )
+      {
+      const IndexType current = front.front();
+      front.pop_front();
+      for( size_t i = 0; i < offsets.size(); ++i )
+        {
+        const IndexType neighbor = current + offsets[i];
+        if( region.IsInside( neighbor ) && mask->GetPixel( neighbor ) != 0 && labels->GetPixel( neighbor ) == 0
+            && functor( image->GetPixel( current ), image->GetPixel( neighbor ) ) )
+          {
+          labels->SetPixel( neighbor, label );
+          front.push_back( neighbor );
+          }
+        }
+      }
+    }
+  return labels;
+}
+
+struct AllPixelsAreJoined
+{
+  template< typename TPixel >
+  bool operator()( const TPixel &, const TPixel & ) const
+  {
+    return true;
+  }
+};
+
+struct ValuesAreClose
+{
+  template< typename TPixel >
+  bool operator()( const TPixel & a, const TPixel & b ) const
+  {
+    return itk::Math::abs( static_cast< int >( a ) - static_cast< int >( b ) ) <= 1;
+  }
+};
+
+template< typename TImage >
+bool
+SameImages( const TImage * expected, const TImage * actual, const std::string & description )
+{
+  itk::ImageRegionConstIteratorWithIndex< TImage > expectedIt( expected, expected->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIteratorWithIndex< TImage > actualIt( actual, actual->GetLargestPossibleRegion() );
+  for( ; !expectedIt.IsAtEnd(); ++expectedIt, ++actualIt )
+    {
+    if( expectedIt.Get() != actualIt.Get() )
+      {
+      std::cerr << description << ": label " << actualIt.Get() << " at " << actualIt.GetIndex()
+                << " instead of " << expectedIt.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< unsigned int VDimension >
+bool
+TestConnectedComponents( const typename itk::Image< unsigned char, VDimension >::SizeType & size,
+                         GeneratorType * generator )
+{
+  typedef itk::Image< unsigned char, VDimension >  ImageType;
+  typedef itk::Image< unsigned int, VDimension >   LabelImageType;
+  typedef itk::ConnectedComponentImageFilter< ImageType, LabelImageType >       FilterType;
+  typedef itk::ScalarConnectedComponentImageFilter< ImageType, LabelImageType > ScalarFilterType;
+
+  typename ImageType::Pointer binaryImage = CreateRandomImage< ImageType >( size, 2, generator );
+  typename ImageType::Pointer image = CreateRandomImage< ImageType >( size, 8, generator );
+  typename ImageType::Pointer mask = CreateRandomImage< ImageType >( size, 5, generator );
+
+  bool passed = true;
+  for( unsigned int fullyConnected = 0; fullyConnected < 2; ++fullyConnected )
+    {
+    typename LabelImageType::Pointer expectedLabels =
+      FloodFillLabels< ImageType, LabelImageType >( binaryImage.GetPointer(), binaryImage.GetPointer(),
+                                                    fullyConnected, AllPixelsAreJoined() );
+    typename LabelImageType::Pointer expectedScalarLabels =
+      FloodFillLabels< ImageType, LabelImageType >( image.GetPointer(), mask.GetPointer(),
+                                                    fullyConnected, ValuesAreClose() );
+
+    for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 8; numberOfThreads += 3 )
+      {
+      std::ostringstream description;
+      description << VDimension << "D, fully connected " << fullyConnected << ", "
+                  << numberOfThreads << " threads";
+
+      typename FilterType::Pointer filter = FilterType::New();
+      filter->SetInput( binaryImage );
+      filter->SetFullyConnected( fullyConnected );
+      filter->SetNumberOfThreads( numberOfThreads );
+      filter->Update();
+      passed &= SameImages< LabelImageType >( expectedLabels, filter->GetOutput(), description.str() );
+
+      typename ScalarFilterType::Pointer scalarFilter = ScalarFilterType::New();
+      scalarFilter->SetInput( image );
+      scalarFilter->SetMaskImage( mask );
+      scalarFilter->SetDistanceThreshold( 1 );
+      scalarFilter->SetFullyConnected( fullyConnected );
+      scalarFilter->SetNumberOfThreads( numberOfThreads );
+      scalarFilter->Update();
+      passed &= SameImages< LabelImageType >( expectedScalarLabels, scalarFilter->GetOutput(),
+                                              "Scalar, " + description.str() );
+      }
+    }
+  return passed;
+}
+}
+
+int itkConnectedComponentImageFilterThreadingTest( int, char *[] )
+{
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 2017 );
+
+  itk::Size< 2 > size2D = {{ 61, 47 }};
+  itk::Size< 3 > size3D = {{ 17, 13, 19 }};
+
+  bool passed = TestConnectedComponents< 2 >( size2D, generator );
+  passed &= TestConnectedComponents< 3 >( size3D, generator );
+
+  // a single line is not split between the threads
+  itk::Size< 2 > lineSize = {{ 97, 1 }};
+  passed &= TestConnectedComponents< 2 >( lineSize, generator );
+
+  if( !passed )
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -39,6 +39,14 @@ namespace itk
  *  \class LevelSetEvolution
  *  \brief Class for iterating and evolving the level-set function
  *
+ *  The sparse level sets (Whitaker, Shi and Malcolm) can be updated in
+ *  parallel, each thread updating whole level sets (see
+ *  SetUpdateLevelSetsInParallel()). A level set is then updated from the state
+ *  of the other level sets at the beginning of the iteration instead of the
+ *  state left by the level sets updated before it, which changes the
+ *  evolution when its terms depend on the other level sets, as the Chan and
+ *  Vese external term does.
+ *
  *  \tparam TEquationContainer Container holding the system of level set of equations
  *  \tparam TLevelSet Level-set function representation (e.g. dense, sparse)
  *
@@ -231,6 +239,12 @@ public:
   /** Set the maximum number of threads to be used. */
   ThreadIdType GetNumberOfThreads() const;
 
+  /** Set/Get whether the level sets are updated in parallel (see
+   * LevelSetEvolution). Off by default. */
+  itkSetMacro( UpdateLevelSetsInParallel, bool );
+  itkGetConstMacro( UpdateLevelSetsInParallel, bool );
+  itkBooleanMacro( UpdateLevelSetsInParallel );
+
 protected:
   LevelSetEvolution();
   ~LevelSetEvolution();
@@ -261,6 +275,20 @@ protected:
   typedef LevelSetEvolutionComputeIterationThreader< LevelSetType, SplitLevelSetPartitionerType, Self > SplitLevelSetComputeIterationThreaderType;
   typename SplitLevelSetComputeIterationThreaderType::Pointer m_SplitLevelSetComputeIterationThreader;
 
+  /** Create the filter updating a level set by one iteration. */
+  UpdateLevelSetFilterPointer CreateUpdateLevelSetFilter( LevelSetType * levelSet,
+                                                          const LevelSetIdentifierType & levelSetId );
+
+  bool m_UpdateLevelSetsInParallel;
+
+  /** Filters updating copies of the level sets when they are updated in
+   * parallel. */
+  std::vector< UpdateLevelSetFilterPointer > m_UpdateLevelSetFilters;
+
+  friend class LevelSetEvolutionUpdateLevelSetsThreader< LevelSetType, ThreadedIndexedContainerPartitioner, Self >;
+  typedef LevelSetEvolutionUpdateLevelSetsThreader< LevelSetType, ThreadedIndexedContainerPartitioner, Self > SplitLevelSetsUpdateLevelSetsThreaderType;
+  typename SplitLevelSetsUpdateLevelSetsThreaderType::Pointer m_SplitLevelSetsUpdateLevelSetsThreader;
+
 private:
   LevelSetEvolution( const Self& );
   void operator = ( const Self& );
@@ -332,6 +360,17 @@ public:
   typedef UpdateShiSparseLevelSet< ImageDimension, EquationContainerType >  UpdateLevelSetFilterType;
   typedef typename UpdateLevelSetFilterType::Pointer                        UpdateLevelSetFilterPointer;
 
+  /** Set the maximum number of threads to be used. */
+  void SetNumberOfThreads( const ThreadIdType threads );
+  /** Set the maximum number of threads to be used. */
+  ThreadIdType GetNumberOfThreads() const;
+
+  /** Set/Get whether the level sets are updated in parallel (see
+   * LevelSetEvolution). Off by default. */
+  itkSetMacro( UpdateLevelSetsInParallel, bool );
+  itkGetConstMacro( UpdateLevelSetsInParallel, bool );
+  itkBooleanMacro( UpdateLevelSetsInParallel );
+
 protected:
   LevelSetEvolution();
   ~LevelSetEvolution();
@@ -342,6 +381,20 @@ protected:
   /** Update the equations at the end of 1 iteration */
   virtual void UpdateEquations() ITK_OVERRIDE;
 
+  /** Create the filter updating a level set by one iteration. */
+  UpdateLevelSetFilterPointer CreateUpdateLevelSetFilter( LevelSetType * levelSet,
+                                                          const LevelSetIdentifierType & levelSetId );
+
+  bool m_UpdateLevelSetsInParallel;
+
+  /** Filters updating copies of the level sets when they are updated in
+   * parallel. */
+  std::vector< UpdateLevelSetFilterPointer > m_UpdateLevelSetFilters;
+
+  friend class LevelSetEvolutionUpdateLevelSetsThreader< LevelSetType, ThreadedIndexedContainerPartitioner, Self >;
+  typedef LevelSetEvolutionUpdateLevelSetsThreader< LevelSetType, ThreadedIndexedContainerPartitioner, Self > SplitLevelSetsUpdateLevelSetsThreaderType;
+  typename SplitLevelSetsUpdateLevelSetsThreaderType::Pointer m_SplitLevelSetsUpdateLevelSetsThreader;
+
 private:
   LevelSetEvolution( const Self& );
   void operator = ( const Self& );
@@ -412,6 +465,17 @@ public:
   typedef UpdateMalcolmSparseLevelSet< ImageDimension, EquationContainerType > UpdateLevelSetFilterType;
   typedef typename UpdateLevelSetFilterType::Pointer UpdateLevelSetFilterPointer;
 
+  /** Set the maximum number of threads to be used. */
+  void SetNumberOfThreads( const ThreadIdType threads );
+  /** Set the maximum number of threads to be used. */
+  ThreadIdType GetNumberOfThreads() const;
+
+  /** Set/Get whether the level sets are updated in parallel (see
+   * LevelSetEvolution). Off by default. */
+  itkSetMacro( UpdateLevelSetsInParallel, bool );
+  itkGetConstMacro( UpdateLevelSetsInParallel, bool );
+  itkBooleanMacro( UpdateLevelSetsInParallel );
+
 protected:
   LevelSetEvolution();
   virtual ~LevelSetEvolution();
@@ -420,6 +484,20 @@ protected:
 
   virtual void UpdateEquations() ITK_OVERRIDE;
 
+  /** Create the filter updating a level set by one iteration. */
+  UpdateLevelSetFilterPointer CreateUpdateLevelSetFilter( LevelSetType * levelSet,
+                                                          const LevelSetIdentifierType & levelSetId );
+
+  bool m_UpdateLevelSetsInParallel;
+
+  /** Filters updating copies of the level sets when they are updated in
+   * parallel. */
+  std::vector< UpdateLevelSetFilterPointer > m_UpdateLevelSetFilters;
+
+  friend class LevelSetEvolutionUpdateLevelSetsThreader< LevelSetType, ThreadedIndexedContainerPartitioner, Self >;
+  typedef LevelSetEvolutionUpdateLevelSetsThreader< LevelSetType, ThreadedIndexedContainerPartitioner, Self > SplitLevelSetsUpdateLevelSetsThreaderType;
+  typename SplitLevelSetsUpdateLevelSetsThreaderType::Pointer m_SplitLevelSetsUpdateLevelSetsThreader;
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(LevelSetEvolution);
 };
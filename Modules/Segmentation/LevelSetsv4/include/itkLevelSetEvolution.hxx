@@ -217,9 +217,11 @@ LevelSetEvolution< TEquationContainer, LevelSetDenseImage< TImage > >
 // Whitaker --------------------------------------------------------------------
 template< typename TEquationContainer, typename TOutput, unsigned int VDimension >
 LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDimension > >
-::LevelSetEvolution()
+::LevelSetEvolution() :
+  m_UpdateLevelSetsInParallel( false )
 {
   this->m_SplitLevelSetComputeIterationThreader = SplitLevelSetComputeIterationThreaderType::New();
+  this->m_SplitLevelSetsUpdateLevelSetsThreader = SplitLevelSetsUpdateLevelSetsThreaderType::New();
 }
 
 template< typename TEquationContainer, typename TOutput, unsigned int VDimension >
@@ -240,6 +242,7 @@ LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDi
 ::SetNumberOfThreads( const ThreadIdType numberOfThreads)
 {
   this->m_SplitLevelSetComputeIterationThreader->SetMaximumNumberOfThreads( numberOfThreads );
+  this->m_SplitLevelSetsUpdateLevelSetsThreader->SetMaximumNumberOfThreads( numberOfThreads );
 }
 
 template< typename TEquationContainer, typename TOutput, unsigned int VDimension >
@@ -339,17 +342,25 @@ void
 LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDimension > >
 ::UpdateLevelSets()
 {
+  if( this->m_UpdateLevelSetsInParallel )
+    {
+    this->m_SplitLevelSetsUpdateLevelSetsThreader->UpdateLevelSets( this );
+
+    typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
+    while( it != this->m_LevelSetContainer->End() )
+      {
+      this->m_UpdateBuffer[it->GetIdentifier()]->clear();
+      ++it;
+      }
+    return;
+    }
+
   typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
   while( it != this->m_LevelSetContainer->End() )
     {
     typename LevelSetType::Pointer levelSet = it->GetLevelSet();
 
-    UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
-    updateLevelSet->SetInputLevelSet( levelSet );
-    updateLevelSet->SetUpdate( * this->m_UpdateBuffer[it->GetIdentifier()] );
-    updateLevelSet->SetEquationContainer( this->m_EquationContainer );
-    updateLevelSet->SetTimeStep( this->m_Dt );
-    updateLevelSet->SetCurrentLevelSetId( it->GetIdentifier() );
+    UpdateLevelSetFilterPointer updateLevelSet = this->CreateUpdateLevelSetFilter( levelSet, it->GetIdentifier() );
     updateLevelSet->Update();
 
     levelSet->Graft( updateLevelSet->GetOutputLevelSet() );
@@ -361,6 +372,20 @@ LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDi
     }
 }
 
+template< typename TEquationContainer, typename TOutput, unsigned int VDimension >
+typename LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDimension > >::UpdateLevelSetFilterPointer
+LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDimension > >
+::CreateUpdateLevelSetFilter( LevelSetType * levelSet, const LevelSetIdentifierType & levelSetId )
+{
+  UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
+  updateLevelSet->SetInputLevelSet( levelSet );
+  updateLevelSet->SetUpdate( * this->m_UpdateBuffer[levelSetId] );
+  updateLevelSet->SetEquationContainer( this->m_EquationContainer );
+  updateLevelSet->SetTimeStep( this->m_Dt );
+  updateLevelSet->SetCurrentLevelSetId( levelSetId );
+  return updateLevelSet;
+}
+
 template< typename TEquationContainer, typename TOutput, unsigned int VDimension >
 void
 LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDimension > >
@@ -372,8 +397,10 @@ LevelSetEvolution< TEquationContainer, WhitakerSparseLevelSetImage< TOutput, VDi
 // Shi
 template< typename TEquationContainer, unsigned int VDimension >
 LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
-::LevelSetEvolution()
+::LevelSetEvolution() :
+  m_UpdateLevelSetsInParallel( false )
 {
+  this->m_SplitLevelSetsUpdateLevelSetsThreader = SplitLevelSetsUpdateLevelSetsThreaderType::New();
 }
 
 template< typename TEquationContainer, unsigned int VDimension >
@@ -381,20 +408,39 @@ LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
 ::~LevelSetEvolution()
 {}
 
+template< typename TEquationContainer, unsigned int VDimension >
+void
+LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
+::SetNumberOfThreads( const ThreadIdType numberOfThreads )
+{
+  this->m_SplitLevelSetsUpdateLevelSetsThreader->SetMaximumNumberOfThreads( numberOfThreads );
+}
+
+template< typename TEquationContainer, unsigned int VDimension >
+ThreadIdType
+LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
+::GetNumberOfThreads() const
+{
+  return this->m_SplitLevelSetsUpdateLevelSetsThreader->GetMaximumNumberOfThreads();
+}
+
 template< typename TEquationContainer, unsigned int VDimension >
 void LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
 ::UpdateLevelSets()
 {
+  if( this->m_UpdateLevelSetsInParallel )
+    {
+    this->m_SplitLevelSetsUpdateLevelSetsThreader->UpdateLevelSets( this );
+    return;
+    }
+
   typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
 
   while( it != this->m_LevelSetContainer->End() )
     {
     typename LevelSetType::Pointer levelSet = it->GetLevelSet();
 
-    UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
-    updateLevelSet->SetInputLevelSet( levelSet );
-    updateLevelSet->SetCurrentLevelSetId( it->GetIdentifier() );
-    updateLevelSet->SetEquationContainer( this->m_EquationContainer );
+    UpdateLevelSetFilterPointer updateLevelSet = this->CreateUpdateLevelSetFilter( levelSet, it->GetIdentifier() );
     updateLevelSet->Update();
 
     levelSet->Graft( updateLevelSet->GetOutputLevelSet() );
@@ -405,6 +451,18 @@ void LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension >
     }
 }
 
+template< typename TEquationContainer, unsigned int VDimension >
+typename LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >::UpdateLevelSetFilterPointer
+LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
+::CreateUpdateLevelSetFilter( LevelSetType * levelSet, const LevelSetIdentifierType & levelSetId )
+{
+  UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
+  updateLevelSet->SetInputLevelSet( levelSet );
+  updateLevelSet->SetCurrentLevelSetId( levelSetId );
+  updateLevelSet->SetEquationContainer( this->m_EquationContainer );
+  return updateLevelSet;
+}
+
 template< typename TEquationContainer, unsigned int VDimension >
 void LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension > >
 ::UpdateEquations()
@@ -415,8 +473,10 @@ void LevelSetEvolution< TEquationContainer, ShiSparseLevelSetImage< VDimension >
 // Malcolm
 template< typename TEquationContainer, unsigned int VDimension >
 LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >
-::LevelSetEvolution()
+::LevelSetEvolution() :
+  m_UpdateLevelSetsInParallel( false )
 {
+  this->m_SplitLevelSetsUpdateLevelSetsThreader = SplitLevelSetsUpdateLevelSetsThreaderType::New();
 }
 
 template< typename TEquationContainer, unsigned int VDimension >
@@ -424,21 +484,39 @@ LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension >
 ::~LevelSetEvolution()
 {}
 
+template< typename TEquationContainer, unsigned int VDimension >
+void
+LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >
+::SetNumberOfThreads( const ThreadIdType numberOfThreads )
+{
+  this->m_SplitLevelSetsUpdateLevelSetsThreader->SetMaximumNumberOfThreads( numberOfThreads );
+}
+
+template< typename TEquationContainer, unsigned int VDimension >
+ThreadIdType
+LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >
+::GetNumberOfThreads() const
+{
+  return this->m_SplitLevelSetsUpdateLevelSetsThreader->GetMaximumNumberOfThreads();
+}
+
 template< typename TEquationContainer, unsigned int VDimension >
 void LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >
 ::UpdateLevelSets()
 {
+  if( this->m_UpdateLevelSetsInParallel )
+    {
+    this->m_SplitLevelSetsUpdateLevelSetsThreader->UpdateLevelSets( this );
+    return;
+    }
+
   typename LevelSetContainerType::Iterator it = this->m_LevelSetContainer->Begin();
 
   while( it != this->m_LevelSetContainer->End() )
     {
     typename LevelSetType::Pointer levelSet = it->GetLevelSet();
-    LevelSetIdentifierType       levelSetId = it->GetIdentifier();
 
-    UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
-    updateLevelSet->SetInputLevelSet( levelSet );
-    updateLevelSet->SetCurrentLevelSetId( levelSetId );
-    updateLevelSet->SetEquationContainer( this->m_EquationContainer );
+    UpdateLevelSetFilterPointer updateLevelSet = this->CreateUpdateLevelSetFilter( levelSet, it->GetIdentifier() );
     updateLevelSet->Update();
 
     levelSet->Graft( updateLevelSet->GetOutputLevelSet() );
@@ -449,6 +527,18 @@ void LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimensi
     }
 }
 
+template< typename TEquationContainer, unsigned int VDimension >
+typename LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >::UpdateLevelSetFilterPointer
+LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >
+::CreateUpdateLevelSetFilter( LevelSetType * levelSet, const LevelSetIdentifierType & levelSetId )
+{
+  UpdateLevelSetFilterPointer updateLevelSet = UpdateLevelSetFilterType::New();
+  updateLevelSet->SetInputLevelSet( levelSet );
+  updateLevelSet->SetCurrentLevelSetId( levelSetId );
+  updateLevelSet->SetEquationContainer( this->m_EquationContainer );
+  return updateLevelSet;
+}
+
 template< typename TEquationContainer, unsigned int VDimension >
 void LevelSetEvolution< TEquationContainer, MalcolmSparseLevelSetImage< VDimension > >
 ::UpdateEquations()
@@ -22,6 +22,7 @@
 #include "itkDomainThreader.h"
 #include "itkLevelSetDenseImage.h"
 #include "itkThreadedImageRegionPartitioner.h"
+#include "itkThreadedIndexedContainerPartitioner.h"
 
 namespace itk
 {
@@ -84,6 +85,55 @@ private:
   ITK_DISALLOW_COPY_AND_ASSIGN(LevelSetEvolutionUpdateLevelSetsThreader);
 };
 
+// For sparse level sets, split by putting whole level sets in each thread.
+// The level sets are updated by the filters of the associate in
+// m_UpdateLevelSetFilters, each filter working on its own copy of a level set.
+template< typename TLevelSet, typename TLevelSetEvolution >
+class ITK_TEMPLATE_EXPORT LevelSetEvolutionUpdateLevelSetsThreader< TLevelSet, ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+  : public DomainThreader< ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+{
+public:
+  /** Standard class typedefs. */
+  typedef LevelSetEvolutionUpdateLevelSetsThreader                                  Self;
+  typedef DomainThreader< ThreadedIndexedContainerPartitioner, TLevelSetEvolution > Superclass;
+  typedef SmartPointer< Self >                                                      Pointer;
+  typedef SmartPointer< const Self >                                                ConstPointer;
+
+  /** Run time type information. */
+  itkTypeMacro( LevelSetEvolutionUpdateLevelSetsThreader, DomainThreader );
+
+  /** Standard New macro. */
+  itkNewMacro( Self );
+
+  /** Superclass types. */
+  typedef typename Superclass::DomainType    DomainType;
+  typedef typename Superclass::AssociateType AssociateType;
+
+  /** Types of the associate class. */
+  typedef TLevelSetEvolution LevelSetEvolutionType;
+
+  /** Update all the level sets of the evolution by one iteration: each level
+   * set is copied, the copies are updated in parallel by the filters created
+   * by the evolution, and the results are grafted back on the level sets. */
+  void UpdateLevelSets( LevelSetEvolutionType * evolution );
+
+protected:
+  LevelSetEvolutionUpdateLevelSetsThreader();
+
+  virtual void BeforeThreadedExecution() ITK_OVERRIDE;
+
+  virtual void ThreadedExecution( const DomainType & levelSetSubRange, const ThreadIdType threadId ) ITK_OVERRIDE;
+
+  virtual void AfterThreadedExecution() ITK_OVERRIDE;
+
+  /** Description of the exception thrown by the filters of each thread, empty
+   * if none was thrown. */
+  std::vector< std::string > m_ExceptionDescriptionPerThread;
+
+private:
+  ITK_DISALLOW_COPY_AND_ASSIGN(LevelSetEvolutionUpdateLevelSetsThreader);
+};
+
 } // end namespace itk
 
 #ifndef ITK_MANUAL_INSTANTIATION
@@ -89,6 +89,101 @@ LevelSetEvolutionUpdateLevelSetsThreader< LevelSetDenseImage< TImage >, Threaded
     }
 }
 
+template< typename TLevelSet, typename TLevelSetEvolution >
+LevelSetEvolutionUpdateLevelSetsThreader< TLevelSet, ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+::LevelSetEvolutionUpdateLevelSetsThreader()
+{
+}
+
+template< typename TLevelSet, typename TLevelSetEvolution >
+void
+LevelSetEvolutionUpdateLevelSetsThreader< TLevelSet, ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+::UpdateLevelSets( LevelSetEvolutionType * evolution )
+{
+  typedef typename LevelSetEvolutionType::LevelSetType          LevelSetType;
+  typedef typename LevelSetEvolutionType::LevelSetLabelMapType  LevelSetLabelMapType;
+  typedef typename LevelSetEvolutionType::LevelSetContainerType LevelSetContainerType;
+
+  evolution->m_UpdateLevelSetFilters.clear();
+
+  typename LevelSetContainerType::Iterator it = evolution->m_LevelSetContainer->Begin();
+  while( it != evolution->m_LevelSetContainer->End() )
+    {
+    // The filter updates a copy of the level set, so that the filters of
+    // the other threads keep reading its state at the beginning of the
+    // iteration.
+    typename LevelSetType::Pointer levelSet = LevelSetType::New();
+    levelSet->SetLabelMap( LevelSetLabelMapType::New() );
+    levelSet->Graft( it->GetLevelSet() );
+    levelSet->SetDomainOffset( it->GetLevelSet()->GetDomainOffset() );
+
+    evolution->m_UpdateLevelSetFilters.push_back( evolution->CreateUpdateLevelSetFilter( levelSet, it->GetIdentifier() ) );
+    ++it;
+    }
+
+  if( evolution->m_UpdateLevelSetFilters.empty() )
+    {
+    return;
+    }
+
+  DomainType completeDomain;
+  completeDomain[0] = 0;
+  completeDomain[1] = static_cast< IndexValueType >( evolution->m_UpdateLevelSetFilters.size() ) - 1;
+  this->Execute( evolution, completeDomain );
+
+  it = evolution->m_LevelSetContainer->Begin();
+  for( size_t ii = 0; ii < evolution->m_UpdateLevelSetFilters.size(); ++ii, ++it )
+    {
+    it->GetLevelSet()->Graft( evolution->m_UpdateLevelSetFilters[ii]->GetOutputLevelSet() );
+
+    evolution->m_RMSChangeAccumulator = evolution->m_UpdateLevelSetFilters[ii]->GetRMSChangeAccumulator();
+    }
+  evolution->m_UpdateLevelSetFilters.clear();
+}
+
+template< typename TLevelSet, typename TLevelSetEvolution >
+void
+LevelSetEvolutionUpdateLevelSetsThreader< TLevelSet, ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+::BeforeThreadedExecution()
+{
+  this->m_ExceptionDescriptionPerThread.assign( this->GetNumberOfThreadsUsed(), std::string() );
+}
+
+template< typename TLevelSet, typename TLevelSetEvolution >
+void
+LevelSetEvolutionUpdateLevelSetsThreader< TLevelSet, ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+::ThreadedExecution( const DomainType & levelSetSubRange,
+                     const ThreadIdType threadId )
+{
+  for( IndexValueType ii = levelSetSubRange[0]; ii <= levelSetSubRange[1]; ++ii )
+    {
+    // The exceptions are thrown again by the calling thread.
+    try
+      {
+      this->m_Associate->m_UpdateLevelSetFilters[ii]->Update();
+      }
+    catch( ExceptionObject & exception )
+      {
+      this->m_ExceptionDescriptionPerThread[threadId] = exception.GetDescription();
+      return;
+      }
+    }
+}
+
+template< typename TLevelSet, typename TLevelSetEvolution >
+void
+LevelSetEvolutionUpdateLevelSetsThreader< TLevelSet, ThreadedIndexedContainerPartitioner, TLevelSetEvolution >
+::AfterThreadedExecution()
+{
+  for( ThreadIdType ii = 0, maxThreads = this->GetNumberOfThreadsUsed(); ii < maxThreads; ++ii )
+    {
+    if( !this->m_ExceptionDescriptionPerThread[ii].empty() )
+      {
+      itkExceptionMacro( << this->m_ExceptionDescriptionPerThread[ii] );
+      }
+    }
+}
+
 } // end namespace itk
 
 #endif
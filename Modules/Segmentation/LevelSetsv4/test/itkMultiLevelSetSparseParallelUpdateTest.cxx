@@ -0,0 +1,288 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkWhitakerSparseLevelSetImage.h"
+#include "itkShiSparseLevelSetImage.h"
+#include "itkMalcolmSparseLevelSetImage.h"
+#include "itkLevelSetContainer.h"
+#include "itkLevelSetEquationChanAndVeseInternalTerm.h"
+#include "itkLevelSetEquationChanAndVeseExternalTerm.h"
+#include "itkLevelSetEquationTermContainer.h"
+#include "itkLevelSetEquationContainer.h"
+#include "itkLevelSetEvolution.h"
+#include "itkLevelSetEvolutionNumberOfIterationsStoppingCriterion.h"
+#include "itkBinaryImageToLevelSetImageAdaptor.h"
+#include "itkAtanRegularizedHeavisideStepFunction.h"
+#include "itkLevelSetDomainMapImageFilter.h"
+
+/*
+ * Evolve three sparse level sets with and without UpdateLevelSetsInParallel.
+ * Level sets defined over disjoint domains evolve exactly as when they are
+ * updated one after the other; level sets coupled by the Chan and Vese
+ * external term over a common domain evolve almost the same way.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+const unsigned int NumberOfLevelSets = 3;
+
+typedef unsigned short                                      InputPixelType;
+typedef itk::Image< InputPixelType, Dimension >             InputImageType;
+typedef itk::ImageRegionIteratorWithIndex< InputImageType > InputIteratorType;
+
+typedef std::list< itk::IdentifierType >                                      IdListType;
+typedef itk::Image< IdListType, Dimension >                                   IdListImageType;
+typedef itk::Image< short, Dimension >                                        CacheImageType;
+typedef itk::LevelSetDomainMapImageFilter< IdListImageType, CacheImageType > DomainMapImageFilterType;
+
+void
+FillSquare( InputImageType * image, unsigned int levelSetId, InputImageType::IndexValueType margin,
+            InputPixelType value )
+{
+  InputImageType::RegionType region;
+  region.SetIndex( 0, 4 + 20 * levelSetId - margin );
+  region.SetIndex( 1, 12 + 8 * levelSetId - margin );
+  region.SetSize( 0, 12 + 2 * margin );
+  region.SetSize( 1, 14 + 2 * margin );
+
+  InputIteratorType it( image, region );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    it.Set( value );
+    }
+}
+
+InputImageType::Pointer
+CreateImage()
+{
+  InputImageType::Pointer image = InputImageType::New();
+  InputImageType::SizeType size;
+  size.Fill( 64 );
+  image->SetRegions( size );
+  image->Allocate();
+  image->FillBuffer( 0 );
+  return image;
+}
+
+template< typename TLevelSet >
+bool
+EvolveLevelSets( InputImageType * input, bool coupled, bool inParallel, itk::ThreadIdType numberOfThreads,
+                 std::vector< double > & values, std::vector< double > & means )
+{
+  typedef TLevelSet                                                     LevelSetType;
+  typedef typename LevelSetType::OutputRealType                         LevelSetOutputRealType;
+  typedef itk::LevelSetContainer< itk::IdentifierType, LevelSetType >   LevelSetContainerType;
+  typedef itk::LevelSetEquationChanAndVeseInternalTerm< InputImageType, LevelSetContainerType >
+                                                                        ChanAndVeseInternalTermType;
+  typedef itk::LevelSetEquationChanAndVeseExternalTerm< InputImageType, LevelSetContainerType >
+                                                                        ChanAndVeseExternalTermType;
+  typedef itk::LevelSetEquationTermContainer< InputImageType, LevelSetContainerType > TermContainerType;
+  typedef itk::LevelSetEquationContainer< TermContainerType >           EquationContainerType;
+  typedef itk::LevelSetEvolution< EquationContainerType, LevelSetType > LevelSetEvolutionType;
+  typedef itk::AtanRegularizedHeavisideStepFunction< LevelSetOutputRealType, LevelSetOutputRealType >
+                                                                        HeavisideFunctionType;
+  typedef itk::BinaryImageToLevelSetImageAdaptor< InputImageType, LevelSetType > BinaryImageToLevelSetType;
+  typedef itk::LevelSetEvolutionNumberOfIterationsStoppingCriterion< LevelSetContainerType >
+                                                                        StoppingCriterionType;
+
+  typename HeavisideFunctionType::Pointer heaviside = HeavisideFunctionType::New();
+  heaviside->SetEpsilon( 1.0 );
+
+  // The coupled level sets are all defined over the whole image, the others
+  // over disjoint vertical bands.
+  IdListType idList;
+  for( unsigned int ii = 0; ii < NumberOfLevelSets; ++ii )
+    {
+    idList.push_back( ii + 1 );
+    }
+  IdListImageType::Pointer idImage = IdListImageType::New();
+  idImage->SetRegions( input->GetLargestPossibleRegion() );
+  idImage->Allocate();
+  idImage->FillBuffer( idList );
+  if( !coupled )
+    {
+    itk::ImageRegionIteratorWithIndex< IdListImageType > it( idImage, idImage->GetLargestPossibleRegion() );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      it.Set( IdListType( 1, std::min< itk::IdentifierType >( it.GetIndex()[0] / 21, NumberOfLevelSets - 1 ) + 1 ) );
+      }
+    }
+
+  DomainMapImageFilterType::Pointer domainMapFilter = DomainMapImageFilterType::New();
+  domainMapFilter->SetInput( idImage );
+  domainMapFilter->Update();
+
+  typename LevelSetContainerType::Pointer levelSetContainer = LevelSetContainerType::New();
+  levelSetContainer->SetHeaviside( heaviside );
+  levelSetContainer->SetDomainMapFilter( domainMapFilter );
+
+  typename EquationContainerType::Pointer equationContainer = EquationContainerType::New();
+  equationContainer->SetLevelSetContainer( levelSetContainer );
+
+  std::vector< typename ChanAndVeseInternalTermType::Pointer > internalTerms;
+  for( unsigned int ii = 0; ii < NumberOfLevelSets; ++ii )
+    {
+    // Each level set starts from a square larger than its object.
+    InputImageType::Pointer binary = CreateImage();
+    FillSquare( binary, ii, 3, 1 );
+
+    typename BinaryImageToLevelSetType::Pointer adaptor = BinaryImageToLevelSetType::New();
+    adaptor->SetInputImage( binary );
+    adaptor->Initialize();
+    levelSetContainer->AddLevelSet( ii, adaptor->GetModifiableLevelSet(), false );
+    }
+
+  for( unsigned int ii = 0; ii < NumberOfLevelSets; ++ii )
+    {
+    typename TermContainerType::Pointer termContainer = TermContainerType::New();
+    termContainer->SetInput( input );
+    termContainer->SetCurrentLevelSetId( ii );
+    termContainer->SetLevelSetContainer( levelSetContainer );
+
+    typename ChanAndVeseInternalTermType::Pointer internalTerm = ChanAndVeseInternalTermType::New();
+    internalTerm->SetInput( input );
+    internalTerm->SetCoefficient( 1.0 );
+    termContainer->AddTerm( 0, internalTerm );
+    internalTerms.push_back( internalTerm );
+
+    typename ChanAndVeseExternalTermType::Pointer externalTerm = ChanAndVeseExternalTermType::New();
+    externalTerm->SetInput( input );
+    externalTerm->SetCoefficient( 1.0 );
+    termContainer->AddTerm( 1, externalTerm );
+    equationContainer->AddEquation( ii, termContainer );
+    }
+
+  typename StoppingCriterionType::Pointer criterion = StoppingCriterionType::New();
+  criterion->SetNumberOfIterations( 20 );
+
+  typename LevelSetEvolutionType::Pointer evolution = LevelSetEvolutionType::New();
+  evolution->SetEquationContainer( equationContainer );
+  evolution->SetStoppingCriterion( criterion );
+  evolution->SetLevelSetContainer( levelSetContainer );
+  evolution->SetNumberOfThreads( numberOfThreads );
+  evolution->SetUpdateLevelSetsInParallel( inParallel );
+  if( evolution->GetUpdateLevelSetsInParallel() != inParallel )
+    {
+    std::cerr << "GetUpdateLevelSetsInParallel() does not return the value set" << std::endl;
+    return false;
+    }
+
+  values.clear();
+  means.clear();
+  try
+    {
+    evolution->Update();
+
+    for( unsigned int ii = 0; ii < NumberOfLevelSets; ++ii )
+      {
+      const LevelSetType * levelSet = levelSetContainer->GetLevelSet( ii );
+      InputIteratorType it( input, input->GetLargestPossibleRegion() );
+      for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+        {
+        values.push_back( static_cast< double >( levelSet->Evaluate( it.GetIndex() ) ) );
+        }
+      means.push_back( internalTerms[ii]->GetMean() );
+      }
+    }
+  catch( itk::ExceptionObject & exception )
+    {
+    std::cerr << exception << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template< typename TLevelSet >
+bool
+TestParallelUpdate( InputImageType * input, const char * name, bool testCoupled )
+{
+  bool result = true;
+
+  // Independent level sets.
+  std::vector< double > serialValues;
+  std::vector< double > serialMeans;
+  result = EvolveLevelSets< TLevelSet >( input, false, false, 1, serialValues, serialMeans ) && result;
+  for( itk::ThreadIdType numberOfThreads = 1; numberOfThreads <= 4; numberOfThreads += 3 )
+    {
+    std::vector< double > parallelValues;
+    std::vector< double > parallelMeans;
+    result = EvolveLevelSets< TLevelSet >( input, false, true, numberOfThreads, parallelValues, parallelMeans ) &&
+      result;
+    if( parallelValues != serialValues || parallelMeans != serialMeans )
+      {
+      std::cerr << name << ": the level sets updated in parallel with " << numberOfThreads
+                << " threads differ from the level sets updated one after the other" << std::endl;
+      result = false;
+      }
+    }
+
+  if( !testCoupled )
+    {
+    return result;
+    }
+
+  // Coupled level sets, which may evolve differently, but not much.
+  result = EvolveLevelSets< TLevelSet >( input, true, false, 1, serialValues, serialMeans ) && result;
+  std::vector< double > parallelValues;
+  std::vector< double > parallelMeans;
+  result = EvolveLevelSets< TLevelSet >( input, true, true, 4, parallelValues, parallelMeans ) && result;
+  if( parallelValues.size() != serialValues.size() )
+    {
+    return false;
+    }
+  size_t numberOfDifferentSigns = 0;
+  for( size_t ii = 0; ii < serialValues.size(); ++ii )
+    {
+    if( ( serialValues[ii] <= 0.0 ) != ( parallelValues[ii] <= 0.0 ) )
+      {
+      ++numberOfDifferentSigns;
+      }
+    }
+  if( numberOfDifferentSigns > serialValues.size() / 100 )
+    {
+    std::cerr << name << ": " << numberOfDifferentSigns << " pixels of the coupled level sets updated in parallel"
+              << " have another sign than when they are updated one after the other" << std::endl;
+    result = false;
+    }
+  return result;
+}
+}
+
+int itkMultiLevelSetSparseParallelUpdateTest( int, char* [] )
+{
+  InputImageType::Pointer input = CreateImage();
+  for( unsigned int ii = 0; ii < NumberOfLevelSets; ++ii )
+    {
+    FillSquare( input, ii, 0, 100 );
+    }
+
+  bool result = true;
+  result = TestParallelUpdate< itk::WhitakerSparseLevelSetImage< float, Dimension > >( input, "Whitaker", true ) && result;
+  result = TestParallelUpdate< itk::ShiSparseLevelSetImage< Dimension > >( input, "Shi", true ) && result;
+  // The coupled Malcolm level sets lose their interior on this input.
+  result = TestParallelUpdate< itk::MalcolmSparseLevelSetImage< Dimension > >( input, "Malcolm", false ) && result;
+
+  if( !result )
+    {
+    std::cerr << "Test failed." << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::cout << "Test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
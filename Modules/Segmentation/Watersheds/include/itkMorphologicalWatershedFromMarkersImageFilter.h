@@ -19,6 +19,9 @@
 #define itkMorphologicalWatershedFromMarkersImageFilter_h
 
 #include "itkImageToImageFilter.h"
+#include <algorithm>
+#include <map>
+#include <vector>
 
 namespace itk
 {
@@ -64,6 +67,29 @@ namespace itk
  * Chapter 9.2 of Pierre Soille's book "Morphological Image Analysis:
  * Principles and Applications", Second Edition, Springer, 2003.
  *
+ * The pixels waiting to be flooded are stored in a hierarchical queue.
+ * For integer pixel types, the queue is a flat array with one bucket per
+ * gray level between the minimum and the maximum of the input image, as
+ * long as there are at most MaximumNumberOfBuckets levels.  For the
+ * other pixel types, the levels are stored in an ordered map.  In both
+ * cases, the pixels are flooded in the same order.
+ *
+ * Two optional modes trade the exact flooding order for speed, and so may
+ * give slightly different labels and watershed lines:
+ *  - With NumberOfQuantizationLevels set, the images which can't use a
+ *    bucket per gray level (floating point images, or integer images with
+ *    a large range) are flooded with a flat array of that many buckets,
+ *    spread evenly between the minimum and the maximum of the input.  The
+ *    pixels in the same bucket are flooded in FIFO order.
+ *  - With TileParallelFlooding on, the output is split in one tile per
+ *    thread, and each tile is flooded independently from the markers in
+ *    the tile padded by TileOverlap pixels.  The tiles are then reconciled
+ *    by a last serial flooding which uses the labels of the tiles as
+ *    markers, and floods the pixels they left unlabeled.  When the
+ *    watershed lines are marked, the pixels of a tile border which touch a
+ *    different label across the border are unlabeled before that last
+ *    flooding, so that a watershed line separates the two labels.
+ *
  * This code was contributed in the Insight Journal paper:
  * "The watershed transform in ITK - discussion and new developments"
  * by Beare R., Lehmann G.
@@ -157,6 +183,33 @@ public:
   itkGetConstReferenceMacro(MarkWatershedLine, bool);
   itkBooleanMacro(MarkWatershedLine);
 
+  /** Largest number of buckets of the hierarchical queue. */
+  itkStaticConstMacro(MaximumNumberOfBuckets, SizeValueType, 65536);
+
+  /**
+   * Set/Get the number of levels used to flood the images which can't be
+   * flooded with a bucket per gray level.  Default is 0, to flood these
+   * images in the exact order of their gray levels.
+   */
+  itkSetClampMacro(NumberOfQuantizationLevels, SizeValueType, NumericTraits< SizeValueType >::ZeroValue(),
+                   static_cast< SizeValueType >( MaximumNumberOfBuckets ) );
+  itkGetConstMacro(NumberOfQuantizationLevels, SizeValueType);
+
+  /**
+   * Set/Get whether the image is flooded by tiles in parallel, and then
+   * reconciled.  Default is false.
+   */
+  itkSetMacro(TileParallelFlooding, bool);
+  itkGetConstReferenceMacro(TileParallelFlooding, bool);
+  itkBooleanMacro(TileParallelFlooding);
+
+  /**
+   * Set/Get the number of pixels added around a tile to find its markers
+   * when TileParallelFlooding is on.  Default is 8.
+   */
+  itkSetMacro(TileOverlap, SizeValueType);
+  itkGetConstMacro(TileOverlap, SizeValueType);
+
 protected:
   MorphologicalWatershedFromMarkersImageFilter();
   ~MorphologicalWatershedFromMarkersImageFilter() {}
@@ -172,15 +225,204 @@ protected:
    * \sa ProcessObject::EnlargeOutputRequestedRegion() */
   void EnlargeOutputRequestedRegion( DataObject *itkNotUsed(output) ) ITK_OVERRIDE;
 
-  /** The filter is single threaded. */
+  /** The filter is single threaded, unless TileParallelFlooding is on. */
   void GenerateData() ITK_OVERRIDE;
 
+  /** Flood a tile of the output when TileParallelFlooding is on. */
+  void ThreadedGenerateData(const LabelImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId) ITK_OVERRIDE;
+
+  /** Reconcile the tiles when TileParallelFlooding is on. */
+  void AfterThreadedGenerateData() ITK_OVERRIDE;
+
 private:
   ITK_DISALLOW_COPY_AND_ASSIGN(MorphologicalWatershedFromMarkersImageFilter);
 
+  /** FIFO of the pixels of the level being flooded. */
+  class LevelQueue
+  {
+  public:
+    LevelQueue():m_Front(0) {}
+
+    bool Empty() const { return m_Front == m_Indexes.size(); }
+
+    void Push(const IndexType & idx) { m_Indexes.push_back(idx); }
+
+    IndexType Pop() { return m_Indexes[m_Front++]; }
+
+    /** Replace the content of the queue by the given pixels, and release
+     * the memory of the previous ones. */
+    void Assign(std::vector< IndexType > & indexes)
+    {
+      m_Indexes.swap(indexes);
+      std::vector< IndexType >().swap(indexes);
+      m_Front = 0;
+    }
+
+  private:
+    std::vector< IndexType > m_Indexes;
+    size_t                   m_Front;
+  };
+
+  /** Hierarchical queue storing the levels in an ordered map. */
+  class MapHierarchicalQueue
+  {
+  public:
+    typedef InputImagePixelType LevelType;
+
+    bool Empty() const { return m_Levels.empty(); }
+
+    LevelType GetLevel(const InputImagePixelType & value) const { return value; }
+
+    void Push(const InputImagePixelType & value, const IndexType & idx) { m_Levels[value].push_back(idx); }
+
+    /** Move the pixels of the lowest level in the given queue, and return
+     * that level. */
+    LevelType PopLevel(LevelQueue & level)
+    {
+      const InputImagePixelType value = m_Levels.begin()->first;
+      level.Assign(m_Levels.begin()->second);
+      m_Levels.erase( m_Levels.begin() );
+      return value;
+    }
+
+  private:
+    std::map< InputImagePixelType, std::vector< IndexType > > m_Levels;
+  };
+
+  /** Hierarchical queue storing the levels in a flat array of buckets.
+   * The levels pushed must not be lower than the last level popped. */
+  class BucketHierarchicalQueue
+  {
+  public:
+    typedef SizeValueType LevelType;
+
+    BucketHierarchicalQueue(SizeValueType numberOfBuckets):
+      m_Buckets(numberOfBuckets),
+      m_CurrentBucket(0),
+      m_Size(0)
+    {}
+
+    bool Empty() const { return m_Size == 0; }
+
+    LevelType PopLevel(LevelQueue & level)
+    {
+      while ( m_Buckets[m_CurrentBucket].empty() )
+        {
+        ++m_CurrentBucket;
+        }
+      m_Size -= m_Buckets[m_CurrentBucket].size();
+      level.Assign(m_Buckets[m_CurrentBucket]);
+      return m_CurrentBucket;
+    }
+
+  protected:
+    void PushInBucket(LevelType bucket, const IndexType & idx)
+    {
+      m_Buckets[bucket].push_back(idx);
+      ++m_Size;
+    }
+
+  private:
+    std::vector< std::vector< IndexType > > m_Buckets;
+    SizeValueType                           m_CurrentBucket;
+    SizeValueType                           m_Size;
+  };
+
+  /** Bucket queue with one bucket per gray level, for integer pixel
+   * types. */
+  class IntegerHierarchicalQueue:public BucketHierarchicalQueue
+  {
+  public:
+    typedef typename BucketHierarchicalQueue::LevelType LevelType;
+
+    IntegerHierarchicalQueue(const InputImagePixelType & minimum, SizeValueType numberOfLevels):
+      BucketHierarchicalQueue(numberOfLevels),
+      m_Minimum( static_cast< SizeValueType >( minimum ) )
+    {}
+
+    LevelType GetLevel(const InputImagePixelType & value) const
+    {
+      return static_cast< SizeValueType >( value ) - m_Minimum;
+    }
+
+    void Push(const InputImagePixelType & value, const IndexType & idx)
+    {
+      this->PushInBucket(this->GetLevel(value), idx);
+    }
+
+  private:
+    SizeValueType m_Minimum;
+  };
+
+  /** Bucket queue with a given number of buckets spread evenly between the
+   * minimum and the maximum gray levels. */
+  class QuantizedHierarchicalQueue:public BucketHierarchicalQueue
+  {
+  public:
+    typedef typename BucketHierarchicalQueue::LevelType LevelType;
+
+    QuantizedHierarchicalQueue(const InputImagePixelType & minimum, const InputImagePixelType & maximum,
+                               SizeValueType numberOfLevels):
+      BucketHierarchicalQueue(numberOfLevels),
+      m_Minimum( static_cast< double >( minimum ) ),
+      m_Scale(0.0),
+      m_LastLevel(numberOfLevels - 1)
+    {
+      const double range = static_cast< double >( maximum ) - m_Minimum;
+      if ( range > 0.0 )
+        {
+        m_Scale = numberOfLevels / range;
+        }
+    }
+
+    LevelType GetLevel(const InputImagePixelType & value) const
+    {
+      const double level = ( static_cast< double >( value ) - m_Minimum ) * m_Scale;
+      if ( !( level > 0.0 ) )
+        {
+        return 0;
+        }
+      return std::min( static_cast< SizeValueType >( level ), m_LastLevel );
+    }
+
+    void Push(const InputImagePixelType & value, const IndexType & idx)
+    {
+      this->PushInBucket(this->GetLevel(value), idx);
+    }
+
+  private:
+    double        m_Minimum;
+    double        m_Scale;
+    SizeValueType m_LastLevel;
+  };
+
+  /** Flood the given output image from the given markers, with a queue
+   * chosen for the input image. */
+  void Flood(const InputImageType *inputImage, const LabelImageType *markerImage, LabelImageType *outputImage,
+             ThreadIdType threadId, float initialProgress, float progressWeight);
+
+  /** Flood the given output image from the given markers, with the given
+   * hierarchical queue. */
+  template< typename THierarchicalQueue >
+  void FloodWithHierarchicalQueue(THierarchicalQueue & fah, const InputImageType *inputImage,
+                                  const LabelImageType *markerImage, LabelImageType *outputImage,
+                                  ThreadIdType threadId, float initialProgress, float progressWeight);
+
+  /** Unlabel the pixels of the tile borders which touch a different label
+   * across the border, so the last flooding separates them with a
+   * watershed line. */
+  void SeparateTiles(LabelImageType *tileLabels);
+
   bool m_FullyConnected;
 
   bool m_MarkWatershedLine;
+
+  SizeValueType m_NumberOfQuantizationLevels;
+
+  bool m_TileParallelFlooding;
+
+  SizeValueType m_TileOverlap;
 }; // end of class
 } // end namespace itk
 
@@ -22,6 +22,7 @@
 #include <queue>
 #include <list>
 #include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkMinimumMaximumImageCalculator.h"
 #include "itkProgressReporter.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
@@ -29,6 +30,7 @@
 #include "itkConstantBoundaryCondition.h"
 #include "itkSize.h"
 #include "itkConnectedComponentAlgorithm.h"
+#include "itkImageAlgorithm.h"
 
 namespace itk
 {
@@ -37,8 +39,10 @@ template< typename TInputImage, typename TLabelImage >
 MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 ::MorphologicalWatershedFromMarkersImageFilter():
   m_FullyConnected( false ),
-  m_MarkWatershedLine( true )
-
+  m_MarkWatershedLine( true ),
+  m_NumberOfQuantizationLevels( 0 ),
+  m_TileParallelFlooding( false ),
+  m_TileOverlap( 8 )
 {
   this->SetNumberOfRequiredInputs(2);
 }
@@ -92,40 +96,236 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
   // the algorithm without watershed lines is from beucher
   // The 2 algorithms are very similar and so are integrated in the same filter.
 
-  //---------------------------------------------------------------------------
-  // declare the vars common to the 2 algorithms: constants, iterators,
-  // hierarchical queue, progress reporter, and status image
-  // also allocate output images and verify preconditions
-  //---------------------------------------------------------------------------
+  const LabelImageType * markerImage = this->GetMarkerImage();
+  const InputImageType * inputImage = this->GetInput();
 
-  // the label used to find background in the marker image
-  static const LabelImagePixelType bgLabel =
-    NumericTraits< LabelImagePixelType >::ZeroValue();
-  // the label used to mark the watershed line in the output image
-  static const LabelImagePixelType wsLabel =
-    NumericTraits< LabelImagePixelType >::ZeroValue();
+  // mask and marker must have the same size
+  if ( markerImage->GetRequestedRegion().GetSize() != inputImage->GetRequestedRegion().GetSize() )
+    {
+    itkExceptionMacro(<< "Marker and input must have the same size.");
+    }
+
+  if ( m_TileParallelFlooding )
+    {
+    // the tiles are flooded in ThreadedGenerateData() and reconciled in
+    // AfterThreadedGenerateData()
+    Superclass::GenerateData();
+    return;
+    }
 
   this->AllocateOutputs();
+  this->Flood(inputImage, markerImage, this->GetOutput(), 0, 0.0f, 1.0f);
+}
+
 
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::ThreadedGenerateData(const LabelImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
   const LabelImageType * markerImage = this->GetMarkerImage();
   const InputImageType * inputImage = this->GetInput();
   LabelImageType * outputImage = this->GetOutput();
 
-  // Set up the progress reporter
-  // we can't found the exact number of pixel to process in the 2nd pass, so we
-  // use the maximum number possible.
-  ProgressReporter progress(this, 0, markerImage->GetRequestedRegion().GetNumberOfPixels() * 2);
+  // the tile is flooded with the markers of its neighborhood, in images
+  // limited to that neighborhood
+  LabelImageRegionType tileRegion = outputRegionForThread;
+  tileRegion.PadByRadius( static_cast< OffsetValueType >( m_TileOverlap ) );
+  tileRegion.Crop( outputImage->GetRequestedRegion() );
 
-  // mask and marker must have the same size
-  if ( markerImage->GetRequestedRegion().GetSize() != inputImage->GetRequestedRegion().GetSize() )
+  typename InputImageType::Pointer tileInput = InputImageType::New();
+  tileInput->SetRegions(tileRegion);
+  tileInput->Allocate();
+  ImageAlgorithm::Copy(inputImage, tileInput.GetPointer(), tileRegion, tileRegion);
+
+  LabelImagePointer tileMarker = LabelImageType::New();
+  tileMarker->SetRegions(tileRegion);
+  tileMarker->Allocate();
+  ImageAlgorithm::Copy(markerImage, tileMarker.GetPointer(), tileRegion, tileRegion);
+
+  LabelImagePointer tileOutput = LabelImageType::New();
+  tileOutput->SetRegions(tileRegion);
+  tileOutput->Allocate();
+
+  // the tiles make the first half of the progress
+  this->Flood(tileInput, tileMarker, tileOutput, threadId, 0.0f, 0.5f);
+
+  ImageAlgorithm::Copy(tileOutput.GetPointer(), outputImage, outputRegionForThread, outputRegionForThread);
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::AfterThreadedGenerateData()
+{
+  LabelImageType * outputImage = this->GetOutput();
+  const LabelImageRegionType & region = outputImage->GetRequestedRegion();
+
+  // the labels found in the tiles are the markers of a last flooding, which
+  // labels the pixels left unlabeled by the tiles
+  LabelImagePointer tileLabels = LabelImageType::New();
+  tileLabels->SetRegions(region);
+  tileLabels->Allocate();
+  ImageAlgorithm::Copy(static_cast< const LabelImageType * >( outputImage ), tileLabels.GetPointer(), region, region);
+
+  if ( m_MarkWatershedLine )
     {
-    itkExceptionMacro(<< "Marker and input must have the same size.");
+    this->SeparateTiles(tileLabels);
     }
 
+  this->Flood(this->GetInput(), tileLabels, outputImage, 0, 0.5f, 0.5f);
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::SeparateTiles(LabelImageType *tileLabels)
+{
+  const LabelImagePixelType bgLabel = NumericTraits< LabelImagePixelType >::ZeroValue();
+
+  const LabelImageType *       markerImage = this->GetMarkerImage();
+  const LabelImageRegionType & region = tileLabels->GetRequestedRegion();
+
+  Size< ImageDimension > radius;
+  radius.Fill(1);
+  typedef ConstShapedNeighborhoodIterator< LabelImageType > LabelIteratorType;
+  typename LabelIteratorType::ConstIterator nIt;
+  ConstantBoundaryCondition< LabelImageType > cbc;
+  cbc.SetConstant(bgLabel);
+
+  // the tiles are the ones of ThreadedGenerateData()
+  const ImageRegionSplitterBase * splitter = this->GetImageRegionSplitter();
+  const unsigned int numberOfTiles = splitter->GetNumberOfSplits( region, this->GetNumberOfThreads() );
+  for ( unsigned int tile = 0; tile < numberOfTiles; ++tile )
+    {
+    LabelImageRegionType tileRegion = region;
+    splitter->GetSplit(tile, numberOfTiles, tileRegion);
+
+    // check the pixels on the lower borders of the tile, against their
+    // neighbors in the previous tiles
+    for ( unsigned int d = 0; d < ImageDimension; ++d )
+      {
+      if ( tileRegion.GetIndex(d) == region.GetIndex(d) )
+        {
+        continue;
+        }
+      LabelImageRegionType borderRegion = tileRegion;
+      borderRegion.SetSize(d, 1);
+
+      LabelIteratorType it(radius, tileLabels, borderRegion);
+      it.OverrideBoundaryCondition(&cbc);
+      setConnectivity(&it, m_FullyConnected);
+      for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+        {
+        const LabelImagePixelType label = it.GetCenterPixel();
+        if ( label == bgLabel )
+          {
+          continue;
+          }
+        for ( nIt = it.Begin(); nIt != it.End(); nIt++ )
+          {
+          const LabelImagePixelType neighborLabel = nIt.Get();
+          const IndexType           neighborIndex = it.GetIndex() + nIt.GetNeighborhoodOffset();
+          if ( neighborLabel == bgLabel || neighborLabel == label || tileRegion.IsInside(neighborIndex) )
+            {
+            continue;
+            }
+          // two labels touch across the border; unlabel one of them, unless
+          // both are markers
+          if ( markerImage->GetPixel( it.GetIndex() ) == bgLabel )
+            {
+            tileLabels->SetPixel(it.GetIndex(), bgLabel);
+            break;
+            }
+          if ( markerImage->GetPixel(neighborIndex) == bgLabel )
+            {
+            tileLabels->SetPixel(neighborIndex, bgLabel);
+            }
+          }
+        }
+      }
+    }
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::Flood(const InputImageType *inputImage, const LabelImageType *markerImage, LabelImageType *outputImage,
+        ThreadIdType threadId, float initialProgress, float progressWeight)
+{
   // FAH (in french: File d'Attente Hierarchique)
-  typedef std::queue< IndexType >                    QueueType;
-  typedef std::map< InputImagePixelType, QueueType > MapType;
-  MapType fah;
+  // use a bucket per gray level for the integer types with a small range,
+  // or a bucket per quantization level when requested
+  if ( NumericTraits< InputImagePixelType >::is_integer || m_NumberOfQuantizationLevels > 0 )
+    {
+    typedef MinimumMaximumImageCalculator< InputImageType > CalculatorType;
+    typename CalculatorType::Pointer calculator = CalculatorType::New();
+    calculator->SetImage(inputImage);
+    calculator->SetRegion( inputImage->GetRequestedRegion() );
+    calculator->Compute();
+
+    if ( NumericTraits< InputImagePixelType >::is_integer )
+      {
+      const double numberOfLevels = static_cast< double >( calculator->GetMaximum() )
+                                    - static_cast< double >( calculator->GetMinimum() ) + 1.0;
+      if ( numberOfLevels <= MaximumNumberOfBuckets )
+        {
+        IntegerHierarchicalQueue fah( calculator->GetMinimum(), static_cast< SizeValueType >( numberOfLevels ) );
+        this->FloodWithHierarchicalQueue(fah, inputImage, markerImage, outputImage,
+                                         threadId, initialProgress, progressWeight);
+        return;
+        }
+      }
+
+    if ( m_NumberOfQuantizationLevels > 0 )
+      {
+      QuantizedHierarchicalQueue fah( calculator->GetMinimum(), calculator->GetMaximum(),
+                                      m_NumberOfQuantizationLevels );
+      this->FloodWithHierarchicalQueue(fah, inputImage, markerImage, outputImage,
+                                       threadId, initialProgress, progressWeight);
+      return;
+      }
+    }
+
+  MapHierarchicalQueue fah;
+  this->FloodWithHierarchicalQueue(fah, inputImage, markerImage, outputImage,
+                                   threadId, initialProgress, progressWeight);
+}
+
+
+template< typename TInputImage, typename TLabelImage >
+template< typename THierarchicalQueue >
+void
+MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
+::FloodWithHierarchicalQueue(THierarchicalQueue & fah, const InputImageType *inputImage,
+                             const LabelImageType *markerImage, LabelImageType *outputImage,
+                             ThreadIdType threadId, float initialProgress, float progressWeight)
+{
+  typedef typename THierarchicalQueue::LevelType LevelType;
+
+  //---------------------------------------------------------------------------
+  // declare the vars common to the 2 algorithms: constants, iterators,
+  // progress reporter, and status image
+  //---------------------------------------------------------------------------
+
+  // the label used to find background in the marker image
+  const LabelImagePixelType bgLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+  // the label used to mark the watershed line in the output image
+  const LabelImagePixelType wsLabel =
+    NumericTraits< LabelImagePixelType >::ZeroValue();
+
+  // Set up the progress reporter
+  // we can't found the exact number of pixel to process in the 2nd pass, so we
+  // use the maximum number possible.
+  ProgressReporter progress(this, threadId, markerImage->GetRequestedRegion().GetNumberOfPixels() * 2,
+                            100, initialProgress, progressWeight);
+
+  // the pixels of the level being flooded
+  LevelQueue currentQueue;
 
   // the radius which will be used for all the shaped iterators
   Size< ImageDimension > radius;
@@ -230,8 +430,8 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
             {
             // this neighbor is a background pixel and is not already
             // processed; add its index to fah
-            fah[niIt.Get()].push( markerIt.GetIndex()
-                                  + nmIt.GetNeighborhoodOffset() );
+            fah.Push( niIt.Get(), markerIt.GetIndex()
+                      + nmIt.GetNeighborhoodOffset() );
             // mark it as already in the fah to avoid adding it several times
             nsIt.Set(true);
             }
@@ -261,18 +461,14 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     inputIt.GoToBegin();
 
     // and start flooding
-    while ( !fah.empty() )
+    while ( !fah.Empty() )
       {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase( fah.begin() );
+      // move the lowest level out of the fah
+      const LevelType currentLevel = fah.PopLevel(currentQueue);
 
-      while ( !currentQueue.empty() )
+      while ( !currentQueue.Empty() )
         {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
+        IndexType idx = currentQueue.Pop();
 
         // move the iterators to the right place
         OffsetType shift = idx - outputIt.GetIndex();
@@ -311,15 +507,15 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
               {
               // the pixel is not yet processed. add it to the fah
               InputImagePixelType GrayVal = niIt.Get();
-              if ( GrayVal <= currentValue )
+              if ( fah.GetLevel(GrayVal) <= currentLevel )
                 {
-                currentQueue.push( inputIt.GetIndex()
+                currentQueue.Push( inputIt.GetIndex()
                                    + niIt.GetNeighborhoodOffset() );
                 }
               else
                 {
-                fah[GrayVal].push( inputIt.GetIndex()
-                                   + niIt.GetNeighborhoodOffset() );
+                fah.Push( GrayVal, inputIt.GetIndex()
+                          + niIt.GetNeighborhoodOffset() );
                 }
               // mark it as already in the fah
               nsIt.Set(true);
@@ -375,7 +571,7 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
         if ( haveBgNeighbor )
           {
           // there is a background pixel in the neighborhood; add to fah
-          fah[inputIt.GetCenterPixel()].push( markerIt.GetIndex() );
+          fah.Push( inputIt.GetCenterPixel(), markerIt.GetIndex() );
           }
         else
           {
@@ -398,18 +594,14 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
     inputIt.GoToBegin();
 
     // and start flooding
-    while ( !fah.empty() )
+    while ( !fah.Empty() )
       {
-      // store the current vars
-      InputImagePixelType currentValue = fah.begin()->first;
-      QueueType           currentQueue = fah.begin()->second;
-      // and remove them from the fah
-      fah.erase( fah.begin() );
+      // move the lowest level out of the fah
+      const LevelType currentLevel = fah.PopLevel(currentQueue);
 
-      while ( !currentQueue.empty() )
+      while ( !currentQueue.Empty() )
         {
-        IndexType idx = currentQueue.front();
-        currentQueue.pop();
+        IndexType idx = currentQueue.Pop();
 
         // move the iterators to the right place
         OffsetType shift = idx - outputIt.GetIndex();
@@ -429,15 +621,15 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
             // current label
             noIt.Set(currentMarker);
             InputImagePixelType GrayVal = niIt.Get();
-            if ( GrayVal <= currentValue )
+            if ( fah.GetLevel(GrayVal) <= currentLevel )
               {
-              currentQueue.push( inputIt.GetIndex()
+              currentQueue.Push( inputIt.GetIndex()
                                  + noIt.GetNeighborhoodOffset() );
               }
             else
               {
-              fah[GrayVal].push( inputIt.GetIndex()
-                                 + noIt.GetNeighborhoodOffset() );
+              fah.Push( GrayVal, inputIt.GetIndex()
+                        + noIt.GetNeighborhoodOffset() );
               }
             progress.CompletedPixel();
             }
@@ -457,6 +649,9 @@ MorphologicalWatershedFromMarkersImageFilter< TInputImage, TLabelImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "MarkWatershedLine: "  << m_MarkWatershedLine << std::endl;
+  os << indent << "NumberOfQuantizationLevels: "  << m_NumberOfQuantizationLevels << std::endl;
+  os << indent << "TileParallelFlooding: "  << m_TileParallelFlooding << std::endl;
+  os << indent << "TileOverlap: "  << m_TileOverlap << std::endl;
 }
 
 } // end namespace itk
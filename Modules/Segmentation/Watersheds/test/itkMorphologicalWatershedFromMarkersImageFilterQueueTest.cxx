@@ -0,0 +1,188 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+/*
+ * The integer images are flooded with a bucket queue, unless their range
+ * is too large, and the floating point images with an ordered map of
+ * levels.  Check that the labels are the same in all cases, on an image
+ * with many plateaus where the flooding order matters.  The quantized
+ * bucket queue must give the same labels when there is a bucket per gray
+ * level, and valid labels when there are less buckets than levels.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< unsigned short, Dimension > LabelImageType;
+typedef itk::Image< double, Dimension >         ReferenceImageType;
+
+template< typename TInputImage >
+typename LabelImageType::Pointer
+ComputeWatershed( const ReferenceImageType * levels, double scale, double shift, const LabelImageType * markers,
+                  bool markWatershedLine, bool fullyConnected, itk::SizeValueType numberOfQuantizationLevels = 0 )
+{
+  typename TInputImage::Pointer input = TInputImage::New();
+  input->SetRegions( levels->GetLargestPossibleRegion() );
+  input->Allocate();
+  itk::ImageRegionConstIterator< ReferenceImageType > lIt( levels, levels->GetLargestPossibleRegion() );
+  for( itk::ImageRegionIterator< TInputImage > it( input, input->GetLargestPossibleRegion() ); !it.IsAtEnd(); ++it, ++lIt )
+    {
+    it.Set( static_cast< typename TInputImage::PixelType >( lIt.Get() * scale + shift ) );
+    }
+
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< TInputImage, LabelImageType > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetMarkerImage( markers );
+  filter->SetMarkWatershedLine( markWatershedLine );
+  filter->SetFullyConnected( fullyConnected );
+  filter->SetNumberOfQuantizationLevels( numberOfQuantizationLevels );
+  filter->Update();
+
+  LabelImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+bool
+SameLabels( const LabelImageType * image1, const LabelImageType * image2 )
+{
+  itk::ImageRegionConstIterator< LabelImageType > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< LabelImageType > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      std::cerr << "Different labels at index " << it1.GetIndex() << ": " << it1.Get()
+                << " and " << it2.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// The markers are kept, and the other pixels are labeled with the label of
+// a marker, or left on a watershed line when the lines are marked.
+bool
+ValidLabels( const LabelImageType * markers, const LabelImageType * output, unsigned int numberOfMarkers,
+             bool markWatershedLine )
+{
+  itk::ImageRegionConstIterator< LabelImageType > mIt( markers, markers->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< LabelImageType > oIt( output, output->GetLargestPossibleRegion() );
+  for( ; !oIt.IsAtEnd(); ++mIt, ++oIt )
+    {
+    if( ( mIt.Get() != 0 && oIt.Get() != mIt.Get() ) || oIt.Get() > numberOfMarkers
+        || ( !markWatershedLine && oIt.Get() == 0 ) )
+      {
+      std::cerr << "Invalid label at index " << oIt.GetIndex() << ": " << oIt.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkMorphologicalWatershedFromMarkersImageFilterQueueTest( int, char *[] )
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 5678 );
+
+  // few levels, to get large plateaus
+  LabelImageType::SizeType size;
+  size[0] = 64;
+  size[1] = 57;
+  ReferenceImageType::Pointer levels = ReferenceImageType::New();
+  levels->SetRegions( size );
+  levels->Allocate();
+  for( itk::ImageRegionIterator< ReferenceImageType > it( levels, levels->GetLargestPossibleRegion() ); !it.IsAtEnd(); ++it )
+    {
+    it.Set( generator->GetIntegerVariate( 15 ) );
+    }
+
+  LabelImageType::Pointer markers = LabelImageType::New();
+  markers->SetRegions( size );
+  markers->Allocate();
+  markers->FillBuffer( 0 );
+  for( unsigned int i = 1; i <= 12; ++i )
+    {
+    LabelImageType::IndexType index;
+    index[0] = generator->GetIntegerVariate( size[0] - 1 );
+    index[1] = generator->GetIntegerVariate( size[1] - 1 );
+    markers->SetPixel( index, i );
+    }
+
+  for( unsigned int markWatershedLine = 0; markWatershedLine < 2; ++markWatershedLine )
+    {
+    for( unsigned int fullyConnected = 0; fullyConnected < 2; ++fullyConnected )
+      {
+      std::cout << "MarkWatershedLine: " << markWatershedLine << ", FullyConnected: " << fullyConnected << std::endl;
+      LabelImageType::Pointer reference =
+        ComputeWatershed< ReferenceImageType >( levels, 1.0, 0.0, markers, markWatershedLine, fullyConnected );
+
+      // bucket queue
+      LabelImageType::Pointer output =
+        ComputeWatershed< itk::Image< unsigned char, Dimension > >( levels, 16.0, 0.0, markers,
+                                                                    markWatershedLine, fullyConnected );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      // bucket queue with negative values
+      output = ComputeWatershed< itk::Image< short, Dimension > >( levels, 100.0, -700.0, markers,
+                                                                   markWatershedLine, fullyConnected );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      // too many levels for a bucket queue
+      output = ComputeWatershed< itk::Image< int, Dimension > >( levels, 100000000.0, -700000000.0, markers,
+                                                                 markWatershedLine, fullyConnected );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      output = ComputeWatershed< itk::Image< float, Dimension > >( levels, 0.5, 0.0, markers,
+                                                                   markWatershedLine, fullyConnected );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      // quantized bucket queue, with a bucket per level
+      output = ComputeWatershed< itk::Image< float, Dimension > >( levels, 0.5, 0.0, markers,
+                                                                   markWatershedLine, fullyConnected, 16 );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      output = ComputeWatershed< itk::Image< int, Dimension > >( levels, 100000000.0, -700000000.0, markers,
+                                                                 markWatershedLine, fullyConnected, 16 );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      // quantized bucket queue, with less buckets than levels
+      output = ComputeWatershed< itk::Image< float, Dimension > >( levels, 0.5, 0.0, markers,
+                                                                   markWatershedLine, fullyConnected, 4 );
+      TEST_EXPECT_TRUE( ValidLabels( markers, output, 12, markWatershedLine ) );
+      }
+    }
+
+  // the number of buckets is bounded
+  typedef itk::MorphologicalWatershedFromMarkersImageFilter< ReferenceImageType, LabelImageType > FilterType;
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetNumberOfQuantizationLevels( 10000000 );
+  TEST_SET_GET_VALUE( 65536, filter->GetNumberOfQuantizationLevels() );
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMorphologicalWatershedFromMarkersImageFilter.h"
+#include "itkConstShapedNeighborhoodIterator.h"
+#include "itkConnectedComponentAlgorithm.h"
+#include "itkImageRegionIterator.h"
+#include "itkMersenneTwisterRandomVariateGenerator.h"
+#include "itkTestingMacros.h"
+
+/*
+ * Flood an image by tiles in parallel.  With a single tile, or with tiles
+ * which overlap the whole image, the labels must be the same as the serial
+ * flooding.  With small overlaps, and with tiles without markers, the
+ * labels must still be valid: the markers are kept, all the pixels are
+ * labeled when the watershed lines are not marked, and two different
+ * labels never touch when they are, unless both pixels are markers.
+ */
+
+namespace
+{
+const unsigned int Dimension = 2;
+
+typedef itk::Image< unsigned char, Dimension >  InputImageType;
+typedef itk::Image< unsigned short, Dimension > LabelImageType;
+
+typedef itk::MorphologicalWatershedFromMarkersImageFilter< InputImageType, LabelImageType > FilterType;
+
+LabelImageType::Pointer
+ComputeWatershed( const InputImageType * input, const LabelImageType * markers, bool markWatershedLine,
+                  bool fullyConnected, bool tileParallelFlooding, unsigned int numberOfThreads,
+                  itk::SizeValueType tileOverlap )
+{
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( input );
+  filter->SetMarkerImage( markers );
+  filter->SetMarkWatershedLine( markWatershedLine );
+  filter->SetFullyConnected( fullyConnected );
+  filter->SetTileParallelFlooding( tileParallelFlooding );
+  filter->SetTileOverlap( tileOverlap );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+
+  LabelImageType::Pointer output = filter->GetOutput();
+  output->DisconnectPipeline();
+  return output;
+}
+
+bool
+SameLabels( const LabelImageType * image1, const LabelImageType * image2 )
+{
+  itk::ImageRegionConstIterator< LabelImageType > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< LabelImageType > it2( image2, image2->GetLargestPossibleRegion() );
+  for( ; !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if( it1.Get() != it2.Get() )
+      {
+      std::cerr << "Different labels at index " << it1.GetIndex() << ": " << it1.Get()
+                << " and " << it2.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+bool
+ValidLabels( const LabelImageType * markers, const LabelImageType * output, bool markWatershedLine,
+             bool fullyConnected )
+{
+  LabelImageType::SizeType radius;
+  radius.Fill( 1 );
+  typedef itk::ConstShapedNeighborhoodIterator< LabelImageType > IteratorType;
+  IteratorType oIt( radius, output, output->GetLargestPossibleRegion() );
+  setConnectivity( &oIt, fullyConnected );
+  IteratorType::ConstIterator nIt;
+
+  itk::ImageRegionConstIterator< LabelImageType > mIt( markers, markers->GetLargestPossibleRegion() );
+  for( oIt.GoToBegin(); !oIt.IsAtEnd(); ++oIt, ++mIt )
+    {
+    const LabelImageType::PixelType label = oIt.GetCenterPixel();
+    if( mIt.Get() != 0 && label != mIt.Get() )
+      {
+      std::cerr << "Marker changed at index " << oIt.GetIndex() << std::endl;
+      return false;
+      }
+    if( !markWatershedLine )
+      {
+      if( label == 0 )
+        {
+        std::cerr << "Unlabeled pixel at index " << oIt.GetIndex() << std::endl;
+        return false;
+        }
+      continue;
+      }
+    if( label == 0 || mIt.Get() != 0 )
+      {
+      continue;
+      }
+    for( nIt = oIt.Begin(); nIt != oIt.End(); nIt++ )
+      {
+      bool inBounds;
+      const LabelImageType::PixelType neighborLabel = oIt.GetPixel( nIt.GetNeighborhoodIndex(), inBounds );
+      if( inBounds && neighborLabel != 0 && neighborLabel != label )
+        {
+        std::cerr << "Labels " << label << " and " << neighborLabel << " touch at index "
+                  << oIt.GetIndex() << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+}
+
+int itkMorphologicalWatershedFromMarkersImageFilterTileTest( int, char *[] )
+{
+  typedef itk::Statistics::MersenneTwisterRandomVariateGenerator GeneratorType;
+  GeneratorType::Pointer generator = GeneratorType::New();
+  generator->Initialize( 1234 );
+
+  InputImageType::SizeType size;
+  size[0] = 61;
+  size[1] = 73;
+  InputImageType::Pointer input = InputImageType::New();
+  input->SetRegions( size );
+  input->Allocate();
+  for( itk::ImageRegionIterator< InputImageType > it( input, input->GetLargestPossibleRegion() ); !it.IsAtEnd(); ++it )
+    {
+    it.Set( generator->GetIntegerVariate( 31 ) );
+    }
+
+  // markers everywhere, and markers only in the first rows so that some
+  // tiles have no marker
+  LabelImageType::Pointer markers = LabelImageType::New();
+  markers->SetRegions( size );
+  markers->Allocate();
+  markers->FillBuffer( 0 );
+  LabelImageType::Pointer firstRowsMarkers = LabelImageType::New();
+  firstRowsMarkers->SetRegions( size );
+  firstRowsMarkers->Allocate();
+  firstRowsMarkers->FillBuffer( 0 );
+  for( unsigned int i = 1; i <= 20; ++i )
+    {
+    LabelImageType::IndexType index;
+    index[0] = generator->GetIntegerVariate( size[0] - 1 );
+    index[1] = generator->GetIntegerVariate( size[1] - 1 );
+    markers->SetPixel( index, i );
+    index[1] = generator->GetIntegerVariate( 9 );
+    firstRowsMarkers->SetPixel( index, i );
+    }
+
+  FilterType::Pointer filter = FilterType::New();
+  EXERCISE_BASIC_OBJECT_METHODS( filter, MorphologicalWatershedFromMarkersImageFilter, ImageToImageFilter );
+  TEST_SET_GET_BOOLEAN( filter, TileParallelFlooding, true );
+  TEST_SET_GET_VALUE( 8, filter->GetTileOverlap() );
+
+  for( unsigned int markWatershedLine = 0; markWatershedLine < 2; ++markWatershedLine )
+    {
+    for( unsigned int fullyConnected = 0; fullyConnected < 2; ++fullyConnected )
+      {
+      std::cout << "MarkWatershedLine: " << markWatershedLine << ", FullyConnected: " << fullyConnected << std::endl;
+      LabelImageType::Pointer reference =
+        ComputeWatershed( input, markers, markWatershedLine, fullyConnected, false, 1, 0 );
+
+      // a single tile
+      LabelImageType::Pointer output =
+        ComputeWatershed( input, markers, markWatershedLine, fullyConnected, true, 1, 0 );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      // tiles which overlap the whole image
+      output = ComputeWatershed( input, markers, markWatershedLine, fullyConnected, true, 4, 100 );
+      TEST_EXPECT_TRUE( SameLabels( reference, output ) );
+
+      // tiles with small overlaps
+      for( itk::SizeValueType overlap = 0; overlap < 8; overlap += 3 )
+        {
+        output = ComputeWatershed( input, markers, markWatershedLine, fullyConnected, true, 4, overlap );
+        TEST_EXPECT_TRUE( ValidLabels( markers, output, markWatershedLine, fullyConnected ) );
+
+        output = ComputeWatershed( input, firstRowsMarkers, markWatershedLine, fullyConnected, true, 5, overlap );
+        TEST_EXPECT_TRUE( ValidLabels( firstRowsMarkers, output, markWatershedLine, fullyConnected ) );
+        }
+      }
+    }
+
+  std::cout << "Test finished." << std::endl;
+  return EXIT_SUCCESS;
+}